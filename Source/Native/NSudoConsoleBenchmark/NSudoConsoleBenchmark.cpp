@@ -0,0 +1,425 @@
+﻿/*
+ * PROJECT:   NSudo Console Benchmark
+ * FILE:      NSudoConsoleBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo Console Benchmark (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+// The benchmark only depends on the buffered console I/O of the plugin host
+// and the system pipes, so it also builds on Linux, e.g.
+// g++ -std=c++14 -O2 -pthread -I../NSudoSDK -I../NSudoRelayBenchmark
+//     NSudoConsoleBenchmark.cpp
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <NSudoBufferedLineReader.h>
+#include <NSudoBufferedWriter.h>
+
+#include "NSudoBenchmarkPipe.h"
+
+/**
+ * @brief Formats a line like the purge plugins write for each file.
+ * @param Buffer The buffer which receives the line.
+ * @param Size The size of the buffer, in bytes.
+ * @param Index The index of the line.
+ * @return The length of the line, in bytes, with the line terminator.
+*/
+static std::size_t NSudoConsoleBenchmarkFormatLine(
+    char* Buffer,
+    std::size_t Size,
+    std::uint64_t Index)
+{
+    int Length = std::snprintf(
+        Buffer,
+        Size,
+        "Detected - C:\\Users\\Public\\AppData\\Local\\Temp\\%012llu.tmp.\r\n",
+        static_cast<unsigned long long>(Index));
+    return Length > 0 ? static_cast<std::size_t>(Length) : 0;
+}
+
+/**
+ * @brief The result of a run of the benchmark.
+*/
+typedef struct _NSUDO_CONSOLE_BENCHMARK_RESULT
+{
+    std::uint64_t Calls;
+    std::uint64_t Bytes;
+    double Seconds;
+} NSUDO_CONSOLE_BENCHMARK_RESULT;
+
+/**
+ * @brief Context of the sink of the buffered writer.
+*/
+typedef struct _NSUDO_CONSOLE_BENCHMARK_SINK
+{
+    CNSudoBenchmarkPipe* Pipe;
+    std::uint64_t Calls;
+} NSUDO_CONSOLE_BENCHMARK_SINK;
+
+/**
+ * @brief Writes the buffered output to the pipe, like the plugin host writes
+ *        it to the console output handle.
+ * @param Context The NSUDO_CONSOLE_BENCHMARK_SINK.
+ * @param Data The data to write.
+ * @param Size The size of the data, in bytes.
+*/
+static void NSudoConsoleBenchmarkWriteSink(
+    void* Context,
+    const void* Data,
+    std::size_t Size)
+{
+    NSUDO_CONSOLE_BENCHMARK_SINK* Sink =
+        reinterpret_cast<NSUDO_CONSOLE_BENCHMARK_SINK*>(Context);
+    ++Sink->Calls;
+    Sink->Pipe->Write(Data, Size);
+}
+
+/**
+ * @brief Writes the lines to a pipe which is drained by another thread.
+ * @param Buffered Writes through CNSudoBufferedWriter if true, or writes
+ *                 each line to the pipe if false, which is how
+ *                 NSudoContextWrite worked before the output was buffered.
+ * @param LineCount The number of the lines.
+ * @return The result. The number of the bytes is zero if the drained output
+ *         is not the written output.
+*/
+static NSUDO_CONSOLE_BENCHMARK_RESULT NSudoConsoleBenchmarkWrite(
+    bool Buffered,
+    std::uint64_t LineCount)
+{
+    NSUDO_CONSOLE_BENCHMARK_RESULT Result = {};
+
+    CNSudoBenchmarkPipe Pipe(1024 * 1024);
+    if (!Pipe.IsValid())
+    {
+        return Result;
+    }
+
+    std::uint64_t Drained = 0;
+    std::thread Drainer([&]()
+    {
+        char Buffer[64 * 1024];
+        std::size_t Read = 0;
+        while (0 != (Read = Pipe.Read(Buffer, sizeof(Buffer))))
+        {
+            Drained += Read;
+        }
+    });
+
+    std::uint64_t Written = 0;
+    char Line[128];
+
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    if (Buffered)
+    {
+        NSUDO_CONSOLE_BENCHMARK_SINK Sink = { &Pipe, 0 };
+        {
+            // The output is flushed when the writer is destroyed, the same as
+            // after the entry point of the plugin returns.
+            CNSudoBufferedWriter Writer(
+                &::NSudoConsoleBenchmarkWriteSink,
+                &Sink);
+            for (std::uint64_t i = 0; i < LineCount; ++i)
+            {
+                Writer.Write([&](std::string& Buffer)
+                {
+                    std::size_t Length = ::NSudoConsoleBenchmarkFormatLine(
+                        Line,
+                        sizeof(Line),
+                        i);
+                    Buffer.append(Line, Length);
+                    Written += Length;
+                });
+            }
+        }
+        Result.Calls = Sink.Calls;
+    }
+    else
+    {
+        for (std::uint64_t i = 0; i < LineCount; ++i)
+        {
+            std::size_t Length = ::NSudoConsoleBenchmarkFormatLine(
+                Line,
+                sizeof(Line),
+                i);
+            Pipe.Write(Line, Length);
+            Written += Length;
+        }
+        Result.Calls = LineCount;
+    }
+
+    Pipe.CloseWriter();
+    Drainer.join();
+
+    Result.Seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - Start).count();
+    Result.Bytes = Drained == Written ? Drained : 0;
+
+    return Result;
+}
+
+/**
+ * @brief Context of the source of the buffered line reader.
+*/
+typedef struct _NSUDO_CONSOLE_BENCHMARK_SOURCE
+{
+    CNSudoBenchmarkPipe* Pipe;
+    std::uint64_t Calls;
+} NSUDO_CONSOLE_BENCHMARK_SOURCE;
+
+/**
+ * @brief Reads the redirected input from the pipe, like the plugin host reads
+ *        it from the console input handle.
+ * @param Context The NSUDO_CONSOLE_BENCHMARK_SOURCE.
+ * @param Buffer The buffer which receives the input.
+ * @param Size The size of the buffer, in bytes.
+ * @return The number of bytes read, 0 at the end of the input.
+*/
+static std::size_t NSudoConsoleBenchmarkReadSource(
+    void* Context,
+    char* Buffer,
+    std::size_t Size)
+{
+    NSUDO_CONSOLE_BENCHMARK_SOURCE* Source =
+        reinterpret_cast<NSUDO_CONSOLE_BENCHMARK_SOURCE*>(Context);
+    ++Source->Calls;
+    return Source->Pipe->Read(Buffer, Size);
+}
+
+/**
+ * @brief Reads the lines which are written to a pipe by another thread in
+ *        large chunks, like the scripted answers piped to a plugin.
+ * @param Buffered Reads through CNSudoBufferedLineReader if true, or reads
+ *                 one character at a time if false, which is how
+ *                 NSudoContextReadLine worked before the input was buffered.
+ * @param LineCount The number of the lines.
+ * @return The result. The number of the bytes is zero if the lines read are
+ *         not the lines written.
+*/
+static NSUDO_CONSOLE_BENCHMARK_RESULT NSudoConsoleBenchmarkRead(
+    bool Buffered,
+    std::uint64_t LineCount)
+{
+    NSUDO_CONSOLE_BENCHMARK_RESULT Result = {};
+
+    CNSudoBenchmarkPipe Pipe(1024 * 1024);
+    if (!Pipe.IsValid())
+    {
+        return Result;
+    }
+
+    std::uint64_t Written = 0;
+    std::thread Producer([&]()
+    {
+        std::string Chunk;
+        char Line[128];
+        for (std::uint64_t i = 0; i < LineCount; ++i)
+        {
+            Chunk.append(Line, ::NSudoConsoleBenchmarkFormatLine(
+                Line,
+                sizeof(Line),
+                i));
+            if (Chunk.size() >= 64 * 1024 || i + 1 == LineCount)
+            {
+                if (!Pipe.Write(Chunk.data(), Chunk.size()))
+                {
+                    break;
+                }
+                Written += Chunk.size();
+                Chunk.clear();
+            }
+        }
+
+        Pipe.CloseWriter();
+    });
+
+    // The line terminators are counted as CRLF, the same as they are
+    // written.
+    std::uint64_t Lines = 0;
+    std::uint64_t Read = 0;
+
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    if (Buffered)
+    {
+        NSUDO_CONSOLE_BENCHMARK_SOURCE Source = { &Pipe, 0 };
+        CNSudoBufferedLineReader<char> Reader(
+            &::NSudoConsoleBenchmarkReadSource,
+            &Source);
+
+        const char* Line = nullptr;
+        std::size_t Length = 0;
+        while (Reader.ReadLine(Line, Length))
+        {
+            ++Lines;
+            Read += Length + 2;
+        }
+        Result.Calls = Source.Calls;
+    }
+    else
+    {
+        std::string Line;
+        char Character = '\0';
+        for (;;)
+        {
+            ++Result.Calls;
+            if (!Pipe.Read(&Character, 1))
+            {
+                break;
+            }
+
+            if (Character == '\n')
+            {
+                if (!Line.empty() && Line.back() == '\r')
+                {
+                    Line.pop_back();
+                }
+                ++Lines;
+                Read += Line.size() + 2;
+                Line.clear();
+            }
+            else
+            {
+                Line.push_back(Character);
+            }
+        }
+    }
+
+    Result.Seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - Start).count();
+
+    Producer.join();
+
+    Result.Bytes = (Lines == LineCount && Read == Written) ? Read : 0;
+
+    return Result;
+}
+
+/**
+ * @brief Prints a result of the benchmark.
+ * @param Name The name of the run.
+ * @param LineCount The number of the lines.
+ * @param Result The result.
+*/
+static void NSudoConsoleBenchmarkPrint(
+    const char* Name,
+    std::uint64_t LineCount,
+    NSUDO_CONSOLE_BENCHMARK_RESULT const& Result)
+{
+    std::printf(
+        "%-16s %10llu %10llu %10.1f %12.1f %10.1f\n",
+        Name,
+        static_cast<unsigned long long>(LineCount),
+        static_cast<unsigned long long>(Result.Calls),
+        Result.Seconds * 1000.0,
+        LineCount / Result.Seconds / 1000.0,
+        Result.Bytes / 1024.0 / 1024.0 / Result.Seconds);
+}
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t LineCount = 1000000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char* End = nullptr;
+        unsigned long long Value = 0;
+
+        if (0 == std::strncmp(argv[i], "-Lines:", 7))
+        {
+            Value = std::strtoull(argv[i] + 7, &End, 10);
+        }
+
+        if (!Value || !End || *End)
+        {
+            std::printf(
+                "Usage: NSudoConsoleBenchmark [-Lines:Count]\n"
+                "\n"
+                "Writes the lines to a pipe through the buffered writer of "
+                "the plugin host\n"
+                "and with a write for each line, reads them from a pipe "
+                "through the buffered\n"
+                "line reader and one character at a time, and reports the "
+                "time of each. The\n"
+                "default is 1000000 lines, and at most 100000 lines are "
+                "read one character\n"
+                "at a time.\n");
+            return EXIT_FAILURE;
+        }
+
+        LineCount = Value;
+    }
+
+    std::printf(
+        "%-16s %10s %10s %10s %12s %10s\n",
+        "Writer",
+        "Lines",
+        "Writes",
+        "ms",
+        "KLines/s",
+        "MiB/s");
+
+    int Result = EXIT_SUCCESS;
+
+    for (bool Buffered : { false, true })
+    {
+        NSUDO_CONSOLE_BENCHMARK_RESULT Current =
+            ::NSudoConsoleBenchmarkWrite(Buffered, LineCount);
+        if (!Current.Bytes)
+        {
+            std::printf("The pipe lost data.\n");
+            Result = EXIT_FAILURE;
+            continue;
+        }
+
+        ::NSudoConsoleBenchmarkPrint(
+            Buffered ? "Buffered" : "Line by line",
+            LineCount,
+            Current);
+    }
+
+    std::printf(
+        "\n%-16s %10s %10s %10s %12s %10s\n",
+        "Reader",
+        "Lines",
+        "Reads",
+        "ms",
+        "KLines/s",
+        "MiB/s");
+
+    for (bool Buffered : { false, true })
+    {
+        // Reading one character at a time makes a system call for each
+        // character, so it is measured with fewer lines.
+        std::uint64_t ReadLineCount =
+            (Buffered || LineCount < 100000) ? LineCount : 100000;
+
+        NSUDO_CONSOLE_BENCHMARK_RESULT Current =
+            ::NSudoConsoleBenchmarkRead(Buffered, ReadLineCount);
+        if (!Current.Bytes)
+        {
+            std::printf("The pipe lost data.\n");
+            Result = EXIT_FAILURE;
+            continue;
+        }
+
+        ::NSudoConsoleBenchmarkPrint(
+            Buffered ? "Buffered" : "Per character",
+            ReadLineCount,
+            Current);
+    }
+
+    return Result;
+}
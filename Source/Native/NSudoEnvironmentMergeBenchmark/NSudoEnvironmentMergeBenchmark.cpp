@@ -0,0 +1,327 @@
+﻿/*
+ * PROJECT:   NSudo Environment Merge Benchmark
+ * FILE:      NSudoEnvironmentMergeBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo Environment Merge Benchmark (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+// The benchmark only depends on the merge routine and the C++ standard
+// library, so it also builds on Linux, e.g.
+// g++ -std=c++14 -O2 -I../NSudoSDK NSudoEnvironmentMergeBenchmark.cpp
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <NSudoEnvironmentBlockMerge.h>
+
+/**
+ * @brief The case-insensitive order of the environment variable names, which
+ *        is used by the map based reference merge.
+*/
+struct NSudoEnvironmentMergeBenchmarkNameLess
+{
+    bool operator()(
+        std::wstring const& Left,
+        std::wstring const& Right) const
+    {
+        return ::NSudoCompareEnvironmentVariableNames(
+            Left.c_str(),
+            Left.size(),
+            Right.c_str(),
+            Right.size()) < 0;
+    }
+};
+
+/**
+ * @brief Merges the overrides by round-tripping the environment block
+ *        through a map, which is the approach the single pass merge avoids.
+ *        It is the reference for both the time and the result.
+ * @param Block The environment block, terminated by two null characters.
+ * @param Overrides The overrides in "Name=Value" form, terminated by two null
+ *                  characters.
+ * @return The merged environment block, in the same form as
+ *         NSudoMergeEnvironmentBlock.
+*/
+static std::wstring NSudoEnvironmentMergeBenchmarkMapMerge(
+    const wchar_t* Block,
+    const wchar_t* Overrides)
+{
+    std::map<
+        std::wstring,
+        std::wstring,
+        NSudoEnvironmentMergeBenchmarkNameLess> Variables;
+
+    auto Apply = [&](const wchar_t* Current, bool IsOverride)
+    {
+        while (*Current)
+        {
+            std::size_t Length = std::wcslen(Current);
+            std::size_t NameLength = ::NSudoGetEnvironmentVariableNameLength(
+                Current,
+                Length);
+            if (NameLength < Length)
+            {
+                std::wstring Name(Current, NameLength);
+                if (IsOverride && NameLength + 1 == Length)
+                {
+                    Variables.erase(Name);
+                }
+                else
+                {
+                    Variables[Name] = std::wstring(Current, Length);
+                }
+            }
+            Current += Length + 1;
+        }
+    };
+
+    Apply(Block, false);
+    Apply(Overrides, true);
+
+    std::wstring Result;
+    for (auto const& Variable : Variables)
+    {
+        Result.append(Variable.second.c_str(), Variable.second.size() + 1);
+    }
+    if (Result.empty())
+    {
+        Result.push_back(L'\0');
+    }
+
+    return Result;
+}
+
+/**
+ * @brief Creates a sorted environment block like the one returned by
+ *        CreateEnvironmentBlock, with a hidden variable at the beginning.
+ * @param VariableCount The number of the variables.
+ * @return The environment block, terminated by two null characters.
+*/
+static std::wstring NSudoEnvironmentMergeBenchmarkCreateBlock(
+    std::size_t VariableCount)
+{
+    std::wstring Block(L"=C:=C:\\Windows\\System32");
+    Block.push_back(L'\0');
+
+    for (std::size_t i = 0; i < VariableCount; ++i)
+    {
+        wchar_t Variable[96];
+        std::swprintf(
+            Variable,
+            96,
+            L"Variable%05zu=C:\\Program Files\\NSudo\\Value\\%05zu",
+            i * 2,
+            i);
+        Block.append(Variable, std::wcslen(Variable) + 1);
+    }
+
+    Block.push_back(L'\0');
+    return Block;
+}
+
+/**
+ * @brief Creates the overrides. Half of them replace existing variables, a
+ *        quarter of them add new variables and the others remove existing
+ *        variables.
+ * @param VariableCount The number of the variables of the block.
+ * @param OverrideCount The number of the overrides.
+ * @return The overrides, terminated by two null characters.
+*/
+static std::wstring NSudoEnvironmentMergeBenchmarkCreateOverrides(
+    std::size_t VariableCount,
+    std::size_t OverrideCount)
+{
+    std::wstring Overrides;
+
+    for (std::size_t i = 0; i < OverrideCount; ++i)
+    {
+        // Spread the overrides over the block, in reverse order so that they
+        // need to be sorted.
+        std::size_t Index = VariableCount
+            ? (OverrideCount - 1 - i) * VariableCount / OverrideCount
+            : i;
+
+        wchar_t Variable[96];
+        switch (i % 4)
+        {
+        case 0:
+        case 1:
+            std::swprintf(
+                Variable,
+                96,
+                L"VARIABLE%05zu=Overridden%05zu",
+                Index * 2,
+                i);
+            break;
+        case 2:
+            std::swprintf(
+                Variable,
+                96,
+                L"Variable%05zu=Added%05zu",
+                Index * 2 + 1,
+                i);
+            break;
+        default:
+            std::swprintf(Variable, 96, L"variable%05zu=", Index * 2);
+            break;
+        }
+        Overrides.append(Variable, std::wcslen(Variable) + 1);
+    }
+
+    Overrides.push_back(L'\0');
+    return Overrides;
+}
+
+/**
+ * @brief Measures a merge function.
+ * @param Iterations The number of the iterations.
+ * @param Merge The merge function, which returns the merged block.
+ * @param Result Receives the merged block of the last iteration.
+ * @return The average time of each iteration, in nanoseconds.
+*/
+template<typename MergeType>
+static double NSudoEnvironmentMergeBenchmarkMeasure(
+    std::uint64_t Iterations,
+    MergeType&& Merge,
+    std::wstring& Result)
+{
+    std::size_t Checksum = 0;
+
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    for (std::uint64_t i = 0; i < Iterations; ++i)
+    {
+        Result = Merge();
+        Checksum += Result.size();
+    }
+
+    std::chrono::steady_clock::time_point End =
+        std::chrono::steady_clock::now();
+
+    // Keep the results observable, so the iterations are not optimized out.
+    if (Checksum != Result.size() * Iterations)
+    {
+        std::printf("The merged block is not stable.\n");
+    }
+
+    return std::chrono::duration<double, std::nano>(End - Start).count()
+        / static_cast<double>(Iterations);
+}
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t Iterations = 2000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char* End = nullptr;
+        unsigned long long Value = 0;
+
+        if (0 == std::strncmp(argv[i], "-Iterations:", 12))
+        {
+            Value = std::strtoull(argv[i] + 12, &End, 10);
+        }
+
+        if (!Value || !End || *End)
+        {
+            std::printf(
+                "Usage: NSudoEnvironmentMergeBenchmark [-Iterations:Count]\n"
+                "\n"
+                "Merges the environment overrides into the environment "
+                "blocks of each size,\n"
+                "and reports the time of the single pass merge and of the "
+                "map round-trip.\n");
+            return EXIT_FAILURE;
+        }
+
+        Iterations = Value;
+    }
+
+    static const std::size_t VariableCounts[] = { 32, 128, 1024 };
+    static const std::size_t OverrideCounts[] = { 1, 8, 64 };
+
+    std::printf(
+        "%10s %10s %14s %14s %10s\n",
+        "Variables",
+        "Overrides",
+        "Merge (ns)",
+        "Map (ns)",
+        "Speedup");
+
+    int Result = EXIT_SUCCESS;
+
+    for (std::size_t VariableCount : VariableCounts)
+    {
+        std::wstring Block =
+            ::NSudoEnvironmentMergeBenchmarkCreateBlock(VariableCount);
+
+        for (std::size_t OverrideCount : OverrideCounts)
+        {
+            std::wstring Overrides =
+                ::NSudoEnvironmentMergeBenchmarkCreateOverrides(
+                    VariableCount,
+                    OverrideCount);
+
+            // The parsing of the overrides is measured, because it is done
+            // for each launch.
+            std::vector<NSudoEnvironmentVariableView> SortedOverrides;
+            std::wstring Merged;
+            double MergeTime = ::NSudoEnvironmentMergeBenchmarkMeasure(
+                Iterations,
+                [&]()
+                {
+                    ::NSudoParseEnvironmentOverrides(
+                        Overrides.c_str(),
+                        SortedOverrides);
+                    return ::NSudoMergeEnvironmentBlock(
+                        Block.c_str(),
+                        SortedOverrides);
+                },
+                Merged);
+
+            std::wstring Reference;
+            double MapTime = ::NSudoEnvironmentMergeBenchmarkMeasure(
+                Iterations,
+                [&]()
+                {
+                    return ::NSudoEnvironmentMergeBenchmarkMapMerge(
+                        Block.c_str(),
+                        Overrides.c_str());
+                },
+                Reference);
+
+            // The block is sorted, so both merges produce the same result.
+            if (Merged != Reference)
+            {
+                std::printf(
+                    "The merged block of %zu variables and %zu overrides "
+                    "differs from the reference.\n",
+                    VariableCount,
+                    OverrideCount);
+                Result = EXIT_FAILURE;
+                continue;
+            }
+
+            std::printf(
+                "%10zu %10zu %14.1f %14.1f %9.1fx\n",
+                VariableCount,
+                OverrideCount,
+                MergeTime,
+                MapTime,
+                MapTime / MergeTime);
+        }
+    }
+
+    return Result;
+}
@@ -0,0 +1,341 @@
+﻿/*
+ * PROJECT:   NSudo JSON Benchmark
+ * FILE:      NSudoJsonBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo JSON Benchmark
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <NSudoLauncherJson.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The reference reader uses its own copy of jsmn without the parent links,
+// which is how the launchers parsed the JSON files before the shared reader.
+#define JSMN_STATIC
+#include <jsmn.h>
+
+/**
+ * @brief Reads the members like the launchers did before the shared reader.
+ *        jsmn_parse is called once for counting the tokens and once more
+ *        into an allocation of exactly that many tokens.
+ * @param JsonString The UTF-8 JSON string without the BOM.
+ * @param ObjectName The name of the JSON objects.
+ * @param Members The members in the order of the JSON string.
+ * @return True if the JSON string is parsed.
+*/
+static bool NSudoJsonBenchmarkReadTwice(
+    std::string const& JsonString,
+    const char* ObjectName,
+    std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER>& Members)
+{
+    Members.clear();
+
+    jsmn_parser Parser;
+    ::jsmn_init(&Parser);
+    int TokenCount = ::jsmn_parse(
+        &Parser,
+        JsonString.c_str(),
+        JsonString.size(),
+        nullptr,
+        0);
+    if (TokenCount <= 0)
+    {
+        return false;
+    }
+
+    jsmntok_t* Tokens = reinterpret_cast<jsmntok_t*>(std::malloc(
+        TokenCount * sizeof(jsmntok_t)));
+    if (!Tokens)
+    {
+        return false;
+    }
+
+    ::jsmn_init(&Parser);
+    int TokensCount = ::jsmn_parse(
+        &Parser,
+        JsonString.c_str(),
+        JsonString.size(),
+        Tokens,
+        static_cast<unsigned int>(TokenCount));
+
+    std::size_t ObjectNameLength = std::strlen(ObjectName);
+
+    for (int i = 0; i + 1 < TokensCount; ++i)
+    {
+        const jsmntok_t& Name = Tokens[i];
+        const jsmntok_t& Object = Tokens[i + 1];
+
+        if (Name.type != JSMN_STRING ||
+            Object.type != JSMN_OBJECT ||
+            static_cast<std::size_t>(Name.end - Name.start)
+                != ObjectNameLength ||
+            0 != std::memcmp(
+                JsonString.c_str() + Name.start,
+                ObjectName,
+                ObjectNameLength))
+        {
+            continue;
+        }
+
+        int Current = i + 2;
+        for (int j = 0; j < Object.size && Current + 1 < TokensCount; ++j)
+        {
+            const jsmntok_t& Key = Tokens[Current];
+            const jsmntok_t& Value = Tokens[Current + 1];
+
+            if (Key.type == JSMN_STRING && Value.type == JSMN_STRING)
+            {
+                Members.emplace_back(
+                    std::string_view(
+                        JsonString.c_str() + Key.start,
+                        Key.end - Key.start),
+                    std::string_view(
+                        JsonString.c_str() + Value.start,
+                        Value.end - Value.start));
+            }
+
+            Current += 2;
+        }
+
+        i = Current - 1;
+    }
+
+    std::free(Tokens);
+
+    return TokensCount > 0;
+}
+
+/**
+ * @brief Creates a JSON string with an object of string members, in the
+ *        layout of NSudo.json or Translations.json.
+ * @param ObjectName The name of the object.
+ * @param MemberCount The number of the members.
+ * @param ValueLength The minimum length of each value, in bytes.
+ * @return The JSON string.
+*/
+static std::string NSudoJsonBenchmarkCreateInput(
+    const char* ObjectName,
+    std::size_t MemberCount,
+    std::size_t ValueLength)
+{
+    std::string JsonString = "{\n  \"";
+    JsonString.append(ObjectName);
+    JsonString.append("\": {\n");
+
+    for (std::size_t i = 0; i < MemberCount; ++i)
+    {
+        char Member[64];
+        std::snprintf(
+            Member,
+            sizeof(Member),
+            "    \"Name.%06zu \xE5\x91\xBD\xE4\xBB\xA4\": \"",
+            i);
+        JsonString.append(Member);
+
+        // The values contain escapes like the paths of the shortcuts.
+        std::string Value = "C:\\\\Windows\\\\System32\\\\";
+        while (Value.size() < ValueLength)
+        {
+            Value.append("Value \\\"quoted\\\" ");
+        }
+        JsonString.append(Value);
+        JsonString.append(i + 1 < MemberCount ? "\",\n" : "\"\n");
+    }
+
+    JsonString.append("  }\n}\n");
+    return JsonString;
+}
+
+/**
+ * @brief Measures a reader.
+ * @param Iterations The number of the iterations.
+ * @param Read The reader, which returns the number of the members or -1 if
+ *             the JSON string is not parsed.
+ * @param MemberCount Receives the number of the members.
+ * @return The average time of each iteration, in microseconds.
+*/
+template<typename ReadType>
+static double NSudoJsonBenchmarkMeasure(
+    std::uint64_t Iterations,
+    ReadType&& Read,
+    std::ptrdiff_t& MemberCount)
+{
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    for (std::uint64_t i = 0; i < Iterations; ++i)
+    {
+        MemberCount = Read();
+    }
+
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - Start).count()
+        / static_cast<double>(Iterations);
+}
+
+/**
+ * @brief An input which is measured by the benchmark.
+*/
+typedef struct _NSUDO_JSON_BENCHMARK_INPUT
+{
+    const char* Name;
+    const char* ObjectName;
+    std::size_t MemberCount;
+    std::size_t ValueLength;
+} NSUDO_JSON_BENCHMARK_INPUT;
+
+static const NSUDO_JSON_BENCHMARK_INPUT g_Inputs[] =
+{
+    // The shortcut lists. 255 members are 513 tokens, which is the smallest
+    // list that outgrows the token buffer on the stack.
+    { "NSudo.json", "ShortCutList_V2", 4, 16 },
+    { "NSudo.json", "ShortCutList_V2", 254, 16 },
+    { "NSudo.json", "ShortCutList_V2", 255, 16 },
+    { "NSudo.json", "ShortCutList_V2", 4096, 16 },
+    { "NSudo.json", "ShortCutList_V2", 65536, 16 },
+
+    // The translations have longer values.
+    { "Translations.json", "Translations", 32, 64 },
+    { "Translations.json", "Translations", 1024, 64 },
+    { "Translations.json", "Translations", 16384, 64 },
+};
+
+/**
+ * @brief The reference reader is quadratic for the large flat objects, it is
+ *        skipped for the inputs with more members.
+*/
+static const std::size_t g_MaxReadTwiceMemberCount = 4096;
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t Iterations = 50;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char* End = nullptr;
+        unsigned long long Value = 0;
+
+        if (0 == std::strncmp(argv[i], "-Iterations:", 12))
+        {
+            Value = std::strtoull(argv[i] + 12, &End, 10);
+        }
+
+        if (!Value || !End || *End)
+        {
+            std::printf(
+                "Usage: NSudoJsonBenchmark [-Iterations:Count]\n"
+                "\n"
+                "Reads the string members of generated NSudo.json and "
+                "Translations.json\n"
+                "files, and reports the time of the shared reader and of "
+                "the double parse.\n");
+            return EXIT_FAILURE;
+        }
+
+        Iterations = Value;
+    }
+
+    std::printf(
+        "%-18s %8s %8s %10s %12s %12s %10s\n",
+        "Input",
+        "Members",
+        "Tokens",
+        "KiB",
+        "Reader (us)",
+        "Twice (us)",
+        "MiB/s");
+
+    int Result = EXIT_SUCCESS;
+
+    for (NSUDO_JSON_BENCHMARK_INPUT const& Input : g_Inputs)
+    {
+        std::string JsonString = ::NSudoJsonBenchmarkCreateInput(
+            Input.ObjectName,
+            Input.MemberCount,
+            Input.ValueLength);
+
+        jsmn_parser Parser;
+        ::jsmn_init(&Parser);
+        int TokenCount = ::jsmn_parse(
+            &Parser,
+            JsonString.c_str(),
+            JsonString.size(),
+            nullptr,
+            0);
+
+        std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER> Members;
+
+        std::ptrdiff_t ReaderMembers = 0;
+        double ReaderTime = ::NSudoJsonBenchmarkMeasure(
+            Iterations,
+            [&]() -> std::ptrdiff_t
+            {
+                if (!::NSudoReadJsonStringMembers(
+                    JsonString,
+                    Input.ObjectName,
+                    Members))
+                {
+                    return -1;
+                }
+                return static_cast<std::ptrdiff_t>(Members.size());
+            },
+            ReaderMembers);
+
+        bool Valid = (ReaderMembers ==
+            static_cast<std::ptrdiff_t>(Input.MemberCount));
+
+        char ReadTwiceTime[32] = "-";
+        if (Input.MemberCount <= g_MaxReadTwiceMemberCount)
+        {
+            std::ptrdiff_t ReadTwiceMembers = 0;
+            double Time = ::NSudoJsonBenchmarkMeasure(
+                Iterations,
+                [&]() -> std::ptrdiff_t
+                {
+                    if (!::NSudoJsonBenchmarkReadTwice(
+                        JsonString,
+                        Input.ObjectName,
+                        Members))
+                    {
+                        return -1;
+                    }
+                    return static_cast<std::ptrdiff_t>(Members.size());
+                },
+                ReadTwiceMembers);
+            std::snprintf(ReadTwiceTime, sizeof(ReadTwiceTime), "%.1f", Time);
+
+            Valid = Valid && (ReadTwiceMembers == ReaderMembers);
+        }
+
+        if (!Valid)
+        {
+            std::printf(
+                "%-18s %8zu members are not read.\n",
+                Input.Name,
+                Input.MemberCount);
+            Result = EXIT_FAILURE;
+            continue;
+        }
+
+        std::printf(
+            "%-18s %8zu %8d %10.1f %12.1f %12s %10.1f\n",
+            Input.Name,
+            Input.MemberCount,
+            TokenCount,
+            JsonString.size() / 1024.0,
+            ReaderTime,
+            ReadTwiceTime,
+            JsonString.size() / ReaderTime / (1024.0 * 1024.0) * 1e6);
+    }
+
+    return Result;
+}
@@ -0,0 +1,677 @@
+﻿/*
+ * PROJECT:   NSudo Launch Benchmark
+ * FILE:      NSudoFakeLaunchBackend.h
+ * PURPOSE:   Definition for NSudo fake launch backend
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_FAKE_LAUNCH_BACKEND
+#define NSUDO_FAKE_LAUNCH_BACKEND
+
+#ifndef __cplusplus
+#error "[NSudoFakeLaunchBackend] You should use a C++ compiler."
+#endif
+
+#include <NSudoLaunchBackend.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief The calls of the launch backend, in the order of INSudoLaunchBackend.
+*/
+enum class NSUDO_LAUNCH_BACKEND_CALL
+{
+    OPEN_PROCESS_TOKEN,
+    DUPLICATE_TOKEN_EX,
+    LOOKUP_PRIVILEGE_VALUE,
+    ADJUST_TOKEN_PRIVILEGES,
+    ADJUST_TOKEN_ALL_PRIVILEGES,
+    SET_THREAD_TOKEN,
+    GET_ACTIVE_SESSION_ID,
+    GET_SESSION_LOGON_TIME,
+    CREATE_SYSTEM_TOKEN,
+    OPEN_SERVICE_PROCESS_TOKEN,
+    CREATE_SESSION_TOKEN,
+    CREATE_LUA_TOKEN,
+    GET_TOKEN_INFORMATION,
+    SET_TOKEN_INFORMATION,
+    SET_TOKEN_MANDATORY_LABEL,
+    CREATE_ENVIRONMENT_BLOCK,
+    DESTROY_ENVIRONMENT_BLOCK,
+    CREATE_PROCESS_AS_USER,
+    SET_PRIORITY_CLASS,
+    SET_PROCESS_AFFINITY_MASK,
+    SET_PROCESS_MEMORY_PRIORITY,
+    SET_PROCESS_IO_PRIORITY,
+    CREATE_JOB_OBJECT,
+    SET_INFORMATION_JOB_OBJECT,
+    ASSIGN_PROCESS_TO_JOB_OBJECT,
+    QUERY_INFORMATION_JOB_OBJECT,
+    RESUME_THREAD,
+    TERMINATE_PROCESS,
+    WAIT_FOR_SINGLE_OBJECT,
+    GET_EXIT_CODE_PROCESS,
+    DUPLICATE_HANDLE,
+    CLOSE_HANDLE,
+
+    COUNT
+};
+
+/**
+ * @brief The launch backend which never touches the system. The tokens, the
+ *        job objects and the processes are fake handles, and each call waits
+ *        for its configured latency to simulate the cost of the system call,
+ *        so the overhead of the launch path itself is the elapsed time minus
+ *        the simulated latency. The backend can be used from multiple
+ *        threads at the same time.
+*/
+class CNSudoFakeLaunchBackend : public INSudoLaunchBackend
+{
+private:
+
+    static const std::size_t CallCount = static_cast<std::size_t>(
+        NSUDO_LAUNCH_BACKEND_CALL::COUNT);
+
+    std::atomic<ULONGLONG> m_Latencies[CallCount];
+    std::atomic<ULONGLONG> m_Calls[CallCount];
+    std::atomic<ULONGLONG> m_SimulatedNanoseconds;
+
+    std::atomic<ULONG_PTR> m_NextHandle;
+    std::atomic<DWORD> m_NextClientId;
+    std::atomic<LONG> m_OpenHandles;
+
+    /**
+     * @brief Counts the call and waits for its latency. The latency is
+     *        spun on the high resolution clock, because the sleep functions
+     *        only have a resolution of milliseconds.
+     * @param Call The call.
+    */
+    void Simulate(
+        NSUDO_LAUNCH_BACKEND_CALL Call)
+    {
+        std::size_t Index = static_cast<std::size_t>(Call);
+
+        this->m_Calls[Index].fetch_add(1, std::memory_order_relaxed);
+
+        ULONGLONG Latency = this->m_Latencies[Index].load(
+            std::memory_order_relaxed);
+        if (!Latency)
+        {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point Start =
+            std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point Deadline =
+            Start + std::chrono::microseconds(Latency);
+        std::chrono::steady_clock::time_point Current = Start;
+        while (Current < Deadline)
+        {
+            YieldProcessor();
+            Current = std::chrono::steady_clock::now();
+        }
+
+        this->m_SimulatedNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Current - Start).count(),
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Creates a fake handle. The values are never null, never
+     *        INVALID_HANDLE_VALUE and never a pseudo handle.
+     * @return The fake handle.
+    */
+    HANDLE CreateHandle()
+    {
+        this->m_OpenHandles.fetch_add(1, std::memory_order_relaxed);
+        return reinterpret_cast<HANDLE>(this->m_NextHandle.fetch_add(
+            4,
+            std::memory_order_relaxed));
+    }
+
+public:
+
+    CNSudoFakeLaunchBackend() :
+        m_SimulatedNanoseconds(0),
+        m_NextHandle(0x10000),
+        m_NextClientId(0x1000),
+        m_OpenHandles(0)
+    {
+        for (std::size_t i = 0; i < CallCount; ++i)
+        {
+            this->m_Latencies[i] = 0;
+            this->m_Calls[i] = 0;
+        }
+    }
+
+    CNSudoFakeLaunchBackend(const CNSudoFakeLaunchBackend&) = delete;
+    CNSudoFakeLaunchBackend& operator=(
+        const CNSudoFakeLaunchBackend&) = delete;
+
+    /**
+     * @brief Sets the simulated latency of a call.
+     * @param Call The call.
+     * @param Microseconds The latency, in microseconds.
+    */
+    void SetLatency(
+        NSUDO_LAUNCH_BACKEND_CALL Call,
+        ULONGLONG Microseconds)
+    {
+        this->m_Latencies[static_cast<std::size_t>(Call)] = Microseconds;
+    }
+
+    /**
+     * @brief Sets the simulated latency of all calls.
+     * @param Microseconds The latency, in microseconds.
+    */
+    void SetAllLatencies(
+        ULONGLONG Microseconds)
+    {
+        for (std::size_t i = 0; i < CallCount; ++i)
+        {
+            this->m_Latencies[i] = Microseconds;
+        }
+    }
+
+    /**
+     * @brief Gets the number of times a call has been made.
+     * @param Call The call.
+     * @return The number of times the call has been made.
+    */
+    ULONGLONG GetCallCount(
+        NSUDO_LAUNCH_BACKEND_CALL Call) const
+    {
+        return this->m_Calls[static_cast<std::size_t>(Call)].load();
+    }
+
+    /**
+     * @brief Gets the total time spent in the simulated latencies.
+     * @return The total time spent in the simulated latencies, in
+     *         nanoseconds.
+    */
+    ULONGLONG GetSimulatedNanoseconds() const
+    {
+        return this->m_SimulatedNanoseconds.load();
+    }
+
+    /**
+     * @brief Gets the number of fake handles which have not been closed.
+     * @return The number of fake handles which have not been closed.
+    */
+    LONG GetOpenHandles() const
+    {
+        return this->m_OpenHandles.load();
+    }
+
+    /**
+     * @brief Resets the call counts and the simulated time. The latencies
+     *        are kept.
+    */
+    void ResetStatistics()
+    {
+        for (std::size_t i = 0; i < CallCount; ++i)
+        {
+            this->m_Calls[i] = 0;
+        }
+        this->m_SimulatedNanoseconds = 0;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE OpenProcessToken(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(DesiredAccess);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::OPEN_PROCESS_TOKEN);
+        *TokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateTokenEx(
+        _In_ HANDLE ExistingTokenHandle,
+        _In_ DWORD DesiredAccess,
+        _In_ SECURITY_IMPERSONATION_LEVEL ImpersonationLevel,
+        _In_ TOKEN_TYPE TokenType,
+        _Out_ PHANDLE NewTokenHandle)
+    {
+        UNREFERENCED_PARAMETER(ExistingTokenHandle);
+        UNREFERENCED_PARAMETER(DesiredAccess);
+        UNREFERENCED_PARAMETER(ImpersonationLevel);
+        UNREFERENCED_PARAMETER(TokenType);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::DUPLICATE_TOKEN_EX);
+        *NewTokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE LookupPrivilegeValueW(
+        _In_ LPCWSTR Name,
+        _Out_ PLUID Luid)
+    {
+        UNREFERENCED_PARAMETER(Name);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::LOOKUP_PRIVILEGE_VALUE);
+        Luid->LowPart = SE_DEBUG_PRIVILEGE;
+        Luid->HighPart = 0;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ PLUID_AND_ATTRIBUTES Privileges,
+        _In_ DWORD PrivilegeCount)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(Privileges);
+        UNREFERENCED_PARAMETER(PrivilegeCount);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::ADJUST_TOKEN_PRIVILEGES);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenAllPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD Attributes)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(Attributes);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::ADJUST_TOKEN_ALL_PRIVILEGES);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetThreadToken(
+        _In_opt_ HANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_THREAD_TOKEN);
+        return S_OK;
+    }
+
+    virtual DWORD STDMETHODCALLTYPE GetActiveSessionID()
+    {
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::GET_ACTIVE_SESSION_ID);
+        return 1;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetSessionLogonTime(
+        _In_ DWORD SessionId,
+        _Out_ PLARGE_INTEGER LogonTime)
+    {
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::GET_SESSION_LOGON_TIME);
+        LogonTime->QuadPart = SessionId;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSystemToken(
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(DesiredAccess);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_SYSTEM_TOKEN);
+        *TokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE OpenServiceProcessToken(
+        _In_ LPCWSTR ServiceName,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(ServiceName);
+        UNREFERENCED_PARAMETER(DesiredAccess);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::OPEN_SERVICE_PROCESS_TOKEN);
+        *TokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSessionToken(
+        _In_ DWORD SessionId,
+        _Out_ PHANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(SessionId);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_SESSION_TOKEN);
+        *TokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateLUAToken(
+        _In_ HANDLE ExistingTokenHandle,
+        _Out_ PHANDLE TokenHandle)
+    {
+        UNREFERENCED_PARAMETER(ExistingTokenHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_LUA_TOKEN);
+        *TokenHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _Out_opt_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength,
+        _Out_ PDWORD ReturnLength)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::GET_TOKEN_INFORMATION);
+
+        if (TokenUser == TokenInformationClass)
+        {
+            // All fake tokens belong to the local system account, which is
+            // S-1-5-18.
+            *ReturnLength = sizeof(TOKEN_USER) + sizeof(SID);
+            if (!TokenInformation || TokenInformationLength < *ReturnLength)
+            {
+                return Mile::HResult::FromWin32(ERROR_INSUFFICIENT_BUFFER);
+            }
+
+            PTOKEN_USER User = reinterpret_cast<PTOKEN_USER>(
+                TokenInformation);
+            PSID Sid = reinterpret_cast<PSID>(&User[1]);
+            SID_IDENTIFIER_AUTHORITY NtAuthority = SECURITY_NT_AUTHORITY;
+
+            ::InitializeSid(Sid, &NtAuthority, 1);
+            *::GetSidSubAuthority(Sid, 0) = SECURITY_LOCAL_SYSTEM_RID;
+
+            User->User.Sid = Sid;
+            User->User.Attributes = 0;
+            return S_OK;
+        }
+        else if (TokenSessionId == TokenInformationClass)
+        {
+            *ReturnLength = sizeof(DWORD);
+            if (!TokenInformation || TokenInformationLength < *ReturnLength)
+            {
+                return Mile::HResult::FromWin32(ERROR_INSUFFICIENT_BUFFER);
+            }
+
+            *reinterpret_cast<PDWORD>(TokenInformation) = 1;
+            return S_OK;
+        }
+        else if (TokenLinkedToken == TokenInformationClass)
+        {
+            *ReturnLength = sizeof(TOKEN_LINKED_TOKEN);
+            if (!TokenInformation || TokenInformationLength < *ReturnLength)
+            {
+                return Mile::HResult::FromWin32(ERROR_INSUFFICIENT_BUFFER);
+            }
+
+            reinterpret_cast<PTOKEN_LINKED_TOKEN>(
+                TokenInformation)->LinkedToken = this->CreateHandle();
+            return S_OK;
+        }
+
+        *ReturnLength = 0;
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _In_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(TokenInformationClass);
+        UNREFERENCED_PARAMETER(TokenInformation);
+        UNREFERENCED_PARAMETER(TokenInformationLength);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_TOKEN_INFORMATION);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenMandatoryLabel(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD MandatoryLabelRid)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(MandatoryLabelRid);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_TOKEN_MANDATORY_LABEL);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateEnvironmentBlock(
+        _Out_ LPVOID* Environment,
+        _In_opt_ HANDLE TokenHandle,
+        _In_ BOOL Inherit)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(Inherit);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_ENVIRONMENT_BLOCK);
+
+        // The block is terminated by two null characters.
+        static const wchar_t FakeBlock[] =
+            L"COMPUTERNAME=NSUDO\0"
+            L"SystemRoot=C:\\Windows\0"
+            L"USERNAME=SYSTEM\0";
+
+        *Environment = Mile::HeapMemory::Allocate(sizeof(FakeBlock));
+        if (!*Environment)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        std::memcpy(*Environment, FakeBlock, sizeof(FakeBlock));
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DestroyEnvironmentBlock(
+        _In_ LPVOID Environment)
+    {
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::DESTROY_ENVIRONMENT_BLOCK);
+        Mile::HeapMemory::Free(Environment);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateProcessAsUserW(
+        _In_opt_ HANDLE TokenHandle,
+        _Inout_ LPWSTR CommandLine,
+        _In_ BOOL InheritHandles,
+        _In_ DWORD CreationFlags,
+        _In_opt_ LPVOID Environment,
+        _In_opt_ LPCWSTR CurrentDirectory,
+        _In_ LPSTARTUPINFOW StartupInfo,
+        _Out_ LPPROCESS_INFORMATION ProcessInformation)
+    {
+        UNREFERENCED_PARAMETER(TokenHandle);
+        UNREFERENCED_PARAMETER(CommandLine);
+        UNREFERENCED_PARAMETER(InheritHandles);
+        UNREFERENCED_PARAMETER(CreationFlags);
+        UNREFERENCED_PARAMETER(Environment);
+        UNREFERENCED_PARAMETER(CurrentDirectory);
+        UNREFERENCED_PARAMETER(StartupInfo);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_PROCESS_AS_USER);
+
+        ProcessInformation->hProcess = this->CreateHandle();
+        ProcessInformation->hThread = this->CreateHandle();
+        ProcessInformation->dwProcessId = this->m_NextClientId.fetch_add(
+            4,
+            std::memory_order_relaxed);
+        ProcessInformation->dwThreadId = this->m_NextClientId.fetch_add(
+            4,
+            std::memory_order_relaxed);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPriorityClass(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD PriorityClass)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(PriorityClass);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_PRIORITY_CLASS);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessAffinityMask(
+        _In_ HANDLE ProcessHandle,
+        _In_ KAFFINITY AffinityMask)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(AffinityMask);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_PROCESS_AFFINITY_MASK);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessMemoryPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG MemoryPriority)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(MemoryPriority);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_PROCESS_MEMORY_PRIORITY);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessIoPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG IoPriority)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(IoPriority);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_PROCESS_IO_PRIORITY);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateJobObject(
+        _Out_ PHANDLE JobHandle)
+    {
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CREATE_JOB_OBJECT);
+        *JobHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _In_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength)
+    {
+        UNREFERENCED_PARAMETER(JobHandle);
+        UNREFERENCED_PARAMETER(JobObjectInformationClass);
+        UNREFERENCED_PARAMETER(JobObjectInformation);
+        UNREFERENCED_PARAMETER(JobObjectInformationLength);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::SET_INFORMATION_JOB_OBJECT);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AssignProcessToJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ HANDLE ProcessHandle)
+    {
+        UNREFERENCED_PARAMETER(JobHandle);
+        UNREFERENCED_PARAMETER(ProcessHandle);
+
+        this->Simulate(
+            NSUDO_LAUNCH_BACKEND_CALL::ASSIGN_PROCESS_TO_JOB_OBJECT);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _Out_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength)
+    {
+        UNREFERENCED_PARAMETER(JobHandle);
+        UNREFERENCED_PARAMETER(JobObjectInformationClass);
+
+        this->Simulate(
+            NSUDO_LAUNCH_BACKEND_CALL::QUERY_INFORMATION_JOB_OBJECT);
+        std::memset(JobObjectInformation, 0, JobObjectInformationLength);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ResumeThread(
+        _In_ HANDLE ThreadHandle)
+    {
+        UNREFERENCED_PARAMETER(ThreadHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::RESUME_THREAD);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE TerminateProcess(
+        _In_ HANDLE ProcessHandle,
+        _In_ UINT ExitCode)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+        UNREFERENCED_PARAMETER(ExitCode);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::TERMINATE_PROCESS);
+        return S_OK;
+    }
+
+    virtual DWORD STDMETHODCALLTYPE WaitForSingleObject(
+        _In_ HANDLE Handle,
+        _In_ DWORD Milliseconds)
+    {
+        UNREFERENCED_PARAMETER(Handle);
+        UNREFERENCED_PARAMETER(Milliseconds);
+
+        // The fake processes exit as soon as they are waited for.
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::WAIT_FOR_SINGLE_OBJECT);
+        return WAIT_OBJECT_0;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetExitCodeProcess(
+        _In_ HANDLE ProcessHandle,
+        _Out_ LPDWORD ExitCode)
+    {
+        UNREFERENCED_PARAMETER(ProcessHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::GET_EXIT_CODE_PROCESS);
+        *ExitCode = 0;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateHandle(
+        _In_ HANDLE SourceHandle,
+        _Out_ PHANDLE TargetHandle)
+    {
+        UNREFERENCED_PARAMETER(SourceHandle);
+
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::DUPLICATE_HANDLE);
+        *TargetHandle = this->CreateHandle();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CloseHandle(
+        _In_ HANDLE Handle)
+    {
+        this->Simulate(NSUDO_LAUNCH_BACKEND_CALL::CLOSE_HANDLE);
+
+        if (!Handle || INVALID_HANDLE_VALUE == Handle)
+        {
+            return Mile::HResult::FromWin32(ERROR_INVALID_HANDLE);
+        }
+
+        this->m_OpenHandles.fetch_sub(1, std::memory_order_relaxed);
+        return S_OK;
+    }
+};
+
+#endif // !NSUDO_FAKE_LAUNCH_BACKEND
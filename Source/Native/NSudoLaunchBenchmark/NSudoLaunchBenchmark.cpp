@@ -0,0 +1,313 @@
+﻿/*
+ * PROJECT:   NSudo Launch Benchmark
+ * FILE:      NSudoLaunchBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo Launch Benchmark
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <Mile.Windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+#include <NSudoDerivedTokenCache.h>
+
+#include "Mile.Project.Properties.h"
+#include "NSudoFakeLaunchBackend.h"
+
+/**
+ * @brief The names of the launch backend calls, which are used by the
+ *        -Latency option. The index of the name is the value of the call.
+*/
+static const wchar_t* const g_CallNames[] =
+{
+    L"OpenProcessToken",
+    L"DuplicateTokenEx",
+    L"LookupPrivilegeValue",
+    L"AdjustTokenPrivileges",
+    L"AdjustTokenAllPrivileges",
+    L"SetThreadToken",
+    L"GetActiveSessionID",
+    L"GetSessionLogonTime",
+    L"CreateSystemToken",
+    L"OpenServiceProcessToken",
+    L"CreateSessionToken",
+    L"CreateLUAToken",
+    L"GetTokenInformation",
+    L"SetTokenInformation",
+    L"SetTokenMandatoryLabel",
+    L"CreateEnvironmentBlock",
+    L"DestroyEnvironmentBlock",
+    L"CreateProcessAsUser",
+    L"SetPriorityClass",
+    L"SetProcessAffinityMask",
+    L"SetProcessMemoryPriority",
+    L"SetProcessIoPriority",
+    L"CreateJobObject",
+    L"SetInformationJobObject",
+    L"AssignProcessToJobObject",
+    L"QueryInformationJobObject",
+    L"ResumeThread",
+    L"TerminateProcess",
+    L"WaitForSingleObject",
+    L"GetExitCodeProcess",
+    L"DuplicateHandle",
+    L"CloseHandle"
+};
+
+static_assert(
+    sizeof(g_CallNames) / sizeof(*g_CallNames) ==
+    static_cast<std::size_t>(NSUDO_LAUNCH_BACKEND_CALL::COUNT),
+    "The names of the launch backend calls are incomplete.");
+
+/**
+ * @brief A user mode which is measured by the benchmark.
+*/
+typedef struct _NSUDO_LAUNCH_BENCHMARK_SCENARIO
+{
+    const wchar_t* Name;
+    NSUDO_USER_MODE_TYPE UserModeType;
+} NSUDO_LAUNCH_BENCHMARK_SCENARIO;
+
+static const NSUDO_LAUNCH_BENCHMARK_SCENARIO g_Scenarios[] =
+{
+    { L"TrustedInstaller", NSUDO_USER_MODE_TYPE::TRUSTED_INSTALLER },
+    { L"System", NSUDO_USER_MODE_TYPE::SYSTEM },
+    { L"CurrentUser", NSUDO_USER_MODE_TYPE::CURRENT_USER },
+    { L"CurrentProcess", NSUDO_USER_MODE_TYPE::CURRENT_PROCESS },
+    {
+        L"CurrentProcessDropRight",
+        NSUDO_USER_MODE_TYPE::CURRENT_PROCESS_DROP_RIGHT
+    },
+    { L"CurrentUserElevated", NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED }
+};
+
+/**
+ * @brief Parses an unsigned decimal integer.
+ * @param String The string.
+ * @param Value Receives the value.
+ * @return True if the whole string is an unsigned decimal integer.
+*/
+static bool NSudoLaunchBenchmarkParseNumber(
+    const wchar_t* String,
+    ULONGLONG& Value)
+{
+    wchar_t* End = nullptr;
+    Value = std::wcstoull(String, &End, 10);
+    return *String && !*End;
+}
+
+/**
+ * @brief Parses the -Latency option. The parameter is the latency of all
+ *        calls, or the name of a call and its latency separated by '='.
+ * @param Parameter The parameter of the option.
+ * @param Backend The fake launch backend.
+ * @return True if the parameter is valid.
+*/
+static bool NSudoLaunchBenchmarkParseLatency(
+    const std::wstring& Parameter,
+    CNSudoFakeLaunchBackend& Backend)
+{
+    ULONGLONG Latency = 0;
+
+    std::wstring::size_type Separator = Parameter.find(L'=');
+    if (Separator == std::wstring::npos)
+    {
+        if (!::NSudoLaunchBenchmarkParseNumber(Parameter.c_str(), Latency))
+        {
+            return false;
+        }
+
+        Backend.SetAllLatencies(Latency);
+        return true;
+    }
+
+    if (!::NSudoLaunchBenchmarkParseNumber(
+        Parameter.c_str() + Separator + 1,
+        Latency))
+    {
+        return false;
+    }
+
+    std::wstring Name = Parameter.substr(0, Separator);
+    for (std::size_t i = 0; i < _countof(g_CallNames); ++i)
+    {
+        if (0 == ::_wcsicmp(Name.c_str(), g_CallNames[i]))
+        {
+            Backend.SetLatency(
+                static_cast<NSUDO_LAUNCH_BACKEND_CALL>(i),
+                Latency);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main()
+{
+    std::wprintf(
+        L"NSudo Launch Benchmark " MILE_PROJECT_VERSION_STRING L" (Build "
+        MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")" L"\r\n"
+        L"(c) M2-Team. All rights reserved.\r\n"
+        L"\r\n");
+
+    // The fake backend is used by the caches of the launch path, so it
+    // outlives all launches and the caches are invalidated before exit.
+    static CNSudoFakeLaunchBackend Backend;
+
+    ULONGLONG Iterations = 10000;
+
+    std::vector<std::wstring> Arguments = Mile::SpiltCommandLine(
+        std::wstring(::GetCommandLineW()));
+    for (std::size_t i = 1; i < Arguments.size(); ++i)
+    {
+        bool Valid = false;
+
+        if (0 == ::_wcsnicmp(Arguments[i].c_str(), L"-Iterations:", 12))
+        {
+            Valid = ::NSudoLaunchBenchmarkParseNumber(
+                Arguments[i].c_str() + 12,
+                Iterations) && Iterations;
+        }
+        else if (0 == ::_wcsnicmp(Arguments[i].c_str(), L"-Latency:", 9))
+        {
+            Valid = ::NSudoLaunchBenchmarkParseLatency(
+                Arguments[i].substr(9),
+                Backend);
+        }
+
+        if (!Valid)
+        {
+            std::wprintf(
+                L"Usage: NSudoLaunchBenchmark [-Iterations:Count]\r\n"
+                L"           [-Latency:Microseconds]"
+                L" [-Latency:Call=Microseconds] ...\r\n"
+                L"\r\n"
+                L"-Latency:Microseconds sets the simulated latency of all"
+                L" calls, and\r\n"
+                L"-Latency:Call=Microseconds sets the simulated latency of"
+                L" one call, e.g.\r\n"
+                L"-Latency:CreateProcessAsUser=2000. The options are"
+                L" applied in order.\r\n");
+            return ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    std::wprintf(
+        L"%-24s %12s %12s %12s %10s %8s\r\n",
+        L"Scenario",
+        L"Total (us)",
+        L"Overhead(us)",
+        L"Calls",
+        L"Hits",
+        L"Leaked");
+
+    int Result = 0;
+
+    for (const NSUDO_LAUNCH_BENCHMARK_SCENARIO& Scenario : g_Scenarios)
+    {
+        // Each scenario starts with cold caches, so the first launch of the
+        // cacheable user modes is a miss.
+        ::NSudoInvalidateDerivedTokenCache();
+        ::NSudoInvalidateEnvironmentBlockCache();
+        Backend.ResetStatistics();
+
+        CNSudoDerivedTokenCache& Cache =
+            CNSudoDerivedTokenCache::GetInstance();
+
+        LONG PreviousHits = 0;
+        LONG PreviousMisses = 0;
+        Cache.GetStatistics(&PreviousHits, &PreviousMisses);
+
+        LONG OpenHandles = Backend.GetOpenHandles();
+        ULONGLONG Failures = 0;
+
+        std::chrono::steady_clock::time_point Start =
+            std::chrono::steady_clock::now();
+
+        for (ULONGLONG i = 0; i < Iterations; ++i)
+        {
+            NSUDO_CREATE_PROCESS_OPTIONS Options = { 0 };
+            Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+
+            if (S_OK != ::NSudoCreateProcessWithBackend(
+                &Backend,
+                Scenario.UserModeType,
+                NSUDO_PRIVILEGES_MODE_TYPE::DEFAULT,
+                NSUDO_MANDATORY_LABEL_TYPE::SYSTEM,
+                NSUDO_PROCESS_PRIORITY_CLASS_TYPE::NORMAL,
+                NSUDO_SHOW_WINDOW_MODE_TYPE::DEFAULT,
+                INFINITE,
+                TRUE,
+                L"cmd.exe",
+                nullptr,
+                &Options))
+            {
+                ++Failures;
+            }
+        }
+
+        std::chrono::steady_clock::time_point End =
+            std::chrono::steady_clock::now();
+
+        ULONGLONG TotalNanoseconds = static_cast<ULONGLONG>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                End - Start).count());
+        ULONGLONG SimulatedNanoseconds = Backend.GetSimulatedNanoseconds();
+        ULONGLONG OverheadNanoseconds =
+            TotalNanoseconds > SimulatedNanoseconds
+            ? TotalNanoseconds - SimulatedNanoseconds
+            : 0;
+
+        ULONGLONG Calls = 0;
+        for (std::size_t i = 0; i < _countof(g_CallNames); ++i)
+        {
+            Calls += Backend.GetCallCount(
+                static_cast<NSUDO_LAUNCH_BACKEND_CALL>(i));
+        }
+
+        LONG Hits = 0;
+        LONG Misses = 0;
+        Cache.GetStatistics(&Hits, &Misses);
+
+        // The derived token cache keeps its own duplicated handles until it
+        // is invalidated.
+        ::NSudoInvalidateDerivedTokenCache();
+        LONG LeakedHandles = Backend.GetOpenHandles() - OpenHandles;
+
+        std::wprintf(
+            L"%-24s %12.3f %12.3f %12.1f %10ld %8ld\r\n",
+            Scenario.Name,
+            TotalNanoseconds / 1000.0 / Iterations,
+            OverheadNanoseconds / 1000.0 / Iterations,
+            static_cast<double>(Calls) / Iterations,
+            Hits - PreviousHits,
+            LeakedHandles);
+
+        if (Failures)
+        {
+            std::wprintf(
+                L"%-24s %llu of %llu launches failed.\r\n",
+                L"",
+                Failures,
+                Iterations);
+            Result = ERROR_GEN_FAILURE;
+        }
+
+        if (LeakedHandles)
+        {
+            Result = ERROR_GEN_FAILURE;
+        }
+    }
+
+    ::NSudoInvalidateEnvironmentBlockCache();
+
+    return Result;
+}
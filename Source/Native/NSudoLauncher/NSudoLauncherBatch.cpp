@@ -0,0 +1,43 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherBatch.cpp
+ * PURPOSE:   Implementation for NSudo Launcher batch mode commands
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoLauncherBatch.h"
+
+#include <Mile.Windows.h>
+
+NSUDO_LAUNCHER_BATCH_RESULT NSudoLaunchBatchCommand(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_LAUNCHER_BATCH_SETTINGS const& Settings,
+    _In_ std::wstring const& CommandLine)
+{
+    NSUDO_LAUNCHER_BATCH_RESULT Result = { 0 };
+
+    NSUDO_CREATE_PROCESS_OPTIONS Options = Settings.Options;
+
+    ULONGLONG StartTick = Mile::GetTickCount();
+
+    Result.Result = ::NSudoCreateProcessWithBackend(
+        Backend,
+        Settings.UserModeType,
+        Settings.PrivilegesModeType,
+        Settings.MandatoryLabelType,
+        Settings.ProcessPriorityClassType,
+        Settings.ShowWindowModeType,
+        INFINITE,
+        Settings.CreateNewConsole,
+        CommandLine.c_str(),
+        Settings.CurrentDirectory,
+        &Options);
+    Result.ExitCode = Options.ExitCode;
+    Result.JobAccounting = Options.JobAccounting;
+    Result.Duration = Mile::GetTickCount() - StartTick;
+
+    return Result;
+}
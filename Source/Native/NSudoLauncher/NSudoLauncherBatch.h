@@ -0,0 +1,60 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherBatch.h
+ * PURPOSE:   Definition for NSudo Launcher batch mode commands
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_BATCH
+#define NSUDO_LAUNCHER_BATCH
+
+#include "NSudoAPI.h"
+#include "NSudoLaunchBackend.h"
+
+#include <string>
+
+/**
+ * @brief The settings shared by all commands in the batch mode.
+*/
+typedef struct _NSUDO_LAUNCHER_BATCH_SETTINGS
+{
+    NSUDO_USER_MODE_TYPE UserModeType;
+    NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType;
+    NSUDO_MANDATORY_LABEL_TYPE MandatoryLabelType;
+    NSUDO_PROCESS_PRIORITY_CLASS_TYPE ProcessPriorityClassType;
+    NSUDO_SHOW_WINDOW_MODE_TYPE ShowWindowModeType;
+    BOOL CreateNewConsole;
+    LPCWSTR CurrentDirectory;
+    NSUDO_CREATE_PROCESS_OPTIONS Options;
+    bool UseJobObject;
+} NSUDO_LAUNCHER_BATCH_SETTINGS, *PNSUDO_LAUNCHER_BATCH_SETTINGS;
+
+/**
+ * @brief The result of a command in the batch mode.
+*/
+typedef struct _NSUDO_LAUNCHER_BATCH_RESULT
+{
+    HRESULT Result;
+    DWORD ExitCode;
+    ULONGLONG Duration;
+    NSUDO_JOB_ACCOUNTING_INFORMATION JobAccounting;
+} NSUDO_LAUNCHER_BATCH_RESULT, *PNSUDO_LAUNCHER_BATCH_RESULT;
+
+/**
+ * @brief Launches a command of the batch mode and waits for it to exit. It
+ *        is called from the worker threads of the batch scheduler, each call
+ *        uses its own copy of the shared options.
+ * @param Backend The launch backend.
+ * @param Settings The settings shared by all commands.
+ * @param CommandLine The command line, with the shortcuts translated.
+ * @return The result of the command.
+*/
+NSUDO_LAUNCHER_BATCH_RESULT NSudoLaunchBatchCommand(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_LAUNCHER_BATCH_SETTINGS const& Settings,
+    _In_ std::wstring const& CommandLine);
+
+#endif // !NSUDO_LAUNCHER_BATCH
@@ -0,0 +1,113 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherBatchScheduler.h
+ * PURPOSE:   Definition for NSudo Launcher batch scheduler
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_BATCH_SCHEDULER
+#define NSUDO_LAUNCHER_BATCH_SCHEDULER
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Runs a batch of items with a bounded number of items in flight, and
+ *        reports the results in the input order. The scheduler only depends
+ *        on the C++ standard library, so it can be driven by a fake launcher.
+ * @param ItemCount The number of items in the batch.
+ * @param MaxParallel The maximum number of items running at the same time.
+ *                    If it is zero, one item is run at a time.
+ * @param Launcher The callable which runs an item. It is called as
+ *                 ResultType Launcher(std::size_t Index) from the worker
+ *                 threads, so it needs to be thread safe.
+ * @param Reporter The callable which reports the result of an item. It is
+ *                 called as void Reporter(std::size_t Index, ResultType&)
+ *                 from the calling thread, once per item in the input order,
+ *                 as soon as the item and all its predecessors are finished.
+*/
+template<typename ResultType, typename LauncherType, typename ReporterType>
+void NSudoRunBatch(
+    std::size_t ItemCount,
+    std::size_t MaxParallel,
+    LauncherType&& Launcher,
+    ReporterType&& Reporter)
+{
+    if (!ItemCount)
+    {
+        return;
+    }
+
+    if (!MaxParallel)
+    {
+        MaxParallel = 1;
+    }
+    if (MaxParallel > ItemCount)
+    {
+        MaxParallel = ItemCount;
+    }
+
+    std::mutex Mutex;
+    std::condition_variable FinishedEvent;
+    std::size_t NextItem = 0;
+    std::vector<ResultType> Results(ItemCount);
+    std::vector<bool> Finished(ItemCount, false);
+
+    auto Worker = [&]()
+    {
+        for (;;)
+        {
+            std::size_t Index;
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                if (NextItem >= ItemCount)
+                {
+                    break;
+                }
+                Index = NextItem++;
+            }
+
+            ResultType Result = Launcher(Index);
+
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Results[Index] = std::move(Result);
+                Finished[Index] = true;
+            }
+            FinishedEvent.notify_one();
+        }
+    };
+
+    std::vector<std::thread> Workers;
+    Workers.reserve(MaxParallel);
+    for (std::size_t i = 0; i < MaxParallel; ++i)
+    {
+        Workers.emplace_back(Worker);
+    }
+
+    for (std::size_t Index = 0; Index < ItemCount; ++Index)
+    {
+        ResultType Result;
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            FinishedEvent.wait(Lock, [&]() { return Finished[Index]; });
+            Result = std::move(Results[Index]);
+        }
+
+        Reporter(Index, Result);
+    }
+
+    for (std::thread& Item : Workers)
+    {
+        Item.join();
+    }
+}
+
+#endif // !NSUDO_LAUNCHER_BATCH_SCHEDULER
@@ -37,117 +37,16 @@
 #include <vector>
 
 #include "Mile.Project.Properties.h"
+#include "NSudoLauncherBatch.h"
+#include "NSudoLauncherBatchScheduler.h"
 #include "NSudoLauncherCUIResource.h"
+#include "NSudoLauncherJobReport.h"
+#include "NSudoLauncherProfiles.h"
+#include "NSudoLauncherShortCuts.h"
+#include "NSudoTranslationTable.h"
 
 #include <NSudoLauncherResources.h>
 
-// 为编译通过而禁用的警告
-#if _MSC_VER >= 1200
-#pragma warning(push)
-#pragma warning(disable:4505) // 未引用的本地函数已移除(等级 4)
-#endif
-
-#include "jsmn.h"
-
-bool JsmnParseJson(
-    _Out_ jsmntok_t** JsonTokens,
-    _Out_ std::int32_t* JsonTokensCount,
-    _In_ const char* JsonString,
-    _In_ std::size_t JsonStringLength)
-{
-    if (!(JsonTokens && JsonTokensCount && JsonString && JsonStringLength))
-    {
-        return false;
-    }
-
-    *JsonTokens = nullptr;
-    *JsonTokensCount = 0;
-
-    jsmn_parser Parser;
-
-    ::jsmn_init(&Parser);
-    std::int32_t TokenCount = ::jsmn_parse(
-        &Parser, JsonString, JsonStringLength, nullptr, 0);
-
-    jsmntok_t* Tokens = reinterpret_cast<jsmntok_t*>(::malloc(
-        TokenCount * sizeof(jsmntok_t)));
-    if (Tokens)
-    {
-        ::jsmn_init(&Parser);
-        std::int32_t TokensCount = ::jsmn_parse(
-            &Parser, JsonString, JsonStringLength, Tokens, TokenCount);
-        if (TokensCount > 0)
-        {
-            *JsonTokens = Tokens;
-            *JsonTokensCount = TokensCount;
-        }
-        else
-        {
-            ::free(Tokens);
-        }
-    }
-
-    return Tokens;
-}
-
-typedef struct _JSON_TOKEN_INFO
-{
-    jsmntype_t Type;
-    const char* Name;
-    std::size_t NameLength;
-    int Size;
-} JSON_TOKEN_INFO, * PJSON_TOKEN_INFO;
-
-void JsmnGetTokenInfo(
-    _Out_ PJSON_TOKEN_INFO JsonTokenInfo,
-    _In_ const char* JsonString,
-    _In_ jsmntok_t* JsonToken)
-{
-    JsonTokenInfo->Type = JsonToken->type;
-    JsonTokenInfo->Name = JsonString + JsonToken->start;
-    JsonTokenInfo->NameLength = JsonToken->end - JsonToken->start;
-    JsonTokenInfo->Size = JsonToken->size;
-}
-
-bool JsmnJsonEqual(
-    _In_ const char* JsonString,
-    _In_ jsmntok_t* JsonToken,
-    _In_ const char* String)
-{
-    if (JsonToken->type == JSMN_STRING)
-    {
-        const char* CurrentToken = JsonString + JsonToken->start;
-        std::size_t CurrentTokenLength = JsonToken->end - JsonToken->start;
-        if (::strlen(String) == CurrentTokenLength)
-        {
-            if (::strncmp(CurrentToken, String, CurrentTokenLength) == 0)
-            {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-#if _MSC_VER >= 1200
-#pragma warning(pop)
-#endif
-
-/*void x()
-{
-    JobObjectCreateSilo;
-    JobObjectExtendedLimitInformation;
-    JobObjectCpuRateControlInformation;
-    JobObjectReserved23Information; // JobObjectSiloSystemRoot
-    JobObjectReserved25Information; // JobObjectThreadImpersonationInformation
-    JobObjectReserved13Information; // JobObjectContainerId
-    JobObjectReserved15Information; // JobObjectSiloRootDirectory
-    JobObjectReserved16Information; // JobObjectServerSiloBasicInformation
-    JobObjectReserved17Information; // JobObjectServerSiloUserSharedData
-    JobObjectReserved18Information; // JobObjectServerSiloInitialize
-}*/
-
 // The NSudo message enum.
 enum NSUDO_MESSAGE
 {
@@ -173,229 +72,45 @@ const char* NSudoMessageTranslationID[] =
 
 class CNSudoTranslationAdapter
 {
-private:
-    static std::wstring GetUTF8WithBOMStringResources(
-        _In_ UINT uID)
-    {
-        Mile::RESOURCE_INFO ResourceInfo = { 0 };
-        if (SUCCEEDED(Mile::LoadResource(
-            &ResourceInfo,
-            GetModuleHandleW(nullptr),
-            L"String",
-            MAKEINTRESOURCEW(uID))))
-        {
-            // Raw string without the UTF-8 BOM. (0xEF,0xBB,0xBF)	
-            return Mile::ToUtf16String(std::string(
-                reinterpret_cast<const char*>(ResourceInfo.Pointer) + 3,
-                ResourceInfo.Size - 3));
-        }
-
-        return L"";
-    }
-
 public:
     static void Load(
-        std::map<std::string, std::wstring>& StringTranslations)
+        CNSudoTranslationTable& StringTranslations,
+        CNSudoTranslationTable& BuiltInTranslations)
     {
-        StringTranslations.clear();
+        CNSudoTranslationTableBuilder Builder;
 
-        StringTranslations.emplace(std::make_pair(
+        Builder.Add(
             "NSudo.VersionText",
             L"M2-Team NSudo Launcher " MILE_PROJECT_VERSION_STRING L" (Build "
-            MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")"));
+            MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")");
 
-        StringTranslations.emplace(std::make_pair(
+        Builder.Add(
             "NSudo.LogoText",
             L"M2-Team NSudo Launcher " MILE_PROJECT_VERSION_STRING L" (Build "
             MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")"
             L"\r\n"
             L"© M2-Team. All rights reserved.\r\n"
-            L"\r\n"));
-
-        StringTranslations.emplace(std::make_pair(
-            "NSudo.String.Links",
-            CNSudoTranslationAdapter::GetUTF8WithBOMStringResources(
-                IDR_STRING_LINKS)));
+            L"\r\n");
 
-        StringTranslations.emplace(std::make_pair(
-            "NSudo.String.CommandLineHelp",
-            CNSudoTranslationAdapter::GetUTF8WithBOMStringResources(
-                IDR_STRING_COMMAND_LINE_HELP)));
+        Builder.Build(BuiltInTranslations);
 
+        // The translations, the links and the command line help are compiled
+        // into a frozen translation table at build time, which is used in
+        // place without parsing or converting.
         Mile::RESOURCE_INFO ResourceInfo = { 0 };
         if (SUCCEEDED(Mile::LoadResource(
             &ResourceInfo,
-            GetModuleHandleW(nullptr),
+            ::GetModuleHandleW(nullptr),
             L"String",
             MAKEINTRESOURCEW(IDR_STRING_TRANSLATIONS))))
         {
-            const char* JsonString =
-                reinterpret_cast<const char*>(ResourceInfo.Pointer) + 3;
-            std::size_t JsonStringLength =
-                ResourceInfo.Size - 3;
-
-            jsmntok_t* JsonTokens = nullptr;
-            std::int32_t JsonTokensCount = 0;
-            if (JsmnParseJson(
-                &JsonTokens,
-                &JsonTokensCount,
-                JsonString,
-                JsonStringLength))
-            {
-                for (size_t i = 0; i < static_cast<size_t>(JsonTokensCount); ++i)
-                {
-                    if (JsmnJsonEqual(
-                        JsonString,
-                        &JsonTokens[i],
-                        "Translations"))
-                    {
-                        if (JsonTokens[i + 1].type != JSMN_OBJECT)
-                        {
-                            continue;
-                        }
-
-                        for (size_t j = 0; j < static_cast<size_t>(JsonTokens[i + 1].size); ++j)
-                        {
-                            jsmntok_t& Key = JsonTokens[i + (j * 2) + 2];
-                            jsmntok_t& Value = JsonTokens[i + (j * 2) + 3];
-
-                            if (Key.type != JSMN_STRING ||
-                                Value.type != JSMN_STRING)
-                            {
-                                continue;
-                            }
-
-                            StringTranslations.emplace(std::make_pair(
-                                std::string(
-                                    JsonString + Key.start,
-                                    Key.end - Key.start),
-                                Mile::ToUtf16String(std::string(
-                                    JsonString + Value.start,
-                                    Value.end - Value.start))));
-                        }
-                        i += JsonTokens[i + 1].size + 1;
-                    }
-                }
-
-                ::free(JsonTokens);
-            }
+            StringTranslations.Attach(
+                ResourceInfo.Pointer,
+                ResourceInfo.Size);
         }
     }
 };
 
-class CNSudoShortCutAdapter
-{
-public:
-    static void Read(
-        const std::wstring& ShortCutListPath,
-        std::map<std::wstring, std::wstring>& ShortCutList)
-    {
-        ShortCutList.clear();
-
-        HRESULT hr = S_OK;
-        HANDLE FileHandle = ::CreateFileW(
-            ShortCutListPath.c_str(),
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            nullptr,
-            OPEN_EXISTING,
-            FILE_FLAG_SEQUENTIAL_SCAN,
-            nullptr);
-        if (FileHandle != INVALID_HANDLE_VALUE)
-        {
-            UINT64 FileSize = 0;
-
-            hr = Mile::GetFileSize(FileHandle, &FileSize);
-            if (hr == S_OK)
-            {
-                char* FileContent = reinterpret_cast<char*>(
-                    Mile::HeapMemory::Allocate(static_cast<SIZE_T>(FileSize)));
-                if (FileContent)
-                {
-                    DWORD NumberOfBytesRead = 0;
-                    if (::ReadFile(
-                        FileHandle,
-                        FileContent,
-                        static_cast<DWORD>(FileSize),
-                        &NumberOfBytesRead,
-                        nullptr))
-                    {
-                        const char* JsonString = FileContent + 3;
-                        std::size_t JsonStringLength = NumberOfBytesRead - 3;
-
-                        jsmntok_t* JsonTokens = nullptr;
-                        std::int32_t JsonTokensCount = 0;
-                        if (JsmnParseJson(
-                            &JsonTokens,
-                            &JsonTokensCount,
-                            JsonString,
-                            JsonStringLength))
-                        {
-                            for (size_t i = 0; i < static_cast<size_t>(JsonTokensCount); ++i)
-                            {
-                                if (JsmnJsonEqual(
-                                    JsonString,
-                                    &JsonTokens[i],
-                                    "ShortCutList_V2"))
-                                {
-                                    if (JsonTokens[i + 1].type != JSMN_OBJECT)
-                                    {
-                                        continue;
-                                    }
-
-                                    for (size_t j = 0; j < static_cast<size_t>(JsonTokens[i + 1].size); ++j)
-                                    {
-                                        jsmntok_t& Key = JsonTokens[i + (j * 2) + 2];
-                                        jsmntok_t& Value = JsonTokens[i + (j * 2) + 3];
-
-                                        if (Key.type != JSMN_STRING ||
-                                            Value.type != JSMN_STRING)
-                                        {
-                                            continue;
-                                        }
-
-                                        ShortCutList.emplace(std::make_pair(
-                                            Mile::ToUtf16String(std::string(
-                                                JsonString + Key.start,
-                                                Key.end - Key.start)),
-                                            Mile::ToUtf16String(std::string(
-                                                JsonString + Value.start,
-                                                Value.end - Value.start))));
-                                    }
-                                    i += JsonTokens[i + 1].size + 1;
-                                }
-                            }
-
-                            ::free(JsonTokens);
-                        }
-                    }
-
-                    Mile::HeapMemory::Free(FileContent);
-                }
-            }
-
-            ::CloseHandle(FileHandle);
-        }
-    }
-
-    static void Write(
-        const std::wstring& ShortCutListPath,
-        const std::map<std::wstring, std::wstring>& ShortCutList)
-    {
-        ShortCutListPath;
-        ShortCutList;
-    }
-
-    static std::wstring Translate(
-        const std::map<std::wstring, std::wstring>& ShortCutList,
-        const std::wstring& CommandLine)
-    {
-        auto iterator = ShortCutList.find(CommandLine);
-
-        return iterator == ShortCutList.end() ? CommandLine : iterator->second;
-    }
-};
-
 class CNSudoResourceManagement
 {
 private:
@@ -406,16 +121,16 @@ private:
     std::wstring m_ExePath;
     std::wstring m_AppPath;
 
-    std::map<std::string, std::wstring> m_StringTranslations;
-    std::map<std::wstring, std::wstring> m_ShortCutList;
+    CNSudoTranslationTable m_StringTranslations;
+    CNSudoTranslationTable m_BuiltInTranslations;
+    CNSudoShortCutList m_ShortCutList;
 
 public:
     const HINSTANCE& Instance = this->m_Instance;
     const std::wstring& ExePath = this->m_ExePath;
     const std::wstring& AppPath = this->m_AppPath;
 
-    const std::map<std::wstring, std::wstring>& ShortCutList =
-        this->m_ShortCutList;
+    const CNSudoShortCutList& ShortCutList = this->m_ShortCutList;
 
 public:
     CNSudoResourceManagement() = default;
@@ -440,7 +155,9 @@ public:
             wcsrchr(&this->m_AppPath[0], L'\\')[0] = L'\0';
             this->m_AppPath.resize(wcslen(this->m_AppPath.c_str()));
 
-            CNSudoTranslationAdapter::Load(this->m_StringTranslations);
+            CNSudoTranslationAdapter::Load(
+                this->m_StringTranslations,
+                this->m_BuiltInTranslations);
 
             CNSudoShortCutAdapter::Read(
                 this->AppPath + L"\\NSudo.json", this->m_ShortCutList);
@@ -455,9 +172,14 @@ public:
     }
 
     std::wstring GetTranslation(
-        _In_ std::string Key)
+        _In_ std::string_view Key)
     {
-        return this->m_StringTranslations[Key];
+        std::wstring_view Translation = this->m_StringTranslations.Find(Key);
+        if (Translation.empty())
+        {
+            Translation = this->m_BuiltInTranslations.Find(Key);
+        }
+        return std::wstring(Translation);
     }
 
     std::wstring GetMessageString(
@@ -469,6 +191,242 @@ public:
 
 CNSudoResourceManagement g_ResourceManagement;
 
+/**
+ * @brief Reads the commands of the batch mode. The input is UTF-8 text with
+ *        one command per line, and blank lines are ignored.
+ * @param BatchPath The path of the input file, or "-" for the standard input.
+ * @param Commands The commands.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoReadBatchCommands(
+    _In_ std::wstring const& BatchPath,
+    _Out_ std::vector<std::wstring>& Commands)
+{
+    Commands.clear();
+
+    bool IsStandardInput = (0 == std::wcscmp(BatchPath.c_str(), L"-"));
+
+    HANDLE InputHandle = IsStandardInput
+        ? ::GetStdHandle(STD_INPUT_HANDLE)
+        : ::CreateFileW(
+            BatchPath.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr);
+    if (!InputHandle || InputHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResultFromLastError(FALSE);
+    }
+
+    auto InputHandleCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        if (!IsStandardInput)
+        {
+            ::CloseHandle(InputHandle);
+        }
+    });
+
+    HRESULT hr = S_OK;
+
+    std::string Content;
+    char Buffer[4096];
+    for (;;)
+    {
+        DWORD NumberOfBytesRead = 0;
+        if (!::ReadFile(
+            InputHandle,
+            Buffer,
+            sizeof(Buffer),
+            &NumberOfBytesRead,
+            nullptr))
+        {
+            DWORD LastError = ::GetLastError();
+            if (LastError != ERROR_BROKEN_PIPE)
+            {
+                hr = Mile::HResult::FromWin32(LastError);
+            }
+            break;
+        }
+
+        if (!NumberOfBytesRead)
+        {
+            break;
+        }
+
+        Content.append(Buffer, NumberOfBytesRead);
+    }
+
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    // Skip the UTF-8 BOM. (0xEF,0xBB,0xBF)
+    std::size_t LineStart = 0;
+    if (0 == Content.compare(0, 3, "\xEF\xBB\xBF"))
+    {
+        LineStart = 3;
+    }
+
+    while (LineStart < Content.size())
+    {
+        std::size_t LineEnd = Content.find('\n', LineStart);
+        if (LineEnd == std::string::npos)
+        {
+            LineEnd = Content.size();
+        }
+
+        std::size_t First = Content.find_first_not_of(" \t\r", LineStart);
+        if (First != std::string::npos && First < LineEnd)
+        {
+            std::size_t Last = Content.find_last_not_of(" \t\r", LineEnd - 1);
+
+            Commands.push_back(Mile::ToUtf16String(
+                Content.substr(First, Last - First + 1)));
+        }
+
+        LineStart = LineEnd + 1;
+    }
+
+    return S_OK;
+}
+
+/**
+ * @brief Appends a string to the JSON output as a quoted JSON string.
+ * @param Output The JSON output.
+ * @param String The string.
+*/
+static void NSudoAppendJsonString(
+    _Inout_ std::wstring& Output,
+    _In_ std::wstring const& String)
+{
+    Output.push_back(L'"');
+    for (wchar_t Character : String)
+    {
+        switch (Character)
+        {
+        case L'"':
+            Output.append(L"\\\"");
+            break;
+        case L'\\':
+            Output.append(L"\\\\");
+            break;
+        case L'\n':
+            Output.append(L"\\n");
+            break;
+        case L'\r':
+            Output.append(L"\\r");
+            break;
+        case L'\t':
+            Output.append(L"\\t");
+            break;
+        default:
+            if (Character < 0x20)
+            {
+                Output.append(Mile::FormatUtf16String(
+                    L"\\u%04X",
+                    Character));
+            }
+            else
+            {
+                Output.push_back(Character);
+            }
+            break;
+        }
+    }
+    Output.push_back(L'"');
+}
+
+/**
+ * @brief Launches the commands read from the input file or the standard
+ *        input with a bounded number of commands running at the same time,
+ *        and writes the result of each command to the standard output as a
+ *        line of NDJSON in the input order.
+ * @param BatchPath The path of the input file, or "-" for the standard input.
+ * @param MaxParallel The maximum number of commands running at the same time.
+ * @param Settings The settings shared by all commands.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoRunBatchCommands(
+    _In_ std::wstring const& BatchPath,
+    _In_ std::size_t MaxParallel,
+    _In_ NSUDO_LAUNCHER_BATCH_SETTINGS const& Settings)
+{
+    std::vector<std::wstring> Commands;
+    HRESULT hr = ::NSudoReadBatchCommands(BatchPath, Commands);
+    if (hr != S_OK)
+    {
+        ::NSudoWriteLog(
+            L"NSudoRunBatchCommands",
+            Mile::FormatUtf16String(
+                L"%s failed, returns 0x%08X.",
+                L"NSudoReadBatchCommands",
+                hr).c_str());
+        return hr;
+    }
+
+    HANDLE OutputHandle = ::GetStdHandle(STD_OUTPUT_HANDLE);
+
+    ::NSudoRunBatch<NSUDO_LAUNCHER_BATCH_RESULT>(
+        Commands.size(),
+        MaxParallel,
+        [&](std::size_t Index) -> NSUDO_LAUNCHER_BATCH_RESULT
+        {
+            std::wstring CommandLine = CNSudoShortCutAdapter::Translate(
+                g_ResourceManagement.ShortCutList,
+                Commands[Index]);
+
+            return ::NSudoLaunchBatchCommand(
+                ::NSudoGetWin32LaunchBackend(),
+                Settings,
+                CommandLine);
+        },
+        [&](std::size_t Index, NSUDO_LAUNCHER_BATCH_RESULT& Result)
+        {
+            std::wstring Line = Mile::FormatUtf16String(
+                L"{\"Index\":%llu,\"CommandLine\":",
+                static_cast<unsigned long long>(Index));
+            ::NSudoAppendJsonString(Line, Commands[Index]);
+            if (Result.Result == S_OK)
+            {
+                Line.append(Mile::FormatUtf16String(
+                    L",\"Succeeded\":true,\"ExitCode\":%lu",
+                    Result.ExitCode));
+            }
+            else
+            {
+                Line.append(Mile::FormatUtf16String(
+                    L",\"Succeeded\":false,\"ExitCode\":null,"
+                    L"\"Error\":\"0x%08X\"",
+                    Result.Result));
+            }
+            if (Settings.UseJobObject && Result.Result == S_OK)
+            {
+                Line.append(L",\"Job\":");
+                Line.append(::NSudoFormatJobAccountingJson(
+                    Result.JobAccounting));
+            }
+            Line.append(Mile::FormatUtf16String(
+                L",\"DurationMilliseconds\":%llu}\n",
+                Result.Duration));
+
+            std::string Utf8Line = Mile::ToUtf8String(Line);
+
+            DWORD NumberOfBytesWritten = 0;
+            ::WriteFile(
+                OutputHandle,
+                Utf8Line.c_str(),
+                static_cast<DWORD>(Utf8Line.size()),
+                &NumberOfBytesWritten,
+                nullptr);
+        });
+
+    return S_OK;
+}
+
 // 解析命令行
 NSUDO_MESSAGE NSudoCommandLineParser(
     _In_ std::wstring& ApplicationName,
@@ -477,6 +435,14 @@ NSUDO_MESSAGE NSudoCommandLineParser(
 {
     UNREFERENCED_PARAMETER(ApplicationName);
 
+    // 展开 -Profile 选项指定的启动配置
+    if (S_OK != ::NSudoExpandLaunchProfile(
+        g_ResourceManagement.AppPath + L"\\" NSUDO_LAUNCHER_PROFILES_FILE_NAME,
+        OptionsAndParameters))
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
     if (1 == OptionsAndParameters.size() && UnresolvedCommandLine.empty())
     {
         auto OptionAndParameter = *OptionsAndParameters.begin();
@@ -493,7 +459,7 @@ NSUDO_MESSAGE NSudoCommandLineParser(
             // 如果选项名是 "Version"，则显示 NSudo 版本号。
             return NSUDO_MESSAGE::NEED_TO_SHOW_NSUDO_VERSION;
         }
-        else
+        else if (0 != _wcsicmp(OptionAndParameter.first.c_str(), L"Batch"))
         {
             return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
         }
@@ -506,6 +472,15 @@ NSUDO_MESSAGE NSudoCommandLineParser(
     DWORD WaitInterval = 0;
     std::wstring CurrentDirectory = g_ResourceManagement.AppPath;
     BOOL CreateNewConsole = TRUE;
+    std::wstring BatchPath;
+    std::size_t MaxParallel = Mile::GetNumberOfHardwareThreads();
+    bool MaxParallelSpecified = false;
+    bool Prewarm = false;
+
+    NSUDO_CREATE_PROCESS_OPTIONS Options = { 0 };
+    Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+    bool UseJobObject = false;
+    std::wstring EnvironmentOverrides;
 
     NSUDO_USER_MODE_TYPE UserModeType =
         NSUDO_USER_MODE_TYPE::DEFAULT;
@@ -664,6 +639,193 @@ NSUDO_MESSAGE NSudoCommandLineParser(
         {
             CreateNewConsole = FALSE;
         }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Affinity"))
+        {
+            // 参数格式为 [处理器组:]十六进制亲和性掩码
+            std::wstring Mask = OptionAndParameter.second;
+            std::wstring::size_type Separator = Mask.find(L':');
+            if (Separator != std::wstring::npos)
+            {
+                wchar_t* End = nullptr;
+                unsigned long Group = std::wcstoul(
+                    Mask.c_str(), &End, 10);
+                if (End != Mask.c_str() + Separator || Group > MAXWORD)
+                {
+                    bArgErr = true;
+                    break;
+                }
+                Options.ProcessorGroup = static_cast<WORD>(Group);
+                Mask = Mask.substr(Separator + 1);
+            }
+            else
+            {
+                PROCESSOR_NUMBER ProcessorNumber = { 0 };
+                ::GetCurrentProcessorNumberEx(&ProcessorNumber);
+                Options.ProcessorGroup = ProcessorNumber.Group;
+            }
+
+            wchar_t* End = nullptr;
+            Options.AffinityMask = static_cast<KAFFINITY>(
+                std::wcstoull(Mask.c_str(), &End, 16));
+            if (Mask.empty() || *End || !Options.AffinityMask)
+            {
+                bArgErr = true;
+                break;
+            }
+            Options.SetAffinity = TRUE;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Node"))
+        {
+            wchar_t* End = nullptr;
+            unsigned long Node = std::wcstoul(
+                OptionAndParameter.second.c_str(), &End, 10);
+            if (OptionAndParameter.second.empty() || *End || Node > MAXUSHORT)
+            {
+                bArgErr = true;
+                break;
+            }
+            Options.PreferredNode = static_cast<USHORT>(Node);
+            Options.SetPreferredNode = TRUE;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"MemoryPriority"))
+        {
+            if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"VeryLow"))
+            {
+                Options.MemoryPriority = NSUDO_MEMORY_PRIORITY_TYPE::VERY_LOW;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"Low"))
+            {
+                Options.MemoryPriority = NSUDO_MEMORY_PRIORITY_TYPE::LOW;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"Medium"))
+            {
+                Options.MemoryPriority = NSUDO_MEMORY_PRIORITY_TYPE::MEDIUM;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"BelowNormal"))
+            {
+                Options.MemoryPriority = NSUDO_MEMORY_PRIORITY_TYPE::BELOW_NORMAL;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"Normal"))
+            {
+                Options.MemoryPriority = NSUDO_MEMORY_PRIORITY_TYPE::NORMAL;
+            }
+            else
+            {
+                bArgErr = true;
+                break;
+            }
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"IoPriority"))
+        {
+            if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"VeryLow"))
+            {
+                Options.IoPriority = NSUDO_IO_PRIORITY_TYPE::VERY_LOW;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"Low"))
+            {
+                Options.IoPriority = NSUDO_IO_PRIORITY_TYPE::LOW;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"Normal"))
+            {
+                Options.IoPriority = NSUDO_IO_PRIORITY_TYPE::NORMAL;
+            }
+            else if (0 == _wcsicmp(OptionAndParameter.second.c_str(), L"High"))
+            {
+                Options.IoPriority = NSUDO_IO_PRIORITY_TYPE::HIGH;
+            }
+            else
+            {
+                bArgErr = true;
+                break;
+            }
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"JobCpuRate"))
+        {
+            // 参数为占所有处理器的百分比
+            wchar_t* End = nullptr;
+            double CpuRate = std::wcstod(
+                OptionAndParameter.second.c_str(), &End);
+            if (OptionAndParameter.second.empty() || *End ||
+                !(CpuRate >= 0.01 && CpuRate <= 100.0))
+            {
+                bArgErr = true;
+                break;
+            }
+            Options.JobCpuRate = static_cast<DWORD>(CpuRate * 100.0 + 0.5);
+            UseJobObject = true;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"JobWorkingSetLimit") ||
+            0 == _wcsicmp(OptionAndParameter.first.c_str(), L"JobMemoryLimit"))
+        {
+            // 参数的单位为 MiB
+            wchar_t* End = nullptr;
+            unsigned long long Limit = std::wcstoull(
+                OptionAndParameter.second.c_str(), &End, 10);
+            if (OptionAndParameter.second.empty() || *End || !Limit ||
+                Limit > static_cast<SIZE_T>(-1) / (1024 * 1024))
+            {
+                bArgErr = true;
+                break;
+            }
+            if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"JobWorkingSetLimit"))
+            {
+                Options.JobWorkingSetLimit =
+                    static_cast<SIZE_T>(Limit) * 1024 * 1024;
+            }
+            else
+            {
+                Options.JobMemoryLimit =
+                    static_cast<SIZE_T>(Limit) * 1024 * 1024;
+            }
+            UseJobObject = true;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"JobKillOnClose"))
+        {
+            Options.JobKillOnClose = TRUE;
+            UseJobObject = true;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Prewarm"))
+        {
+            // 预热已在 main 函数中启动，此处仅检查是否与 -Batch 一起使用
+            Prewarm = true;
+        }
+        else if (0 == _wcsnicmp(OptionAndParameter.first.c_str(), L"Env:", 4))
+        {
+            // 由于选项在第一个 "=" 处分割，"-Env:Name=Value" 的选项名为
+            // "Env:Name"，参数为 "Value"。参数为空时删除该环境变量。
+            if (OptionAndParameter.first.size() == 4)
+            {
+                bArgErr = true;
+                break;
+            }
+
+            EnvironmentOverrides.append(OptionAndParameter.first, 4);
+            EnvironmentOverrides.push_back(L'=');
+            EnvironmentOverrides.append(OptionAndParameter.second);
+            EnvironmentOverrides.push_back(L'\0');
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Batch"))
+        {
+            BatchPath = OptionAndParameter.second;
+            if (BatchPath.empty())
+            {
+                bArgErr = true;
+                break;
+            }
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"MaxParallel"))
+        {
+            wchar_t* End = nullptr;
+            unsigned long Value = std::wcstoul(
+                OptionAndParameter.second.c_str(), &End, 10);
+            if (OptionAndParameter.second.empty() || *End || !Value)
+            {
+                bArgErr = true;
+                break;
+            }
+            MaxParallel = Value;
+            MaxParallelSpecified = true;
+        }
         else
         {
             bArgErr = true;
@@ -671,12 +833,68 @@ NSUDO_MESSAGE NSudoCommandLineParser(
         }
     }
 
-    if (bArgErr || UnresolvedCommandLine.empty())
+    if (bArgErr)
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
+    // 环境变量覆盖列表以两个空字符结尾，第二个由 std::wstring::c_str 提供
+    if (!EnvironmentOverrides.empty())
+    {
+        Options.EnvironmentOverrides = EnvironmentOverrides.c_str();
+    }
+
+    // 单次启动本就需要等待服务启动，预热仅在批处理模式下有意义
+    if (Prewarm && BatchPath.empty())
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
+    // 最大并行数仅用于批处理模式，单次启动时指定视为参数错误
+    if (MaxParallelSpecified && BatchPath.empty())
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
+    // 批处理模式下从文件或标准输入读取命令，且不接受命令行中的命令
+    if (!BatchPath.empty())
+    {
+        if (!UnresolvedCommandLine.empty())
+        {
+            return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+        }
+
+        NSUDO_LAUNCHER_BATCH_SETTINGS Settings;
+        Settings.UserModeType = UserModeType;
+        Settings.PrivilegesModeType = PrivilegesModeType;
+        Settings.MandatoryLabelType = MandatoryLabelType;
+        Settings.ProcessPriorityClassType = ProcessPriorityClassType;
+        Settings.ShowWindowModeType = ShowWindowModeType;
+        Settings.CreateNewConsole = CreateNewConsole;
+        Settings.CurrentDirectory = CurrentDirectory.c_str();
+        Settings.Options = Options;
+        Settings.UseJobObject = UseJobObject;
+
+        if (::NSudoRunBatchCommands(BatchPath, MaxParallel, Settings) != S_OK)
+        {
+            return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+        }
+
+        return NSUDO_MESSAGE::SUCCESS;
+    }
+
+    if (UnresolvedCommandLine.empty())
     {
         return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
     }
 
-    if (NSudoCreateProcess(
+    // 作业关闭时会终止进程树，因此必须等待进程结束
+    if (Options.JobKillOnClose && WaitInterval != INFINITE)
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
+    if (NSudoCreateProcessEx(
         UserModeType,
         PrivilegesModeType,
         MandatoryLabelType,
@@ -685,11 +903,26 @@ NSUDO_MESSAGE NSudoCommandLineParser(
         WaitInterval,
         CreateNewConsole,
         UnresolvedCommandLine.c_str(),
-        CurrentDirectory.c_str()) != S_OK)
+        CurrentDirectory.c_str(),
+        &Options) != S_OK)
     {
         return NSUDO_MESSAGE::CREATE_PROCESS_FAILED;
     }
 
+    if (UseJobObject && WaitInterval == INFINITE)
+    {
+        std::string CurrentCodePageString = Mile::ToConsoleString(
+            ::NSudoFormatJobAccountingReport(Options.JobAccounting));
+
+        DWORD NumberOfCharsWritten = 0;
+        ::WriteFile(
+            ::GetStdHandle(STD_OUTPUT_HANDLE),
+            CurrentCodePageString.c_str(),
+            static_cast<DWORD>(CurrentCodePageString.size()),
+            &NumberOfCharsWritten,
+            nullptr);
+    }
+
     return NSUDO_MESSAGE::SUCCESS;
 }
 
@@ -780,6 +1013,34 @@ int main()
         OptionsAndParameters,
         UnresolvedCommandLine);
 
+    // 如果在批处理模式下指定了 -Prewarm 选项，则尽早在后台预热
+    // TrustedInstaller 访问令牌
+    bool Prewarm = false;
+    bool Batch = false;
+    for (auto const& OptionAndParameter : OptionsAndParameters)
+    {
+        if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Prewarm"))
+        {
+            Prewarm = true;
+        }
+        else if (0 == _wcsicmp(OptionAndParameter.first.c_str(), L"Batch"))
+        {
+            Batch = true;
+        }
+    }
+    Prewarm = Prewarm && Batch;
+    if (Prewarm)
+    {
+        ::NSudoStartTrustedInstallerTokenPrewarm();
+    }
+    auto PrewarmHandler = Mile::ScopeExitTaskHandler([&]()
+    {
+        if (Prewarm)
+        {
+            ::NSudoStopTrustedInstallerTokenPrewarm();
+        }
+    });
+
     UnresolvedCommandLine = CNSudoShortCutAdapter::Translate(
         g_ResourceManagement.ShortCutList,
         UnresolvedCommandLine);
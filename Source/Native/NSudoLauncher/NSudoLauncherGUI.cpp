@@ -34,6 +34,7 @@
 #include <cwchar>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -52,102 +53,12 @@
 
 #include "Mile.Project.Properties.h"
 #include "NSudoLauncherGUIResource.h"
+#include "NSudoLauncherProfiles.h"
+#include "NSudoLauncherShortCuts.h"
+#include "NSudoTranslationTable.h"
 
 #include <NSudoLauncherResources.h>
 
-// 为编译通过而禁用的警告
-#if _MSC_VER >= 1200
-#pragma warning(push)
-#pragma warning(disable:4505) // 未引用的本地函数已移除(等级 4)
-#endif
-
-#include "jsmn.h"
-
-bool JsmnParseJson(
-    _Out_ jsmntok_t** JsonTokens,
-    _Out_ std::int32_t* JsonTokensCount,
-    _In_ const char* JsonString,
-    _In_ std::size_t JsonStringLength)
-{
-    if (!(JsonTokens && JsonTokensCount && JsonString && JsonStringLength))
-    {
-        return false;
-    }
-
-    *JsonTokens = nullptr;
-    *JsonTokensCount = 0;
-
-    jsmn_parser Parser;
-
-    ::jsmn_init(&Parser);
-    std::int32_t TokenCount = ::jsmn_parse(
-        &Parser, JsonString, JsonStringLength, nullptr, 0);
-
-    jsmntok_t* Tokens = reinterpret_cast<jsmntok_t*>(::malloc(
-        TokenCount * sizeof(jsmntok_t)));
-    if (Tokens)
-    {
-        ::jsmn_init(&Parser);
-        std::int32_t TokensCount = ::jsmn_parse(
-            &Parser, JsonString, JsonStringLength, Tokens, TokenCount);
-        if (TokensCount > 0)
-        {
-            *JsonTokens = Tokens;
-            *JsonTokensCount = TokensCount;
-        }
-        else
-        {
-            ::free(Tokens);
-        }
-    }
-
-    return Tokens;
-}
-
-typedef struct _JSON_TOKEN_INFO
-{
-    jsmntype_t Type;
-    const char* Name;
-    std::size_t NameLength;
-    int Size;
-} JSON_TOKEN_INFO, * PJSON_TOKEN_INFO;
-
-void JsmnGetTokenInfo(
-    _Out_ PJSON_TOKEN_INFO JsonTokenInfo,
-    _In_ const char* JsonString,
-    _In_ jsmntok_t* JsonToken)
-{
-    JsonTokenInfo->Type = JsonToken->type;
-    JsonTokenInfo->Name = JsonString + JsonToken->start;
-    JsonTokenInfo->NameLength = JsonToken->end - JsonToken->start;
-    JsonTokenInfo->Size = JsonToken->size;
-}
-
-bool JsmnJsonEqual(
-    _In_ const char* JsonString,
-    _In_ jsmntok_t* JsonToken,
-    _In_ const char* String)
-{
-    if (JsonToken->type == JSMN_STRING)
-    {
-        const char* CurrentToken = JsonString + JsonToken->start;
-        std::size_t CurrentTokenLength = JsonToken->end - JsonToken->start;
-        if (::strlen(String) == CurrentTokenLength)
-        {
-            if (::strncmp(CurrentToken, String, CurrentTokenLength) == 0)
-            {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-#if _MSC_VER >= 1200
-#pragma warning(pop)
-#endif
-
 /*void x()
 {
     JobObjectCreateSilo;
@@ -187,55 +98,31 @@ const char* NSudoMessageTranslationID[] =
 
 class CNSudoTranslationAdapter
 {
-private:
-    static std::wstring GetUTF8WithBOMStringResources(
-        _In_ UINT uID)
-    {
-        Mile::RESOURCE_INFO ResourceInfo = { 0 };
-        if (SUCCEEDED(Mile::LoadResource(
-            &ResourceInfo,
-            GetModuleHandleW(nullptr),
-            L"String",
-            MAKEINTRESOURCEW(uID))))
-        {
-            // Raw string without the UTF-8 BOM. (0xEF,0xBB,0xBF)
-            return Mile::ToUtf16String(std::string(
-                reinterpret_cast<const char*>(ResourceInfo.Pointer) + 3,
-                ResourceInfo.Size - 3));
-        }
-
-        return L"";
-    }
-
 public:
     static void Load(
-        std::map<std::string, std::wstring>& StringTranslations)
+        CNSudoTranslationTable& StringTranslations,
+        CNSudoTranslationTable& BuiltInTranslations)
     {
-        StringTranslations.clear();
+        CNSudoTranslationTableBuilder Builder;
 
-        StringTranslations.emplace(std::make_pair(
+        Builder.Add(
             "NSudo.VersionText",
             L"M2-Team NSudo Launcher " MILE_PROJECT_VERSION_STRING L" (Build "
-            MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")"));
+            MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")");
 
-        StringTranslations.emplace(std::make_pair(
+        Builder.Add(
             "NSudo.LogoText",
             L"M2-Team NSudo Launcher " MILE_PROJECT_VERSION_STRING L" (Build "
             MILE_PROJECT_MACRO_TO_STRING(MILE_PROJECT_VERSION_BUILD) L")"
             L"\r\n"
             L"© M2-Team. All rights reserved.\r\n"
-            L"\r\n"));
-
-        StringTranslations.emplace(std::make_pair(
-            "NSudo.String.Links",
-            CNSudoTranslationAdapter::GetUTF8WithBOMStringResources(
-                IDR_STRING_LINKS)));
+            L"\r\n");
 
-        StringTranslations.emplace(std::make_pair(
-            "NSudo.String.CommandLineHelp",
-            CNSudoTranslationAdapter::GetUTF8WithBOMStringResources(
-                IDR_STRING_COMMAND_LINE_HELP)));
+        Builder.Build(BuiltInTranslations);
 
+        // The translations, the links and the command line help are compiled
+        // into a frozen translation table at build time, which is used in
+        // place without parsing or converting.
         Mile::RESOURCE_INFO ResourceInfo = { 0 };
         if (SUCCEEDED(Mile::LoadResource(
             &ResourceInfo,
@@ -243,171 +130,11 @@ public:
             L"String",
             MAKEINTRESOURCEW(IDR_STRING_TRANSLATIONS))))
         {
-            const char* JsonString =
-                reinterpret_cast<const char*>(ResourceInfo.Pointer) + 3;
-            std::size_t JsonStringLength =
-                ResourceInfo.Size - 3;
-
-            jsmntok_t* JsonTokens = nullptr;
-            std::int32_t JsonTokensCount = 0;
-            if (JsmnParseJson(
-                &JsonTokens,
-                &JsonTokensCount,
-                JsonString,
-                JsonStringLength))
-            {
-                for (size_t i = 0; i < static_cast<size_t>(JsonTokensCount); ++i)
-                {
-                    if (JsmnJsonEqual(
-                        JsonString,
-                        &JsonTokens[i],
-                        "Translations"))
-                    {
-                        if (JsonTokens[i + 1].type != JSMN_OBJECT)
-                        {
-                            continue;
-                        }
-
-                        for (size_t j = 0; j < static_cast<size_t>(JsonTokens[i + 1].size); ++j)
-                        {
-                            jsmntok_t& Key = JsonTokens[i + (j * 2) + 2];
-                            jsmntok_t& Value = JsonTokens[i + (j * 2) + 3];
-
-                            if (Key.type != JSMN_STRING ||
-                                Value.type != JSMN_STRING)
-                            {
-                                continue;
-                            }
-
-                            StringTranslations.emplace(std::make_pair(
-                                std::string(
-                                    JsonString + Key.start,
-                                    Key.end - Key.start),
-                                Mile::ToUtf16String(std::string(
-                                    JsonString + Value.start,
-                                    Value.end - Value.start))));
-                        }
-                        i += JsonTokens[i + 1].size + 1;
-                    }
-                }
-
-                ::free(JsonTokens);
-            }
-        }
-    }
-};
-
-class CNSudoShortCutAdapter
-{
-public:
-    static void Read(
-        const std::wstring& ShortCutListPath,
-        std::map<std::wstring, std::wstring>& ShortCutList)
-    {
-        ShortCutList.clear();
-
-        HRESULT hr = S_OK;
-        HANDLE FileHandle = ::CreateFileW(
-            ShortCutListPath.c_str(),
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            nullptr,
-            OPEN_EXISTING,
-            FILE_FLAG_SEQUENTIAL_SCAN,
-            nullptr);
-        if (FileHandle != INVALID_HANDLE_VALUE)
-        {
-            UINT64 FileSize = 0;
-
-            hr = Mile::GetFileSize(FileHandle, &FileSize);
-            if (hr == S_OK)
-            {
-                char* FileContent = reinterpret_cast<char*>(
-                    Mile::HeapMemory::Allocate(static_cast<SIZE_T>(FileSize)));
-                if (FileContent)
-                {
-                    DWORD NumberOfBytesRead = 0;
-                    if (::ReadFile(
-                        FileHandle,
-                        FileContent,
-                        static_cast<DWORD>(FileSize),
-                        &NumberOfBytesRead,
-                        nullptr))
-                    {
-                        const char* JsonString = FileContent + 3;
-                        std::size_t JsonStringLength = NumberOfBytesRead - 3;
-
-                        jsmntok_t* JsonTokens = nullptr;
-                        std::int32_t JsonTokensCount = 0;
-                        if (JsmnParseJson(
-                            &JsonTokens,
-                            &JsonTokensCount,
-                            JsonString,
-                            JsonStringLength))
-                        {
-                            for (size_t i = 0; i < static_cast<size_t>(JsonTokensCount); ++i)
-                            {
-                                if (JsmnJsonEqual(
-                                    JsonString,
-                                    &JsonTokens[i],
-                                    "ShortCutList_V2"))
-                                {
-                                    if (JsonTokens[i + 1].type != JSMN_OBJECT)
-                                    {
-                                        continue;
-                                    }
-
-                                    for (size_t j = 0; j < static_cast<size_t>(JsonTokens[i + 1].size); ++j)
-                                    {
-                                        jsmntok_t& Key = JsonTokens[i + (j * 2) + 2];
-                                        jsmntok_t& Value = JsonTokens[i + (j * 2) + 3];
-
-                                        if (Key.type != JSMN_STRING ||
-                                            Value.type != JSMN_STRING)
-                                        {
-                                            continue;
-                                        }
-
-                                        ShortCutList.emplace(std::make_pair(
-                                            Mile::ToUtf16String(std::string(
-                                                JsonString + Key.start,
-                                                Key.end - Key.start)),
-                                            Mile::ToUtf16String(std::string(
-                                                JsonString + Value.start,
-                                                Value.end - Value.start))));
-                                    }
-                                    i += JsonTokens[i + 1].size + 1;
-                                }
-                            }
-
-                            ::free(JsonTokens);
-                        }
-                    }
-
-                    Mile::HeapMemory::Free(FileContent);
-                }
-            }
-
-            ::CloseHandle(FileHandle);
+            StringTranslations.Attach(
+                ResourceInfo.Pointer,
+                ResourceInfo.Size);
         }
     }
-
-    static void Write(
-        const std::wstring& ShortCutListPath,
-        const std::map<std::wstring, std::wstring>& ShortCutList)
-    {
-        ShortCutListPath;
-        ShortCutList;
-    }
-
-    static std::wstring Translate(
-        const std::map<std::wstring, std::wstring>& ShortCutList,
-        const std::wstring& CommandLine)
-    {
-        auto iterator = ShortCutList.find(CommandLine);
-
-        return iterator == ShortCutList.end() ? CommandLine : iterator->second;
-    }
 };
 
 class CNSudoResourceManagement
@@ -420,16 +147,16 @@ private:
     std::wstring m_ExePath;
     std::wstring m_AppPath;
 
-    std::map<std::string, std::wstring> m_StringTranslations;
-    std::map<std::wstring, std::wstring> m_ShortCutList;
+    CNSudoTranslationTable m_StringTranslations;
+    CNSudoTranslationTable m_BuiltInTranslations;
+    CNSudoShortCutList m_ShortCutList;
 
 public:
     const HINSTANCE& Instance = this->m_Instance;
     const std::wstring& ExePath = this->m_ExePath;
     const std::wstring& AppPath = this->m_AppPath;
 
-    const std::map<std::wstring, std::wstring>& ShortCutList =
-        this->m_ShortCutList;
+    const CNSudoShortCutList& ShortCutList = this->m_ShortCutList;
 
 public:
     CNSudoResourceManagement() = default;
@@ -454,7 +181,9 @@ public:
             wcsrchr(&this->m_AppPath[0], L'\\')[0] = L'\0';
             this->m_AppPath.resize(wcslen(this->m_AppPath.c_str()));
 
-            CNSudoTranslationAdapter::Load(this->m_StringTranslations);
+            CNSudoTranslationAdapter::Load(
+                this->m_StringTranslations,
+                this->m_BuiltInTranslations);
 
             CNSudoShortCutAdapter::Read(
                 this->AppPath + L"\\NSudo.json", this->m_ShortCutList);
@@ -468,10 +197,21 @@ public:
         // TODO: Empty
     }
 
+    void ReplaceShortCutList(
+        _Inout_ CNSudoShortCutList& ShortCutList)
+    {
+        this->m_ShortCutList.Swap(ShortCutList);
+    }
+
     std::wstring GetTranslation(
-        _In_ std::string Key)
+        _In_ std::string_view Key)
     {
-        return this->m_StringTranslations[Key];
+        std::wstring_view Translation = this->m_StringTranslations.Find(Key);
+        if (Translation.empty())
+        {
+            Translation = this->m_BuiltInTranslations.Find(Key);
+        }
+        return std::wstring(Translation);
     }
 
     std::wstring GetMessageString(
@@ -491,6 +231,14 @@ NSUDO_MESSAGE NSudoCommandLineParser(
 {
     UNREFERENCED_PARAMETER(ApplicationName);
 
+    // 展开 -Profile 选项指定的启动配置
+    if (S_OK != ::NSudoExpandLaunchProfile(
+        g_ResourceManagement.AppPath + L"\\" NSUDO_LAUNCHER_PROFILES_FILE_NAME,
+        OptionsAndParameters))
+    {
+        return NSUDO_MESSAGE::INVALID_COMMAND_PARAMETER;
+    }
+
     if (1 == OptionsAndParameters.size() && UnresolvedCommandLine.empty())
     {
         auto OptionAndParameter = *OptionsAndParameters.begin();
@@ -754,6 +502,10 @@ HRESULT NSudoShowAboutDialog(
 #include <uxtheme.h>
 #pragma comment(lib,"uxtheme.lib")
 
+// The message posted by the shortcut list watcher, the LPARAM is a
+// PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE.
+#define WM_NSUDO_SHORTCUT_LIST_UPDATE (WM_APP + 1)
+
 class CNSudoMainWindow : public ATL::CDialogImpl<CNSudoMainWindow>
 {
 public:
@@ -762,10 +514,14 @@ public:
 public:
     BEGIN_MSG_MAP(CNSudoMainWindow)
         MSG_WM_CLOSE(OnClose)
+        MSG_WM_DESTROY(OnDestroy)
         MSG_WM_INITDIALOG(OnInitDialog)
         MSG_WM_PAINT(OnPaint)
         MSG_WM_DPICHANGED(OnDpiChanged)
         MSG_WM_DROPFILES(OnDropFiles)
+        MESSAGE_HANDLER_EX(
+            WM_NSUDO_SHORTCUT_LIST_UPDATE,
+            OnShortCutListUpdate)
 
         COMMAND_ID_HANDLER_EX(IDC_Run, OnRun)
         COMMAND_ID_HANDLER_EX(IDC_About, OnAbout)
@@ -798,11 +554,33 @@ private:
     WTL::CButton EnableAllPrivilegesCheckBox;
     WTL::CComboBox PathComboBox;
 
+    CNSudoShortCutListWatcher ShortCutListWatcher;
+
     void OnClose()
     {
         this->EndDialog(0);
     }
 
+    void OnDestroy()
+    {
+        // The watcher is stopped whenever the dialog is destroyed, so it
+        // never posts to a destroyed window.
+        this->ShortCutListWatcher.Stop();
+
+        // Release the updates which will not be handled.
+        MSG Message;
+        while (::PeekMessageW(
+            &Message,
+            this->m_hWnd,
+            WM_NSUDO_SHORTCUT_LIST_UPDATE,
+            WM_NSUDO_SHORTCUT_LIST_UPDATE,
+            PM_REMOVE))
+        {
+            delete reinterpret_cast<PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE>(
+                Message.lParam);
+        }
+    }
+
     BOOL OnInitDialog(ATL::CWindow wndFocus, LPARAM lInitParam)
     {
         UNREFERENCED_PARAMETER(wndFocus);
@@ -911,12 +689,23 @@ private:
         //设置默认项"TrustedInstaller"
         this->UserNameComboBox.SetCurSel(3);
 
-        for (std::pair<std::wstring, std::wstring> Item
-            : g_ResourceManagement.ShortCutList)
+        CNSudoShortCutList const& ShortCutList =
+            g_ResourceManagement.ShortCutList;
+        for (std::size_t i = 0; i < ShortCutList.GetCount(); ++i)
         {
-            this->PathComboBox.InsertString(0, Item.first.c_str());
+            this->PathComboBox.InsertString(
+                0,
+                Mile::ToUtf16String(
+                    std::string(ShortCutList.GetName(i))).c_str());
         }
 
+        // Reload the shortcut list when NSudo.json is changed.
+        this->ShortCutListWatcher.Start(
+            g_ResourceManagement.AppPath + L"\\NSudo.json",
+            ShortCutList,
+            this->m_hWnd,
+            WM_NSUDO_SHORTCUT_LIST_UPDATE);
+
         return TRUE;
     }
 
@@ -1014,6 +803,35 @@ private:
         ::DragFinish(hDropInfo);
     }
 
+    LRESULT OnShortCutListUpdate(UINT uMsg, WPARAM wParam, LPARAM lParam)
+    {
+        UNREFERENCED_PARAMETER(uMsg);
+        UNREFERENCED_PARAMETER(wParam);
+
+        std::unique_ptr<NSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE> Update(
+            reinterpret_cast<PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE>(lParam));
+
+        // Only the changed names are applied, so the text and the selection
+        // of the combo box are kept.
+        for (std::wstring const& Name : Update->RemovedNames)
+        {
+            int Index = this->PathComboBox.FindStringExact(-1, Name.c_str());
+            if (Index != CB_ERR)
+            {
+                this->PathComboBox.DeleteString(Index);
+            }
+        }
+
+        for (std::wstring const& Name : Update->AddedNames)
+        {
+            this->PathComboBox.InsertString(0, Name.c_str());
+        }
+
+        g_ResourceManagement.ReplaceShortCutList(Update->ShortCutList);
+
+        return 0;
+    }
+
     LRESULT OnRun(UINT uNotifyCode, int nID, CWindow wndCtl)
     {
         UNREFERENCED_PARAMETER(uNotifyCode);
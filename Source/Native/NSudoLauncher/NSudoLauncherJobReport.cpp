@@ -0,0 +1,73 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherJobReport.cpp
+ * PURPOSE:   Implementation for NSudo Launcher job accounting report
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoLauncherJobReport.h"
+
+#include <Mile.Windows.h>
+
+/**
+ * @brief The number of 100-nanosecond ticks in a millisecond.
+*/
+static const ULONGLONG g_TicksPerMillisecond = 10000;
+
+std::wstring NSudoFormatJobAccountingReport(
+    _In_ NSUDO_JOB_ACCOUNTING_INFORMATION const& Accounting)
+{
+    ULONGLONG UserTime = Accounting.TotalUserTime / g_TicksPerMillisecond;
+    ULONGLONG KernelTime = Accounting.TotalKernelTime / g_TicksPerMillisecond;
+
+    return Mile::FormatUtf16String(
+        L"Job accounting:\r\n"
+        L"    Processes: %lu\r\n"
+        L"    User time: %llu.%03llu s\r\n"
+        L"    Kernel time: %llu.%03llu s\r\n"
+        L"    Peak job memory: %s\r\n"
+        L"    Peak process memory: %s\r\n"
+        L"    Read: %s\r\n"
+        L"    Written: %s\r\n"
+        L"    Other I/O: %s\r\n",
+        Accounting.TotalProcesses,
+        UserTime / 1000,
+        UserTime % 1000,
+        KernelTime / 1000,
+        KernelTime % 1000,
+        Mile::ConvertByteSizeToUtf16String(
+            Accounting.PeakJobMemoryUsed).c_str(),
+        Mile::ConvertByteSizeToUtf16String(
+            Accounting.PeakProcessMemoryUsed).c_str(),
+        Mile::ConvertByteSizeToUtf16String(
+            Accounting.ReadTransferCount).c_str(),
+        Mile::ConvertByteSizeToUtf16String(
+            Accounting.WriteTransferCount).c_str(),
+        Mile::ConvertByteSizeToUtf16String(
+            Accounting.OtherTransferCount).c_str());
+}
+
+std::wstring NSudoFormatJobAccountingJson(
+    _In_ NSUDO_JOB_ACCOUNTING_INFORMATION const& Accounting)
+{
+    return Mile::FormatUtf16String(
+        L"{\"TotalProcesses\":%lu,"
+        L"\"UserTimeMilliseconds\":%llu,"
+        L"\"KernelTimeMilliseconds\":%llu,"
+        L"\"PeakJobMemoryUsed\":%llu,"
+        L"\"PeakProcessMemoryUsed\":%llu,"
+        L"\"ReadTransferCount\":%llu,"
+        L"\"WriteTransferCount\":%llu,"
+        L"\"OtherTransferCount\":%llu}",
+        Accounting.TotalProcesses,
+        Accounting.TotalUserTime / g_TicksPerMillisecond,
+        Accounting.TotalKernelTime / g_TicksPerMillisecond,
+        Accounting.PeakJobMemoryUsed,
+        Accounting.PeakProcessMemoryUsed,
+        Accounting.ReadTransferCount,
+        Accounting.WriteTransferCount,
+        Accounting.OtherTransferCount);
+}
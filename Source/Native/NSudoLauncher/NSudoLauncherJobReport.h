@@ -0,0 +1,35 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherJobReport.h
+ * PURPOSE:   Definition for NSudo Launcher job accounting report
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_JOB_REPORT
+#define NSUDO_LAUNCHER_JOB_REPORT
+
+#include "NSudoAPI.h"
+
+#include <string>
+
+/**
+ * @brief Formats the accounting information of the job as a human-readable
+ *        report.
+ * @param Accounting The accounting information of the job.
+ * @return The report.
+*/
+std::wstring NSudoFormatJobAccountingReport(
+    _In_ NSUDO_JOB_ACCOUNTING_INFORMATION const& Accounting);
+
+/**
+ * @brief Formats the accounting information of the job as a JSON object.
+ * @param Accounting The accounting information of the job.
+ * @return The JSON object.
+*/
+std::wstring NSudoFormatJobAccountingJson(
+    _In_ NSUDO_JOB_ACCOUNTING_INFORMATION const& Accounting);
+
+#endif // !NSUDO_LAUNCHER_JOB_REPORT
@@ -0,0 +1,149 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherJson.cpp
+ * PURPOSE:   Implementation for NSudo Launcher JSON reader
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoLauncherJson.h"
+
+// Without the parent links, jsmn looks for the enclosing object by scanning
+// back through all tokens at each comma, which is quadratic for the large flat
+// objects like the shortcut list.
+#define JSMN_PARENT_LINKS
+#include "jsmn.h"
+
+/**
+ * @brief The number of tokens which are placed on the stack, enough for the
+ *        most of NSudo.json files.
+*/
+#define NSUDO_LAUNCHER_JSON_STACK_TOKENS 512
+
+/**
+ * @brief Gets the index of the token after the token and all its children.
+ * @param Tokens The tokens.
+ * @param TokensCount The number of tokens.
+ * @param Index The index of the token.
+ * @return The index of the next sibling token.
+*/
+static int NSudoSkipJsonToken(
+    _In_ const jsmntok_t* Tokens,
+    _In_ int TokensCount,
+    _In_ int Index)
+{
+    // The tokens are in pre-order, so the children follow their parent.
+    int Pending = 1;
+    while (Pending && Index < TokensCount)
+    {
+        const jsmntok_t& Token = Tokens[Index++];
+        --Pending;
+        // The size of an object is the number of its keys, and each key owns
+        // its value.
+        Pending += Token.size;
+    }
+
+    return Index;
+}
+
+/**
+ * @brief Gets the string which the token points to.
+ * @param JsonString The JSON string.
+ * @param Token The token.
+ * @return The string which the token points to.
+*/
+static std::string_view NSudoGetJsonTokenString(
+    _In_ std::string_view JsonString,
+    _In_ const jsmntok_t& Token)
+{
+    return JsonString.substr(
+        static_cast<std::size_t>(Token.start),
+        static_cast<std::size_t>(Token.end - Token.start));
+}
+
+bool NSudoReadJsonStringMembers(
+    _In_ std::string_view JsonString,
+    _In_ std::string_view ObjectName,
+    _Out_ std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER>& Members)
+{
+    Members.clear();
+
+    if (JsonString.empty())
+    {
+        return false;
+    }
+
+    jsmntok_t StackTokens[NSUDO_LAUNCHER_JSON_STACK_TOKENS];
+    std::vector<jsmntok_t> HeapTokens;
+
+    jsmntok_t* Tokens = StackTokens;
+    unsigned int TokensCapacity = NSUDO_LAUNCHER_JSON_STACK_TOKENS;
+
+    jsmn_parser Parser;
+    ::jsmn_init(&Parser);
+
+    int TokensCount = 0;
+    for (;;)
+    {
+        // jsmn keeps its position when it runs out of tokens, so the parse
+        // resumes with the larger buffer instead of starting over.
+        TokensCount = ::jsmn_parse(
+            &Parser,
+            JsonString.data(),
+            JsonString.size(),
+            Tokens,
+            TokensCapacity);
+        if (TokensCount != JSMN_ERROR_NOMEM)
+        {
+            break;
+        }
+
+        TokensCapacity *= 2;
+        if (HeapTokens.empty())
+        {
+            HeapTokens.assign(StackTokens, StackTokens + Parser.toknext);
+        }
+        HeapTokens.resize(TokensCapacity);
+        Tokens = HeapTokens.data();
+    }
+
+    if (TokensCount <= 0)
+    {
+        return false;
+    }
+
+    for (int i = 0; i + 1 < TokensCount; ++i)
+    {
+        const jsmntok_t& Name = Tokens[i];
+        const jsmntok_t& Object = Tokens[i + 1];
+
+        if (Name.type != JSMN_STRING ||
+            Object.type != JSMN_OBJECT ||
+            NSudoGetJsonTokenString(JsonString, Name) != ObjectName)
+        {
+            continue;
+        }
+
+        int Current = i + 2;
+        for (int j = 0; j < Object.size && Current + 1 < TokensCount; ++j)
+        {
+            const jsmntok_t& Key = Tokens[Current];
+            const jsmntok_t& Value = Tokens[Current + 1];
+
+            if (Key.type == JSMN_STRING && Value.type == JSMN_STRING)
+            {
+                Members.emplace_back(
+                    NSudoGetJsonTokenString(JsonString, Key),
+                    NSudoGetJsonTokenString(JsonString, Value));
+            }
+
+            Current = NSudoSkipJsonToken(Tokens, TokensCount, Current);
+        }
+
+        i = Current - 1;
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherJson.h
+ * PURPOSE:   Definition for NSudo Launcher JSON reader
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_JSON
+#define NSUDO_LAUNCHER_JSON
+
+#include <Windows.h>
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A member of a JSON object whose value is a string. The key and the
+ *        value point into the JSON string and are not unescaped.
+*/
+typedef std::pair<std::string_view, std::string_view>
+    NSUDO_LAUNCHER_JSON_STRING_MEMBER;
+
+/**
+ * @brief Reads the members whose values are strings from the JSON objects
+ *        named ObjectName, e.g. the "ShortCutList_V2" object of NSudo.json.
+ *        The JSON string is tokenized in a single pass, and the token buffer
+ *        grows on demand.
+ * @param JsonString The UTF-8 JSON string without the BOM.
+ * @param ObjectName The name of the JSON objects.
+ * @param Members The members in the order of the JSON string. Members whose
+ *                values are not strings are skipped.
+ * @return True if the JSON string is parsed.
+*/
+bool NSudoReadJsonStringMembers(
+    _In_ std::string_view JsonString,
+    _In_ std::string_view ObjectName,
+    _Out_ std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER>& Members);
+
+#endif // !NSUDO_LAUNCHER_JSON
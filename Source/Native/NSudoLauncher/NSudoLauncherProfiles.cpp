@@ -0,0 +1,570 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherProfiles.cpp
+ * PURPOSE:   Implementation for NSudo Launcher named launch profiles
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#define NOMINMAX
+
+#include "NSudoLauncherProfiles.h"
+
+#include "NSudoAPI.h"
+#include <Mile.Windows.h>
+
+#include <toml.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The magic number of the compiled cache, "NSPC".
+*/
+static const DWORD g_ProfilesCacheMagic = 0x4350534E;
+
+/**
+ * @brief The version of the compiled cache layout.
+*/
+static const DWORD g_ProfilesCacheVersion = 1;
+
+/**
+ * @brief The header of the compiled cache. It is followed by the
+ *        profiles, each profile is serialized as the name and the option
+ *        count, followed by the option names and the parameters. Every
+ *        string is serialized as the length in UTF-16 code units followed
+ *        by the UTF-16 code units without the terminating null character.
+*/
+typedef struct _NSUDO_LAUNCHER_PROFILES_CACHE_HEADER
+{
+    DWORD Magic;
+    DWORD Version;
+    ULONGLONG ContentHash;
+    ULONGLONG ContentSize;
+    DWORD ProfileCount;
+    DWORD Reserved;
+} NSUDO_LAUNCHER_PROFILES_CACHE_HEADER, *PNSUDO_LAUNCHER_PROFILES_CACHE_HEADER;
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of the content.
+ * @param Content The content.
+ * @return The 64-bit FNV-1a hash of the content.
+*/
+static ULONGLONG HashContent(
+    std::string const& Content)
+{
+    ULONGLONG Hash = 14695981039346656037ULL;
+    for (char const& Character : Content)
+    {
+        Hash ^= static_cast<std::uint8_t>(Character);
+        Hash *= 1099511628211ULL;
+    }
+    return Hash;
+}
+
+/**
+ * @brief Reads the whole file.
+ * @param FilePath The path of the file.
+ * @param Content The content of the file.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT ReadWholeFile(
+    std::wstring const& FilePath,
+    std::string& Content)
+{
+    Content.clear();
+
+    HANDLE FileHandle = ::CreateFileW(
+        FilePath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    UINT64 FileSize = 0;
+    HRESULT hr = Mile::GetFileSize(FileHandle, &FileSize);
+    if (hr == S_OK)
+    {
+        Content.resize(static_cast<std::size_t>(FileSize));
+
+        DWORD NumberOfBytesRead = 0;
+        hr = Mile::HResultFromLastError(::ReadFile(
+            FileHandle,
+            &Content[0],
+            static_cast<DWORD>(Content.size()),
+            &NumberOfBytesRead,
+            nullptr));
+        Content.resize(NumberOfBytesRead);
+    }
+
+    ::CloseHandle(FileHandle);
+
+    return hr;
+}
+
+/**
+ * @brief Reads the profiles from the compiled cache. The cache is only
+ *        a hint, so every count and every string length is checked
+ *        against the remaining size, and any inconsistency makes the
+ *        caller fall back to parsing the profile file.
+ * @param Cache The content of the compiled cache.
+ * @param ContentHash The hash of the profile file.
+ * @param ContentSize The size of the profile file.
+ * @param Profiles The launch profiles.
+ * @return true if the cache is valid and matches the profile file.
+*/
+static bool ReadProfilesCacheContent(
+    std::string const& Cache,
+    ULONGLONG ContentHash,
+    ULONGLONG ContentSize,
+    NSUDO_LAUNCHER_PROFILES& Profiles)
+{
+
+    if (Cache.size() < sizeof(NSUDO_LAUNCHER_PROFILES_CACHE_HEADER))
+    {
+        return false;
+    }
+
+    NSUDO_LAUNCHER_PROFILES_CACHE_HEADER Header;
+    std::memcpy(
+        &Header,
+        Cache.data(),
+        sizeof(NSUDO_LAUNCHER_PROFILES_CACHE_HEADER));
+    if (Header.Magic != g_ProfilesCacheMagic ||
+        Header.Version != g_ProfilesCacheVersion ||
+        Header.ContentHash != ContentHash ||
+        Header.ContentSize != ContentSize)
+    {
+        return false;
+    }
+
+    std::size_t Offset = sizeof(NSUDO_LAUNCHER_PROFILES_CACHE_HEADER);
+
+    auto ReadCount = [&](DWORD& Value) -> bool
+    {
+        if (Cache.size() - Offset < sizeof(DWORD))
+        {
+            return false;
+        }
+        std::memcpy(&Value, Cache.data() + Offset, sizeof(DWORD));
+        Offset += sizeof(DWORD);
+        return true;
+    };
+
+    auto ReadString = [&](std::wstring& Value) -> bool
+    {
+        DWORD Length = 0;
+        if (!ReadCount(Length) ||
+            (Cache.size() - Offset) / sizeof(wchar_t) < Length)
+        {
+            return false;
+        }
+        Value.resize(Length);
+        std::memcpy(
+            &Value[0],
+            Cache.data() + Offset,
+            Length * sizeof(wchar_t));
+        Offset += Length * sizeof(wchar_t);
+        return true;
+    };
+
+    // Each profile takes at least the name length and the option count,
+    // and each option takes at least the two string lengths.
+    const std::size_t MinimumEntrySize = 2 * sizeof(DWORD);
+
+    if ((Cache.size() - Offset) / MinimumEntrySize < Header.ProfileCount)
+    {
+        return false;
+    }
+
+    for (DWORD i = 0; i < Header.ProfileCount; ++i)
+    {
+        std::wstring Name;
+        DWORD OptionCount = 0;
+        if (!ReadString(Name) || !ReadCount(OptionCount))
+        {
+            return false;
+        }
+
+        if ((Cache.size() - Offset) / MinimumEntrySize < OptionCount)
+        {
+            return false;
+        }
+
+        auto Profile = Profiles.emplace(Name, NSUDO_LAUNCHER_PROFILE());
+        if (!Profile.second)
+        {
+            return false;
+        }
+
+        for (DWORD j = 0; j < OptionCount; ++j)
+        {
+            std::wstring Option;
+            std::wstring Parameter;
+            if (!ReadString(Option) || !ReadString(Parameter))
+            {
+                return false;
+            }
+
+            // The parser never produces a nested profile selection or a
+            // duplicate option, so the cache must not contain them either.
+            if (0 == _wcsicmp(Option.c_str(), L"Profile") ||
+                !Profile.first->second.emplace(Option, Parameter).second)
+            {
+                return false;
+            }
+        }
+    }
+
+    return Offset == Cache.size();
+}
+
+/**
+ * @brief Reads the profiles from the compiled cache, the profiles are
+ *        cleared if the cache is rejected.
+ * @param Cache The content of the compiled cache.
+ * @param ContentHash The hash of the profile file.
+ * @param ContentSize The size of the profile file.
+ * @param Profiles The launch profiles.
+ * @return true if the cache is valid and matches the profile file.
+*/
+static bool ReadProfilesCache(
+    std::string const& Cache,
+    ULONGLONG ContentHash,
+    ULONGLONG ContentSize,
+    NSUDO_LAUNCHER_PROFILES& Profiles)
+{
+    Profiles.clear();
+
+    if (!::ReadProfilesCacheContent(
+        Cache,
+        ContentHash,
+        ContentSize,
+        Profiles))
+    {
+        Profiles.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Writes the profiles to the compiled cache. The cache is written
+ *        to a temporary file first and then renamed, so the readers never
+ *        see a partially written cache.
+ * @param CachePath The path of the compiled cache.
+ * @param ContentHash The hash of the profile file.
+ * @param ContentSize The size of the profile file.
+ * @param Profiles The launch profiles.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT WriteProfilesCache(
+    std::wstring const& CachePath,
+    ULONGLONG ContentHash,
+    ULONGLONG ContentSize,
+    NSUDO_LAUNCHER_PROFILES const& Profiles)
+{
+    std::vector<BYTE> Cache(sizeof(NSUDO_LAUNCHER_PROFILES_CACHE_HEADER));
+
+    NSUDO_LAUNCHER_PROFILES_CACHE_HEADER Header = { 0 };
+    Header.Magic = g_ProfilesCacheMagic;
+    Header.Version = g_ProfilesCacheVersion;
+    Header.ContentHash = ContentHash;
+    Header.ContentSize = ContentSize;
+    Header.ProfileCount = static_cast<DWORD>(Profiles.size());
+    std::memcpy(
+        Cache.data(),
+        &Header,
+        sizeof(NSUDO_LAUNCHER_PROFILES_CACHE_HEADER));
+
+    auto WriteCount = [&](DWORD Value)
+    {
+        const BYTE* Bytes = reinterpret_cast<const BYTE*>(&Value);
+        Cache.insert(Cache.end(), Bytes, Bytes + sizeof(DWORD));
+    };
+
+    auto WriteString = [&](std::wstring const& Value)
+    {
+        WriteCount(static_cast<DWORD>(Value.size()));
+        const BYTE* Bytes = reinterpret_cast<const BYTE*>(Value.data());
+        Cache.insert(
+            Cache.end(),
+            Bytes,
+            Bytes + Value.size() * sizeof(wchar_t));
+    };
+
+    for (auto const& Profile : Profiles)
+    {
+        WriteString(Profile.first);
+        WriteCount(static_cast<DWORD>(Profile.second.size()));
+        for (auto const& Option : Profile.second)
+        {
+            WriteString(Option.first);
+            WriteString(Option.second);
+        }
+    }
+
+    std::wstring TemporaryPath = Mile::FormatUtf16String(
+        L"%s.%u.tmp",
+        CachePath.c_str(),
+        ::GetCurrentProcessId());
+
+    HANDLE FileHandle = ::CreateFileW(
+        TemporaryPath.c_str(),
+        GENERIC_WRITE,
+        0,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    DWORD NumberOfBytesWritten = 0;
+    HRESULT hr = Mile::HResultFromLastError(::WriteFile(
+        FileHandle,
+        Cache.data(),
+        static_cast<DWORD>(Cache.size()),
+        &NumberOfBytesWritten,
+        nullptr));
+
+    ::CloseHandle(FileHandle);
+
+    if (hr == S_OK)
+    {
+        hr = Mile::HResultFromLastError(::MoveFileExW(
+            TemporaryPath.c_str(),
+            CachePath.c_str(),
+            MOVEFILE_REPLACE_EXISTING));
+    }
+
+    if (hr != S_OK)
+    {
+        ::DeleteFileW(TemporaryPath.c_str());
+    }
+
+    return hr;
+}
+
+/**
+ * @brief Parses the profile file. Each top-level table is a profile, and
+ *        each key of the table is an option of the command line. String
+ *        and integer values are used as the parameters, a boolean value
+ *        of true adds the option without a parameter.
+ * @param Content The content of the profile file.
+ * @param Profiles The launch profiles.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT ParseProfiles(
+    std::string const& Content,
+    NSUDO_LAUNCHER_PROFILES& Profiles)
+{
+    Profiles.clear();
+
+    std::size_t Offset = 0;
+    if (Content.size() >= 3 &&
+        Content[0] == '\xEF' &&
+        Content[1] == '\xBB' &&
+        Content[2] == '\xBF')
+    {
+        Offset = 3;
+    }
+
+    try
+    {
+        toml::table Root = toml::parse(std::string_view(
+            Content.data() + Offset,
+            Content.size() - Offset));
+
+        for (auto const& Item : Root)
+        {
+            toml::table const* Table = Item.second.as_table();
+            if (!Table)
+            {
+                continue;
+            }
+
+            NSUDO_LAUNCHER_PROFILE& Profile =
+                Profiles[Mile::ToUtf16String(Item.first)];
+
+            for (auto const& Option : *Table)
+            {
+                std::wstring Name = Mile::ToUtf16String(Option.first);
+
+                // Profiles are not allowed to select other profiles.
+                if (0 == _wcsicmp(Name.c_str(), L"Profile"))
+                {
+                    Profiles.clear();
+                    return E_INVALIDARG;
+                }
+
+                if (Option.second.is_string())
+                {
+                    Profile[Name] = Mile::ToUtf16String(
+                        Option.second.value_or<std::string>(""));
+                }
+                else if (Option.second.is_integer())
+                {
+                    Profile[Name] = std::to_wstring(
+                        Option.second.value_or<std::int64_t>(0));
+                }
+                else if (Option.second.is_boolean())
+                {
+                    if (Option.second.value_or(false))
+                    {
+                        Profile[Name] = std::wstring();
+                    }
+                }
+                else
+                {
+                    Profiles.clear();
+                    return E_INVALIDARG;
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        Profiles.clear();
+        return E_INVALIDARG;
+    }
+
+    return S_OK;
+}
+
+HRESULT NSudoLoadLaunchProfiles(
+    _In_ std::wstring const& ProfilesPath,
+    _Out_ NSUDO_LAUNCHER_PROFILES& Profiles)
+{
+    Profiles.clear();
+
+    std::string Content;
+    HRESULT hr = ::ReadWholeFile(ProfilesPath, Content);
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    ULONGLONG ContentHash = ::HashContent(Content);
+    ULONGLONG ContentSize = Content.size();
+
+    std::wstring CachePath =
+        ProfilesPath + NSUDO_LAUNCHER_PROFILES_CACHE_SUFFIX;
+
+    std::string Cache;
+    if (S_OK == ::ReadWholeFile(CachePath, Cache) &&
+        ::ReadProfilesCache(Cache, ContentHash, ContentSize, Profiles))
+    {
+        return S_OK;
+    }
+
+    hr = ::ParseProfiles(Content, Profiles);
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    // The profile directory may be read-only, the profiles are still usable
+    // without the compiled cache.
+    hr = ::WriteProfilesCache(CachePath, ContentHash, ContentSize, Profiles);
+    if (hr != S_OK)
+    {
+        ::NSudoWriteLog(
+            L"NSudoLoadLaunchProfiles",
+            Mile::FormatUtf16String(
+                L"%s failed, returns %d.",
+                L"Write the compiled cache of the launch profiles",
+                hr).c_str());
+    }
+
+    return S_OK;
+}
+
+HRESULT NSudoExpandLaunchProfile(
+    _In_ std::wstring const& ProfilesPath,
+    _Inout_ std::map<std::wstring, std::wstring>& OptionsAndParameters)
+{
+    auto ProfileOption = OptionsAndParameters.begin();
+    for (; ProfileOption != OptionsAndParameters.end(); ++ProfileOption)
+    {
+        if (0 == _wcsicmp(ProfileOption->first.c_str(), L"Profile"))
+        {
+            break;
+        }
+    }
+    if (ProfileOption == OptionsAndParameters.end())
+    {
+        return S_OK;
+    }
+
+    std::wstring ProfileName = ProfileOption->second;
+    OptionsAndParameters.erase(ProfileOption);
+
+    NSUDO_LAUNCHER_PROFILES Profiles;
+    HRESULT hr = ::NSudoLoadLaunchProfiles(ProfilesPath, Profiles);
+    if (hr != S_OK)
+    {
+        ::NSudoWriteLog(
+            L"NSudoExpandLaunchProfile",
+            Mile::FormatUtf16String(
+                L"%s failed, returns %d.",
+                L"Load the launch profiles",
+                hr).c_str());
+
+        return hr;
+    }
+
+    auto Profile = Profiles.begin();
+    for (; Profile != Profiles.end(); ++Profile)
+    {
+        if (0 == _wcsicmp(Profile->first.c_str(), ProfileName.c_str()))
+        {
+            break;
+        }
+    }
+    if (Profile == Profiles.end())
+    {
+        ::NSudoWriteLog(
+            L"NSudoExpandLaunchProfile",
+            Mile::FormatUtf16String(
+                L"Invalid Parameter: %s",
+                ProfileName.c_str()).c_str());
+
+        return Mile::HResult::FromWin32(ERROR_NOT_FOUND);
+    }
+
+    for (auto const& Option : Profile->second)
+    {
+        bool Overridden = false;
+        for (auto const& OptionAndParameter : OptionsAndParameters)
+        {
+            if (0 == _wcsicmp(
+                OptionAndParameter.first.c_str(),
+                Option.first.c_str()))
+            {
+                Overridden = true;
+                break;
+            }
+        }
+
+        if (!Overridden)
+        {
+            OptionsAndParameters.emplace(Option);
+        }
+    }
+
+    return S_OK;
+}
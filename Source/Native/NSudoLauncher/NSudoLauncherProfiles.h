@@ -0,0 +1,67 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherProfiles.h
+ * PURPOSE:   Definition for NSudo Launcher named launch profiles
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_PROFILES
+#define NSUDO_LAUNCHER_PROFILES
+
+#include <Windows.h>
+
+#include <map>
+#include <string>
+
+/**
+ * @brief The file name of the launch profiles, which is placed next to
+ *        NSudo.json.
+*/
+#define NSUDO_LAUNCHER_PROFILES_FILE_NAME L"NSudoProfiles.toml"
+
+/**
+ * @brief The suffix of the compiled cache of the launch profiles.
+*/
+#define NSUDO_LAUNCHER_PROFILES_CACHE_SUFFIX L".cache"
+
+/**
+ * @brief The options of a launch profile, in the same form as the options
+ *        and parameters parsed from the command line.
+*/
+typedef std::map<std::wstring, std::wstring> NSUDO_LAUNCHER_PROFILE;
+
+/**
+ * @brief The launch profiles, keyed by the profile name.
+*/
+typedef std::map<std::wstring, NSUDO_LAUNCHER_PROFILE> NSUDO_LAUNCHER_PROFILES;
+
+/**
+ * @brief Loads the launch profiles. The compiled cache next to the profile
+ *        file is used if its content hash matches the profile file, otherwise
+ *        the profile file is parsed and the cache is rebuilt.
+ * @param ProfilesPath The path of the profile file.
+ * @param Profiles The launch profiles.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+HRESULT NSudoLoadLaunchProfiles(
+    _In_ std::wstring const& ProfilesPath,
+    _Out_ NSUDO_LAUNCHER_PROFILES& Profiles);
+
+/**
+ * @brief Replaces the "Profile" option with the options of the selected
+ *        launch profile. The options specified in the command line take
+ *        precedence over the options of the profile.
+ * @param ProfilesPath The path of the profile file. It is only loaded if the
+ *                     "Profile" option is specified.
+ * @param OptionsAndParameters The options and parameters parsed from the
+ *                             command line.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+HRESULT NSudoExpandLaunchProfile(
+    _In_ std::wstring const& ProfilesPath,
+    _Inout_ std::map<std::wstring, std::wstring>& OptionsAndParameters);
+
+#endif // !NSUDO_LAUNCHER_PROFILES
@@ -3,8 +3,6 @@
 // Used by NSudoLauncherResources.rc
 #define IDI_NSUDO_LAUNCHER              2000
 #define IDR_STRING_TRANSLATIONS         2001
-#define IDR_STRING_COMMAND_LINE_HELP    2002
-#define IDR_STRING_LINKS                2003
 
 // Next default values for new objects
 // 
@@ -0,0 +1,1587 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherShortCuts.cpp
+ * PURPOSE:   Implementation for NSudo Launcher shortcut list
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#define NOMINMAX
+
+#include "NSudoLauncherShortCuts.h"
+
+#include "NSudoLauncherJson.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+
+/**
+ * @brief The UTF-8 byte order mark.
+*/
+static const char g_Utf8ByteOrderMark[] = "\xEF\xBB\xBF";
+
+/**
+ * @brief The magic number of the compiled shortcut index, "NSSI".
+*/
+static const DWORD g_ShortCutIndexMagic = 0x4953534E;
+
+/**
+ * @brief The version of the compiled shortcut index layout.
+*/
+static const DWORD g_ShortCutIndexVersion = 2;
+
+/**
+ * @brief The header of the compiled shortcut index. It is followed by the
+ *        entries sorted by the case-folded names, the hash buckets, the prefix
+ *        trie nodes, the prefix trie edges and the UTF-8 string table.
+*/
+typedef struct _NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER
+{
+    DWORD Magic;
+    DWORD Version;
+    ULONGLONG SourceSize;
+    ULONGLONG SourceLastWriteTime;
+    ULONGLONG SourceHash;
+    DWORD EntryCount;
+    DWORD BucketCount;
+    DWORD StringTableSize;
+    DWORD TrieNodeCount;
+    DWORD TrieEdgeCount;
+    DWORD Reserved;
+} NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER, *PNSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER;
+
+/**
+ * @brief An entry of the compiled shortcut index. The offsets are relative to
+ *        the string table, in bytes.
+*/
+typedef struct _NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY
+{
+    DWORD Hash;
+    DWORD FoldedNameOffset;
+    DWORD FoldedNameLength;
+    DWORD NameOffset;
+    DWORD NameLength;
+    DWORD TargetOffset;
+    DWORD TargetLength;
+    DWORD Reserved;
+} NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY, *PNSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY;
+
+/**
+ * @brief A node of the prefix trie over the bytes of the case-folded names.
+ *        The first node is the root. The edges of a node are stored together
+ *        and sorted by their bytes.
+*/
+typedef struct _NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE
+{
+    DWORD FirstEdge;
+    DWORD EdgeCount;
+    DWORD Entry; // The entry index plus one, 0 means no name ends here.
+} NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE, *PNSUDO_LAUNCHER_SHORTCUT_TRIE_NODE;
+
+/**
+ * @brief An edge of the prefix trie.
+*/
+typedef struct _NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE
+{
+    DWORD Byte;
+    DWORD Node;
+} NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE, *PNSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE;
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of the content.
+ * @param Content The content.
+ * @return The 64-bit FNV-1a hash of the content.
+*/
+static ULONGLONG HashContent(
+    std::string_view Content)
+{
+    ULONGLONG Hash = 14695981039346656037ULL;
+    for (char const& Character : Content)
+    {
+        Hash ^= static_cast<std::uint8_t>(Character);
+        Hash *= 1099511628211ULL;
+    }
+    return Hash;
+}
+
+/**
+ * @brief Computes the 32-bit FNV-1a hash of the case-folded name.
+ * @param FoldedName The case-folded name.
+ * @return The 32-bit FNV-1a hash of the case-folded name.
+*/
+static DWORD HashFoldedName(
+    std::string_view FoldedName)
+{
+    DWORD Hash = 2166136261U;
+    for (char const& Character : FoldedName)
+    {
+        Hash ^= static_cast<std::uint8_t>(Character);
+        Hash *= 16777619U;
+    }
+    return Hash;
+}
+
+/**
+ * @brief Folds the case of the UTF-8 name, the folded names are compared
+ *        ordinally. The ASCII names are folded without conversions.
+ * @param Name The UTF-8 name.
+ * @return The case-folded UTF-8 name.
+*/
+static std::string FoldName(
+    std::string_view Name)
+{
+    std::string Result(Name);
+
+    bool IsAscii = true;
+    for (char& Character : Result)
+    {
+        if (static_cast<std::uint8_t>(Character) >= 0x80)
+        {
+            IsAscii = false;
+            break;
+        }
+
+        if (Character >= 'a' && Character <= 'z')
+        {
+            Character = static_cast<char>(Character - 'a' + 'A');
+        }
+    }
+
+    if (IsAscii)
+    {
+        return Result;
+    }
+
+    std::wstring WideName = Mile::ToUtf16String(std::string(Name));
+    if (WideName.empty())
+    {
+        return std::string(Name);
+    }
+
+    ::LCMapStringEx(
+        LOCALE_NAME_INVARIANT,
+        LCMAP_UPPERCASE,
+        WideName.c_str(),
+        static_cast<int>(WideName.size()),
+        &WideName[0],
+        static_cast<int>(WideName.size()),
+        nullptr,
+        nullptr,
+        0);
+
+    return Mile::ToUtf8String(WideName);
+}
+
+/**
+ * @brief Gets the length of the UTF-8 sequence at the position. The invalid
+ *        sequences are treated as single bytes.
+ * @param Value The UTF-8 string.
+ * @param Position The position of the sequence. It must be less than the
+ *                 length of Value.
+ * @return The length of the UTF-8 sequence, in bytes.
+*/
+static std::size_t GetUtf8SequenceLength(
+    std::string_view Value,
+    std::size_t Position)
+{
+    BYTE LeadByte = static_cast<BYTE>(Value[Position]);
+
+    std::size_t Length = 1;
+    if (LeadByte >= 0xF0)
+    {
+        Length = 4;
+    }
+    else if (LeadByte >= 0xE0)
+    {
+        Length = 3;
+    }
+    else if (LeadByte >= 0xC0)
+    {
+        Length = 2;
+    }
+
+    if (Length > Value.size() - Position)
+    {
+        return 1;
+    }
+
+    for (std::size_t i = 1; i < Length; ++i)
+    {
+        if ((static_cast<BYTE>(Value[Position + i]) & 0xC0) != 0x80)
+        {
+            return 1;
+        }
+    }
+
+    return Length;
+}
+
+/**
+ * @brief Checks whether the character is a command line argument separator.
+ * @param Character The character.
+ * @return True if the character is a space or a tab.
+*/
+static bool IsArgumentSeparator(
+    wchar_t Character)
+{
+    return Character == L' ' || Character == L'\t';
+}
+
+/**
+ * @brief Expands the target of the shortcut with the arguments. The "{N}"
+ *        placeholders are replaced with the N-th argument, which keeps its
+ *        quotes, or nothing if there are not enough arguments. The "{*}"
+ *        placeholders are replaced with all arguments. If the target has no
+ *        placeholders, the arguments are appended to the target.
+ * @param Target The target of the shortcut.
+ * @param Arguments The arguments without the leading and trailing separators.
+ * @return The expanded target of the shortcut.
+*/
+static std::wstring ExpandShortCutTarget(
+    std::wstring const& Target,
+    std::wstring const& Arguments)
+{
+    std::vector<std::wstring_view> ArgumentList;
+    {
+        std::wstring_view Rest(Arguments);
+        std::size_t Position = 0;
+        while (Position < Rest.size())
+        {
+            while (Position < Rest.size() &&
+                ::IsArgumentSeparator(Rest[Position]))
+            {
+                ++Position;
+            }
+            if (Position == Rest.size())
+            {
+                break;
+            }
+
+            std::size_t Start = Position;
+            bool InQuotes = false;
+            for (; Position < Rest.size(); ++Position)
+            {
+                if (Rest[Position] == L'"')
+                {
+                    InQuotes = !InQuotes;
+                }
+                else if (!InQuotes && ::IsArgumentSeparator(Rest[Position]))
+                {
+                    break;
+                }
+            }
+
+            ArgumentList.push_back(Rest.substr(Start, Position - Start));
+        }
+    }
+
+    std::wstring Result;
+    Result.reserve(Target.size() + Arguments.size() + 1);
+
+    bool HasPlaceholder = false;
+    for (std::size_t i = 0; i < Target.size(); ++i)
+    {
+        std::size_t End = (Target[i] == L'{')
+            ? Target.find(L'}', i + 1)
+            : std::wstring::npos;
+        if (End == std::wstring::npos || End == i + 1)
+        {
+            Result.push_back(Target[i]);
+            continue;
+        }
+
+        std::wstring_view Placeholder =
+            std::wstring_view(Target).substr(i + 1, End - i - 1);
+        if (Placeholder == L"*")
+        {
+            Result.append(Arguments);
+        }
+        else if (Placeholder.size() <= 4 && std::all_of(
+            Placeholder.begin(),
+            Placeholder.end(),
+            [](wchar_t Character)
+            {
+                return Character >= L'0' && Character <= L'9';
+            }))
+        {
+            std::size_t ArgumentIndex = 0;
+            for (wchar_t const& Character : Placeholder)
+            {
+                ArgumentIndex = ArgumentIndex * 10 + (Character - L'0');
+            }
+            if (ArgumentIndex < ArgumentList.size())
+            {
+                Result.append(ArgumentList[ArgumentIndex]);
+            }
+        }
+        else
+        {
+            Result.push_back(Target[i]);
+            continue;
+        }
+
+        HasPlaceholder = true;
+        i = End;
+    }
+
+    if (!HasPlaceholder && !Arguments.empty())
+    {
+        Result.push_back(L' ');
+        Result.append(Arguments);
+    }
+
+    return Result;
+}
+
+/**
+ * @brief Maps the whole file read-only.
+ * @param FileHandle The file opened for reading.
+ * @param FileSize The size of the file. It must not be 0.
+ * @param View Receives the view of the file.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT MapWholeFile(
+    _In_ HANDLE FileHandle,
+    _In_ UINT64 FileSize,
+    _Out_ const BYTE** View)
+{
+    *View = nullptr;
+
+    if (FileSize > static_cast<SIZE_T>(-1))
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    HANDLE FileMappingHandle = ::CreateFileMappingW(
+        FileHandle,
+        nullptr,
+        PAGE_READONLY,
+        0,
+        0,
+        nullptr);
+    if (!FileMappingHandle)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    // The view keeps the mapping alive after the handle is closed.
+    *View = reinterpret_cast<const BYTE*>(::MapViewOfFile(
+        FileMappingHandle,
+        FILE_MAP_READ,
+        0,
+        0,
+        0));
+    HRESULT hr = Mile::HResultFromLastError(*View != nullptr);
+
+    ::CloseHandle(FileMappingHandle);
+
+    return hr;
+}
+
+/**
+ * @brief Checks the header and the layout of the compiled shortcut index.
+ *        The entries are checked when they are accessed, so the cost does
+ *        not depend on the number of the shortcuts.
+ * @param Index The compiled shortcut index.
+ * @param IndexSize The size of the compiled shortcut index.
+ * @return True if the layout is valid.
+*/
+static bool CheckIndexLayout(
+    _In_ const BYTE* Index,
+    _In_ std::size_t IndexSize)
+{
+    if (IndexSize < sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER))
+    {
+        return false;
+    }
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(Index);
+    if (Header->Magic != g_ShortCutIndexMagic ||
+        Header->Version != g_ShortCutIndexVersion)
+    {
+        return false;
+    }
+
+    // The bucket count is a power of two with at least one empty bucket, so
+    // the probing always stops.
+    if (!Header->BucketCount ||
+        (Header->BucketCount & (Header->BucketCount - 1)) ||
+        Header->BucketCount <= Header->EntryCount)
+    {
+        return false;
+    }
+
+    ULONGLONG ExpectedSize =
+        sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER) +
+        static_cast<ULONGLONG>(Header->EntryCount) *
+        sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY) +
+        static_cast<ULONGLONG>(Header->BucketCount) * sizeof(DWORD) +
+        static_cast<ULONGLONG>(Header->TrieNodeCount) *
+        sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE) +
+        static_cast<ULONGLONG>(Header->TrieEdgeCount) *
+        sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE) +
+        Header->StringTableSize;
+
+    // The trie always has the root node.
+    return Header->TrieNodeCount && ExpectedSize == IndexSize;
+}
+
+/**
+ * @brief Gets the prefix trie nodes of the compiled shortcut index.
+ * @param Index The compiled shortcut index with a valid layout.
+ * @return The prefix trie nodes.
+*/
+static const NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE* GetTrieNodes(
+    _In_ const BYTE* Index)
+{
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(Index);
+
+    return reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE*>(
+        Index +
+        sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER) +
+        Header->EntryCount * sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY) +
+        Header->BucketCount * sizeof(DWORD));
+}
+
+/**
+ * @brief Gets the prefix trie edges of the compiled shortcut index.
+ * @param Index The compiled shortcut index with a valid layout.
+ * @return The prefix trie edges.
+*/
+static const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE* GetTrieEdges(
+    _In_ const BYTE* Index)
+{
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(Index);
+
+    return reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE*>(
+        ::GetTrieNodes(Index) + Header->TrieNodeCount);
+}
+
+/**
+ * @brief Gets the string in the string table of the compiled shortcut index.
+ * @param Index The compiled shortcut index with a valid layout.
+ * @param Offset The offset of the string.
+ * @param Length The length of the string.
+ * @return The string, or an empty string if it is out of the string table.
+*/
+static std::string_view GetIndexString(
+    _In_ const BYTE* Index,
+    _In_ DWORD Offset,
+    _In_ DWORD Length)
+{
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(Index);
+
+    if (Offset > Header->StringTableSize ||
+        Length > Header->StringTableSize - Offset)
+    {
+        return std::string_view();
+    }
+
+    const char* StringTable = reinterpret_cast<const char*>(
+        ::GetTrieEdges(Index) + Header->TrieEdgeCount);
+
+    return std::string_view(StringTable + Offset, Length);
+}
+
+/**
+ * @brief Builds the compiled shortcut index from the content of NSudo.json.
+ * @param Content The content of NSudo.json.
+ * @param SourceHash The content hash of NSudo.json.
+ * @param SourceLastWriteTime The last write time of NSudo.json.
+ * @param Index Receives the compiled shortcut index.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT BuildIndex(
+    _In_ std::string_view Content,
+    _In_ ULONGLONG SourceHash,
+    _In_ ULONGLONG SourceLastWriteTime,
+    _Out_ std::vector<BYTE>& Index)
+{
+    Index.clear();
+
+    std::string_view JsonString = Content;
+    if (JsonString.size() >= 3 &&
+        0 == JsonString.compare(0, 3, g_Utf8ByteOrderMark, 3))
+    {
+        JsonString.remove_prefix(3);
+    }
+
+    std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER> Members;
+    if (!JsonString.empty() && !::NSudoReadJsonStringMembers(
+        JsonString,
+        "ShortCutList_V2",
+        Members))
+    {
+        return E_INVALIDARG;
+    }
+
+    struct FoldedMember
+    {
+        std::string FoldedName;
+        std::size_t MemberIndex;
+    };
+
+    std::vector<FoldedMember> FoldedMembers;
+    FoldedMembers.reserve(Members.size());
+    for (std::size_t i = 0; i < Members.size(); ++i)
+    {
+        FoldedMembers.push_back({ ::FoldName(Members[i].first), i });
+    }
+
+    // The first definition of a name wins, the same as the JSON object
+    // semantics used by the previous versions.
+    std::stable_sort(
+        FoldedMembers.begin(),
+        FoldedMembers.end(),
+        [](FoldedMember const& Left, FoldedMember const& Right)
+        {
+            return Left.FoldedName < Right.FoldedName;
+        });
+    FoldedMembers.erase(
+        std::unique(
+            FoldedMembers.begin(),
+            FoldedMembers.end(),
+            [](FoldedMember const& Left, FoldedMember const& Right)
+            {
+                return Left.FoldedName == Right.FoldedName;
+            }),
+        FoldedMembers.end());
+
+    DWORD EntryCount = static_cast<DWORD>(FoldedMembers.size());
+    DWORD BucketCount = 1;
+    while (BucketCount <= EntryCount * 2)
+    {
+        BucketCount <<= 1;
+    }
+
+    // The trie is built from the sorted names. The names sharing the first
+    // Depth bytes are a contiguous range, so each range is split by the byte
+    // at Depth into the children of its node, whose edges are allocated
+    // together.
+    struct TrieRange
+    {
+        DWORD Node;
+        std::size_t First;
+        std::size_t Last;
+        std::size_t Depth;
+    };
+
+    std::vector<NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE> TrieNodes;
+    std::vector<NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE> TrieEdges;
+    std::vector<TrieRange> PendingRanges;
+
+    TrieNodes.push_back({ 0, 0, 0 });
+    PendingRanges.push_back({ 0, 0, FoldedMembers.size(), 0 });
+    while (!PendingRanges.empty())
+    {
+        TrieRange Range = PendingRanges.back();
+        PendingRanges.pop_back();
+
+        if (Range.First < Range.Last &&
+            FoldedMembers[Range.First].FoldedName.size() == Range.Depth)
+        {
+            TrieNodes[Range.Node].Entry = static_cast<DWORD>(Range.First + 1);
+            ++Range.First;
+        }
+
+        TrieNodes[Range.Node].FirstEdge = static_cast<DWORD>(TrieEdges.size());
+
+        for (std::size_t First = Range.First; First < Range.Last;)
+        {
+            BYTE Byte = static_cast<BYTE>(
+                FoldedMembers[First].FoldedName[Range.Depth]);
+
+            std::size_t Last = First + 1;
+            while (Last < Range.Last && Byte == static_cast<BYTE>(
+                FoldedMembers[Last].FoldedName[Range.Depth]))
+            {
+                ++Last;
+            }
+
+            DWORD Child = static_cast<DWORD>(TrieNodes.size());
+            TrieNodes.push_back({ 0, 0, 0 });
+            TrieEdges.push_back({ Byte, Child });
+            PendingRanges.push_back({ Child, First, Last, Range.Depth + 1 });
+
+            First = Last;
+        }
+
+        TrieNodes[Range.Node].EdgeCount = static_cast<DWORD>(
+            TrieEdges.size() - TrieNodes[Range.Node].FirstEdge);
+    }
+
+    ULONGLONG StringTableSize = 0;
+    for (FoldedMember const& Item : FoldedMembers)
+    {
+        StringTableSize += Item.FoldedName.size();
+        StringTableSize += Members[Item.MemberIndex].first.size();
+        StringTableSize += Members[Item.MemberIndex].second.size();
+    }
+    if (StringTableSize > MAXDWORD)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::size_t EntriesOffset = sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER);
+    std::size_t BucketsOffset = EntriesOffset +
+        EntryCount * sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY);
+    std::size_t TrieNodesOffset = BucketsOffset +
+        BucketCount * sizeof(DWORD);
+    std::size_t TrieEdgesOffset = TrieNodesOffset +
+        TrieNodes.size() * sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE);
+    std::size_t StringTableOffset = TrieEdgesOffset +
+        TrieEdges.size() * sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE);
+
+    Index.resize(StringTableOffset + static_cast<std::size_t>(StringTableSize));
+
+    PNSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER Header =
+        reinterpret_cast<PNSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER>(&Index[0]);
+    Header->Magic = g_ShortCutIndexMagic;
+    Header->Version = g_ShortCutIndexVersion;
+    Header->SourceSize = Content.size();
+    Header->SourceLastWriteTime = SourceLastWriteTime;
+    Header->SourceHash = SourceHash;
+    Header->EntryCount = EntryCount;
+    Header->BucketCount = BucketCount;
+    Header->StringTableSize = static_cast<DWORD>(StringTableSize);
+    Header->TrieNodeCount = static_cast<DWORD>(TrieNodes.size());
+    Header->TrieEdgeCount = static_cast<DWORD>(TrieEdges.size());
+    Header->Reserved = 0;
+
+    std::memcpy(
+        &Index[TrieNodesOffset],
+        TrieNodes.data(),
+        TrieNodes.size() * sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE));
+    if (!TrieEdges.empty())
+    {
+        std::memcpy(
+            &Index[TrieEdgesOffset],
+            TrieEdges.data(),
+            TrieEdges.size() * sizeof(NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE));
+    }
+
+    PNSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY Entries =
+        reinterpret_cast<PNSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY>(
+            &Index[EntriesOffset]);
+    DWORD* Buckets = reinterpret_cast<DWORD*>(&Index[BucketsOffset]);
+    char* StringTable = reinterpret_cast<char*>(&Index[0] + StringTableOffset);
+
+    DWORD Offset = 0;
+    auto AppendString = [&](std::string_view Value) -> DWORD
+    {
+        DWORD Current = Offset;
+        std::memcpy(StringTable + Offset, Value.data(), Value.size());
+        Offset += static_cast<DWORD>(Value.size());
+        return Current;
+    };
+
+    for (DWORD i = 0; i < EntryCount; ++i)
+    {
+        FoldedMember const& Item = FoldedMembers[i];
+        NSUDO_LAUNCHER_JSON_STRING_MEMBER const& Member =
+            Members[Item.MemberIndex];
+
+        NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY& Entry = Entries[i];
+        Entry.Hash = ::HashFoldedName(Item.FoldedName);
+        Entry.FoldedNameLength = static_cast<DWORD>(Item.FoldedName.size());
+        Entry.FoldedNameOffset = AppendString(Item.FoldedName);
+        Entry.NameLength = static_cast<DWORD>(Member.first.size());
+        Entry.NameOffset = AppendString(Member.first);
+        Entry.TargetLength = static_cast<DWORD>(Member.second.size());
+        Entry.TargetOffset = AppendString(Member.second);
+        Entry.Reserved = 0;
+
+        // The buckets hold the entry index plus one, 0 means empty.
+        DWORD Bucket = Entry.Hash & (BucketCount - 1);
+        while (Buckets[Bucket])
+        {
+            Bucket = (Bucket + 1) & (BucketCount - 1);
+        }
+        Buckets[Bucket] = i + 1;
+    }
+
+    return S_OK;
+}
+
+/**
+ * @brief Writes the file. The content is written to a temporary file first
+ *        and then renamed, so the readers never see a partially written file.
+ * @param FilePath The path of the file.
+ * @param Content The content of the file.
+ * @param ContentSize The size of the content.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT WriteFileAtomically(
+    std::wstring const& FilePath,
+    _In_ const void* Content,
+    _In_ std::size_t ContentSize)
+{
+    if (ContentSize > MAXDWORD)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::wstring TemporaryPath = Mile::FormatUtf16String(
+        L"%s.%u.tmp",
+        FilePath.c_str(),
+        ::GetCurrentProcessId());
+
+    HANDLE FileHandle = ::CreateFileW(
+        TemporaryPath.c_str(),
+        GENERIC_WRITE,
+        0,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    DWORD NumberOfBytesWritten = 0;
+    HRESULT hr = Mile::HResultFromLastError(::WriteFile(
+        FileHandle,
+        Content,
+        static_cast<DWORD>(ContentSize),
+        &NumberOfBytesWritten,
+        nullptr));
+
+    ::CloseHandle(FileHandle);
+
+    if (hr == S_OK)
+    {
+        hr = Mile::HResultFromLastError(::MoveFileExW(
+            TemporaryPath.c_str(),
+            FilePath.c_str(),
+            MOVEFILE_REPLACE_EXISTING));
+    }
+
+    if (hr != S_OK)
+    {
+        ::DeleteFileW(TemporaryPath.c_str());
+    }
+
+    return hr;
+}
+
+CNSudoShortCutList::~CNSudoShortCutList()
+{
+    this->Close();
+}
+
+HRESULT CNSudoShortCutList::Load(
+    _In_ std::wstring const& ShortCutListPath)
+{
+    this->Close();
+
+    HANDLE SourceHandle = ::CreateFileW(
+        ShortCutListPath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (SourceHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    auto SourceHandleCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        ::CloseHandle(SourceHandle);
+    });
+
+    BY_HANDLE_FILE_INFORMATION SourceInformation;
+    if (!::GetFileInformationByHandle(SourceHandle, &SourceInformation))
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    ULONGLONG SourceSize =
+        (static_cast<ULONGLONG>(SourceInformation.nFileSizeHigh) << 32) |
+        SourceInformation.nFileSizeLow;
+    ULONGLONG SourceLastWriteTime =
+        (static_cast<ULONGLONG>(
+            SourceInformation.ftLastWriteTime.dwHighDateTime) << 32) |
+        SourceInformation.ftLastWriteTime.dwLowDateTime;
+
+    std::wstring IndexPath =
+        ShortCutListPath + NSUDO_LAUNCHER_SHORTCUT_INDEX_SUFFIX;
+
+    const BYTE* CachedIndex = nullptr;
+    std::size_t CachedIndexSize = 0;
+    {
+        HANDLE IndexHandle = ::CreateFileW(
+            IndexPath.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (IndexHandle != INVALID_HANDLE_VALUE)
+        {
+            UINT64 IndexSize = 0;
+            if (S_OK == Mile::GetFileSize(IndexHandle, &IndexSize) &&
+                IndexSize &&
+                S_OK == ::MapWholeFile(IndexHandle, IndexSize, &CachedIndex))
+            {
+                CachedIndexSize = static_cast<std::size_t>(IndexSize);
+            }
+
+            ::CloseHandle(IndexHandle);
+        }
+    }
+
+    if (CachedIndex && CNSudoShortCutList::IsIndexCurrent(
+        CachedIndex,
+        CachedIndexSize,
+        SourceSize,
+        SourceLastWriteTime))
+    {
+        this->m_MappedIndex = CachedIndex;
+        this->m_Index = CachedIndex;
+        this->m_IndexSize = CachedIndexSize;
+        return S_OK;
+    }
+
+    auto CachedIndexCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        if (CachedIndex)
+        {
+            ::UnmapViewOfFile(CachedIndex);
+        }
+    });
+
+    const BYTE* SourceView = nullptr;
+    if (SourceSize)
+    {
+        HRESULT hr = ::MapWholeFile(SourceHandle, SourceSize, &SourceView);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    auto SourceViewCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        if (SourceView)
+        {
+            ::UnmapViewOfFile(SourceView);
+        }
+    });
+
+    HRESULT hr = this->Build(
+        std::string_view(
+            reinterpret_cast<const char*>(SourceView),
+            static_cast<std::size_t>(SourceSize)),
+        SourceLastWriteTime,
+        CachedIndex,
+        CachedIndexSize,
+        nullptr);
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    // The index file is only a cache, e.g. it cannot be written when NSudo is
+    // placed in a read-only directory, so the failure is ignored.
+    if (CachedIndex)
+    {
+        ::UnmapViewOfFile(CachedIndex);
+        CachedIndex = nullptr;
+    }
+    ::WriteFileAtomically(
+        IndexPath,
+        this->m_OwnedIndex.data(),
+        this->m_OwnedIndex.size());
+
+    return S_OK;
+}
+
+HRESULT CNSudoShortCutList::Build(
+    _In_ std::string_view Content,
+    _In_ ULONGLONG SourceLastWriteTime,
+    _In_opt_ const BYTE* CachedIndex,
+    _In_ std::size_t CachedIndexSize,
+    _Out_opt_ bool* CachedIndexReused)
+{
+    this->Close();
+
+    if (CachedIndexReused)
+    {
+        *CachedIndexReused = false;
+    }
+
+    ULONGLONG SourceHash = ::HashContent(Content);
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* CachedHeader =
+        (CachedIndex && ::CheckIndexLayout(CachedIndex, CachedIndexSize))
+        ? reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(
+            CachedIndex)
+        : nullptr;
+
+    if (CachedHeader &&
+        CachedHeader->SourceSize == Content.size() &&
+        CachedHeader->SourceHash == SourceHash)
+    {
+        // Only the last write time is changed, e.g. the file is copied, so
+        // the index is reused with the new last write time.
+        this->m_OwnedIndex.assign(
+            CachedIndex,
+            CachedIndex + CachedIndexSize);
+        reinterpret_cast<PNSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER>(
+            &this->m_OwnedIndex[0])->SourceLastWriteTime =
+            SourceLastWriteTime;
+
+        if (CachedIndexReused)
+        {
+            *CachedIndexReused = true;
+        }
+    }
+    else
+    {
+        HRESULT hr = ::BuildIndex(
+            Content,
+            SourceHash,
+            SourceLastWriteTime,
+            this->m_OwnedIndex);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    this->m_Index = &this->m_OwnedIndex[0];
+    this->m_IndexSize = this->m_OwnedIndex.size();
+
+    return S_OK;
+}
+
+HRESULT CNSudoShortCutList::LoadIndex(
+    _In_ const BYTE* Index,
+    _In_ std::size_t IndexSize)
+{
+    this->Close();
+
+    if (!Index || !::CheckIndexLayout(Index, IndexSize))
+    {
+        return E_INVALIDARG;
+    }
+
+    this->m_OwnedIndex.assign(Index, Index + IndexSize);
+
+    this->m_Index = &this->m_OwnedIndex[0];
+    this->m_IndexSize = this->m_OwnedIndex.size();
+
+    return S_OK;
+}
+
+bool CNSudoShortCutList::IsIndexCurrent(
+    _In_ const BYTE* Index,
+    _In_ std::size_t IndexSize,
+    _In_ ULONGLONG SourceSize,
+    _In_ ULONGLONG SourceLastWriteTime)
+{
+    if (!Index || !::CheckIndexLayout(Index, IndexSize))
+    {
+        return false;
+    }
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(Index);
+
+    return Header->SourceSize == SourceSize &&
+        Header->SourceLastWriteTime == SourceLastWriteTime;
+}
+
+void CNSudoShortCutList::Close()
+{
+    if (this->m_MappedIndex)
+    {
+        ::UnmapViewOfFile(this->m_MappedIndex);
+        this->m_MappedIndex = nullptr;
+    }
+
+    this->m_OwnedIndex.clear();
+
+    this->m_Index = nullptr;
+    this->m_IndexSize = 0;
+}
+
+void CNSudoShortCutList::Swap(
+    _Inout_ CNSudoShortCutList& Other)
+{
+    // The owned index keeps its buffer when the vectors are swapped, so
+    // m_Index is still valid.
+    std::swap(this->m_MappedIndex, Other.m_MappedIndex);
+    this->m_OwnedIndex.swap(Other.m_OwnedIndex);
+    std::swap(this->m_Index, Other.m_Index);
+    std::swap(this->m_IndexSize, Other.m_IndexSize);
+}
+
+const BYTE* CNSudoShortCutList::GetIndex() const
+{
+    return this->m_Index;
+}
+
+std::size_t CNSudoShortCutList::GetIndexSize() const
+{
+    return this->m_IndexSize;
+}
+
+std::size_t CNSudoShortCutList::GetCount() const
+{
+    if (!this->m_Index)
+    {
+        return 0;
+    }
+
+    return reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(
+        this->m_Index)->EntryCount;
+}
+
+std::string_view CNSudoShortCutList::GetName(
+    _In_ std::size_t Index) const
+{
+    if (Index >= this->GetCount())
+    {
+        return std::string_view();
+    }
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY& Entry =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY*>(
+            this->m_Index + sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER))[
+                Index];
+
+    return ::GetIndexString(this->m_Index, Entry.NameOffset, Entry.NameLength);
+}
+
+bool CNSudoShortCutList::Find(
+    _In_ std::string_view Name,
+    _Out_ std::string_view& Target) const
+{
+    Target = std::string_view();
+
+    if (!this->GetCount())
+    {
+        return false;
+    }
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(
+            this->m_Index);
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY* Entries =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY*>(
+            this->m_Index + sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER));
+    const DWORD* Buckets = reinterpret_cast<const DWORD*>(
+        Entries + Header->EntryCount);
+
+    std::string FoldedName = ::FoldName(Name);
+    DWORD Hash = ::HashFoldedName(FoldedName);
+
+    DWORD Mask = Header->BucketCount - 1;
+    DWORD Bucket = Hash & Mask;
+    for (DWORD i = 0; i < Header->BucketCount && Buckets[Bucket]; ++i)
+    {
+        DWORD EntryIndex = Buckets[Bucket] - 1;
+        if (EntryIndex < Header->EntryCount)
+        {
+            const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY& Entry =
+                Entries[EntryIndex];
+            if (Entry.Hash == Hash && FoldedName == ::GetIndexString(
+                this->m_Index,
+                Entry.FoldedNameOffset,
+                Entry.FoldedNameLength))
+            {
+                Target = ::GetIndexString(
+                    this->m_Index,
+                    Entry.TargetOffset,
+                    Entry.TargetLength);
+                return true;
+            }
+        }
+
+        Bucket = (Bucket + 1) & Mask;
+    }
+
+    return false;
+}
+
+bool CNSudoShortCutList::FindPrefix(
+    _In_ std::string_view CommandLine,
+    _Out_ std::string_view& Target,
+    _Out_ std::size_t& NameLength) const
+{
+    Target = std::string_view();
+    NameLength = 0;
+
+    if (!this->GetCount())
+    {
+        return false;
+    }
+
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER* Header =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER*>(
+            this->m_Index);
+    const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY* Entries =
+        reinterpret_cast<const NSUDO_LAUNCHER_SHORTCUT_INDEX_ENTRY*>(
+            this->m_Index + sizeof(NSUDO_LAUNCHER_SHORTCUT_INDEX_HEADER));
+    const NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE* Nodes =
+        ::GetTrieNodes(this->m_Index);
+    const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE* Edges =
+        ::GetTrieEdges(this->m_Index);
+
+    bool Found = false;
+
+    DWORD Node = 0;
+    std::size_t Position = 0;
+    for (;;)
+    {
+        // Keep the longest name which ends at an argument boundary, e.g.
+        // "PowerShell ISE" instead of "PowerShell".
+        DWORD Entry = Nodes[Node].Entry;
+        if (Entry && Entry <= Header->EntryCount && (
+            Position == CommandLine.size() ||
+            CommandLine[Position] == ' ' ||
+            CommandLine[Position] == '\t'))
+        {
+            Target = ::GetIndexString(
+                this->m_Index,
+                Entries[Entry - 1].TargetOffset,
+                Entries[Entry - 1].TargetLength);
+            NameLength = Position;
+            Found = true;
+        }
+
+        if (Position == CommandLine.size())
+        {
+            break;
+        }
+
+        // The names are folded by characters, so the command line is folded
+        // in the same way as the walk goes.
+        std::size_t SequenceLength =
+            ::GetUtf8SequenceLength(CommandLine, Position);
+        std::string FoldedSequence = ::FoldName(
+            CommandLine.substr(Position, SequenceLength));
+
+        for (char const& Character : FoldedSequence)
+        {
+            const NSUDO_LAUNCHER_SHORTCUT_TRIE_NODE& Current = Nodes[Node];
+            if (Current.FirstEdge > Header->TrieEdgeCount ||
+                Current.EdgeCount > Header->TrieEdgeCount - Current.FirstEdge)
+            {
+                return Found;
+            }
+
+            const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE* FirstEdge =
+                Edges + Current.FirstEdge;
+            const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE* LastEdge =
+                FirstEdge + Current.EdgeCount;
+            DWORD Byte = static_cast<BYTE>(Character);
+
+            const NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE* Edge = std::lower_bound(
+                FirstEdge,
+                LastEdge,
+                Byte,
+                [](NSUDO_LAUNCHER_SHORTCUT_TRIE_EDGE const& Left, DWORD Right)
+                {
+                    return Left.Byte < Right;
+                });
+            if (Edge == LastEdge ||
+                Edge->Byte != Byte ||
+                Edge->Node >= Header->TrieNodeCount)
+            {
+                return Found;
+            }
+
+            Node = Edge->Node;
+        }
+
+        Position += SequenceLength;
+    }
+
+    return Found;
+}
+
+void CNSudoShortCutAdapter::Read(
+    const std::wstring& ShortCutListPath,
+    CNSudoShortCutList& ShortCutList)
+{
+    ShortCutList.Load(ShortCutListPath);
+}
+
+std::wstring CNSudoShortCutAdapter::Translate(
+    const CNSudoShortCutList& ShortCutList,
+    const std::wstring& CommandLine)
+{
+    if (CommandLine.empty() || !ShortCutList.GetCount())
+    {
+        return CommandLine;
+    }
+
+    std::string CommandLineUtf8 = Mile::ToUtf8String(CommandLine);
+
+    std::string_view Target;
+    std::size_t NameLength = 0;
+    if (CommandLineUtf8[0] == '"')
+    {
+        // The name of the shortcut is quoted, e.g. the name contains spaces.
+        std::size_t End = CommandLineUtf8.find('"', 1);
+        if (End == std::string::npos ||
+            (End + 1 < CommandLineUtf8.size() &&
+                CommandLineUtf8[End + 1] != ' ' &&
+                CommandLineUtf8[End + 1] != '\t') ||
+            !ShortCutList.FindPrefix(
+                std::string_view(CommandLineUtf8).substr(1, End - 1),
+                Target,
+                NameLength) ||
+            NameLength != End - 1)
+        {
+            return CommandLine;
+        }
+        NameLength = End + 1;
+    }
+    else if (!ShortCutList.FindPrefix(CommandLineUtf8, Target, NameLength))
+    {
+        return CommandLine;
+    }
+
+    std::wstring Arguments;
+    if (NameLength < CommandLineUtf8.size())
+    {
+        Arguments = Mile::ToUtf16String(CommandLineUtf8.substr(NameLength));
+
+        std::size_t First = 0;
+        while (First < Arguments.size() &&
+            ::IsArgumentSeparator(Arguments[First]))
+        {
+            ++First;
+        }
+        std::size_t Last = Arguments.size();
+        while (Last > First && ::IsArgumentSeparator(Arguments[Last - 1]))
+        {
+            --Last;
+        }
+        Arguments = Arguments.substr(First, Last - First);
+    }
+
+    return ::ExpandShortCutTarget(
+        Mile::ToUtf16String(std::string(Target)),
+        Arguments);
+}
+
+CNSudoShortCutListWatcher::~CNSudoShortCutListWatcher()
+{
+    this->Stop();
+}
+
+HRESULT CNSudoShortCutListWatcher::Start(
+    _In_ std::wstring const& ShortCutListPath,
+    _In_ CNSudoShortCutList const& ShortCutList,
+    _In_ HWND NotifyWindow,
+    _In_ UINT NotifyMessage)
+{
+    this->Stop();
+
+    std::size_t Separator = ShortCutListPath.find_last_of(L'\\');
+    if (Separator == std::wstring::npos)
+    {
+        return E_INVALIDARG;
+    }
+
+    this->m_ShortCutListPath = ShortCutListPath;
+    this->m_FileName = ShortCutListPath.substr(Separator + 1);
+    this->m_NotifyWindow = NotifyWindow;
+    this->m_NotifyMessage = NotifyMessage;
+
+    this->m_Names.clear();
+    this->m_Names.reserve(ShortCutList.GetCount());
+    for (std::size_t i = 0; i < ShortCutList.GetCount(); ++i)
+    {
+        this->m_Names.emplace_back(ShortCutList.GetName(i));
+    }
+    std::sort(this->m_Names.begin(), this->m_Names.end());
+
+    HRESULT hr = S_OK;
+
+    do
+    {
+        this->m_DirectoryHandle = ::CreateFileW(
+            ShortCutListPath.substr(0, Separator).c_str(),
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            nullptr);
+        if (this->m_DirectoryHandle == INVALID_HANDLE_VALUE)
+        {
+            hr = Mile::HResult::FromWin32(::GetLastError());
+            break;
+        }
+
+        this->m_StopEvent = ::CreateEventExW(
+            nullptr,
+            nullptr,
+            CREATE_EVENT_MANUAL_RESET,
+            EVENT_ALL_ACCESS);
+        if (!this->m_StopEvent)
+        {
+            hr = Mile::HResult::FromWin32(::GetLastError());
+            break;
+        }
+
+        this->m_ThreadHandle = Mile::CreateThread([this]()
+        {
+            this->Run();
+        });
+        if (!this->m_ThreadHandle)
+        {
+            hr = Mile::HResult::FromWin32(::GetLastError());
+            break;
+        }
+
+    } while (false);
+
+    if (hr != S_OK)
+    {
+        this->Stop();
+    }
+
+    return hr;
+}
+
+void CNSudoShortCutListWatcher::Stop()
+{
+    if (this->m_ThreadHandle)
+    {
+        ::SetEvent(this->m_StopEvent);
+        ::WaitForSingleObjectEx(this->m_ThreadHandle, INFINITE, FALSE);
+        ::CloseHandle(this->m_ThreadHandle);
+        this->m_ThreadHandle = nullptr;
+    }
+
+    if (this->m_StopEvent)
+    {
+        ::CloseHandle(this->m_StopEvent);
+        this->m_StopEvent = nullptr;
+    }
+
+    if (this->m_DirectoryHandle != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(this->m_DirectoryHandle);
+        this->m_DirectoryHandle = INVALID_HANDLE_VALUE;
+    }
+}
+
+void CNSudoShortCutListWatcher::Run()
+{
+    OVERLAPPED Overlapped = { 0 };
+    Overlapped.hEvent = ::CreateEventExW(
+        nullptr,
+        nullptr,
+        CREATE_EVENT_MANUAL_RESET,
+        EVENT_ALL_ACCESS);
+    if (!Overlapped.hEvent)
+    {
+        return;
+    }
+
+    auto OverlappedEventCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        ::CloseHandle(Overlapped.hEvent);
+    });
+
+    alignas(DWORD) BYTE Buffer[4096];
+
+    for (;;)
+    {
+        ::ResetEvent(Overlapped.hEvent);
+
+        if (!::ReadDirectoryChangesW(
+            this->m_DirectoryHandle,
+            Buffer,
+            sizeof(Buffer),
+            FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME |
+            FILE_NOTIFY_CHANGE_SIZE |
+            FILE_NOTIFY_CHANGE_LAST_WRITE,
+            nullptr,
+            &Overlapped,
+            nullptr))
+        {
+            break;
+        }
+
+        HANDLE WaitHandles[] = { this->m_StopEvent, Overlapped.hEvent };
+        DWORD NumberOfBytesTransferred = 0;
+        if (WAIT_OBJECT_0 + 1 != ::WaitForMultipleObjectsEx(
+            2,
+            WaitHandles,
+            FALSE,
+            INFINITE,
+            FALSE))
+        {
+            ::CancelIoEx(this->m_DirectoryHandle, &Overlapped);
+            ::GetOverlappedResult(
+                this->m_DirectoryHandle,
+                &Overlapped,
+                &NumberOfBytesTransferred,
+                TRUE);
+            break;
+        }
+
+        if (!::GetOverlappedResult(
+            this->m_DirectoryHandle,
+            &Overlapped,
+            &NumberOfBytesTransferred,
+            FALSE))
+        {
+            break;
+        }
+
+        // No records are returned when the buffer overflows, so NSudo.json
+        // may have been changed.
+        bool Changed = (NumberOfBytesTransferred == 0);
+        for (DWORD Offset = 0; !Changed && Offset < NumberOfBytesTransferred;)
+        {
+            PFILE_NOTIFY_INFORMATION Information =
+                reinterpret_cast<PFILE_NOTIFY_INFORMATION>(&Buffer[Offset]);
+
+            // The changes of the compiled index and the temporary files are
+            // ignored by comparing the whole file name.
+            Changed = (CSTR_EQUAL == ::CompareStringOrdinal(
+                Information->FileName,
+                static_cast<int>(Information->FileNameLength / sizeof(WCHAR)),
+                this->m_FileName.c_str(),
+                static_cast<int>(this->m_FileName.size()),
+                TRUE));
+
+            if (!Information->NextEntryOffset)
+            {
+                break;
+            }
+            Offset += Information->NextEntryOffset;
+        }
+
+        if (!Changed)
+        {
+            continue;
+        }
+
+        // A save usually changes the file several times, wait for it to
+        // settle before reloading.
+        if (WAIT_TIMEOUT != ::WaitForSingleObjectEx(
+            this->m_StopEvent,
+            200,
+            FALSE))
+        {
+            break;
+        }
+
+        this->Reload();
+    }
+}
+
+void CNSudoShortCutListWatcher::Reload()
+{
+    PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE Update =
+        new (std::nothrow) NSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE();
+    if (!Update)
+    {
+        return;
+    }
+
+    auto UpdateCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        delete Update;
+    });
+
+    // The editor may still hold NSudo.json, so retry for a while.
+    HRESULT hr = S_OK;
+    for (int i = 0; i < 5; ++i)
+    {
+        hr = Update->ShortCutList.Load(this->m_ShortCutListPath);
+        if (hr != Mile::HResult::FromWin32(ERROR_SHARING_VIOLATION))
+        {
+            break;
+        }
+
+        if (WAIT_TIMEOUT != ::WaitForSingleObjectEx(
+            this->m_StopEvent,
+            100,
+            FALSE))
+        {
+            return;
+        }
+    }
+
+    // A deleted NSudo.json means no shortcuts. The other failures, e.g. a
+    // partially written file, keep the current shortcuts.
+    if (hr == Mile::HResult::FromWin32(ERROR_FILE_NOT_FOUND))
+    {
+        Update->ShortCutList.Close();
+    }
+    else if (hr != S_OK)
+    {
+        return;
+    }
+
+    std::vector<std::string> Names;
+    Names.reserve(Update->ShortCutList.GetCount());
+    for (std::size_t i = 0; i < Update->ShortCutList.GetCount(); ++i)
+    {
+        Names.emplace_back(Update->ShortCutList.GetName(i));
+    }
+    std::sort(Names.begin(), Names.end());
+
+    std::vector<std::string> AddedNames;
+    std::set_difference(
+        Names.begin(),
+        Names.end(),
+        this->m_Names.begin(),
+        this->m_Names.end(),
+        std::back_inserter(AddedNames));
+    std::vector<std::string> RemovedNames;
+    std::set_difference(
+        this->m_Names.begin(),
+        this->m_Names.end(),
+        Names.begin(),
+        Names.end(),
+        std::back_inserter(RemovedNames));
+
+    for (std::string const& Name : AddedNames)
+    {
+        Update->AddedNames.push_back(Mile::ToUtf16String(Name));
+    }
+    for (std::string const& Name : RemovedNames)
+    {
+        Update->RemovedNames.push_back(Mile::ToUtf16String(Name));
+    }
+
+    if (!::PostMessageW(
+        this->m_NotifyWindow,
+        this->m_NotifyMessage,
+        0,
+        reinterpret_cast<LPARAM>(Update)))
+    {
+        return;
+    }
+
+    // The notify window owns the update now.
+    Update = nullptr;
+    this->m_Names.swap(Names);
+}
@@ -0,0 +1,280 @@
+﻿/*
+ * PROJECT:   NSudo Launcher
+ * FILE:      NSudoLauncherShortCuts.h
+ * PURPOSE:   Definition for NSudo Launcher shortcut list
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCHER_SHORTCUTS
+#define NSUDO_LAUNCHER_SHORTCUTS
+
+#include <Mile.Windows.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The suffix of the compiled shortcut index, which is placed next to
+ *        NSudo.json.
+*/
+#define NSUDO_LAUNCHER_SHORTCUT_INDEX_SUFFIX L".idx"
+
+/**
+ * @brief The shortcuts defined in the "ShortCutList_V2" object of NSudo.json.
+ *        The shortcuts are looked up through a compiled index which holds the
+ *        UTF-8 names and targets sorted by the case-folded names, a hash table
+ *        and a prefix trie of the case-folded names. The index is memory-mapped from
+ *        NSudo.json.idx when it matches the size, the last write time or the
+ *        content hash of NSudo.json, so no JSON is parsed. Otherwise it is
+ *        rebuilt from NSudo.json, used from memory and written back. Only the
+ *        target of the selected shortcut is converted to UTF-16.
+*/
+class CNSudoShortCutList :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    const BYTE* m_MappedIndex = nullptr;
+    std::vector<BYTE> m_OwnedIndex;
+
+    const BYTE* m_Index = nullptr;
+    std::size_t m_IndexSize = 0;
+
+public:
+
+    CNSudoShortCutList() = default;
+
+    ~CNSudoShortCutList();
+
+    /**
+     * @brief Loads the shortcuts from the compiled index, and rebuilds the
+     *        compiled index if it is stale. The previous shortcuts are
+     *        released.
+     * @param ShortCutListPath The path of NSudo.json.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Load(
+        _In_ std::wstring const& ShortCutListPath);
+
+    /**
+     * @brief Builds the shortcuts from the content of NSudo.json. The cached
+     *        index is reused with the new last write time if it is built from
+     *        the same content, otherwise the index is rebuilt. The previous
+     *        shortcuts are released.
+     * @param Content The content of NSudo.json.
+     * @param SourceLastWriteTime The last write time of NSudo.json.
+     * @param CachedIndex The compiled shortcut index read from NSudo.json.idx,
+     *                    or nullptr if there is no compiled shortcut index.
+     * @param CachedIndexSize The size of the cached index.
+     * @param CachedIndexReused Receives whether the cached index is reused.
+     *                          It can be nullptr.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Build(
+        _In_ std::string_view Content,
+        _In_ ULONGLONG SourceLastWriteTime,
+        _In_opt_ const BYTE* CachedIndex,
+        _In_ std::size_t CachedIndexSize,
+        _Out_opt_ bool* CachedIndexReused);
+
+    /**
+     * @brief Loads the shortcuts from a copy of the compiled shortcut index.
+     *        The previous shortcuts are released.
+     * @param Index The compiled shortcut index.
+     * @param IndexSize The size of the compiled shortcut index.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT LoadIndex(
+        _In_ const BYTE* Index,
+        _In_ std::size_t IndexSize);
+
+    /**
+     * @brief Checks whether the compiled shortcut index is valid and is built
+     *        from NSudo.json with the size and the last write time, so it can
+     *        be used without reading NSudo.json.
+     * @param Index The compiled shortcut index.
+     * @param IndexSize The size of the compiled shortcut index.
+     * @param SourceSize The size of NSudo.json.
+     * @param SourceLastWriteTime The last write time of NSudo.json.
+     * @return True if the compiled shortcut index is current.
+    */
+    static bool IsIndexCurrent(
+        _In_ const BYTE* Index,
+        _In_ std::size_t IndexSize,
+        _In_ ULONGLONG SourceSize,
+        _In_ ULONGLONG SourceLastWriteTime);
+
+    /**
+     * @brief Releases the shortcuts and unmaps the compiled index.
+    */
+    void Close();
+
+    /**
+     * @brief Exchanges the shortcuts with another list. The views returned by
+     *        the lists follow the shortcuts.
+     * @param Other The other list.
+    */
+    void Swap(
+        _Inout_ CNSudoShortCutList& Other);
+
+    /**
+     * @brief Gets the compiled shortcut index of the shortcuts.
+     * @return The compiled shortcut index, or nullptr if the list is not
+     *         loaded. It is valid until the list is loaded again or closed.
+    */
+    const BYTE* GetIndex() const;
+
+    /**
+     * @brief Gets the size of the compiled shortcut index.
+     * @return The size of the compiled shortcut index.
+    */
+    std::size_t GetIndexSize() const;
+
+    /**
+     * @brief Gets the number of the shortcuts.
+     * @return The number of the shortcuts.
+    */
+    std::size_t GetCount() const;
+
+    /**
+     * @brief Gets the name of the shortcut. The shortcuts are sorted by the
+     *        case-folded names.
+     * @param Index The index of the shortcut.
+     * @return The UTF-8 name of the shortcut. The view is valid until the list
+     *         is loaded again or closed.
+    */
+    std::string_view GetName(
+        _In_ std::size_t Index) const;
+
+    /**
+     * @brief Finds the target of the shortcut. The names are compared
+     *        case-insensitively.
+     * @param Name The UTF-8 name of the shortcut.
+     * @param Target Receives the UTF-8 target of the shortcut. The view is
+     *               valid until the list is loaded again or closed.
+     * @return True if the shortcut is found.
+    */
+    bool Find(
+        _In_ std::string_view Name,
+        _Out_ std::string_view& Target) const;
+
+    /**
+     * @brief Finds the shortcut with the longest name which is a prefix of the
+     *        command line and is followed by the end of the command line or a
+     *        whitespace. The names are compared case-insensitively through the
+     *        prefix trie of the compiled index, so the cost depends on the
+     *        length of the matched name instead of the number of the shortcuts.
+     * @param CommandLine The UTF-8 command line.
+     * @param Target Receives the UTF-8 target of the shortcut. The view is
+     *               valid until the list is loaded again or closed.
+     * @param NameLength Receives the length of the matched name in the command
+     *                   line, in bytes.
+     * @return True if the shortcut is found.
+    */
+    bool FindPrefix(
+        _In_ std::string_view CommandLine,
+        _Out_ std::string_view& Target,
+        _Out_ std::size_t& NameLength) const;
+};
+
+/**
+ * @brief Reads and translates the shortcuts of NSudo.json.
+*/
+class CNSudoShortCutAdapter
+{
+public:
+
+    static void Read(
+        const std::wstring& ShortCutListPath,
+        CNSudoShortCutList& ShortCutList);
+
+    /**
+     * @brief Replaces the command line with the target of the shortcut if the
+     *        command line starts with the name of a shortcut, which can be
+     *        quoted if it contains spaces. The arguments after the name
+     *        replace the "{0}", "{1}", ... placeholders of the target in
+     *        order, and all arguments replace the "{*}" placeholder. If the
+     *        target has no placeholders, the arguments are appended to it.
+     * @param ShortCutList The shortcut list.
+     * @param CommandLine The command line.
+     * @return The expanded target of the shortcut, or the command line if it
+     *         does not start with the name of a shortcut.
+    */
+    static std::wstring Translate(
+        const CNSudoShortCutList& ShortCutList,
+        const std::wstring& CommandLine);
+};
+
+/**
+ * @brief The shortcut list reloaded by CNSudoShortCutListWatcher and the
+ *        changes of the shortcut names. It is posted to the notify window,
+ *        which takes the ownership.
+*/
+typedef struct _NSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE
+{
+    CNSudoShortCutList ShortCutList;
+    std::vector<std::wstring> AddedNames;
+    std::vector<std::wstring> RemovedNames;
+} NSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE, *PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE;
+
+/**
+ * @brief Watches NSudo.json for changes. When it is changed, the shortcut
+ *        list is reloaded on the watcher thread, compared with the previous
+ *        one, and posted to the notify window as the LPARAM of the notify
+ *        message in a PNSUDO_LAUNCHER_SHORTCUT_LIST_UPDATE.
+*/
+class CNSudoShortCutListWatcher :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    std::wstring m_ShortCutListPath;
+    std::wstring m_FileName;
+    HWND m_NotifyWindow = nullptr;
+    UINT m_NotifyMessage = 0;
+
+    std::vector<std::string> m_Names;
+
+    HANDLE m_DirectoryHandle = INVALID_HANDLE_VALUE;
+    HANDLE m_StopEvent = nullptr;
+    HANDLE m_ThreadHandle = nullptr;
+
+    void Run();
+
+    void Reload();
+
+public:
+
+    CNSudoShortCutListWatcher() = default;
+
+    ~CNSudoShortCutListWatcher();
+
+    /**
+     * @brief Starts watching NSudo.json.
+     * @param ShortCutListPath The path of NSudo.json.
+     * @param ShortCutList The current shortcut list, which the first changes
+     *                     are compared with.
+     * @param NotifyWindow The window which receives the updates.
+     * @param NotifyMessage The message which carries the updates.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Start(
+        _In_ std::wstring const& ShortCutListPath,
+        _In_ CNSudoShortCutList const& ShortCutList,
+        _In_ HWND NotifyWindow,
+        _In_ UINT NotifyMessage);
+
+    /**
+     * @brief Stops watching NSudo.json and waits for the watcher thread. The
+     *        updates which have been posted are not recalled.
+    */
+    void Stop();
+};
+
+#endif // !NSUDO_LAUNCHER_SHORTCUTS
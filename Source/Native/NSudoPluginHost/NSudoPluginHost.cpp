@@ -17,61 +17,770 @@
 #include <toml.hpp>
 
 #include "Mile.Project.Properties.h"
+#include "NSudoPluginHostJobScheduler.h"
 
-int main()
+/**
+ * @brief The names of the resource classes of the job tasks. The index of
+ *        the name is the index of the resource class in the scheduler.
+*/
+static const char* const g_JobResourceClassNames[] =
 {
-    // Fall back to English in unsupported environment. (Temporary Hack)
-    // Reference: https://github.com/M2Team/NSudo/issues/56
-    switch (PRIMARYLANGID(::GetThreadUILanguage()))
+    "Cpu",
+    "Disk",
+    "Network"
+};
+
+/**
+ * @brief A task of the job mode.
+*/
+typedef struct _NSUDO_PLUGIN_HOST_JOB_TASK
+{
+    std::wstring Name;
+    std::wstring Command;
+    std::wstring ModuleName;
+    std::wstring EntryName;
+    std::wstring Arguments;
+} NSUDO_PLUGIN_HOST_JOB_TASK, *PNSUDO_PLUGIN_HOST_JOB_TASK;
+
+/**
+ * @brief The result of a task of the job mode.
+*/
+typedef struct _NSUDO_PLUGIN_HOST_JOB_RESULT
+{
+    HRESULT Result;
+    std::wstring Output;
+
+    // The time when the task starts, relative to the start of the job, and
+    // the duration of the task, in milliseconds.
+    ULONGLONG StartTime;
+    ULONGLONG Duration;
+
+} NSUDO_PLUGIN_HOST_JOB_RESULT, *PNSUDO_PLUGIN_HOST_JOB_RESULT;
+
+/**
+ * @brief Initializes the NSudo context which writes to the console.
+ * @param Context The NSudo context.
+*/
+static void NSudoPluginHostInitializeContext(
+    _Out_ NSUDO_CONTEXT_PRIVATE& Context)
+{
+    ::NSudoContextFillFunctionTable(
+        &Context.PublicContext);
+
+    Context.Size = sizeof(NSUDO_CONTEXT_PRIVATE);
+
+    Context.PiConsoleWindowHandle = nullptr;
+    Context.ConsoleInputHandle = ::GetStdHandle(STD_INPUT_HANDLE);
+    Context.ConsoleOutputHandle = ::GetStdHandle(STD_OUTPUT_HANDLE);
+    Context.ConsoleMode = true;
+}
+
+/**
+ * @brief Reads the whole input file or standard input.
+ * @param InputPath The path of the input file, or "-" for the standard input.
+ * @param Content The content of the input. The UTF-8 BOM is removed.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoPluginHostReadInput(
+    _In_ std::wstring const& InputPath,
+    _Out_ std::string& Content)
+{
+    Content.clear();
+
+    bool IsStandardInput = (0 == std::wcscmp(InputPath.c_str(), L"-"));
+
+    HANDLE InputHandle = IsStandardInput
+        ? ::GetStdHandle(STD_INPUT_HANDLE)
+        : ::CreateFileW(
+            InputPath.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr);
+    if (!InputHandle || InputHandle == INVALID_HANDLE_VALUE)
     {
-    case LANG_ENGLISH:
-    case LANG_CHINESE:
-        break;
-    default:
-        ::SetThreadUILanguage(MAKELANGID(LANG_ENGLISH, SUBLANG_NEUTRAL));
-        break;
+        return Mile::HResultFromLastError(FALSE);
     }
 
-    std::map<std::string, std::wstring> GlobalTranslations;
+    auto InputHandleCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        if (!IsStandardInput)
+        {
+            ::CloseHandle(InputHandle);
+        }
+    });
 
-    Mile::RESOURCE_INFO ResourceInfo = { 0 };
-    if (SUCCEEDED(Mile::LoadResource(
-        &ResourceInfo,
-        ::GetModuleHandleW(nullptr),
-        L"Translations",
-        MAKEINTRESOURCEW(1))))
+    char Buffer[4096];
+    for (;;)
     {
-        try
+        DWORD NumberOfBytesRead = 0;
+        if (!::ReadFile(
+            InputHandle,
+            Buffer,
+            sizeof(Buffer),
+            &NumberOfBytesRead,
+            nullptr))
         {
-            toml::table Translations = toml::parse(std::string(
-                reinterpret_cast<const char*>(ResourceInfo.Pointer),
-                ResourceInfo.Size));
-            for (auto const& Translation : Translations)
+            DWORD LastError = ::GetLastError();
+            if (LastError != ERROR_BROKEN_PIPE)
             {
-                GlobalTranslations.emplace(std::make_pair(
-                    Translation.first,
-                    Mile::ToUtf16String(
-                        Translation.second.value_or<std::string>(""))));
+                return Mile::HResult::FromWin32(LastError);
             }
+            break;
+        }
+
+        if (!NumberOfBytesRead)
+        {
+            break;
+        }
+
+        Content.append(Buffer, NumberOfBytesRead);
+    }
+
+    // Skip the UTF-8 BOM. (0xEF,0xBB,0xBF)
+    if (0 == Content.compare(0, 3, "\xEF\xBB\xBF"))
+    {
+        Content.erase(0, 3);
+    }
+
+    return S_OK;
+}
+
+/**
+ * @brief Reads the commands of the session mode. The input is UTF-8 text with
+ *        one command per line, and blank lines and the lines starting with
+ *        "#" are ignored.
+ * @param ScriptPath The path of the input file, or "-" for the standard input.
+ * @param Commands The commands.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoPluginHostReadSessionCommands(
+    _In_ std::wstring const& ScriptPath,
+    _Out_ std::vector<std::wstring>& Commands)
+{
+    Commands.clear();
+
+    std::string Content;
+    HRESULT hr = ::NSudoPluginHostReadInput(ScriptPath, Content);
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    std::size_t LineStart = 0;
+    while (LineStart < Content.size())
+    {
+        std::size_t LineEnd = Content.find('\n', LineStart);
+        if (LineEnd == std::string::npos)
+        {
+            LineEnd = Content.size();
         }
-        catch (...)
+
+        std::size_t First = Content.find_first_not_of(" \t\r", LineStart);
+        if (First != std::string::npos &&
+            First < LineEnd &&
+            Content[First] != '#')
         {
+            std::size_t Last = Content.find_last_not_of(" \t\r", LineEnd - 1);
 
+            Commands.push_back(Mile::ToUtf16String(
+                Content.substr(First, Last - First + 1)));
         }
+
+        LineStart = LineEnd + 1;
     }
 
-    NSUDO_CONTEXT_PRIVATE Context;
+    return S_OK;
+}
 
-    ::NSudoContextFillFunctionTable(
-        &Context.PublicContext);
+/**
+ * @brief Parses a command of the session mode, which is in the
+ *        "[ Module Name ]![ Entry Name ] [ Arguments ]" form. The module name
+ *        and the entry name can be quoted together.
+ * @param Command The command.
+ * @param ModuleName The module name of the context plugin.
+ * @param EntryName The entry point name of the context plugin.
+ * @param Arguments The command line arguments of the context plugin.
+ * @return true if the command is valid.
+*/
+static bool NSudoPluginHostParseSessionCommand(
+    _In_ std::wstring const& Command,
+    _Out_ std::wstring& ModuleName,
+    _Out_ std::wstring& EntryName,
+    _Out_ std::wstring& Arguments)
+{
+    ModuleName.clear();
+    EntryName.clear();
+    Arguments.clear();
 
-    Context.Size = sizeof(NSUDO_CONTEXT_PRIVATE);
+    std::wstring Target;
+    std::size_t TargetEnd = 0;
 
-    Context.PiConsoleWindowHandle = nullptr;
-    Context.ConsoleInputHandle = ::GetStdHandle(STD_INPUT_HANDLE);
-    Context.ConsoleOutputHandle = ::GetStdHandle(STD_OUTPUT_HANDLE);
-    Context.ConsoleMode = true;
+    if (!Command.empty() && Command[0] == L'"')
+    {
+        std::size_t QuoteEnd = Command.find(L'"', 1);
+        if (QuoteEnd == std::wstring::npos)
+        {
+            return false;
+        }
+
+        Target = Command.substr(1, QuoteEnd - 1);
+        TargetEnd = QuoteEnd + 1;
+    }
+    else
+    {
+        TargetEnd = Command.find_first_of(L" \t");
+        if (TargetEnd == std::wstring::npos)
+        {
+            TargetEnd = Command.size();
+        }
+
+        Target = Command.substr(0, TargetEnd);
+    }
+
+    std::size_t Separator = Target.rfind(L'!');
+    if (Separator == std::wstring::npos ||
+        Separator == 0 ||
+        Separator + 1 == Target.size())
+    {
+        return false;
+    }
+
+    ModuleName = Target.substr(0, Separator);
+    EntryName = Target.substr(Separator + 1);
+
+    std::size_t ArgumentsStart = Command.find_first_not_of(L" \t", TargetEnd);
+    if (ArgumentsStart != std::wstring::npos)
+    {
+        if (ArgumentsStart == TargetEnd)
+        {
+            // The closing quote is followed by other characters.
+            return false;
+        }
+
+        Arguments = Command.substr(ArgumentsStart);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Executes the commands read from the input file or the standard input
+ *        in one context plugin session, so the modules are only loaded once.
+ *        The remaining commands are still executed if a command fails.
+ * @param Context The NSudo context.
+ * @param Translations The translations of NSudo Plugin Host.
+ * @param RootPath The directory of the context plugin modules.
+ * @param ScriptPath The path of the input file, or "-" for the standard input.
+ * @return HRESULT. If all commands succeed, the return value is S_OK.
+ *         Otherwise, the return value is the result of the first failed
+ *         command.
+*/
+static HRESULT NSudoPluginHostRunSession(
+    _In_ PNSUDO_CONTEXT Context,
+    _In_ CNSudoTranslationTable const& Translations,
+    _In_ std::wstring const& RootPath,
+    _In_ std::wstring const& ScriptPath)
+{
+    std::vector<std::wstring> Commands;
+    HRESULT hr = ::NSudoPluginHostReadSessionCommands(ScriptPath, Commands);
+    if (hr != S_OK)
+    {
+        Context->WriteLine(
+            Context,
+            Mile::GetHResultMessage(hr).c_str());
+        return hr;
+    }
+
+    NSUDO_CONTEXT_PLUGIN_SESSION Session;
+
+    auto SessionCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        ::NSudoContextClosePluginSession(&Session);
+    });
+
+    for (std::wstring const& Command : Commands)
+    {
+        std::wstring ModuleName;
+        std::wstring EntryName;
+        std::wstring Arguments;
+
+        HRESULT CommandResult = E_INVALIDARG;
+        if (::NSudoPluginHostParseSessionCommand(
+            Command,
+            ModuleName,
+            EntryName,
+            Arguments))
+        {
+            CommandResult = ::NSudoContextExecutePluginInSession(
+                &Session,
+                Context,
+                (RootPath + L"\\" + ModuleName).c_str(),
+                Mile::ToUtf8String(EntryName).c_str(),
+                Arguments.c_str());
+        }
+
+        if (CommandResult != S_OK)
+        {
+            Context->Write(
+                Context,
+                Translations.Find("SessionCommandFailedText").data());
+            Context->WriteLine(
+                Context,
+                Mile::FormatUtf16String(
+                    L"%s (0x%08X)",
+                    Command.c_str(),
+                    CommandResult).c_str());
+
+            if (hr == S_OK)
+            {
+                hr = CommandResult;
+            }
+        }
+    }
+
+    return hr;
+}
+
+/**
+ * @brief Reads the tasks of the job mode. The job file is a TOML file with
+ *        an array of tables named "Task". Each task has a "Command" in the
+ *        form of the session mode, an optional "Name" which defaults to the
+ *        command, an optional "After" array with the names of the tasks which
+ *        need to succeed before it starts, and an optional "Resources" array
+ *        with the resource classes it uses, which are "Cpu", "Disk" and
+ *        "Network". The keys and the resource classes are case insensitive.
+ * @param JobPath The path of the job file, or "-" for the standard input.
+ * @param JobTasks The tasks of the job.
+ * @param SchedulerTasks The tasks of the job, as seen by the scheduler.
+ * @param ErrorMessage The description of the error if the job file is
+ *                     invalid.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoPluginHostReadJobTasks(
+    _In_ std::wstring const& JobPath,
+    _Out_ std::vector<NSUDO_PLUGIN_HOST_JOB_TASK>& JobTasks,
+    _Out_ std::vector<NSUDO_JOB_TASK>& SchedulerTasks,
+    _Out_ std::wstring& ErrorMessage)
+{
+    JobTasks.clear();
+    SchedulerTasks.clear();
+    ErrorMessage.clear();
+
+    std::string Content;
+    HRESULT hr = ::NSudoPluginHostReadInput(JobPath, Content);
+    if (hr != S_OK)
+    {
+        ErrorMessage = Mile::GetHResultMessage(hr);
+        return hr;
+    }
+
+    // The dependencies are resolved after all task names are known.
+    std::vector<std::vector<std::wstring>> Dependencies;
+
+    try
+    {
+        toml::table Root = toml::parse(std::string_view(Content));
+
+        for (auto const& Item : Root)
+        {
+            toml::array const* Array = Item.second.as_array();
+            if (0 != _stricmp(Item.first.c_str(), "Task") ||
+                !Array ||
+                !Array->is_array_of_tables())
+            {
+                ErrorMessage = Mile::ToUtf16String(Item.first);
+                return E_INVALIDARG;
+            }
+
+            for (auto const& Element : *Array)
+            {
+                NSUDO_PLUGIN_HOST_JOB_TASK JobTask;
+                NSUDO_JOB_TASK SchedulerTask;
+                std::vector<std::wstring> After;
+
+                for (auto const& Option : *Element.as_table())
+                {
+                    char const* Name = Option.first.c_str();
+
+                    if (0 == _stricmp(Name, "Name") &&
+                        Option.second.is_string())
+                    {
+                        JobTask.Name = Mile::ToUtf16String(
+                            Option.second.value_or<std::string>(""));
+                    }
+                    else if (0 == _stricmp(Name, "Command") &&
+                        Option.second.is_string())
+                    {
+                        JobTask.Command = Mile::ToUtf16String(
+                            Option.second.value_or<std::string>(""));
+                    }
+                    else if (0 == _stricmp(Name, "After") &&
+                        Option.second.is_array())
+                    {
+                        for (auto const& Value : *Option.second.as_array())
+                        {
+                            if (!Value.is_string())
+                            {
+                                ErrorMessage = Mile::ToUtf16String(Name);
+                                return E_INVALIDARG;
+                            }
+                            After.push_back(Mile::ToUtf16String(
+                                Value.value_or<std::string>("")));
+                        }
+                    }
+                    else if (0 == _stricmp(Name, "Resources") &&
+                        Option.second.is_array())
+                    {
+                        for (auto const& Value : *Option.second.as_array())
+                        {
+                            std::string ClassName =
+                                Value.value_or<std::string>("");
+
+                            std::size_t Index = 0;
+                            while (Index < ARRAYSIZE(g_JobResourceClassNames) &&
+                                0 != _stricmp(
+                                    ClassName.c_str(),
+                                    g_JobResourceClassNames[Index]))
+                            {
+                                ++Index;
+                            }
+                            if (!Value.is_string() ||
+                                Index >= ARRAYSIZE(g_JobResourceClassNames))
+                            {
+                                ErrorMessage = Mile::ToUtf16String(ClassName);
+                                return E_INVALIDARG;
+                            }
+
+                            SchedulerTask.Resources.push_back(Index);
+                        }
+                    }
+                    else
+                    {
+                        ErrorMessage = Mile::ToUtf16String(Name);
+                        return E_INVALIDARG;
+                    }
+                }
 
+                if (!::NSudoPluginHostParseSessionCommand(
+                    JobTask.Command,
+                    JobTask.ModuleName,
+                    JobTask.EntryName,
+                    JobTask.Arguments))
+                {
+                    ErrorMessage = JobTask.Command;
+                    return E_INVALIDARG;
+                }
+
+                if (JobTask.Name.empty())
+                {
+                    JobTask.Name = JobTask.Command;
+                }
+
+                for (NSUDO_PLUGIN_HOST_JOB_TASK const& Previous : JobTasks)
+                {
+                    if (Previous.Name == JobTask.Name)
+                    {
+                        ErrorMessage = JobTask.Name;
+                        return E_INVALIDARG;
+                    }
+                }
+
+                JobTasks.push_back(std::move(JobTask));
+                SchedulerTasks.push_back(std::move(SchedulerTask));
+                Dependencies.push_back(std::move(After));
+            }
+        }
+    }
+    catch (toml::parse_error const& Error)
+    {
+        ErrorMessage = Mile::FormatUtf16String(
+            L"(%u, %u) %s",
+            static_cast<unsigned int>(Error.source().begin.line),
+            static_cast<unsigned int>(Error.source().begin.column),
+            Mile::ToUtf16String(std::string(Error.description())).c_str());
+        return E_INVALIDARG;
+    }
+    catch (...)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (std::size_t Index = 0; Index < JobTasks.size(); ++Index)
+    {
+        for (std::wstring const& Dependency : Dependencies[Index])
+        {
+            std::size_t Found = 0;
+            while (Found < JobTasks.size() &&
+                JobTasks[Found].Name != Dependency)
+            {
+                ++Found;
+            }
+            if (Found >= JobTasks.size())
+            {
+                ErrorMessage = Dependency;
+                return E_INVALIDARG;
+            }
+
+            SchedulerTasks[Index].After.push_back(Found);
+        }
+    }
+
+    return S_OK;
+}
+
+/**
+ * @brief Runs the tasks of the job file on a bounded worker pool in one
+ *        context plugin session. The output of each task is captured and
+ *        written when the task is finished, and a timing table is written
+ *        when all tasks are finished. The tasks which depend on a failed task
+ *        are skipped. The tasks using the "Disk" or the "Network" resource
+ *        class run one at a time for each class, and the tasks using the
+ *        "Cpu" resource class are limited to the number of the logical
+ *        processors.
+ * @param Context The NSudo context.
+ * @param Translations The translations of NSudo Plugin Host.
+ * @param RootPath The directory of the context plugin modules.
+ * @param JobPath The path of the job file, or "-" for the standard input.
+ * @param MaxParallel The maximum number of tasks running at the same time.
+ * @return HRESULT. If all tasks succeed, the return value is S_OK. Otherwise,
+ *         the return value is the result of the first failed task in the
+ *         order of the job file, or E_ABORT if the tasks are only skipped.
+*/
+static HRESULT NSudoPluginHostRunJob(
+    _In_ PNSUDO_CONTEXT Context,
+    _In_ CNSudoTranslationTable const& Translations,
+    _In_ std::wstring const& RootPath,
+    _In_ std::wstring const& JobPath,
+    _In_ std::size_t MaxParallel)
+{
+    std::vector<NSUDO_PLUGIN_HOST_JOB_TASK> JobTasks;
+    std::vector<NSUDO_JOB_TASK> SchedulerTasks;
+    std::wstring ErrorMessage;
+
+    std::vector<std::size_t> ResourceCapacities(
+        ARRAYSIZE(g_JobResourceClassNames),
+        1);
+    ResourceCapacities[0] = Mile::GetNumberOfHardwareThreads();
+
+    HRESULT hr = ::NSudoPluginHostReadJobTasks(
+        JobPath,
+        JobTasks,
+        SchedulerTasks,
+        ErrorMessage);
+    if (hr == S_OK)
+    {
+        std::size_t InvalidTask = 0;
+        if (!::NSudoCheckJobTasks(
+            SchedulerTasks,
+            ResourceCapacities,
+            InvalidTask))
+        {
+            // The names and the resource classes are resolved when reading,
+            // so the task is in a dependency cycle.
+            ErrorMessage = JobTasks[InvalidTask].Name;
+            hr = E_INVALIDARG;
+        }
+    }
+    if (hr != S_OK)
+    {
+        Context->Write(
+            Context,
+            Translations.Find("InvalidJobFileText").data());
+        Context->WriteLine(
+            Context,
+            ErrorMessage.c_str());
+        return hr;
+    }
+
+    NSUDO_CONTEXT_PLUGIN_SESSION Session;
+
+    auto SessionCleaner = Mile::ScopeExitTaskHandler([&]()
+    {
+        ::NSudoContextClosePluginSession(&Session);
+    });
+
+    std::vector<NSUDO_PLUGIN_HOST_JOB_RESULT> Results(JobTasks.size());
+    std::vector<NSUDO_JOB_TASK_STATUS> Statuses(JobTasks.size());
+
+    ULONGLONG JobStartTime = Mile::GetTickCount();
+
+    ::NSudoRunJob<NSUDO_PLUGIN_HOST_JOB_RESULT>(
+        SchedulerTasks,
+        ResourceCapacities,
+        MaxParallel,
+        [&](std::size_t Index, NSUDO_PLUGIN_HOST_JOB_RESULT& Result) -> bool
+        {
+            NSUDO_PLUGIN_HOST_JOB_TASK const& Task = JobTasks[Index];
+
+            NSUDO_CONTEXT_PRIVATE TaskContext;
+            ::NSudoPluginHostInitializeContext(TaskContext);
+            TaskContext.CapturedOutput = &Result.Output;
+
+            ULONGLONG StartTime = Mile::GetTickCount();
+            Result.StartTime = StartTime - JobStartTime;
+
+            Result.Result = ::NSudoContextExecutePluginInSession(
+                &Session,
+                &TaskContext.PublicContext,
+                (RootPath + L"\\" + Task.ModuleName).c_str(),
+                Mile::ToUtf8String(Task.EntryName).c_str(),
+                Task.Arguments.c_str());
+
+            Result.Duration = Mile::GetTickCount() - StartTime;
+
+            return Result.Result == S_OK;
+        },
+        [&](
+            std::size_t Index,
+            NSUDO_PLUGIN_HOST_JOB_RESULT& Result,
+            NSUDO_JOB_TASK_STATUS Status)
+        {
+            NSUDO_PLUGIN_HOST_JOB_TASK const& Task = JobTasks[Index];
+
+            Context->WriteLine(
+                Context,
+                Mile::FormatUtf16String(L"[%s]", Task.Name.c_str()).c_str());
+
+            if (Status == NSUDO_JOB_TASK_STATUS::Skipped)
+            {
+                Context->WriteLine(
+                    Context,
+                    Translations.Find("JobTaskSkippedText").data());
+            }
+            else
+            {
+                if (!Result.Output.empty())
+                {
+                    if (Result.Output.back() != L'\n')
+                    {
+                        Result.Output.append(L"\r\n");
+                    }
+                    Context->Write(Context, Result.Output.c_str());
+                }
+
+                if (Status == NSUDO_JOB_TASK_STATUS::Failed)
+                {
+                    Context->Write(
+                        Context,
+                        Translations.Find("SessionCommandFailedText").data());
+                    Context->WriteLine(
+                        Context,
+                        Mile::FormatUtf16String(
+                            L"%s (0x%08X)",
+                            Task.Command.c_str(),
+                            Result.Result).c_str());
+                }
+            }
+
+            Context->WriteLine(Context, L"");
+
+            Statuses[Index] = Status;
+            Results[Index].Result = Result.Result;
+            Results[Index].StartTime = Result.StartTime;
+            Results[Index].Duration = Result.Duration;
+        });
+
+    ULONGLONG JobDuration = Mile::GetTickCount() - JobStartTime;
+
+    int NameWidth = 4;
+    for (NSUDO_PLUGIN_HOST_JOB_TASK const& Task : JobTasks)
+    {
+        if (NameWidth < static_cast<int>(Task.Name.size()))
+        {
+            NameWidth = static_cast<int>(Task.Name.size());
+        }
+    }
+
+    std::wstring Table = Mile::FormatUtf16String(
+        L"%-*s  %-9s  %12s  %12s\r\n",
+        NameWidth,
+        L"Task",
+        L"Status",
+        L"Start (ms)",
+        L"Time (ms)");
+
+    hr = S_OK;
+    bool Skipped = false;
+    for (std::size_t Index = 0; Index < JobTasks.size(); ++Index)
+    {
+        if (Statuses[Index] == NSUDO_JOB_TASK_STATUS::Skipped)
+        {
+            Table.append(Mile::FormatUtf16String(
+                L"%-*s  %-9s  %12s  %12s\r\n",
+                NameWidth,
+                JobTasks[Index].Name.c_str(),
+                L"Skipped",
+                L"-",
+                L"-"));
+        }
+        else
+        {
+            Table.append(Mile::FormatUtf16String(
+                L"%-*s  %-9s  %12llu  %12llu\r\n",
+                NameWidth,
+                JobTasks[Index].Name.c_str(),
+                Statuses[Index] == NSUDO_JOB_TASK_STATUS::Succeeded
+                ? L"Succeeded"
+                : L"Failed",
+                Results[Index].StartTime,
+                Results[Index].Duration));
+        }
+
+        if (Statuses[Index] == NSUDO_JOB_TASK_STATUS::Failed)
+        {
+            if (hr == S_OK)
+            {
+                hr = Results[Index].Result;
+            }
+        }
+        else if (Statuses[Index] == NSUDO_JOB_TASK_STATUS::Skipped)
+        {
+            Skipped = true;
+        }
+    }
+    if (hr == S_OK && Skipped)
+    {
+        hr = E_ABORT;
+    }
+
+    Table.append(Mile::FormatUtf16String(
+        L"%-*s  %-9s  %12s  %12llu\r\n",
+        NameWidth,
+        L"Total",
+        L"",
+        L"",
+        JobDuration));
+
+    Context->Write(Context, Table.c_str());
+
+    return hr;
+}
+
+int main()
+{
+    // Fall back to English in unsupported environment. (Temporary Hack)
+    // Reference: https://github.com/M2Team/NSudo/issues/56
+    switch (PRIMARYLANGID(::GetThreadUILanguage()))
+    {
+    case LANG_ENGLISH:
+    case LANG_CHINESE:
+        break;
+    default:
+        ::SetThreadUILanguage(MAKELANGID(LANG_ENGLISH, SUBLANG_NEUTRAL));
+        break;
+    }
+
+    std::shared_ptr<const CNSudoTranslationTable> GlobalTranslations;
+
+    ::NSudoContextLoadTranslations(
+        GlobalTranslations,
+        ::GetModuleHandleW(nullptr));
+
+    NSUDO_CONTEXT_PRIVATE Context;
+    ::NSudoPluginHostInitializeContext(Context);
 
     Context.PublicContext.Write(
         &Context.PublicContext,
@@ -82,16 +791,70 @@ int main()
 
     Context.PublicContext.Write(
         &Context.PublicContext,
-        GlobalTranslations["WarningText"].c_str());
+        GlobalTranslations->Find("WarningText").data());
+
+    std::wstring RootPath = Mile::GetCurrentProcessModulePath();
+    std::wcsrchr(&RootPath[0], '\\')[0] = L'\0';
+    RootPath.resize(std::wcslen(RootPath.c_str()));
 
     std::wstring CommandLine = std::wstring(::GetCommandLineW());
 
     std::vector<std::wstring> Arguments = Mile::SpiltCommandLine(CommandLine);
-    if (Arguments.size() < 3)
+    if (Arguments.size() == 2 &&
+        Arguments[1].size() > 9 &&
+        0 == ::_wcsnicmp(Arguments[1].c_str(), L"-Session:", 9))
+    {
+        return ::NSudoPluginHostRunSession(
+            &Context.PublicContext,
+            *GlobalTranslations,
+            RootPath,
+            Arguments[1].substr(9));
+    }
+
+    if (Arguments.size() >= 2 &&
+        Arguments[1].size() > 5 &&
+        0 == ::_wcsnicmp(Arguments[1].c_str(), L"-Job:", 5))
+    {
+        std::size_t MaxParallel = Mile::GetNumberOfHardwareThreads();
+        bool ArgumentError = false;
+
+        for (std::size_t i = 2; i < Arguments.size(); ++i)
+        {
+            if (0 == ::_wcsnicmp(Arguments[i].c_str(), L"-MaxParallel:", 13))
+            {
+                wchar_t* End = nullptr;
+                unsigned long Value = std::wcstoul(
+                    Arguments[i].c_str() + 13, &End, 10);
+                if (Arguments[i].size() == 13 || *End || !Value)
+                {
+                    ArgumentError = true;
+                    break;
+                }
+                MaxParallel = Value;
+            }
+            else
+            {
+                ArgumentError = true;
+                break;
+            }
+        }
+
+        if (!ArgumentError)
+        {
+            return ::NSudoPluginHostRunJob(
+                &Context.PublicContext,
+                *GlobalTranslations,
+                RootPath,
+                Arguments[1].substr(5),
+                MaxParallel);
+        }
+    }
+
+    if (Arguments.size() < 3 || Arguments[1][0] == L'-')
     {
         Context.PublicContext.Write(
             &Context.PublicContext,
-            GlobalTranslations["CommandLineHelpText"].c_str());
+            GlobalTranslations->Find("CommandLineHelpText").data());
         return E_INVALIDARG;
     }
 
@@ -127,10 +890,6 @@ int main()
         PluginArguments = std::wstring(command);
     }
 
-    std::wstring RootPath = Mile::GetCurrentProcessModulePath();
-    std::wcsrchr(&RootPath[0], '\\')[0] = L'\0';
-    RootPath.resize(std::wcslen(RootPath.c_str()));
-
     HRESULT hr = ::NSudoContextExecutePlugin(
         &Context.PublicContext,
         (RootPath + L"\\" + PluginModuleName).c_str(),
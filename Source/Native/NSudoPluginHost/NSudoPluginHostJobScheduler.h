@@ -0,0 +1,337 @@
+﻿/*
+ * PROJECT:   NSudo Plugin Host
+ * FILE:      NSudoPluginHostJobScheduler.h
+ * PURPOSE:   Definition for NSudo Plugin Host job scheduler
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_PLUGIN_HOST_JOB_SCHEDULER
+#define NSUDO_PLUGIN_HOST_JOB_SCHEDULER
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A task of the job, as seen by the scheduler.
+*/
+typedef struct _NSUDO_JOB_TASK
+{
+    // The indexes of the tasks which need to succeed before the task starts.
+    std::vector<std::size_t> After;
+
+    // The indexes of the resource classes used by the task.
+    std::vector<std::size_t> Resources;
+
+} NSUDO_JOB_TASK, *PNSUDO_JOB_TASK;
+
+/**
+ * @brief The status of a finished task of the job.
+*/
+typedef enum class _NSUDO_JOB_TASK_STATUS
+{
+    Succeeded,
+    Failed,
+
+    // The task is not run because a task which it depends on has failed or
+    // has been skipped.
+    Skipped,
+
+} NSUDO_JOB_TASK_STATUS, *PNSUDO_JOB_TASK_STATUS;
+
+/**
+ * @brief Checks the tasks of the job, which need to refer to the existing
+ *        tasks and resource classes and have no dependency cycle.
+ * @param Tasks The tasks of the job.
+ * @param ResourceCapacities The number of the tasks which can use each
+ *                           resource class at the same time.
+ * @param InvalidTask Receives the index of the first task which refers to a
+ *                    task or resource class which does not exist, or of a
+ *                    task in a dependency cycle.
+ * @return True if the tasks can be run.
+*/
+inline bool NSudoCheckJobTasks(
+    std::vector<NSUDO_JOB_TASK> const& Tasks,
+    std::vector<std::size_t> const& ResourceCapacities,
+    std::size_t& InvalidTask)
+{
+    std::vector<std::size_t> PendingCount(Tasks.size(), 0);
+    std::vector<std::vector<std::size_t>> Dependents(Tasks.size());
+
+    for (std::size_t Index = 0; Index < Tasks.size(); ++Index)
+    {
+        for (std::size_t const& Dependency : Tasks[Index].After)
+        {
+            if (Dependency >= Tasks.size())
+            {
+                InvalidTask = Index;
+                return false;
+            }
+            Dependents[Dependency].push_back(Index);
+            ++PendingCount[Index];
+        }
+
+        for (std::size_t const& Resource : Tasks[Index].Resources)
+        {
+            if (Resource >= ResourceCapacities.size() ||
+                !ResourceCapacities[Resource])
+            {
+                InvalidTask = Index;
+                return false;
+            }
+        }
+    }
+
+    // The tasks which are never ready after removing the tasks without the
+    // pending dependencies repeatedly are in the dependency cycles.
+    std::vector<std::size_t> Ready;
+    for (std::size_t Index = 0; Index < Tasks.size(); ++Index)
+    {
+        if (!PendingCount[Index])
+        {
+            Ready.push_back(Index);
+        }
+    }
+    for (std::size_t Position = 0; Position < Ready.size(); ++Position)
+    {
+        for (std::size_t const& Dependent : Dependents[Ready[Position]])
+        {
+            if (!--PendingCount[Dependent])
+            {
+                Ready.push_back(Dependent);
+            }
+        }
+    }
+    for (std::size_t Index = 0; Index < Tasks.size(); ++Index)
+    {
+        if (PendingCount[Index])
+        {
+            InvalidTask = Index;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Runs the tasks of the job on a bounded worker pool. A task starts
+ *        when all the tasks which it depends on have succeeded and all its
+ *        resource classes have capacity left, and the ready tasks start in
+ *        the input order. The scheduler only depends on the C++ standard
+ *        library, so it can be driven by stub tasks.
+ * @param Tasks The tasks of the job, which need to be checked by
+ *              NSudoCheckJobTasks.
+ * @param ResourceCapacities The number of the tasks which can use each
+ *                           resource class at the same time.
+ * @param MaxParallel The maximum number of tasks running at the same time.
+ *                    If it is zero, one task is run at a time.
+ * @param Runner The callable which runs a task. It is called as
+ *               bool Runner(std::size_t Index, ResultType& Result) from the
+ *               worker threads, so it needs to be thread safe. It returns
+ *               true if the task has succeeded.
+ * @param Reporter The callable which reports a finished task. It is called as
+ *                 void Reporter(std::size_t Index, ResultType& Result,
+ *                 NSUDO_JOB_TASK_STATUS Status) from the calling thread, once
+ *                 per task in the finishing order. The result of a skipped
+ *                 task is value-initialized.
+*/
+template<typename ResultType, typename RunnerType, typename ReporterType>
+void NSudoRunJob(
+    std::vector<NSUDO_JOB_TASK> const& Tasks,
+    std::vector<std::size_t> const& ResourceCapacities,
+    std::size_t MaxParallel,
+    RunnerType&& Runner,
+    ReporterType&& Reporter)
+{
+    if (Tasks.empty())
+    {
+        return;
+    }
+
+    if (!MaxParallel)
+    {
+        MaxParallel = 1;
+    }
+    if (MaxParallel > Tasks.size())
+    {
+        MaxParallel = Tasks.size();
+    }
+
+    std::mutex Mutex;
+    std::condition_variable StateChangedEvent;
+
+    std::vector<std::size_t> PendingCount(Tasks.size(), 0);
+    std::vector<std::vector<std::size_t>> Dependents(Tasks.size());
+    for (std::size_t Index = 0; Index < Tasks.size(); ++Index)
+    {
+        for (std::size_t const& Dependency : Tasks[Index].After)
+        {
+            Dependents[Dependency].push_back(Index);
+            ++PendingCount[Index];
+        }
+    }
+
+    std::vector<std::size_t> Ready;
+    for (std::size_t Index = 0; Index < Tasks.size(); ++Index)
+    {
+        if (!PendingCount[Index])
+        {
+            Ready.push_back(Index);
+        }
+    }
+
+    std::vector<std::size_t> ResourceUsage(ResourceCapacities.size(), 0);
+    std::vector<bool> Finished(Tasks.size(), false);
+    std::vector<ResultType> Results(Tasks.size());
+    std::vector<NSUDO_JOB_TASK_STATUS> Statuses(Tasks.size());
+    std::deque<std::size_t> Reports;
+    std::size_t NotStartedCount = Tasks.size();
+
+    // Finds the first ready task whose resource classes have capacity left.
+    // It needs to be called with the mutex held.
+    auto FindRunnable = [&]() -> std::size_t
+    {
+        for (std::size_t Position = 0; Position < Ready.size(); ++Position)
+        {
+            bool Runnable = true;
+            NSUDO_JOB_TASK const& Task = Tasks[Ready[Position]];
+            for (std::size_t const& Resource : Task.Resources)
+            {
+                if (ResourceUsage[Resource] >= ResourceCapacities[Resource])
+                {
+                    Runnable = false;
+                    break;
+                }
+            }
+            if (Runnable)
+            {
+                return Position;
+            }
+        }
+        return Ready.size();
+    };
+
+    // Marks the task as finished, and makes its dependents ready or skips
+    // them. It needs to be called with the mutex held.
+    std::vector<std::size_t> FinishStack;
+    auto Finish = [&](std::size_t Index, NSUDO_JOB_TASK_STATUS Status)
+    {
+        Finished[Index] = true;
+        Statuses[Index] = Status;
+        Reports.push_back(Index);
+
+        FinishStack.push_back(Index);
+        while (!FinishStack.empty())
+        {
+            std::size_t Current = FinishStack.back();
+            FinishStack.pop_back();
+
+            for (std::size_t const& Dependent : Dependents[Current])
+            {
+                if (Statuses[Current] != NSUDO_JOB_TASK_STATUS::Succeeded)
+                {
+                    // The dependent has not started, because it still has a
+                    // pending dependency.
+                    if (!Finished[Dependent])
+                    {
+                        Finished[Dependent] = true;
+                        Statuses[Dependent] = NSUDO_JOB_TASK_STATUS::Skipped;
+                        Reports.push_back(Dependent);
+                        --NotStartedCount;
+                        FinishStack.push_back(Dependent);
+                    }
+                }
+                else if (!--PendingCount[Dependent] && !Finished[Dependent])
+                {
+                    Ready.push_back(Dependent);
+                }
+            }
+        }
+    };
+
+    auto Worker = [&]()
+    {
+        for (;;)
+        {
+            std::size_t Index;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                std::size_t Position = Ready.size();
+                StateChangedEvent.wait(Lock, [&]()
+                {
+                    Position = FindRunnable();
+                    return Position < Ready.size() || !NotStartedCount;
+                });
+                if (Position >= Ready.size())
+                {
+                    break;
+                }
+
+                Index = Ready[Position];
+                Ready.erase(Ready.begin() + Position);
+                --NotStartedCount;
+                for (std::size_t const& Resource : Tasks[Index].Resources)
+                {
+                    ++ResourceUsage[Resource];
+                }
+            }
+
+            ResultType Result = ResultType();
+            bool Succeeded = Runner(Index, Result);
+
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                Results[Index] = std::move(Result);
+                for (std::size_t const& Resource : Tasks[Index].Resources)
+                {
+                    --ResourceUsage[Resource];
+                }
+                Finish(
+                    Index,
+                    Succeeded
+                    ? NSUDO_JOB_TASK_STATUS::Succeeded
+                    : NSUDO_JOB_TASK_STATUS::Failed);
+            }
+            StateChangedEvent.notify_all();
+        }
+    };
+
+    std::vector<std::thread> Workers;
+    Workers.reserve(MaxParallel);
+    for (std::size_t i = 0; i < MaxParallel; ++i)
+    {
+        Workers.emplace_back(Worker);
+    }
+
+    for (std::size_t Reported = 0; Reported < Tasks.size(); ++Reported)
+    {
+        std::size_t Index;
+        ResultType Result;
+        NSUDO_JOB_TASK_STATUS Status;
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            StateChangedEvent.wait(Lock, [&]() { return !Reports.empty(); });
+            Index = Reports.front();
+            Reports.pop_front();
+            Result = std::move(Results[Index]);
+            Status = Statuses[Index];
+        }
+
+        Reporter(Index, Result, Status);
+    }
+
+    for (std::thread& Item : Workers)
+    {
+        Item.join();
+    }
+}
+
+#endif // !NSUDO_PLUGIN_HOST_JOB_SCHEDULER
@@ -0,0 +1,212 @@
+﻿/*
+ * PROJECT:   NSudo Relay Benchmark
+ * FILE:      NSudoBenchmarkPipe.h
+ * PURPOSE:   Definition for NSudo benchmark pipe (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_BENCHMARK_PIPE
+#define NSUDO_BENCHMARK_PIPE
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+
+/**
+ * @brief An anonymous pipe with a large buffer, which stands for the pipe of
+ *        a redirected stream, e.g. of a child process or of the standard
+ *        input and output of the plugin host.
+*/
+class CNSudoBenchmarkPipe
+{
+private:
+
+#ifdef _WIN32
+    HANDLE m_ReadHandle = nullptr;
+    HANDLE m_WriteHandle = nullptr;
+#else
+    int m_ReadHandle = -1;
+    int m_WriteHandle = -1;
+#endif
+
+public:
+
+    /**
+     * @brief Creates the pipe.
+     * @param BufferSize The requested buffer size of the pipe, in bytes.
+    */
+    explicit CNSudoBenchmarkPipe(
+        std::size_t BufferSize)
+    {
+#ifdef _WIN32
+        ::CreatePipe(
+            &this->m_ReadHandle,
+            &this->m_WriteHandle,
+            nullptr,
+            static_cast<DWORD>(BufferSize));
+#else
+        int Handles[2] = { -1, -1 };
+        if (0 == ::pipe(Handles))
+        {
+            this->m_ReadHandle = Handles[0];
+            this->m_WriteHandle = Handles[1];
+#ifdef F_SETPIPE_SZ
+            // The size is limited by /proc/sys/fs/pipe-max-size, the default
+            // size is kept if it cannot be changed.
+            ::fcntl(
+                this->m_WriteHandle,
+                F_SETPIPE_SZ,
+                static_cast<int>(BufferSize));
+#endif
+        }
+#endif
+    }
+
+    ~CNSudoBenchmarkPipe()
+    {
+        this->CloseWriter();
+#ifdef _WIN32
+        if (this->m_ReadHandle)
+        {
+            ::CloseHandle(this->m_ReadHandle);
+        }
+#else
+        if (this->m_ReadHandle != -1)
+        {
+            ::close(this->m_ReadHandle);
+        }
+#endif
+    }
+
+    CNSudoBenchmarkPipe(const CNSudoBenchmarkPipe&) = delete;
+    CNSudoBenchmarkPipe& operator=(
+        const CNSudoBenchmarkPipe&) = delete;
+
+    /**
+     * @brief Checks whether the pipe has been created.
+     * @return True if the pipe has been created.
+    */
+    bool IsValid() const
+    {
+#ifdef _WIN32
+        return this->m_ReadHandle && this->m_WriteHandle;
+#else
+        return this->m_ReadHandle != -1 && this->m_WriteHandle != -1;
+#endif
+    }
+
+    /**
+     * @brief Reads from the pipe.
+     * @param Buffer The buffer which receives the data.
+     * @param Size The size of the buffer, in bytes.
+     * @return The number of bytes read, 0 at the end of the stream.
+    */
+    std::size_t Read(
+        void* Buffer,
+        std::size_t Size)
+    {
+#ifdef _WIN32
+        DWORD NumberOfBytesRead = 0;
+        if (!::ReadFile(
+            this->m_ReadHandle,
+            Buffer,
+            static_cast<DWORD>(Size),
+            &NumberOfBytesRead,
+            nullptr))
+        {
+            return 0;
+        }
+        return NumberOfBytesRead;
+#else
+        for (;;)
+        {
+            ssize_t Result = ::read(this->m_ReadHandle, Buffer, Size);
+            if (Result >= 0)
+            {
+                return static_cast<std::size_t>(Result);
+            }
+            if (errno != EINTR)
+            {
+                return 0;
+            }
+        }
+#endif
+    }
+
+    /**
+     * @brief Writes all the data to the pipe.
+     * @param Buffer The data to write.
+     * @param Size The size of the data, in bytes.
+     * @return True if all the data has been written.
+    */
+    bool Write(
+        const void* Buffer,
+        std::size_t Size)
+    {
+        const char* Current = reinterpret_cast<const char*>(Buffer);
+
+        while (Size)
+        {
+#ifdef _WIN32
+            DWORD NumberOfBytesWritten = 0;
+            if (!::WriteFile(
+                this->m_WriteHandle,
+                Current,
+                static_cast<DWORD>(Size),
+                &NumberOfBytesWritten,
+                nullptr))
+            {
+                return false;
+            }
+            std::size_t Length = NumberOfBytesWritten;
+#else
+            ssize_t Result = ::write(this->m_WriteHandle, Current, Size);
+            if (Result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            std::size_t Length = static_cast<std::size_t>(Result);
+#endif
+            Current += Length;
+            Size -= Length;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Closes the write end, so the reader gets the end of the stream.
+    */
+    void CloseWriter()
+    {
+#ifdef _WIN32
+        if (this->m_WriteHandle)
+        {
+            ::CloseHandle(this->m_WriteHandle);
+            this->m_WriteHandle = nullptr;
+        }
+#else
+        if (this->m_WriteHandle != -1)
+        {
+            ::close(this->m_WriteHandle);
+            this->m_WriteHandle = -1;
+        }
+#endif
+    }
+};
+
+#endif // !NSUDO_BENCHMARK_PIPE
@@ -0,0 +1,214 @@
+﻿/*
+ * PROJECT:   NSudo Relay Benchmark
+ * FILE:      NSudoRelayBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo Relay Benchmark (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+// The benchmark only depends on the relay core and the system pipes, so it
+// also builds on Linux, e.g.
+// g++ -std=c++14 -O2 -pthread -I../NSudoSDK NSudoRelayBenchmark.cpp
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <NSudoOutputRelay.h>
+
+#include "NSudoBenchmarkPipe.h"
+
+/**
+ * @brief The sink types which are measured by the benchmark.
+*/
+enum class NSUDO_RELAY_BENCHMARK_SINK
+{
+    NONE,
+    RING
+};
+
+/**
+ * @brief Relays the data written by a producer thread through a pipe.
+ * @param Sink The sink type.
+ * @param TotalSize The number of bytes written by the producer.
+ * @param WriteSize The size of each write of the producer, in bytes.
+ * @param RelayBufferSize The size of the relay buffer, in bytes.
+ * @param Seconds Receives the elapsed time, in seconds.
+ * @return The number of bytes received by the sink.
+*/
+static std::uint64_t NSudoRelayBenchmarkRun(
+    NSUDO_RELAY_BENCHMARK_SINK Sink,
+    std::uint64_t TotalSize,
+    std::size_t WriteSize,
+    std::size_t RelayBufferSize,
+    double& Seconds)
+{
+    Seconds = 0.0;
+
+    // The same pipe buffer size as the redirected child streams.
+    CNSudoBenchmarkPipe Pipe(1024 * 1024);
+    if (!Pipe.IsValid())
+    {
+        return 0;
+    }
+
+    std::vector<char> WriteBuffer(WriteSize, 'N');
+    std::vector<char> RelayBuffer(RelayBufferSize);
+
+    CNSudoOutputRing Ring(4 * 1024 * 1024);
+    std::uint64_t Received = 0;
+
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    std::thread Producer([&]()
+    {
+        std::uint64_t Remaining = TotalSize;
+        while (Remaining)
+        {
+            std::size_t Length = Remaining < WriteSize
+                ? static_cast<std::size_t>(Remaining)
+                : WriteSize;
+            if (!Pipe.Write(WriteBuffer.data(), Length))
+            {
+                break;
+            }
+            Remaining -= Length;
+        }
+
+        Pipe.CloseWriter();
+    });
+
+    std::thread Consumer;
+    if (Sink == NSUDO_RELAY_BENCHMARK_SINK::RING)
+    {
+        Consumer = std::thread([&]()
+        {
+            std::vector<char> ReadBuffer(RelayBufferSize);
+            bool Completed = false;
+            while (!Completed)
+            {
+                Received += Ring.Read(
+                    ReadBuffer.data(),
+                    ReadBuffer.size(),
+                    std::chrono::milliseconds(100),
+                    Completed);
+            }
+        });
+    }
+
+    std::uint64_t Relayed = ::NSudoRelayOutput(
+        [&](void* Buffer, std::size_t Size) -> std::size_t
+        {
+            return Pipe.Read(Buffer, Size);
+        },
+        [&](const void* Buffer, std::size_t Size) -> bool
+        {
+            if (Sink == NSUDO_RELAY_BENCHMARK_SINK::RING)
+            {
+                return Ring.Write(Buffer, Size);
+            }
+
+            Received += Size;
+            return true;
+        },
+        RelayBuffer.data(),
+        RelayBuffer.size());
+
+    Ring.Complete();
+
+    Producer.join();
+    if (Consumer.joinable())
+    {
+        Consumer.join();
+    }
+
+    Seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - Start).count();
+
+    return Relayed == Received ? Received : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t TotalSize = 1024ULL * 1024 * 1024;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char* End = nullptr;
+        unsigned long long Value = 0;
+
+        if (0 == std::strncmp(argv[i], "-Size:", 6))
+        {
+            Value = std::strtoull(argv[i] + 6, &End, 10);
+        }
+
+        if (!Value || !End || *End)
+        {
+            std::printf(
+                "Usage: NSudoRelayBenchmark [-Size:MiB]\n"
+                "\n"
+                "Relays the data written to a pipe by a producer thread, and "
+                "reports the\n"
+                "throughput of each sink and relay buffer size. The default "
+                "size is 1024 MiB.\n");
+            return EXIT_FAILURE;
+        }
+
+        TotalSize = Value * 1024 * 1024;
+    }
+
+    static const std::size_t RelayBufferSizes[] =
+    {
+        4 * 1024,
+        64 * 1024,
+        1024 * 1024
+    };
+
+    std::printf(
+        "%-6s %14s %14s %12s\n",
+        "Sink",
+        "Buffer (KiB)",
+        "Write (KiB)",
+        "MiB/s");
+
+    int Result = EXIT_SUCCESS;
+
+    for (NSUDO_RELAY_BENCHMARK_SINK Sink :
+        { NSUDO_RELAY_BENCHMARK_SINK::NONE, NSUDO_RELAY_BENCHMARK_SINK::RING })
+    {
+        for (std::size_t RelayBufferSize : RelayBufferSizes)
+        {
+            const std::size_t WriteSize = 64 * 1024;
+
+            double Seconds = 0.0;
+            std::uint64_t Received = ::NSudoRelayBenchmarkRun(
+                Sink,
+                TotalSize,
+                WriteSize,
+                RelayBufferSize,
+                Seconds);
+            if (Received != TotalSize)
+            {
+                std::printf("The relay lost data.\n");
+                Result = EXIT_FAILURE;
+                continue;
+            }
+
+            std::printf(
+                "%-6s %14zu %14zu %12.1f\n",
+                Sink == NSUDO_RELAY_BENCHMARK_SINK::RING ? "Ring" : "None",
+                RelayBufferSize / 1024,
+                WriteSize / 1024,
+                Received / 1024.0 / 1024.0 / Seconds);
+        }
+    }
+
+    return Result;
+}
@@ -13,13 +13,22 @@
 #include <Mile.Windows.h>
 
 #include "M2.Base.h"
+#include "NSudoDerivedTokenCache.h"
+#include "NSudoEnvironmentBlockCache.h"
+#include "NSudoJobObject.h"
+#include "NSudoLaunchBackend.h"
+#include "NSudoOutputRedirection.h"
+#include "NSudoTrustedInstallerPrewarm.h"
 
 #include <cstdio>
+#include <cstring>
 #include <cwchar>
+#include <new>
 
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP | WINAPI_PARTITION_SYSTEM)
 #include <Userenv.h>
@@ -69,6 +78,305 @@ EXTERN_C VOID WINAPI NSudoWriteLog(
     g_NSudoLog += g_NSudoLogSplitter;
 }
 
+EXTERN_C VOID WINAPI NSudoInvalidateEnvironmentBlockCache()
+{
+    CNSudoEnvironmentBlockCache::GetInstance().Invalidate();
+
+    ::NSudoWriteLog(
+        L"NSudoInvalidateEnvironmentBlockCache",
+        L"The environment block cache has been invalidated.");
+}
+
+EXTERN_C VOID WINAPI NSudoSetEnvironmentBlockCacheTimeToLive(
+    _In_ DWORD TimeToLive)
+{
+    CNSudoEnvironmentBlockCache::GetInstance().SetTimeToLive(TimeToLive);
+}
+
+EXTERN_C VOID WINAPI NSudoInvalidateDerivedTokenCache()
+{
+    CNSudoDerivedTokenCache::GetInstance().Invalidate();
+
+    ::NSudoWriteLog(
+        L"NSudoInvalidateDerivedTokenCache",
+        L"The derived access token cache has been invalidated.");
+}
+
+EXTERN_C VOID WINAPI NSudoStartTrustedInstallerTokenPrewarm()
+{
+    ::NSudoStartTrustedInstallerPrewarm();
+
+    ::NSudoWriteLog(
+        L"NSudoStartTrustedInstallerTokenPrewarm",
+        L"The TrustedInstaller access token prewarm has been started.");
+}
+
+EXTERN_C VOID WINAPI NSudoStopTrustedInstallerTokenPrewarm()
+{
+    ::NSudoStopTrustedInstallerPrewarm();
+
+    ::NSudoWriteLog(
+        L"NSudoStopTrustedInstallerTokenPrewarm",
+        L"The TrustedInstaller access token prewarm has been stopped.");
+}
+
+EXTERN_C HRESULT WINAPI NSudoCreateOutputRing(
+    _In_ DWORD Capacity,
+    _Out_ NSUDO_OUTPUT_RING_HANDLE* RingHandle)
+{
+    if (!RingHandle)
+    {
+        return E_INVALIDARG;
+    }
+
+    *RingHandle = new (std::nothrow) _NSUDO_OUTPUT_RING();
+    if (!*RingHandle)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    try
+    {
+        (*RingHandle)->Ring = std::make_shared<CNSudoOutputRing>(Capacity);
+    }
+    catch (std::bad_alloc const&)
+    {
+        delete *RingHandle;
+        *RingHandle = nullptr;
+        return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
+EXTERN_C HRESULT WINAPI NSudoReadOutputRing(
+    _In_ NSUDO_OUTPUT_RING_HANDLE RingHandle,
+    _Out_writes_bytes_to_(Size, *NumberOfBytesRead) LPVOID Buffer,
+    _In_ DWORD Size,
+    _In_ DWORD Timeout,
+    _Out_ LPDWORD NumberOfBytesRead)
+{
+    if (!RingHandle || !Buffer || !NumberOfBytesRead)
+    {
+        return E_INVALIDARG;
+    }
+
+    bool Completed = false;
+
+    *NumberOfBytesRead = static_cast<DWORD>(RingHandle->Ring->Read(
+        Buffer,
+        Size,
+        std::chrono::milliseconds(Timeout),
+        Completed));
+
+    return Completed ? S_FALSE : S_OK;
+}
+
+EXTERN_C VOID WINAPI NSudoCloseOutputRing(
+    _In_ NSUDO_OUTPUT_RING_HANDLE RingHandle)
+{
+    if (RingHandle)
+    {
+        // The redirectors writing to the ring share it, so the relay thread
+        // woken up by closing the ring never touches a freed ring.
+        RingHandle->Ring->Close();
+        delete RingHandle;
+    }
+}
+
+/**
+ * @brief Wraps the attribute list for process and thread creation.
+*/
+class CNSudoProcThreadAttributeList :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    LPPROC_THREAD_ATTRIBUTE_LIST m_AttributeList = nullptr;
+
+public:
+
+    CNSudoProcThreadAttributeList() = default;
+
+    ~CNSudoProcThreadAttributeList()
+    {
+        if (this->m_AttributeList)
+        {
+            ::DeleteProcThreadAttributeList(this->m_AttributeList);
+            Mile::HeapMemory::Free(this->m_AttributeList);
+        }
+    }
+
+    HRESULT Initialize(
+        _In_ DWORD AttributeCount)
+    {
+        SIZE_T Size = 0;
+        ::InitializeProcThreadAttributeList(
+            nullptr,
+            AttributeCount,
+            0,
+            &Size);
+
+        LPPROC_THREAD_ATTRIBUTE_LIST AttributeList =
+            reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(
+                Mile::HeapMemory::Allocate(Size));
+        if (!AttributeList)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        HRESULT hr = Mile::HResultFromLastError(
+            ::InitializeProcThreadAttributeList(
+                AttributeList,
+                AttributeCount,
+                0,
+                &Size));
+        if (hr != S_OK)
+        {
+            Mile::HeapMemory::Free(AttributeList);
+            return hr;
+        }
+
+        this->m_AttributeList = AttributeList;
+
+        return S_OK;
+    }
+
+    HRESULT Update(
+        _In_ DWORD_PTR Attribute,
+        _In_ PVOID Value,
+        _In_ SIZE_T Size)
+    {
+        return Mile::HResultFromLastError(::UpdateProcThreadAttribute(
+            this->m_AttributeList,
+            0,
+            Attribute,
+            Value,
+            Size,
+            nullptr,
+            nullptr));
+    }
+
+    LPPROC_THREAD_ATTRIBUTE_LIST Get() const
+    {
+        return this->m_AttributeList;
+    }
+};
+
+/**
+ * @brief Applies the affinity, the memory priority and the I/O priority in
+ *        the launch options to the process. It is called while the primary
+ *        thread of the process is still suspended.
+ * @param Backend The launch backend.
+ * @param ProcessHandle The handle of the process.
+ * @param Options The launch options.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+static HRESULT NSudoApplyProcessResourceOptions(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ HANDLE ProcessHandle,
+    _In_ PNSUDO_CREATE_PROCESS_OPTIONS Options)
+{
+    HRESULT hr = S_OK;
+
+    if (Options->SetAffinity)
+    {
+        // The processor group is selected by the process attribute list, the
+        // process affinity mask also covers the threads created later.
+        hr = Backend->SetProcessAffinityMask(
+            ProcessHandle,
+            Options->AffinityMask);
+        if (hr != S_OK)
+        {
+            ::NSudoWriteLog(
+                L"NSudoCreateProcess",
+                Mile::FormatUtf16String(
+                    L"%s failed, returns %d.",
+                    L"Set affinity mask for process",
+                    hr).c_str());
+
+            return hr;
+        }
+    }
+
+    if (NSUDO_MEMORY_PRIORITY_TYPE::DEFAULT != Options->MemoryPriority)
+    {
+        ULONG MemoryPriority;
+        switch (Options->MemoryPriority)
+        {
+        case NSUDO_MEMORY_PRIORITY_TYPE::VERY_LOW:
+            MemoryPriority = MEMORY_PRIORITY_VERY_LOW;
+            break;
+        case NSUDO_MEMORY_PRIORITY_TYPE::LOW:
+            MemoryPriority = MEMORY_PRIORITY_LOW;
+            break;
+        case NSUDO_MEMORY_PRIORITY_TYPE::MEDIUM:
+            MemoryPriority = MEMORY_PRIORITY_MEDIUM;
+            break;
+        case NSUDO_MEMORY_PRIORITY_TYPE::BELOW_NORMAL:
+            MemoryPriority = MEMORY_PRIORITY_BELOW_NORMAL;
+            break;
+        case NSUDO_MEMORY_PRIORITY_TYPE::NORMAL:
+            MemoryPriority = MEMORY_PRIORITY_NORMAL;
+            break;
+        default:
+            return E_INVALIDARG;
+        }
+
+        hr = Backend->SetProcessMemoryPriority(ProcessHandle, MemoryPriority);
+        if (hr != S_OK)
+        {
+            ::NSudoWriteLog(
+                L"NSudoCreateProcess",
+                Mile::FormatUtf16String(
+                    L"%s failed, returns %d.",
+                    L"Set memory priority for process",
+                    hr).c_str());
+
+            return hr;
+        }
+    }
+
+    if (NSUDO_IO_PRIORITY_TYPE::DEFAULT != Options->IoPriority)
+    {
+        // The values of IO_PRIORITY_HINT.
+        ULONG IoPriority;
+        switch (Options->IoPriority)
+        {
+        case NSUDO_IO_PRIORITY_TYPE::VERY_LOW:
+            IoPriority = 0;
+            break;
+        case NSUDO_IO_PRIORITY_TYPE::LOW:
+            IoPriority = 1;
+            break;
+        case NSUDO_IO_PRIORITY_TYPE::NORMAL:
+            IoPriority = 2;
+            break;
+        case NSUDO_IO_PRIORITY_TYPE::HIGH:
+            IoPriority = 3;
+            break;
+        default:
+            return E_INVALIDARG;
+        }
+
+        hr = Backend->SetProcessIoPriority(ProcessHandle, IoPriority);
+        if (hr != S_OK)
+        {
+            ::NSudoWriteLog(
+                L"NSudoCreateProcess",
+                Mile::FormatUtf16String(
+                    L"%s failed, returns %d.",
+                    L"Set I/O priority for process",
+                    hr).c_str());
+
+            return hr;
+        }
+    }
+
+    return hr;
+}
+
 EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     _In_ NSUDO_USER_MODE_TYPE UserModeType,
     _In_ NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType,
@@ -80,6 +388,63 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     _In_ LPCWSTR CommandLine,
     _In_opt_ LPCWSTR CurrentDirectory)
 {
+    return ::NSudoCreateProcessEx(
+        UserModeType,
+        PrivilegesModeType,
+        MandatoryLabelType,
+        ProcessPriorityClassType,
+        ShowWindowModeType,
+        WaitInterval,
+        CreateNewConsole,
+        CommandLine,
+        CurrentDirectory,
+        nullptr);
+}
+
+EXTERN_C HRESULT WINAPI NSudoCreateProcessEx(
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType,
+    _In_ NSUDO_MANDATORY_LABEL_TYPE MandatoryLabelType,
+    _In_ NSUDO_PROCESS_PRIORITY_CLASS_TYPE ProcessPriorityClassType,
+    _In_ NSUDO_SHOW_WINDOW_MODE_TYPE ShowWindowModeType,
+    _In_ DWORD WaitInterval,
+    _In_ BOOL CreateNewConsole,
+    _In_ LPCWSTR CommandLine,
+    _In_opt_ LPCWSTR CurrentDirectory,
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options)
+{
+    return ::NSudoCreateProcessWithBackend(
+        ::NSudoGetWin32LaunchBackend(),
+        UserModeType,
+        PrivilegesModeType,
+        MandatoryLabelType,
+        ProcessPriorityClassType,
+        ShowWindowModeType,
+        WaitInterval,
+        CreateNewConsole,
+        CommandLine,
+        CurrentDirectory,
+        Options);
+}
+
+HRESULT NSudoCreateProcessWithBackend(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType,
+    _In_ NSUDO_MANDATORY_LABEL_TYPE MandatoryLabelType,
+    _In_ NSUDO_PROCESS_PRIORITY_CLASS_TYPE ProcessPriorityClassType,
+    _In_ NSUDO_SHOW_WINDOW_MODE_TYPE ShowWindowModeType,
+    _In_ DWORD WaitInterval,
+    _In_ BOOL CreateNewConsole,
+    _In_ LPCWSTR CommandLine,
+    _In_opt_ LPCWSTR CurrentDirectory,
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options)
+{
+    if (!Backend)
+    {
+        return E_INVALIDARG;
+    }
+
     ::NSudoWriteLog(
         L"NSudoCreateProcess",
         Mile::FormatUtf16String(
@@ -91,7 +456,8 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
             L"WaitInterval: %d\r\n"
             L"CreateNewConsole: %d\r\n"
             L"CommandLine: %s\r\n"
-            L"CurrentDirectory: %s",
+            L"CurrentDirectory: %s\r\n"
+            L"OutputSinkType: %d",
             UserModeType,
             PrivilegesModeType,
             MandatoryLabelType,
@@ -100,7 +466,28 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
             WaitInterval,
             CreateNewConsole,
             CommandLine,
-            CurrentDirectory).c_str());
+            CurrentDirectory,
+            Options ? Options->OutputSinkType : NSUDO_OUTPUT_SINK_TYPE::NONE).c_str());
+
+    if (Options && Options->Size != sizeof(NSUDO_CREATE_PROCESS_OPTIONS))
+    {
+        ::NSudoWriteLog(
+            L"NSudoCreateProcess",
+            Mile::FormatUtf16String(
+                L"Invalid Parameter: %s",
+                L"Options").c_str());
+
+        return E_INVALIDARG;
+    }
+
+    if (Options)
+    {
+        Options->ExitCode = STILL_ACTIVE;
+        std::memset(
+            &Options->JobAccounting,
+            0,
+            sizeof(NSUDO_JOB_ACCOUNTING_INFORMATION));
+    }
 
     DWORD MandatoryLabelRid;
     switch (MandatoryLabelType)
@@ -215,39 +602,39 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         {
             if (CurrentProcessToken !=INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(CurrentProcessToken);
+                Backend->CloseHandle(CurrentProcessToken);
             }
 
             if (DuplicatedCurrentProcessToken != INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(DuplicatedCurrentProcessToken);
+                Backend->CloseHandle(DuplicatedCurrentProcessToken);
             }
 
             if (OriginalSystemToken != INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(OriginalSystemToken);
+                Backend->CloseHandle(OriginalSystemToken);
             }
 
             if (SystemToken != INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(SystemToken);
+                Backend->CloseHandle(SystemToken);
             }
 
             if (hToken != INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(hToken);
+                Backend->CloseHandle(hToken);
             }
 
             if (OriginalToken != INVALID_HANDLE_VALUE)
             {
-                ::CloseHandle(OriginalToken);
+                Backend->CloseHandle(OriginalToken);
             }
 
-            ::SetThreadToken(nullptr, nullptr);
+            Backend->SetThreadToken(nullptr);
         });
 
-    hr = Mile::HResultFromLastError(::OpenProcessToken(
-        ::GetCurrentProcess(), MAXIMUM_ALLOWED, &CurrentProcessToken));
+    hr = Backend->OpenProcessToken(
+        ::GetCurrentProcess(), MAXIMUM_ALLOWED, &CurrentProcessToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -260,13 +647,12 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::HResultFromLastError(::DuplicateTokenEx(
+    hr = Backend->DuplicateTokenEx(
         CurrentProcessToken,
         MAXIMUM_ALLOWED,
-        nullptr,
         SecurityImpersonation,
         TokenImpersonation,
-        &DuplicatedCurrentProcessToken));
+        &DuplicatedCurrentProcessToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -281,8 +667,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
 
     LUID_AND_ATTRIBUTES RawPrivilege;
 
-    hr = Mile::HResultFromLastError(::LookupPrivilegeValueW(
-        nullptr, SE_DEBUG_NAME, &RawPrivilege.Luid));
+    hr = Backend->LookupPrivilegeValueW(SE_DEBUG_NAME, &RawPrivilege.Luid);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -297,7 +682,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
 
     RawPrivilege.Attributes = SE_PRIVILEGE_ENABLED;
 
-    hr = Mile::AdjustTokenPrivilegesSimple(
+    hr = Backend->AdjustTokenPrivileges(
         DuplicatedCurrentProcessToken,
         &RawPrivilege,
         1);
@@ -313,8 +698,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::HResultFromLastError(::SetThreadToken(
-        nullptr, DuplicatedCurrentProcessToken));
+    hr = Backend->SetThreadToken(DuplicatedCurrentProcessToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -327,7 +711,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    SessionID = Mile::GetActiveSessionID();
+    SessionID = Backend->GetActiveSessionID();
     if (SessionID == static_cast<DWORD>(-1))
     {
         ::NSudoWriteLog(
@@ -339,7 +723,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return Mile::HResult::FromWin32(ERROR_NO_TOKEN);
     }
 
-    hr = Mile::CreateSystemToken(MAXIMUM_ALLOWED, &OriginalSystemToken);
+    hr = Backend->CreateSystemToken(MAXIMUM_ALLOWED, &OriginalSystemToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -352,13 +736,12 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::HResultFromLastError(::DuplicateTokenEx(
+    hr = Backend->DuplicateTokenEx(
         OriginalSystemToken,
         MAXIMUM_ALLOWED,
-        nullptr,
         SecurityImpersonation,
         TokenImpersonation,
-        &SystemToken));
+        &SystemToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -371,7 +754,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::AdjustTokenAllPrivileges(
+    hr = Backend->AdjustTokenAllPrivileges(
         SystemToken,
         SE_PRIVILEGE_ENABLED);
     if (hr != S_OK)
@@ -386,8 +769,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::HResultFromLastError(::SetThreadToken(
-        nullptr, SystemToken));
+    hr = Backend->SetThreadToken(SystemToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -400,9 +782,17 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    if (NSUDO_USER_MODE_TYPE::TRUSTED_INSTALLER == UserModeType)
+    if (NSUDO_USER_MODE_TYPE::TRUSTED_INSTALLER == UserModeType &&
+        Backend == ::NSudoGetWin32LaunchBackend() &&
+        ::NSudoAcquireTrustedInstallerPrewarmToken(&OriginalToken))
+    {
+        ::NSudoWriteLog(
+            L"NSudoCreateProcess",
+            L"Use the prewarmed TrustedInstaller service access token.");
+    }
+    else if (NSUDO_USER_MODE_TYPE::TRUSTED_INSTALLER == UserModeType)
     {
-        hr = Mile::OpenServiceProcessToken(
+        hr = Backend->OpenServiceProcessToken(
             L"TrustedInstaller",
             MAXIMUM_ALLOWED,
             &OriginalToken);
@@ -420,7 +810,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     }
     else if (NSUDO_USER_MODE_TYPE::SYSTEM == UserModeType)
     {
-        hr = Mile::CreateSystemToken(MAXIMUM_ALLOWED, &OriginalToken);
+        hr = Backend->CreateSystemToken(MAXIMUM_ALLOWED, &OriginalToken);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -435,7 +825,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     }
     else if (NSUDO_USER_MODE_TYPE::CURRENT_USER == UserModeType)
     {
-        hr = Mile::CreateSessionToken(SessionID, &OriginalToken);
+        hr = Backend->CreateSessionToken(SessionID, &OriginalToken);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -450,8 +840,8 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     }
     else if (NSUDO_USER_MODE_TYPE::CURRENT_PROCESS == UserModeType)
     {
-        hr = Mile::HResultFromLastError(::OpenProcessToken(
-            ::GetCurrentProcess(), MAXIMUM_ALLOWED, &OriginalToken));
+        hr = Backend->OpenProcessToken(
+            ::GetCurrentProcess(), MAXIMUM_ALLOWED, &OriginalToken);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -464,85 +854,55 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
             return hr;
         }
     }
-    else if (NSUDO_USER_MODE_TYPE::CURRENT_PROCESS_DROP_RIGHT == UserModeType)
+    else if (CNSudoDerivedTokenCache::IsCacheable(UserModeType))
     {
-        HANDLE hCurrentProcessToken = nullptr;
-        hr = Mile::HResultFromLastError(::OpenProcessToken(
-            ::GetCurrentProcess(), MAXIMUM_ALLOWED, &hCurrentProcessToken));
-        if (hr == S_OK)
-        {
-            hr = Mile::CreateLUAToken(hCurrentProcessToken, &OriginalToken);
-
-            ::CloseHandle(hCurrentProcessToken);
-        }
+        CNSudoDerivedTokenCache& Cache =
+            CNSudoDerivedTokenCache::GetInstance();
 
+        bool CacheHit = false;
+        hr = Cache.Acquire(
+            Backend,
+            UserModeType,
+            SessionID,
+            &OriginalToken,
+            CacheHit);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
                 L"NSudoCreateProcess",
                 Mile::FormatUtf16String(
                     L"%s failed, returns %d.",
-                    L"Create the current process LUA acccess token",
+                    NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED == UserModeType
+                    ? L"Get the elevated current session acccess token"
+                    : L"Create the current process LUA acccess token",
                     hr).c_str());
 
             return hr;
         }
-    }
-    else if (NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED == UserModeType)
-    {
-        HANDLE hCurrentProcessToken = nullptr;
-        hr = Mile::CreateSessionToken(SessionID, &hCurrentProcessToken);
-        if (hr == S_OK)
-        {
-            TOKEN_LINKED_TOKEN LinkedToken = { 0 };
-            DWORD ReturnLength = 0;
-
-            hr = Mile::HResultFromLastError(::GetTokenInformation(
-                hCurrentProcessToken,
-                TokenLinkedToken,
-                &LinkedToken,
-                sizeof(TOKEN_LINKED_TOKEN),
-                &ReturnLength));
-            if (hr == S_OK)
-            {
-                hr = Mile::HResultFromLastError(::DuplicateTokenEx(
-                    LinkedToken.LinkedToken,
-                    MAXIMUM_ALLOWED,
-                    nullptr,
-                    SecurityIdentification,
-                    TokenPrimary,
-                    &OriginalToken));
-
-                ::CloseHandle(LinkedToken.LinkedToken);
-            }
 
-            ::CloseHandle(hCurrentProcessToken);
-        }
-
-        if (hr != S_OK)
-        {
-            ::NSudoWriteLog(
-                L"NSudoCreateProcess",
-                Mile::FormatUtf16String(
-                    L"%s failed, returns %d.",
-                    L"Get the elevated current session acccess token",
-                    hr).c_str());
+        LONG Hits = 0;
+        LONG Misses = 0;
+        Cache.GetStatistics(&Hits, &Misses);
 
-            return hr;
-        }
+        ::NSudoWriteLog(
+            L"NSudoCreateProcess",
+            Mile::FormatUtf16String(
+                L"Derived access token cache %s. (Hits: %ld, Misses: %ld)",
+                CacheHit ? L"hit" : L"miss",
+                Hits,
+                Misses).c_str());
     }
     else
     {
         return E_INVALIDARG;
     }
 
-    hr = Mile::HResultFromLastError(::DuplicateTokenEx(
+    hr = Backend->DuplicateTokenEx(
         OriginalToken,
         MAXIMUM_ALLOWED,
-        nullptr,
         SecurityIdentification,
         TokenPrimary,
-        &hToken));
+        &hToken);
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -555,11 +915,11 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         return hr;
     }
 
-    hr = Mile::HResultFromLastError(::SetTokenInformation(
+    hr = Backend->SetTokenInformation(
         hToken,
         TokenSessionId,
         (PVOID)&SessionID,
-        sizeof(DWORD)));
+        sizeof(DWORD));
     if (hr != S_OK)
     {
         ::NSudoWriteLog(
@@ -576,7 +936,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     {
     case NSUDO_PRIVILEGES_MODE_TYPE::ENABLE_ALL_PRIVILEGES:
 
-        hr = Mile::AdjustTokenAllPrivileges(hToken, SE_PRIVILEGE_ENABLED);
+        hr = Backend->AdjustTokenAllPrivileges(hToken, SE_PRIVILEGE_ENABLED);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -592,7 +952,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         break;
     case NSUDO_PRIVILEGES_MODE_TYPE::DISABLE_ALL_PRIVILEGES:
 
-        hr = Mile::AdjustTokenAllPrivileges(hToken, 0);
+        hr = Backend->AdjustTokenAllPrivileges(hToken, 0);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -612,7 +972,7 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
 
     if (NSUDO_MANDATORY_LABEL_TYPE::UNTRUSTED != MandatoryLabelType)
     {
-        hr = Mile::SetTokenMandatoryLabel(hToken, MandatoryLabelRid);
+        hr = Backend->SetTokenMandatoryLabel(hToken, MandatoryLabelRid);
         if (hr != S_OK)
         {
             ::NSudoWriteLog(
@@ -626,6 +986,36 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         }
     }
 
+    CNSudoOutputRedirector OutputRedirector;
+
+    hr = OutputRedirector.Initialize(Options);
+    if (hr != S_OK)
+    {
+        ::NSudoWriteLog(
+            L"NSudoCreateProcess",
+            Mile::FormatUtf16String(
+                L"%s failed, returns %d.",
+                L"Initialize the output redirection",
+                hr).c_str());
+
+        return hr;
+    }
+
+    CNSudoJobObject JobObject;
+
+    hr = JobObject.Initialize(Backend, Options);
+    if (hr != S_OK)
+    {
+        ::NSudoWriteLog(
+            L"NSudoCreateProcess",
+            Mile::FormatUtf16String(
+                L"%s failed, returns %d.",
+                L"Initialize the job object",
+                hr).c_str());
+
+        return hr;
+    }
+
     DWORD dwCreationFlags = CREATE_SUSPENDED | CREATE_UNICODE_ENVIRONMENT;
 
     if (CreateNewConsole)
@@ -633,53 +1023,201 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
         dwCreationFlags |= CREATE_NEW_CONSOLE;
     }
 
-    STARTUPINFOW StartupInfo = { 0 };
+    STARTUPINFOEXW StartupInfo = { 0 };
     PROCESS_INFORMATION ProcessInfo = { 0 };
 
-    StartupInfo.cb = sizeof(STARTUPINFOW);
+    StartupInfo.StartupInfo.cb = sizeof(STARTUPINFOW);
+
+    StartupInfo.StartupInfo.lpDesktop = const_cast<LPWSTR>(L"WinSta0\\Default");
+
+    StartupInfo.StartupInfo.dwFlags |= STARTF_USESHOWWINDOW;
+    StartupInfo.StartupInfo.wShowWindow = static_cast<WORD>(ShowWindowMode);
+
+    BOOL InheritHandles = FALSE;
+    CNSudoProcThreadAttributeList AttributeList;
+    GROUP_AFFINITY GroupAffinity = { 0 };
+    USHORT PreferredNode = 0;
+
+    DWORD AttributeCount = 0;
+    if (OutputRedirector.IsEnabled())
+    {
+        OutputRedirector.FillStartupInfo(&StartupInfo.StartupInfo);
+        ++AttributeCount;
+    }
+    if (Options && Options->SetAffinity)
+    {
+        ++AttributeCount;
+    }
+    if (Options && Options->SetPreferredNode)
+    {
+        ++AttributeCount;
+    }
+
+    if (AttributeCount)
+    {
+        hr = AttributeList.Initialize(AttributeCount);
 
-    StartupInfo.lpDesktop = const_cast<LPWSTR>(L"WinSta0\\Default");
+        if (hr == S_OK && OutputRedirector.IsEnabled())
+        {
+            // Only the handles of the standard streams are inherited, so the
+            // child process never holds the handles of concurrent launches.
+            std::vector<HANDLE>& InheritedHandles =
+                OutputRedirector.GetInheritedHandles();
+            if (!InheritedHandles.empty())
+            {
+                hr = AttributeList.Update(
+                    PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+                    InheritedHandles.data(),
+                    InheritedHandles.size() * sizeof(HANDLE));
+                if (hr == S_OK)
+                {
+                    InheritHandles = TRUE;
+                }
+            }
+        }
 
-    StartupInfo.dwFlags |= STARTF_USESHOWWINDOW;
-    StartupInfo.wShowWindow = static_cast<WORD>(ShowWindowMode);
+        if (hr == S_OK && Options->SetAffinity)
+        {
+            // The primary thread starts in the specified processor group,
+            // which becomes the primary group of the process.
+            GroupAffinity.Group = Options->ProcessorGroup;
+            GroupAffinity.Mask = Options->AffinityMask;
+
+            hr = AttributeList.Update(
+                PROC_THREAD_ATTRIBUTE_GROUP_AFFINITY,
+                &GroupAffinity,
+                sizeof(GROUP_AFFINITY));
+        }
+
+        if (hr == S_OK && Options->SetPreferredNode)
+        {
+            PreferredNode = Options->PreferredNode;
 
-    LPVOID lpEnvironment = nullptr;
+            hr = AttributeList.Update(
+                PROC_THREAD_ATTRIBUTE_PREFERRED_NODE,
+                &PreferredNode,
+                sizeof(USHORT));
+        }
 
-    hr = Mile::HResultFromLastError(::CreateEnvironmentBlock(
-        &lpEnvironment, hToken, TRUE));
+        if (hr != S_OK)
+        {
+            ::NSudoWriteLog(
+                L"NSudoCreateProcess",
+                Mile::FormatUtf16String(
+                    L"%s failed, returns %d.",
+                    L"Initialize the process attribute list",
+                    hr).c_str());
+
+            return hr;
+        }
+
+        StartupInfo.StartupInfo.cb = sizeof(STARTUPINFOEXW);
+        StartupInfo.lpAttributeList = AttributeList.Get();
+        dwCreationFlags |= EXTENDED_STARTUPINFO_PRESENT;
+    }
+
+    std::wstring EnvironmentBlock;
+
+    hr = CNSudoEnvironmentBlockCache::GetInstance().Acquire(
+        Backend,
+        hToken,
+        TRUE,
+        Options ? Options->EnvironmentOverrides : nullptr,
+        EnvironmentBlock);
     if (hr == S_OK)
     {
         std::wstring ExpandedString = Mile::ExpandEnvironmentStringsW(
             std::wstring(CommandLine));
         if (hr == S_OK)
         {
-            hr = Mile::HResultFromLastError(::CreateProcessAsUserW(
+            hr = Backend->CreateProcessAsUserW(
                 hToken,
-                nullptr,
                 const_cast<LPWSTR>(ExpandedString.c_str()),
-                nullptr,
-                nullptr,
-                FALSE,
+                InheritHandles,
                 dwCreationFlags,
-                lpEnvironment,
+                const_cast<LPWSTR>(EnvironmentBlock.c_str()),
                 CurrentDirectory,
-                &StartupInfo,
-                &ProcessInfo));
+                &StartupInfo.StartupInfo,
+                &ProcessInfo);
             if (hr == S_OK)
             {
-                ::SetPriorityClass(ProcessInfo.hProcess, ProcessPriority);
-
-                ::ResumeThread(ProcessInfo.hThread);
-
-                ::WaitForSingleObjectEx(
-                    ProcessInfo.hProcess, WaitInterval, FALSE);
-
-                ::CloseHandle(ProcessInfo.hProcess);
-                ::CloseHandle(ProcessInfo.hThread);
+                Backend->SetPriorityClass(ProcessInfo.hProcess, ProcessPriority);
+
+                // The process is assigned to the job before its primary
+                // thread runs, so the whole process tree is in the job.
+                hr = JobObject.Assign(ProcessInfo.hProcess);
+                if (hr != S_OK)
+                {
+                    ::NSudoWriteLog(
+                        L"NSudoCreateProcess",
+                        Mile::FormatUtf16String(
+                            L"%s failed, returns %d.",
+                            L"Assign process to job object",
+                            hr).c_str());
+                }
+
+                if (hr == S_OK && Options)
+                {
+                    hr = ::NSudoApplyProcessResourceOptions(
+                        Backend,
+                        ProcessInfo.hProcess,
+                        Options);
+                }
+
+                if (hr == S_OK)
+                {
+                    hr = OutputRedirector.Start();
+                }
+                if (hr == S_OK)
+                {
+                    ULONGLONG StartTick = Mile::GetTickCount();
+
+                    Backend->ResumeThread(ProcessInfo.hThread);
+
+                    Backend->WaitForSingleObject(
+                        ProcessInfo.hProcess, WaitInterval);
+
+                    if (OutputRedirector.IsEnabled())
+                    {
+                        DWORD RemainingInterval = WaitInterval;
+                        if (WaitInterval != INFINITE)
+                        {
+                            ULONGLONG ElapsedTime =
+                                Mile::GetTickCount() - StartTick;
+                            RemainingInterval = ElapsedTime < WaitInterval
+                                ? static_cast<DWORD>(WaitInterval - ElapsedTime)
+                                : 0;
+                        }
+
+                        OutputRedirector.Wait(RemainingInterval);
+                    }
+
+                    if (Options)
+                    {
+                        if (S_OK != Backend->GetExitCodeProcess(
+                            ProcessInfo.hProcess,
+                            &Options->ExitCode))
+                        {
+                            Options->ExitCode = STILL_ACTIVE;
+                        }
+
+                        if (JobObject.IsEnabled())
+                        {
+                            JobObject.QueryAccounting(&Options->JobAccounting);
+                        }
+                    }
+                }
+                else
+                {
+                    Backend->TerminateProcess(
+                        ProcessInfo.hProcess,
+                        static_cast<UINT>(hr));
+                }
+
+                Backend->CloseHandle(ProcessInfo.hProcess);
+                Backend->CloseHandle(ProcessInfo.hThread);
             }
         }
-
-        ::DestroyEnvironmentBlock(lpEnvironment);
     }
 
     if (hr != S_OK)
@@ -32,6 +32,46 @@ EXTERN_C VOID WINAPI NSudoWriteLog(
     _In_ LPCWSTR Sender,
     _In_ LPCWSTR Content);
 
+/**
+ * @brief Removes all environment blocks cached by NSudoCreateProcess. The next
+ *        launch for each user will create a new environment block.
+*/
+EXTERN_C VOID WINAPI NSudoInvalidateEnvironmentBlockCache();
+
+/**
+ * @brief Sets the time-to-live of the environment blocks cached by
+ *        NSudoCreateProcess.
+ * @param TimeToLive The time-to-live of the cached environment blocks, in
+ *                   milliseconds. If this parameter is 0, the environment
+ *                   blocks will be created for every launch.
+*/
+EXTERN_C VOID WINAPI NSudoSetEnvironmentBlockCacheTimeToLive(
+    _In_ DWORD TimeToLive);
+
+/**
+ * @brief Releases all access tokens cached by NSudoCreateProcess for the
+ *        CURRENT_USER_ELEVATED and CURRENT_PROCESS_DROP_RIGHT user modes. The
+ *        cache detects the session changes by itself, the hosts which receive
+ *        the session logoff notification can call it to release the tokens
+ *        earlier.
+*/
+EXTERN_C VOID WINAPI NSudoInvalidateDerivedTokenCache();
+
+/**
+ * @brief Starts the TrustedInstaller service and opens its access token in the
+ *        background, and opens the access token again when the service stops.
+ *        The TRUSTED_INSTALLER user mode of NSudoCreateProcess uses the ready
+ *        access token instead of starting the service by itself.
+*/
+EXTERN_C VOID WINAPI NSudoStartTrustedInstallerTokenPrewarm();
+
+/**
+ * @brief Stops the prewarm started by NSudoStartTrustedInstallerTokenPrewarm
+ *        and releases the ready access token. The hosts which unload the
+ *        NSudo Shared Library need to call it before unloading.
+*/
+EXTERN_C VOID WINAPI NSudoStopTrustedInstallerTokenPrewarm();
+
 /**
 * Contains values that specify the type of user mode.
 */
@@ -95,6 +135,309 @@ typedef enum class _NSUDO_SHOW_WINDOW_MODE_TYPE
     MINIMIZE,
 } NSUDO_SHOW_WINDOW_MODE_TYPE, *PNSUDO_SHOW_WINDOW_MODE_TYPE;
 
+/**
+ * Contains values that specify the type of memory priority.
+ */
+typedef enum class _NSUDO_MEMORY_PRIORITY_TYPE
+{
+    DEFAULT,
+    VERY_LOW,
+    LOW,
+    MEDIUM,
+    BELOW_NORMAL,
+    NORMAL,
+} NSUDO_MEMORY_PRIORITY_TYPE, *PNSUDO_MEMORY_PRIORITY_TYPE;
+
+/**
+ * Contains values that specify the type of I/O priority.
+ */
+typedef enum class _NSUDO_IO_PRIORITY_TYPE
+{
+    DEFAULT,
+    VERY_LOW,
+    LOW,
+    NORMAL,
+    HIGH,
+} NSUDO_IO_PRIORITY_TYPE, *PNSUDO_IO_PRIORITY_TYPE;
+
+/**
+ * Contains values that specify the type of the output stream of the child
+ * process.
+ */
+typedef enum class _NSUDO_OUTPUT_STREAM_TYPE
+{
+    STANDARD_OUTPUT,
+    STANDARD_ERROR,
+} NSUDO_OUTPUT_STREAM_TYPE, *PNSUDO_OUTPUT_STREAM_TYPE;
+
+/**
+ * Contains values that specify the type of the sink which receives the
+ * captured output of the child process.
+ */
+typedef enum class _NSUDO_OUTPUT_SINK_TYPE
+{
+    NONE,
+    CALLBACK_FUNCTION,
+    FILE_HANDLE,
+    RING_BUFFER,
+} NSUDO_OUTPUT_SINK_TYPE, *PNSUDO_OUTPUT_SINK_TYPE;
+
+/**
+ * @brief The callback which receives the captured output of the child process.
+ *        The chunks are delivered as they are read from the pipe, they are not
+ *        split by lines and the calls are serialized.
+ * @param Context The context specified in the launch options.
+ * @param StreamType The stream which the chunk comes from.
+ * @param Buffer The chunk. It is only valid during the call.
+ * @param Size The size of the chunk, in bytes.
+*/
+typedef VOID(WINAPI* NSUDO_OUTPUT_CALLBACK_TYPE)(
+    _In_opt_ LPVOID Context,
+    _In_ NSUDO_OUTPUT_STREAM_TYPE StreamType,
+    _In_ LPCVOID Buffer,
+    _In_ DWORD Size);
+
+/**
+ * @brief The handle of the memory ring which receives the captured output of
+ *        the child process.
+*/
+typedef struct _NSUDO_OUTPUT_RING* NSUDO_OUTPUT_RING_HANDLE;
+
+/**
+ * @brief Creates a memory ring for receiving the captured output of the child
+ *        process.
+ * @param Capacity The capacity of the ring, in bytes. The relay blocks when
+ *                 the ring is full, so the ring should be drained by another
+ *                 thread while the child process is running.
+ * @param RingHandle The handle of the ring.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+EXTERN_C HRESULT WINAPI NSudoCreateOutputRing(
+    _In_ DWORD Capacity,
+    _Out_ NSUDO_OUTPUT_RING_HANDLE* RingHandle);
+
+/**
+ * @brief Reads the captured output from the memory ring.
+ * @param RingHandle The handle of the ring.
+ * @param Buffer The buffer which receives the data.
+ * @param Size The size of the buffer, in bytes.
+ * @param Timeout The time-out interval for waiting the data, in milliseconds.
+ * @param NumberOfBytesRead The number of bytes read.
+ * @return HRESULT. If the function succeeds, the return value is S_OK. If
+ *         there is no data left and the relay has completed, the return value
+ *         is S_FALSE.
+*/
+EXTERN_C HRESULT WINAPI NSudoReadOutputRing(
+    _In_ NSUDO_OUTPUT_RING_HANDLE RingHandle,
+    _Out_writes_bytes_to_(Size, *NumberOfBytesRead) LPVOID Buffer,
+    _In_ DWORD Size,
+    _In_ DWORD Timeout,
+    _Out_ LPDWORD NumberOfBytesRead);
+
+/**
+ * @brief Closes the memory ring. The relay which is still writing to the ring
+ *        stops, and the ring is freed after the launch which uses it has
+ *        finished.
+ * @param RingHandle The handle of the ring.
+*/
+EXTERN_C VOID WINAPI NSudoCloseOutputRing(
+    _In_ NSUDO_OUTPUT_RING_HANDLE RingHandle);
+
+/**
+ * @brief The default size of the output pipe buffer, in bytes.
+*/
+#define NSUDO_DEFAULT_OUTPUT_PIPE_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Contains the accounting information of the job which contains the launched
+ * process tree.
+ */
+typedef struct _NSUDO_JOB_ACCOUNTING_INFORMATION
+{
+    /**
+     * @brief The total number of processes associated with the job.
+    */
+    DWORD TotalProcesses;
+
+    /**
+     * @brief The total user-mode execution time, in 100-nanosecond ticks.
+    */
+    ULONGLONG TotalUserTime;
+
+    /**
+     * @brief The total kernel-mode execution time, in 100-nanosecond ticks.
+    */
+    ULONGLONG TotalKernelTime;
+
+    /**
+     * @brief The peak committed memory of the job, in bytes.
+    */
+    ULONGLONG PeakJobMemoryUsed;
+
+    /**
+     * @brief The peak committed memory of any process in the job, in bytes.
+    */
+    ULONGLONG PeakProcessMemoryUsed;
+
+    /**
+     * @brief The number of bytes read by the job.
+    */
+    ULONGLONG ReadTransferCount;
+
+    /**
+     * @brief The number of bytes written by the job.
+    */
+    ULONGLONG WriteTransferCount;
+
+    /**
+     * @brief The number of bytes transferred by the job in the I/O operations
+     *        other than read and write.
+    */
+    ULONGLONG OtherTransferCount;
+
+} NSUDO_JOB_ACCOUNTING_INFORMATION, *PNSUDO_JOB_ACCOUNTING_INFORMATION;
+
+/**
+ * Contains the extended options for NSudoCreateProcessEx.
+ */
+typedef struct _NSUDO_CREATE_PROCESS_OPTIONS
+{
+    /**
+     * @brief The size of the structure, in bytes. It must be set to
+     *        sizeof(NSUDO_CREATE_PROCESS_OPTIONS).
+    */
+    DWORD Size;
+
+    /**
+     * @brief The sink which receives the captured output. If this member is
+     *        NSUDO_OUTPUT_SINK_TYPE::NONE, the output is not captured.
+    */
+    NSUDO_OUTPUT_SINK_TYPE OutputSinkType;
+
+    /**
+     * @brief Redirects the standard output of the child process to the sink.
+    */
+    BOOL RedirectStandardOutput;
+
+    /**
+     * @brief Redirects the standard error of the child process to the sink.
+    */
+    BOOL RedirectStandardError;
+
+    /**
+     * @brief The size of the output pipe buffer, in bytes. If this member is
+     *        0, NSUDO_DEFAULT_OUTPUT_PIPE_BUFFER_SIZE is used.
+    */
+    DWORD OutputPipeBufferSize;
+
+    /**
+     * @brief The callback for NSUDO_OUTPUT_SINK_TYPE::CALLBACK_FUNCTION.
+    */
+    NSUDO_OUTPUT_CALLBACK_TYPE OutputCallback;
+
+    /**
+     * @brief The context passed to OutputCallback.
+    */
+    LPVOID OutputCallbackContext;
+
+    /**
+     * @brief The file handle for NSUDO_OUTPUT_SINK_TYPE::FILE_HANDLE. The
+     *        handle must be opened for synchronous writing.
+    */
+    HANDLE OutputFileHandle;
+
+    /**
+     * @brief The memory ring for NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER.
+    */
+    NSUDO_OUTPUT_RING_HANDLE OutputRingHandle;
+
+    /**
+     * @brief Receives the exit code of the process. If the process does not
+     *        exit within the wait interval, it receives STILL_ACTIVE.
+    */
+    DWORD ExitCode;
+
+    /**
+     * @brief Restricts the process to the processors in AffinityMask of the
+     *        processor group ProcessorGroup.
+    */
+    BOOL SetAffinity;
+
+    /**
+     * @brief The processor group for SetAffinity.
+    */
+    WORD ProcessorGroup;
+
+    /**
+     * @brief The processors for SetAffinity, relative to ProcessorGroup.
+    */
+    KAFFINITY AffinityMask;
+
+    /**
+     * @brief Sets PreferredNode as the preferred NUMA node of the process.
+    */
+    BOOL SetPreferredNode;
+
+    /**
+     * @brief The NUMA node for SetPreferredNode.
+    */
+    USHORT PreferredNode;
+
+    /**
+     * @brief The memory priority of the process. If this member is
+     *        NSUDO_MEMORY_PRIORITY_TYPE::DEFAULT, it is not changed.
+    */
+    NSUDO_MEMORY_PRIORITY_TYPE MemoryPriority;
+
+    /**
+     * @brief The I/O priority of the process. If this member is
+     *        NSUDO_IO_PRIORITY_TYPE::DEFAULT, it is not changed.
+    */
+    NSUDO_IO_PRIORITY_TYPE IoPriority;
+
+    /**
+     * @brief The CPU rate cap of the job, in 1/100 of a percent of all
+     *        processors. If this member is 0, the CPU rate is not capped.
+    */
+    DWORD JobCpuRate;
+
+    /**
+     * @brief The maximum working set size of each process in the job, in
+     *        bytes. If this member is 0, the working set is not limited.
+    */
+    SIZE_T JobWorkingSetLimit;
+
+    /**
+     * @brief The maximum committed memory of the job, in bytes. If this
+     *        member is 0, the committed memory is not limited.
+    */
+    SIZE_T JobMemoryLimit;
+
+    /**
+     * @brief Terminates the process tree when the job is closed. The job is
+     *        closed when NSudoCreateProcessEx returns, so the process tree is
+     *        terminated after the wait interval.
+    */
+    BOOL JobKillOnClose;
+
+    /**
+     * @brief Receives the accounting information of the job when the wait
+     *        interval ends. The process tree is placed into a job if any of
+     *        the job options is specified, otherwise it receives zeros.
+    */
+    NSUDO_JOB_ACCOUNTING_INFORMATION JobAccounting;
+
+    /**
+     * @brief The environment variables to override in "Name=Value" form,
+     *        terminated by two null characters like an environment block. If
+     *        the value is empty, the variable is removed. The overrides are
+     *        merged into the environment block of the user. If this member is
+     *        nullptr, the environment block is not changed.
+    */
+    LPCWSTR EnvironmentOverrides;
+
+} NSUDO_CREATE_PROCESS_OPTIONS, *PNSUDO_CREATE_PROCESS_OPTIONS;
+
 /**
  * Creates a new process and its primary thread.
  *
@@ -141,4 +484,35 @@ EXTERN_C HRESULT WINAPI NSudoCreateProcess(
     _In_ LPCWSTR CommandLine,
     _In_opt_ LPCWSTR CurrentDirectory);
 
+/**
+ * Creates a new process and its primary thread with the extended options.
+ *
+ * @param UserModeType See NSudoCreateProcess.
+ * @param PrivilegesModeType See NSudoCreateProcess.
+ * @param MandatoryLabelType See NSudoCreateProcess.
+ * @param ProcessPriorityClassType See NSudoCreateProcess.
+ * @param ShowWindowModeType See NSudoCreateProcess.
+ * @param WaitInterval See NSudoCreateProcess. If the output is captured, the
+ *                     relay is also waited within this interval, and the
+ *                     output which is not relayed in time is discarded. Use
+ *                     INFINITE to capture the full output.
+ * @param CreateNewConsole See NSudoCreateProcess.
+ * @param CommandLine See NSudoCreateProcess.
+ * @param CurrentDirectory See NSudoCreateProcess.
+ * @param Options The extended options. If this parameter is nullptr, the
+ *                function is the same as NSudoCreateProcess.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+ */
+EXTERN_C HRESULT WINAPI NSudoCreateProcessEx(
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType,
+    _In_ NSUDO_MANDATORY_LABEL_TYPE MandatoryLabelType,
+    _In_ NSUDO_PROCESS_PRIORITY_CLASS_TYPE ProcessPriorityClassType,
+    _In_ NSUDO_SHOW_WINDOW_MODE_TYPE ShowWindowModeType,
+    _In_ DWORD WaitInterval,
+    _In_ BOOL CreateNewConsole,
+    _In_ LPCWSTR CommandLine,
+    _In_opt_ LPCWSTR CurrentDirectory,
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options);
+
 #endif
@@ -0,0 +1,177 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoBufferedLineReader.h
+ * PURPOSE:   Definition for NSudo buffered line reader (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_BUFFERED_LINE_READER
+#define NSUDO_BUFFERED_LINE_READER
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L)
+#elif (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#else
+#error "[NSudoBufferedLineReader] You should use a C++ compiler with the C++14 standard."
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Reads the input from the source in large chunks and splits it into
+ *        lines in the buffer. The input after the returned line is kept for
+ *        the next call, so each chunk is only read and scanned once. The
+ *        lines are terminated by LF, and the CR before it is removed. The
+ *        last line may have no LF, and a CR at its end is removed as well,
+ *        so an input which is cut after the CR of a CRLF reads the same as
+ *        the complete one. The reader is not thread safe.
+ * @tparam CharType The character type of the input. The lines are split on
+ *                  the LF character, so the input encoding needs to keep it
+ *                  as a single code unit, e.g. UTF-16, UTF-8 and the ANSI
+ *                  code pages.
+*/
+template<typename CharType>
+class CNSudoBufferedLineReader
+{
+public:
+
+    /**
+     * @brief The source type.
+     * @param Context The context of the source.
+     * @param Buffer The buffer which receives the input.
+     * @param Size The size of the buffer, in characters.
+     * @return The number of characters read. Zero means the end of the
+     *         input, or that the source has failed.
+    */
+    typedef std::size_t(*SourceType)(
+        void* Context,
+        CharType* Buffer,
+        std::size_t Size);
+
+private:
+
+    SourceType m_Source;
+    void* m_SourceContext;
+    std::size_t m_ChunkSize;
+
+    std::vector<CharType> m_Buffer;
+
+    // The unread input is in [m_Start, m_End), and the characters in
+    // [m_Start, m_Scanned) are known to have no LF.
+    std::size_t m_Start = 0;
+    std::size_t m_Scanned = 0;
+    std::size_t m_End = 0;
+    bool m_EndOfInput = false;
+
+public:
+
+    /**
+     * @brief Creates the reader. The buffer is allocated by the first read.
+     * @param Source The source of the input.
+     * @param SourceContext The context of the source.
+     * @param ChunkSize The number of characters requested from the source at
+     *                  least by each read.
+    */
+    CNSudoBufferedLineReader(
+        SourceType Source,
+        void* SourceContext,
+        std::size_t ChunkSize = 4096) :
+        m_Source(Source),
+        m_SourceContext(SourceContext),
+        m_ChunkSize(ChunkSize ? ChunkSize : 1)
+    {
+    }
+
+    CNSudoBufferedLineReader(const CNSudoBufferedLineReader&) = delete;
+    CNSudoBufferedLineReader& operator=(
+        const CNSudoBufferedLineReader&) = delete;
+
+    /**
+     * @brief Reads the next line.
+     * @param Line Receives the first character of the line, which is valid
+     *             until the next call. The line is not null-terminated.
+     * @param Length Receives the length of the line, in characters, without
+     *               the line terminator.
+     * @return True if a line has been read. False if the input has ended, or
+     *         the source has failed, and all the lines have been read. The
+     *         last line is returned even if it has no line terminator, and
+     *         without the CR at its end.
+    */
+    bool ReadLine(
+        const CharType*& Line,
+        std::size_t& Length)
+    {
+        for (;;)
+        {
+            CharType* Begin = this->m_Buffer.data();
+            CharType* Found = std::find(
+                Begin + this->m_Scanned,
+                Begin + this->m_End,
+                static_cast<CharType>('\n'));
+
+            std::size_t LineEnd = Found - Begin;
+            if (LineEnd < this->m_End || (
+                this->m_EndOfInput && this->m_Start < this->m_End))
+            {
+                Line = Begin + this->m_Start;
+                Length = LineEnd - this->m_Start;
+                if (Length && Line[Length - 1] == static_cast<CharType>('\r'))
+                {
+                    --Length;
+                }
+
+                this->m_Start = LineEnd < this->m_End ? LineEnd + 1 : LineEnd;
+                this->m_Scanned = this->m_Start;
+                return true;
+            }
+
+            this->m_Scanned = this->m_End;
+
+            if (this->m_EndOfInput)
+            {
+                return false;
+            }
+
+            // Moves the partial line to the front of the buffer, and grows
+            // the buffer if the partial line leaves no room for a chunk.
+            if (this->m_Start)
+            {
+                std::copy(
+                    Begin + this->m_Start,
+                    Begin + this->m_End,
+                    Begin);
+                this->m_End -= this->m_Start;
+                this->m_Scanned -= this->m_Start;
+                this->m_Start = 0;
+            }
+            if (this->m_Buffer.size() - this->m_End < this->m_ChunkSize)
+            {
+                std::size_t NewSize = this->m_Buffer.size() * 2;
+                if (NewSize < this->m_End + this->m_ChunkSize)
+                {
+                    NewSize = this->m_End + this->m_ChunkSize;
+                }
+                this->m_Buffer.resize(NewSize);
+            }
+
+            std::size_t Read = this->m_Source(
+                this->m_SourceContext,
+                this->m_Buffer.data() + this->m_End,
+                this->m_Buffer.size() - this->m_End);
+            if (Read)
+            {
+                this->m_End += Read;
+            }
+            else
+            {
+                this->m_EndOfInput = true;
+            }
+        }
+    }
+};
+
+#endif // !NSUDO_BUFFERED_LINE_READER
@@ -0,0 +1,216 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoBufferedWriter.h
+ * PURPOSE:   Definition for NSudo buffered writer (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_BUFFERED_WRITER
+#define NSUDO_BUFFERED_WRITER
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L)
+#elif (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#else
+#error "[NSudoBufferedWriter] You should use a C++ compiler with the C++14 standard."
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Collects the output in a buffer and passes it to the sink in large
+ *        chunks. The buffer is flushed when it reaches the capacity, when
+ *        the oldest pending output is older than the flush interval, when
+ *        Flush is called and when the writer is destroyed. The flush interval
+ *        is kept by a background thread, which is started on the first write.
+ *        The writer can be used from multiple threads at the same time.
+*/
+class CNSudoBufferedWriter
+{
+public:
+
+    /**
+     * @brief The sink type. It is called with the lock of the writer held,
+     *        so the chunks are passed in order.
+     * @param Context The context of the sink.
+     * @param Data The data to write.
+     * @param Size The size of the data, in bytes.
+    */
+    typedef void(*SinkType)(
+        void* Context,
+        const void* Data,
+        std::size_t Size);
+
+private:
+
+    std::mutex m_Mutex;
+    std::condition_variable m_StateChanged;
+    std::thread m_FlushThread;
+    bool m_Stopping = false;
+
+    SinkType m_Sink;
+    void* m_SinkContext;
+    std::size_t m_Capacity;
+    std::chrono::milliseconds m_FlushInterval;
+
+    std::string m_Buffer;
+    std::chrono::steady_clock::time_point m_PendingTime;
+
+    void FlushLocked()
+    {
+        if (!this->m_Buffer.empty())
+        {
+            this->m_Sink(
+                this->m_SinkContext,
+                this->m_Buffer.data(),
+                this->m_Buffer.size());
+
+            // The capacity of the buffer is kept for the next writes.
+            this->m_Buffer.clear();
+        }
+    }
+
+    void FlushLoop()
+    {
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+
+        for (;;)
+        {
+            this->m_StateChanged.wait(Lock, [this]()
+            {
+                return this->m_Stopping || !this->m_Buffer.empty();
+            });
+            if (this->m_Stopping)
+            {
+                break;
+            }
+
+            std::chrono::steady_clock::time_point Deadline =
+                this->m_PendingTime + this->m_FlushInterval;
+            if (this->m_StateChanged.wait_until(Lock, Deadline, [this]()
+            {
+                return this->m_Stopping;
+            }))
+            {
+                break;
+            }
+
+            // The buffer may have been flushed and written again while
+            // waiting, then the new deadline is waited for.
+            if (!this->m_Buffer.empty() &&
+                std::chrono::steady_clock::now() >=
+                this->m_PendingTime + this->m_FlushInterval)
+            {
+                this->FlushLocked();
+            }
+        }
+    }
+
+public:
+
+    /**
+     * @brief Creates the writer.
+     * @param Sink The sink which receives the buffered output.
+     * @param SinkContext The context of the sink.
+     * @param Capacity The size of the buffer which makes it flushed, in
+     *                 bytes.
+     * @param FlushInterval The maximum time the output is kept in the buffer.
+    */
+    CNSudoBufferedWriter(
+        SinkType Sink,
+        void* SinkContext,
+        std::size_t Capacity = 64 * 1024,
+        std::chrono::milliseconds FlushInterval =
+            std::chrono::milliseconds(50)) :
+        m_Sink(Sink),
+        m_SinkContext(SinkContext),
+        m_Capacity(Capacity),
+        m_FlushInterval(FlushInterval)
+    {
+    }
+
+    CNSudoBufferedWriter(const CNSudoBufferedWriter&) = delete;
+    CNSudoBufferedWriter& operator=(const CNSudoBufferedWriter&) = delete;
+
+    /**
+     * @brief Stops the background thread and flushes the buffer.
+    */
+    ~CNSudoBufferedWriter()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            this->m_Stopping = true;
+        }
+        this->m_StateChanged.notify_all();
+
+        if (this->m_FlushThread.joinable())
+        {
+            this->m_FlushThread.join();
+        }
+
+        this->Flush();
+    }
+
+    /**
+     * @brief Appends the output to the buffer.
+     * @tparam AppendType The appender type, the signature should be
+     *                    void(std::string& Buffer), which appends the output
+     *                    to the buffer directly, e.g. by converting a string
+     *                    into the spare space of the buffer.
+     * @param Append The appender. It is called with the lock of the writer
+     *               held.
+    */
+    template<typename AppendType>
+    void Write(
+        AppendType&& Append)
+    {
+        bool Pending = false;
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+
+            bool WasEmpty = this->m_Buffer.empty();
+
+            Append(this->m_Buffer);
+
+            if (this->m_Buffer.size() >= this->m_Capacity)
+            {
+                this->FlushLocked();
+            }
+            else if (WasEmpty && !this->m_Buffer.empty())
+            {
+                this->m_PendingTime = std::chrono::steady_clock::now();
+                Pending = true;
+
+                if (!this->m_FlushThread.joinable() && !this->m_Stopping)
+                {
+                    this->m_FlushThread = std::thread(
+                        &CNSudoBufferedWriter::FlushLoop,
+                        this);
+                }
+            }
+        }
+
+        if (Pending)
+        {
+            this->m_StateChanged.notify_all();
+        }
+    }
+
+    /**
+     * @brief Passes the buffered output to the sink.
+    */
+    void Flush()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->FlushLocked();
+    }
+};
+
+#endif // !NSUDO_BUFFERED_WRITER
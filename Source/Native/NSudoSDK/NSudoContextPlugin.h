@@ -94,17 +94,21 @@ struct _NSUDO_CONTEXT
      * @param InputPrompt The prompt you want to notice to the user.
      * @return The next line of characters from the user input. If the return
      *         value is not nullptr, you should use PNSUDO_CONTEXT::Free method
-     *         to release.
+     *         to release. It is nullptr at the end of the input, or if the
+     *         user input cannot be read, e.g. in a task of a job.
     */
     LPCWSTR(WINAPI* ReadLine)(
         _In_ PNSUDO_CONTEXT Context,
         _In_ LPCWSTR InputPrompt);
 
     /**
-     * @brief Gets the translated string.
+     * @brief Gets the translated string. It can be called from any thread of
+     *        the plugin at the same time without locks, until the entry point
+     *        returns.
      * @param Context The NSudo context.
      * @param Name The UTF-8 name of the translated string.
-     * @return The translated string.
+     * @return The translated string. It is valid until the entry point
+     *         returns.
     */
     LPCWSTR(WINAPI* GetTranslation)(
         _In_ PNSUDO_CONTEXT Context,
@@ -12,8 +12,32 @@
 
 #include <Mile.PiConsole.h>
 
+#include <map>
+#include <string>
+
+#include "NSudoTranslationToml.h"
 #include "toml.hpp"
 
+/**
+ * @brief A translation table parsed from a module without the compiled
+ *        translations, and the checksum of the translation resource which it
+ *        is parsed from.
+*/
+typedef struct _NSUDO_CONTEXT_TRANSLATION_CACHE_ENTRY
+{
+    std::uint64_t Checksum;
+    std::shared_ptr<const CNSudoTranslationTable> Translations;
+} NSUDO_CONTEXT_TRANSLATION_CACHE_ENTRY, *PNSUDO_CONTEXT_TRANSLATION_CACHE_ENTRY;
+
+/**
+ * @brief The parsed translation tables, keyed by the module path. The entries
+ *        are kept for the lifetime of the host, and an entry is replaced when
+ *        the checksum of the module's translation resource changes.
+*/
+static Mile::SRWLock g_TranslationCacheLock;
+static std::map<std::wstring, NSUDO_CONTEXT_TRANSLATION_CACHE_ENTRY>
+    g_TranslationCache;
+
 /**
  * @brief Gets the NSudo private context.
  * @param Context The NSudo context.
@@ -106,6 +130,173 @@ VOID WINAPI NSudoContextFree(
     Mile::HeapMemory::Free(Block);
 }
 
+void NSudoContextWriteConsoleOutput(
+    _In_ void* Context,
+    _In_ const void* Data,
+    _In_ std::size_t Size)
+{
+    PNSUDO_CONTEXT_PRIVATE PrivateContext =
+        reinterpret_cast<PNSUDO_CONTEXT_PRIVATE>(Context);
+
+    const BYTE* Current = reinterpret_cast<const BYTE*>(Data);
+    while (Size)
+    {
+        DWORD NumberOfBytesWritten = 0;
+        if (!::WriteFile(
+            PrivateContext->ConsoleOutputHandle,
+            Current,
+            static_cast<DWORD>(Size < MAXDWORD ? Size : MAXDWORD),
+            &NumberOfBytesWritten,
+            nullptr) || !NumberOfBytesWritten)
+        {
+            break;
+        }
+
+        Current += NumberOfBytesWritten;
+        Size -= NumberOfBytesWritten;
+    }
+
+    // The code page is queried again by the next write.
+    PrivateContext->ConsoleOutputCodePage = 0;
+}
+
+std::size_t NSudoContextReadConsoleInput(
+    _In_ void* Context,
+    _Out_ wchar_t* Buffer,
+    _In_ std::size_t Size)
+{
+    PNSUDO_CONTEXT_PRIVATE PrivateContext =
+        reinterpret_cast<PNSUDO_CONTEXT_PRIVATE>(Context);
+
+    const DWORD LineInputMode =
+        ENABLE_LINE_INPUT | ENABLE_PROCESSED_INPUT | ENABLE_ECHO_INPUT;
+
+    DWORD PreviousConsoleMode = 0;
+    if (!::GetConsoleMode(
+        PrivateContext->ConsoleInputHandle,
+        &PreviousConsoleMode))
+    {
+        return 0;
+    }
+
+    // The console mode is only changed if the line input is not enabled
+    // already, e.g. by a plugin which reads the raw console input.
+    bool ConsoleModeChanged =
+        (PreviousConsoleMode & LineInputMode) != LineInputMode;
+    if (ConsoleModeChanged)
+    {
+        if (!::SetConsoleMode(
+            PrivateContext->ConsoleInputHandle,
+            PreviousConsoleMode | LineInputMode))
+        {
+            return 0;
+        }
+    }
+
+    // The console input buffer of ReadConsoleW is limited on the earlier
+    // versions of Windows.
+    DWORD NumberOfCharsRead = 0;
+    if (!::ReadConsoleW(
+        PrivateContext->ConsoleInputHandle,
+        Buffer,
+        static_cast<DWORD>(Size < 8192 ? Size : 8192),
+        &NumberOfCharsRead,
+        nullptr))
+    {
+        NumberOfCharsRead = 0;
+    }
+
+    if (ConsoleModeChanged)
+    {
+        ::SetConsoleMode(
+            PrivateContext->ConsoleInputHandle,
+            PreviousConsoleMode);
+    }
+
+    return NumberOfCharsRead;
+}
+
+std::size_t NSudoContextReadRedirectedInput(
+    _In_ void* Context,
+    _Out_ char* Buffer,
+    _In_ std::size_t Size)
+{
+    PNSUDO_CONTEXT_PRIVATE PrivateContext =
+        reinterpret_cast<PNSUDO_CONTEXT_PRIVATE>(Context);
+
+    // ReadFile fails with ERROR_BROKEN_PIPE at the end of a pipe.
+    DWORD NumberOfBytesRead = 0;
+    if (!::ReadFile(
+        PrivateContext->ConsoleInputHandle,
+        Buffer,
+        static_cast<DWORD>(Size < MAXDWORD ? Size : MAXDWORD),
+        &NumberOfBytesRead,
+        nullptr))
+    {
+        NumberOfBytesRead = 0;
+    }
+
+    return NumberOfBytesRead;
+}
+
+/**
+ * @brief Converts the string value to the console output code page into the
+ *        buffer of the output writer of the NSudo private context.
+ * @param PrivateContext The NSudo private context.
+ * @param Value The value to write.
+ * @param NewLine Appends the line terminator after the value if true.
+*/
+static void NSudoContextWriteBufferedConsoleOutput(
+    _In_ PNSUDO_CONTEXT_PRIVATE PrivateContext,
+    _In_opt_ LPCWSTR Value,
+    _In_ bool NewLine)
+{
+    int ValueLength = Value ? static_cast<int>(std::wcslen(Value)) : 0;
+
+    PrivateContext->OutputWriter.Write([&](std::string& Buffer)
+    {
+        if (!PrivateContext->ConsoleOutputCodePage)
+        {
+            PrivateContext->ConsoleOutputCodePage = ::GetConsoleOutputCP();
+        }
+
+        if (ValueLength)
+        {
+            int ConvertedLength = ::WideCharToMultiByte(
+                PrivateContext->ConsoleOutputCodePage,
+                0,
+                Value,
+                ValueLength,
+                nullptr,
+                0,
+                nullptr,
+                nullptr);
+            if (ConvertedLength > 0)
+            {
+                std::size_t Offset = Buffer.size();
+                Buffer.resize(Offset + ConvertedLength);
+                ConvertedLength = ::WideCharToMultiByte(
+                    PrivateContext->ConsoleOutputCodePage,
+                    0,
+                    Value,
+                    ValueLength,
+                    &Buffer[Offset],
+                    ConvertedLength,
+                    nullptr,
+                    nullptr);
+                Buffer.resize(Offset + (ConvertedLength > 0
+                    ? ConvertedLength
+                    : 0));
+            }
+        }
+
+        if (NewLine)
+        {
+            Buffer.append("\r\n", 2);
+        }
+    });
+}
+
 /**
  * @brief Writes the specified string value to the NSudo user interface.
  * @param Context The NSudo context.
@@ -119,17 +310,18 @@ VOID WINAPI NSudoContextWrite(
 
     if (PrivateContext)
     {
-        if (PrivateContext->ConsoleMode)
+        if (PrivateContext->CapturedOutput)
         {
-            std::string CurrentCodePageString = Mile::ToConsoleString(Value);
-
-            DWORD NumberOfCharsWritten = 0;
-            ::WriteFile(
-                PrivateContext->ConsoleOutputHandle,
-                CurrentCodePageString.c_str(),
-                static_cast<DWORD>(CurrentCodePageString.size()),
-                &NumberOfCharsWritten,
-                nullptr);
+            Mile::AutoSRWExclusiveLock Lock(
+                PrivateContext->CapturedOutputLock);
+            PrivateContext->CapturedOutput->append(Value ? Value : L"");
+        }
+        else if (PrivateContext->ConsoleMode)
+        {
+            ::NSudoContextWriteBufferedConsoleOutput(
+                PrivateContext,
+                Value,
+                false);
         }
         else
         {
@@ -150,7 +342,20 @@ VOID WINAPI NSudoContextWriteLine(
     _In_ PNSUDO_CONTEXT Context,
     _In_ LPCWSTR Value)
 {
-    if (Context)
+    PNSUDO_CONTEXT_PRIVATE PrivateContext = ::NSudoContextGetPrivate(Context);
+
+    if (PrivateContext &&
+        !PrivateContext->CapturedOutput &&
+        PrivateContext->ConsoleMode)
+    {
+        // The line terminator is converted into the buffer after the value,
+        // so the line is not formatted into a temporary string first.
+        ::NSudoContextWriteBufferedConsoleOutput(
+            PrivateContext,
+            Value,
+            true);
+    }
+    else if (Context)
     {
         Context->Write(
             Context,
@@ -164,7 +369,8 @@ VOID WINAPI NSudoContextWriteLine(
  * @param InputPrompt The prompt you want to notice to the user.
  * @return The next line of characters from the user input. If the return
  *         value is not nullptr, you should use PNSUDO_CONTEXT::Free method
- *         to release.
+ *         to release. It is nullptr at the end of the input, or if the output
+ *         of the plugin is captured.
 */
 LPCWSTR WINAPI NSudoContextReadLine(
     _In_ PNSUDO_CONTEXT Context,
@@ -174,79 +380,113 @@ LPCWSTR WINAPI NSudoContextReadLine(
 
     if (PrivateContext)
     {
-        if (PrivateContext->ConsoleMode)
+        if (PrivateContext->CapturedOutput)
         {
-            wchar_t* InputBuffer = nullptr;
-            DWORD PreviousConsoleMode = 0;
+            // The prompt would be captured instead of being shown, and the
+            // plugins executed at the same time would take the input lines of
+            // each other.
+            return nullptr;
+        }
+        else if (PrivateContext->ConsoleMode)
+        {
+            // The prompt written by the plugin needs to be shown before the
+            // user input is read.
+            PrivateContext->OutputWriter.Flush();
 
-            do
+            if (!PrivateContext->ConsoleInputChecked)
             {
-                if (!::GetConsoleMode(
-                    PrivateContext->ConsoleInputHandle,
-                    &PreviousConsoleMode))
-                {
-                    break;
-                }
-
-                if (!::SetConsoleMode(
+                DWORD ConsoleInputMode = 0;
+                PrivateContext->ConsoleInputRedirected = !::GetConsoleMode(
                     PrivateContext->ConsoleInputHandle,
-                    ENABLE_LINE_INPUT |
-                    ENABLE_PROCESSED_INPUT |
-                    ENABLE_ECHO_INPUT))
-                {
-                    break;
-                }
+                    &ConsoleInputMode);
+                PrivateContext->ConsoleInputChecked = true;
+            }
 
-                std::wstring Result;
+            wchar_t* InputBuffer = nullptr;
 
-                for (;;)
+            if (!PrivateContext->ConsoleInputRedirected)
+            {
+                const wchar_t* Line = nullptr;
+                std::size_t Length = 0;
+
+                // Ctrl+Z at the start of the line ends the console input, the
+                // same as the C runtime.
+                if (PrivateContext->ConsoleInputReader.ReadLine(
+                    Line,
+                    Length) && !(Length && Line[0] == L'\x1A'))
                 {
-                    wchar_t CurrentChar = L'\0';
-                    DWORD NumberOfCharsRead = 0;
-
-                    if (!::ReadConsoleW(
-                        PrivateContext->ConsoleInputHandle,
-                        reinterpret_cast<LPVOID>(&CurrentChar),
-                        1,
-                        &NumberOfCharsRead,
-                        nullptr))
+                    InputBuffer = reinterpret_cast<wchar_t*>(
+                        Mile::HeapMemory::Allocate(
+                            (Length + 1) * sizeof(wchar_t)));
+                    if (InputBuffer)
                     {
-                        break;
+                        std::memcpy(
+                            InputBuffer,
+                            Line,
+                            Length * sizeof(wchar_t));
+                        InputBuffer[Length] = L'\0';
                     }
+                }
+            }
+            else
+            {
+                const char* Line = nullptr;
+                std::size_t Length = 0;
 
-                    if (CurrentChar == '\r')
+                if (PrivateContext->RedirectedInputReader.ReadLine(
+                    Line,
+                    Length))
+                {
+                    if (!PrivateContext->RedirectedInputCodePage)
                     {
-                        continue;
+                        if (Length >= 3 &&
+                            0 == std::memcmp(Line, "\xEF\xBB\xBF", 3))
+                        {
+                            PrivateContext->RedirectedInputCodePage = CP_UTF8;
+                            Line += 3;
+                            Length -= 3;
+                        }
+                        else
+                        {
+                            UINT ConsoleInputCodePage = ::GetConsoleCP();
+                            PrivateContext->RedirectedInputCodePage =
+                                ConsoleInputCodePage
+                                ? ConsoleInputCodePage
+                                : ::GetACP();
+                        }
                     }
-                    else if (CurrentChar == '\n')
+
+                    int ValueLength = Length ? ::MultiByteToWideChar(
+                        PrivateContext->RedirectedInputCodePage,
+                        0,
+                        Line,
+                        static_cast<int>(Length),
+                        nullptr,
+                        0) : 0;
+                    if (ValueLength < 0)
                     {
-                        break;
+                        ValueLength = 0;
                     }
-                    else
+
+                    InputBuffer = reinterpret_cast<wchar_t*>(
+                        Mile::HeapMemory::Allocate(
+                            (ValueLength + 1) * sizeof(wchar_t)));
+                    if (InputBuffer)
                     {
-                        Result.push_back(CurrentChar);
+                        if (ValueLength)
+                        {
+                            ValueLength = ::MultiByteToWideChar(
+                                PrivateContext->RedirectedInputCodePage,
+                                0,
+                                Line,
+                                static_cast<int>(Length),
+                                InputBuffer,
+                                ValueLength);
+                        }
+                        InputBuffer[ValueLength > 0 ? ValueLength : 0] = L'\0';
                     }
                 }
-
-                std::size_t InputResultLength =
-                    (Result.size() + 1) * sizeof(wchar_t);
-                InputBuffer = reinterpret_cast<wchar_t*>(
-                    Mile::HeapMemory::Allocate(InputResultLength));
-                if (InputBuffer)
-                {
-                    std::memcpy(
-                        InputBuffer,
-                        Result.c_str(),
-                        InputResultLength);
-                }
-
-                Result = Result;
-
-            } while (false);
-
-            ::SetConsoleMode(
-                PrivateContext->ConsoleInputHandle,
-                PreviousConsoleMode);
+            }
 
             return InputBuffer;
         }
@@ -274,7 +514,14 @@ LPCWSTR WINAPI NSudoContextGetTranslation(
     PNSUDO_CONTEXT_PRIVATE PrivateContext = ::NSudoContextGetPrivate(Context);
     if (PrivateContext)
     {
-        return PrivateContext->Translations[Name].c_str();
+        const CNSudoTranslationTable* Translations =
+            PrivateContext->PublishedTranslations.load(
+                std::memory_order_acquire);
+        if (Translations)
+        {
+            // The values of the table are followed by null characters.
+            return Translations->Find(Name ? Name : "").data();
+        }
     }
 
     return L"";
@@ -305,82 +552,260 @@ EXTERN_C VOID WINAPI NSudoContextFillFunctionTable(
     }
 }
 
-EXTERN_C HRESULT WINAPI NSudoContextExecutePlugin(
-    _In_ PNSUDO_CONTEXT Context,
-    _In_ LPCWSTR PluginModuleName,
-    _In_ LPCSTR PluginEntryPointName,
-    _In_ LPCWSTR CommandArguments)
+/**
+ * @brief Computes the checksum of the translation resource, which is the
+ *        64-bit FNV-1a hash of its content.
+ * @param ResourceInfo The translation resource.
+ * @return The checksum of the translation resource.
+*/
+static std::uint64_t NSudoContextGetTranslationsChecksum(
+    _In_ Mile::RESOURCE_INFO const& ResourceInfo)
 {
-    if (!Context || !PluginModuleName || !PluginEntryPointName)
+    const std::uint8_t* Content =
+        reinterpret_cast<const std::uint8_t*>(ResourceInfo.Pointer);
+
+    std::uint64_t Checksum = 14695981039346656037ULL;
+    for (DWORD i = 0; i < ResourceInfo.Size; ++i)
     {
-        return E_INVALIDARG;
+        Checksum ^= Content[i];
+        Checksum *= 1099511628211ULL;
     }
+    return Checksum;
+}
 
-    PNSUDO_CONTEXT_PRIVATE PrivateContext = nullptr;
-    HMODULE ModuleHandle = nullptr;
-    NSUDO_CONTEXT_PLUGIN_ENTRY_POINT_TYPE EntryPointFunction = nullptr;
-    HRESULT EntryPointResult = S_OK;
+HRESULT NSudoContextLoadTranslations(
+    _Out_ std::shared_ptr<const CNSudoTranslationTable>& Translations,
+    _In_ HMODULE ModuleHandle)
+{
+    Translations = std::make_shared<const CNSudoTranslationTable>();
 
-    auto ExitHandler = Mile::ScopeExitTaskHandler([&]()
+    Mile::RESOURCE_INFO ResourceInfo = { 0 };
+    HRESULT hr = Mile::LoadResource(
+        &ResourceInfo,
+        ModuleHandle,
+        L"Translations",
+        MAKEINTRESOURCEW(1));
+    if (FAILED(hr))
     {
-        if (ModuleHandle)
+        return hr;
+    }
+
+    // The compiled translations are used in place and are not cached, because
+    // they refer to the resource, which is released with the module.
+    std::shared_ptr<CNSudoTranslationTable> Table =
+        std::make_shared<CNSudoTranslationTable>();
+    if (Table->Attach(ResourceInfo.Pointer, ResourceInfo.Size))
+    {
+        Translations = Table;
+        return S_OK;
+    }
+
+    // 32767 is the maximum path length without the terminating null character.
+    std::wstring ModulePath(32767, L'\0');
+    ModulePath.resize(::GetModuleFileNameW(
+        ModuleHandle,
+        &ModulePath[0],
+        static_cast<DWORD>(ModulePath.size())));
+    std::uint64_t Checksum = ::NSudoContextGetTranslationsChecksum(
+        ResourceInfo);
+
+    if (!ModulePath.empty())
+    {
+        Mile::AutoSRWSharedLock Lock(g_TranslationCacheLock);
+
+        auto Iterator = g_TranslationCache.find(ModulePath);
+        if (Iterator != g_TranslationCache.end() &&
+            Iterator->second.Checksum == Checksum)
         {
-            ::FreeLibrary(ModuleHandle);
+            Translations = Iterator->second.Translations;
+            return S_OK;
         }
-    });
+    }
 
-    PrivateContext = ::NSudoContextGetPrivate(Context);
-    if (!PrivateContext)
+    // The values are kept in UTF-8 and converted when they are looked up,
+    // because the most of them are never shown in a run.
+    std::string_view Content(
+        reinterpret_cast<const char*>(ResourceInfo.Pointer),
+        ResourceInfo.Size);
+    CNSudoTranslationTableBuilder Builder;
+    CNSudoTranslationTomlReader Reader;
+    if (!Reader.Read(Content, Builder))
     {
-        return E_NOINTERFACE;
+        // Fall back to toml++ for the files outside the flat subset.
+        Builder = CNSudoTranslationTableBuilder();
+        try
+        {
+            toml::table TranslationsTable = toml::parse(Content);
+
+            Builder.Reserve(TranslationsTable.size());
+            for (auto const& Translation : TranslationsTable)
+            {
+                Builder.AddUtf8(
+                    Translation.first,
+                    Translation.second.value_or(std::string_view()));
+            }
+        }
+        catch (...)
+        {
+            return E_FAIL;
+        }
     }
+    Builder.Build(*Table);
+
+    Translations = Table;
 
-    ModuleHandle = Mile::LoadLibraryFromSystem32(PluginModuleName);
-    if (!ModuleHandle)
+    if (!ModulePath.empty())
     {
-        return E_NOINTERFACE;
+        Mile::AutoSRWExclusiveLock Lock(g_TranslationCacheLock);
+
+        NSUDO_CONTEXT_TRANSLATION_CACHE_ENTRY& Entry =
+            g_TranslationCache[ModulePath];
+        Entry.Checksum = Checksum;
+        Entry.Translations = Table;
+    }
+
+    return S_OK;
+}
+
+HRESULT NSudoContextExecutePluginInSession(
+    _In_ PNSUDO_CONTEXT_PLUGIN_SESSION Session,
+    _In_ PNSUDO_CONTEXT Context,
+    _In_ LPCWSTR PluginModuleName,
+    _In_ LPCSTR PluginEntryPointName,
+    _In_ LPCWSTR CommandArguments)
+{
+    if (!Session || !Context || !PluginModuleName || !PluginEntryPointName)
+    {
+        return E_INVALIDARG;
     }
 
-    EntryPointFunction = reinterpret_cast<NSUDO_CONTEXT_PLUGIN_ENTRY_POINT_TYPE>(
-        ::GetProcAddress(ModuleHandle, PluginEntryPointName));
-    if (!EntryPointFunction)
+    PNSUDO_CONTEXT_PRIVATE PrivateContext = ::NSudoContextGetPrivate(Context);
+    if (!PrivateContext)
     {
         return E_NOINTERFACE;
     }
 
-    PrivateContext->ModuleHandle = ModuleHandle;
-    PrivateContext->CommandArguments = CommandArguments;
-    Mile::RESOURCE_INFO ResourceInfo = { 0 };
-    if (SUCCEEDED(Mile::LoadResource(
-        &ResourceInfo,
-        PrivateContext->ModuleHandle,
-        L"Translations",
-        MAKEINTRESOURCEW(1))))
+    std::wstring ModuleKey = std::wstring(PluginModuleName);
+    ::_wcslwr_s(&ModuleKey[0], ModuleKey.size() + 1);
+
+    HMODULE ModuleHandle = nullptr;
+    std::shared_ptr<const CNSudoTranslationTable> Translations;
+    NSUDO_CONTEXT_PLUGIN_ENTRY_POINT_TYPE EntryPointFunction = nullptr;
+
     {
-        try
+        Mile::AutoSRWExclusiveLock Lock(Session->Lock);
+
+        auto ModuleIterator = Session->Modules.find(ModuleKey);
+        if (ModuleIterator == Session->Modules.end())
         {
-            toml::table Translations = toml::parse(std::string(
-                reinterpret_cast<const char*>(ResourceInfo.Pointer),
-                ResourceInfo.Size));
-            for (auto const& Translation : Translations)
+            HMODULE LoadedModuleHandle =
+                Mile::LoadLibraryFromSystem32(PluginModuleName);
+            if (!LoadedModuleHandle)
             {
-                PrivateContext->Translations.emplace(std::make_pair(
-                    Translation.first,
-                    Mile::ToUtf16String(
-                        Translation.second.value_or<std::string>(""))));
+                return E_NOINTERFACE;
             }
+
+            NSUDO_CONTEXT_PLUGIN_MODULE Module;
+            Module.ModuleHandle = LoadedModuleHandle;
+            ::NSudoContextLoadTranslations(
+                Module.Translations,
+                Module.ModuleHandle);
+
+            ModuleIterator = Session->Modules.emplace(
+                ModuleKey,
+                std::move(Module)).first;
         }
-        catch (...)
+
+        NSUDO_CONTEXT_PLUGIN_MODULE& Module = ModuleIterator->second;
+
+        auto EntryPointIterator = Module.EntryPoints.find(
+            PluginEntryPointName);
+        if (EntryPointIterator != Module.EntryPoints.end())
+        {
+            EntryPointFunction = EntryPointIterator->second;
+        }
+        else
         {
+            EntryPointFunction =
+                reinterpret_cast<NSUDO_CONTEXT_PLUGIN_ENTRY_POINT_TYPE>(
+                    ::GetProcAddress(
+                        Module.ModuleHandle,
+                        PluginEntryPointName));
+            if (!EntryPointFunction)
+            {
+                return E_NOINTERFACE;
+            }
 
+            Module.EntryPoints.emplace(
+                PluginEntryPointName,
+                EntryPointFunction);
         }
-    }
 
-    EntryPointResult = EntryPointFunction(&PrivateContext->PublicContext);
+        ModuleHandle = Module.ModuleHandle;
+        Translations = Module.Translations;
+    }
 
+    PrivateContext->ModuleHandle = ModuleHandle;
+    PrivateContext->CommandArguments = CommandArguments;
+    PrivateContext->Translations = Translations;
+    PrivateContext->PublishedTranslations.store(
+        PrivateContext->Translations.get(),
+        std::memory_order_release);
+
+    HRESULT EntryPointResult = EntryPointFunction(
+        &PrivateContext->PublicContext);
+
+    // The output of the plugin is shown before the host writes its result.
+    PrivateContext->OutputWriter.Flush();
+
+    // The plugin has joined its worker threads before returning, so no lookup
+    // can still be reading the table after it is unpublished.
+    PrivateContext->PublishedTranslations.store(
+        nullptr,
+        std::memory_order_release);
     PrivateContext->ModuleHandle = nullptr;
     PrivateContext->CommandArguments = nullptr;
-    PrivateContext->Translations.clear();
+    PrivateContext->Translations.reset();
 
     return EntryPointResult;
 }
+
+VOID NSudoContextClosePluginSession(
+    _In_ PNSUDO_CONTEXT_PLUGIN_SESSION Session)
+{
+    if (Session)
+    {
+        Mile::AutoSRWExclusiveLock Lock(Session->Lock);
+
+        for (auto& Module : Session->Modules)
+        {
+            // The translations may refer to the resource of the module.
+            Module.second.EntryPoints.clear();
+            Module.second.Translations.reset();
+            ::FreeLibrary(Module.second.ModuleHandle);
+        }
+
+        Session->Modules.clear();
+    }
+}
+
+EXTERN_C HRESULT WINAPI NSudoContextExecutePlugin(
+    _In_ PNSUDO_CONTEXT Context,
+    _In_ LPCWSTR PluginModuleName,
+    _In_ LPCSTR PluginEntryPointName,
+    _In_ LPCWSTR CommandArguments)
+{
+    NSUDO_CONTEXT_PLUGIN_SESSION Session;
+
+    auto ExitHandler = Mile::ScopeExitTaskHandler([&]()
+    {
+        ::NSudoContextClosePluginSession(&Session);
+    });
+
+    return ::NSudoContextExecutePluginInSession(
+        &Session,
+        Context,
+        PluginModuleName,
+        PluginEntryPointName,
+        CommandArguments);
+}
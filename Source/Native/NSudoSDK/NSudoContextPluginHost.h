@@ -11,10 +11,55 @@
 #ifndef NSUDO_CONTEXT_PLUGIN_HOST
 #define NSUDO_CONTEXT_PLUGIN_HOST
 
+#include "NSudoBufferedLineReader.h"
+#include "NSudoBufferedWriter.h"
 #include "NSudoContextPlugin.h"
+#include "NSudoTranslationTable.h"
 
-#include <map>
+#include <Mile.Windows.h>
+
+#include <atomic>
+#include <memory>
 #include <string>
+#include <unordered_map>
+
+/**
+ * @brief Writes the buffered console output of the NSudo private context to
+ *        its console output handle.
+ * @param Context The NSudo private context.
+ * @param Data The output in the console output code page.
+ * @param Size The size of the output, in bytes.
+*/
+void NSudoContextWriteConsoleOutput(
+    _In_ void* Context,
+    _In_ const void* Data,
+    _In_ std::size_t Size);
+
+/**
+ * @brief Reads the console input of the NSudo private context by
+ *        ReadConsoleW.
+ * @param Context The NSudo private context.
+ * @param Buffer The buffer which receives the input.
+ * @param Size The size of the buffer, in characters.
+ * @return The number of characters read, or zero if the function fails.
+*/
+std::size_t NSudoContextReadConsoleInput(
+    _In_ void* Context,
+    _Out_ wchar_t* Buffer,
+    _In_ std::size_t Size);
+
+/**
+ * @brief Reads the redirected input of the NSudo private context by ReadFile.
+ * @param Context The NSudo private context.
+ * @param Buffer The buffer which receives the input.
+ * @param Size The size of the buffer, in bytes.
+ * @return The number of bytes read, or zero at the end of the input or if
+ *         the function fails.
+*/
+std::size_t NSudoContextReadRedirectedInput(
+    _In_ void* Context,
+    _Out_ char* Buffer,
+    _In_ std::size_t Size);
 
 /**
  * @brief Definition for NSudo private context.
@@ -33,10 +78,100 @@ typedef struct _NSUDO_CONTEXT_PRIVATE
     HMODULE ModuleHandle;
     LPCWSTR CommandArguments;
 
-    std::map<std::string, std::wstring> Translations;
+    // The translations of the executing plugin. The parsed translations are
+    // shared with the translation cache of the host.
+    std::shared_ptr<const CNSudoTranslationTable> Translations;
+
+    // The translations published to GetTranslation, which may be called from
+    // the worker threads of the plugin. The table is immutable once it is
+    // published and is only released after the entry point returns, so the
+    // lookups only need to load this pointer.
+    std::atomic<const CNSudoTranslationTable*> PublishedTranslations{ nullptr };
+
+    // If it is not nullptr, the output of the plugin is appended to it instead
+    // of being written to the user interface, e.g. for the plugins executed
+    // at the same time which need their output kept together. The plugin
+    // cannot read the user input then, and ReadLine returns nullptr. The
+    // appends are guarded by the lock, because the plugin may write from its
+    // worker threads.
+    std::wstring* CapturedOutput = nullptr;
+    Mile::SRWLock CapturedOutputLock;
+
+    // The console output code page which the buffered output is converted
+    // to. It is zero until the next write after a flush, so the code page
+    // changed by the plugin is used from the next chunk. It is guarded by the
+    // lock of the output writer.
+    UINT ConsoleOutputCodePage = 0;
+
+    // Whether the console input handle is a console or is redirected, which
+    // is checked by the first ReadLine in console mode.
+    bool ConsoleInputChecked = false;
+    bool ConsoleInputRedirected = false;
+
+    // The code page of the redirected input. It is zero until the first line
+    // is read, which selects UTF-8 if the line starts with the UTF-8 BOM, or
+    // the console input code page.
+    UINT RedirectedInputCodePage = 0;
+
+    // The input read by ReadLine in console mode, which is read in chunks
+    // and split into lines in the buffer of the reader. The input after the
+    // returned line is kept for the next call. The redirected input is split
+    // before it is converted, so a multi-byte character is never split
+    // between the chunks.
+    CNSudoBufferedLineReader<wchar_t> ConsoleInputReader{
+        &::NSudoContextReadConsoleInput,
+        this };
+    CNSudoBufferedLineReader<char> RedirectedInputReader{
+        &::NSudoContextReadRedirectedInput,
+        this };
+
+    // The console output written in console mode is converted into the buffer
+    // of the writer and written in large chunks, which is flushed when the
+    // buffer is full, when the output is kept for too long, before reading
+    // the user input, after the entry point returns and when the context is
+    // destroyed. It is declared last, so it is flushed before the other
+    // members are destroyed.
+    CNSudoBufferedWriter OutputWriter{
+        &::NSudoContextWriteConsoleOutput,
+        this };
 
 } NSUDO_CONTEXT_PRIVATE, *PNSUDO_CONTEXT_PRIVATE;
 
+/**
+ * @brief Definition for a module loaded in the NSudo context plugin session.
+*/
+typedef struct _NSUDO_CONTEXT_PLUGIN_MODULE
+{
+    HMODULE ModuleHandle;
+
+    // The translations of the module, which are loaded with the module and
+    // released before the module is unloaded.
+    std::shared_ptr<const CNSudoTranslationTable> Translations;
+
+    // The entry points resolved from the module, keyed by the entry point
+    // name.
+    std::unordered_map<std::string, NSUDO_CONTEXT_PLUGIN_ENTRY_POINT_TYPE>
+        EntryPoints;
+
+} NSUDO_CONTEXT_PLUGIN_MODULE, *PNSUDO_CONTEXT_PLUGIN_MODULE;
+
+/**
+ * @brief Definition for NSudo context plugin session. The modules loaded in
+ *        the session are kept loaded until the session is closed, so the
+ *        entry points of the same module can be executed more than once
+ *        without loading the module and resolving the entry points again.
+*/
+typedef struct _NSUDO_CONTEXT_PLUGIN_SESSION
+{
+    // The session can be used from multiple threads at the same time, each
+    // with its own context. The lock is not held while the entry points run.
+    Mile::SRWLock Lock;
+
+    // The modules loaded in the session, keyed by the module name in lower
+    // case.
+    std::unordered_map<std::wstring, NSUDO_CONTEXT_PLUGIN_MODULE> Modules;
+
+} NSUDO_CONTEXT_PLUGIN_SESSION, *PNSUDO_CONTEXT_PLUGIN_SESSION;
 
 /**
  * @brief Fills the function table of the NSudo context.
@@ -46,7 +181,55 @@ EXTERN_C VOID WINAPI NSudoContextFillFunctionTable(
     _In_ PNSUDO_CONTEXT Context);
 
 /**
- * @brief Executes the context plugin.
+ * @brief Loads the translations from the "Translations" resource of the
+ *        module. The translations compiled by NSudoTranslations.targets are
+ *        used in place, and the TOML translations of the modules which are
+ *        not built with it are parsed, by the flat reader first and by
+ *        toml++ if the file is outside its subset, with the values converted
+ *        to UTF-16 on the first lookup. The parsed translations are cached
+ *        for the lifetime of the host, keyed by the module path and the
+ *        checksum of the resource, so executing the same module again does
+ *        not parse them again.
+ * @param Translations The table which receives the translations. It is empty
+ *                     if the module has no translations. If it refers to the
+ *                     resource, it must be released before the module is
+ *                     unloaded.
+ * @param ModuleHandle The module which contains the translations.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+HRESULT NSudoContextLoadTranslations(
+    _Out_ std::shared_ptr<const CNSudoTranslationTable>& Translations,
+    _In_ HMODULE ModuleHandle);
+
+/**
+ * @brief Executes the context plugin in the session. The module is loaded
+ *        when it is used in the session for the first time, and the entry
+ *        point is resolved when it is executed for the first time.
+ * @param Session The NSudo context plugin session.
+ * @param Context The NSudo context.
+ * @param PluginModuleName The module name of the context plugin.
+ * @param PluginEntryPointName The entry point name of the context plugin.
+ * @param CommandArguments The command line arguments of the context plugin.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+HRESULT NSudoContextExecutePluginInSession(
+    _In_ PNSUDO_CONTEXT_PLUGIN_SESSION Session,
+    _In_ PNSUDO_CONTEXT Context,
+    _In_ LPCWSTR PluginModuleName,
+    _In_ LPCSTR PluginEntryPointName,
+    _In_ LPCWSTR CommandArguments);
+
+/**
+ * @brief Closes the NSudo context plugin session, which unloads the modules
+ *        loaded in the session.
+ * @param Session The NSudo context plugin session.
+*/
+VOID NSudoContextClosePluginSession(
+    _In_ PNSUDO_CONTEXT_PLUGIN_SESSION Session);
+
+/**
+ * @brief Executes the context plugin. The module is unloaded when the entry
+ *        point returns.
  * @param Context The NSudo context.
  * @param PluginModuleName The module name of the context plugin.
  * @param PluginEntryPointName The entry point name of the context plugin.
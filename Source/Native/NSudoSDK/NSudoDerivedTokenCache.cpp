@@ -0,0 +1,220 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoDerivedTokenCache.cpp
+ * PURPOSE:   Implementation for NSudo derived access token cache
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoDerivedTokenCache.h"
+
+HRESULT CNSudoDerivedTokenCache::CreateDerivedToken(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ DWORD SessionId,
+    _Out_ PHANDLE TokenHandle)
+{
+    *TokenHandle = INVALID_HANDLE_VALUE;
+
+    HRESULT hr = E_INVALIDARG;
+
+    if (NSUDO_USER_MODE_TYPE::CURRENT_PROCESS_DROP_RIGHT == UserModeType)
+    {
+        HANDLE hCurrentProcessToken = nullptr;
+        hr = Backend->OpenProcessToken(
+            ::GetCurrentProcess(), MAXIMUM_ALLOWED, &hCurrentProcessToken);
+        if (hr == S_OK)
+        {
+            hr = Backend->CreateLUAToken(hCurrentProcessToken, TokenHandle);
+
+            Backend->CloseHandle(hCurrentProcessToken);
+        }
+    }
+    else if (NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED == UserModeType)
+    {
+        HANDLE hCurrentProcessToken = nullptr;
+        hr = Backend->CreateSessionToken(SessionId, &hCurrentProcessToken);
+        if (hr == S_OK)
+        {
+            TOKEN_LINKED_TOKEN LinkedToken = { 0 };
+            DWORD ReturnLength = 0;
+
+            hr = Backend->GetTokenInformation(
+                hCurrentProcessToken,
+                TokenLinkedToken,
+                &LinkedToken,
+                sizeof(TOKEN_LINKED_TOKEN),
+                &ReturnLength);
+            if (hr == S_OK)
+            {
+                hr = Backend->DuplicateTokenEx(
+                    LinkedToken.LinkedToken,
+                    MAXIMUM_ALLOWED,
+                    SecurityIdentification,
+                    TokenPrimary,
+                    TokenHandle);
+
+                Backend->CloseHandle(LinkedToken.LinkedToken);
+            }
+
+            Backend->CloseHandle(hCurrentProcessToken);
+        }
+    }
+
+    if (hr != S_OK)
+    {
+        *TokenHandle = INVALID_HANDLE_VALUE;
+    }
+
+    return hr;
+}
+
+void CNSudoDerivedTokenCache::ReleaseEntries()
+{
+    for (auto& Entry : this->m_Entries)
+    {
+        this->m_Backend->CloseHandle(Entry.second);
+    }
+    this->m_Entries.clear();
+}
+
+CNSudoDerivedTokenCache::~CNSudoDerivedTokenCache()
+{
+    this->Invalidate();
+}
+
+bool CNSudoDerivedTokenCache::IsCacheable(
+    _In_ NSUDO_USER_MODE_TYPE UserModeType)
+{
+    return (
+        NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED == UserModeType ||
+        NSUDO_USER_MODE_TYPE::CURRENT_PROCESS_DROP_RIGHT == UserModeType);
+}
+
+HRESULT CNSudoDerivedTokenCache::Acquire(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ DWORD SessionId,
+    _Out_ PHANDLE TokenHandle,
+    _Out_ bool& CacheHit)
+{
+    *TokenHandle = INVALID_HANDLE_VALUE;
+    CacheHit = false;
+
+    if (!Backend || !CNSudoDerivedTokenCache::IsCacheable(UserModeType))
+    {
+        return E_INVALIDARG;
+    }
+
+    // The logon time changes when the user of the session logs off and on
+    // again, so the tokens of the previous logon are never reused.
+    LARGE_INTEGER LogonTime = { 0 };
+    HRESULT hr = Backend->GetSessionLogonTime(SessionId, &LogonTime);
+    bool Cacheable = (hr == S_OK);
+
+    if (Cacheable)
+    {
+        Mile::AutoSRWSharedLock Lock(this->m_Lock);
+
+        if (this->m_Backend == Backend &&
+            this->m_SessionId == SessionId &&
+            this->m_LogonTime == LogonTime.QuadPart)
+        {
+            auto Iterator = this->m_Entries.find(UserModeType);
+            if (Iterator != this->m_Entries.end())
+            {
+                if (S_OK == Backend->DuplicateHandle(
+                    Iterator->second,
+                    TokenHandle))
+                {
+                    CacheHit = true;
+                }
+            }
+        }
+    }
+
+    if (CacheHit)
+    {
+        ::InterlockedIncrement(&this->m_Hits);
+        return S_OK;
+    }
+
+    ::InterlockedIncrement(&this->m_Misses);
+
+    hr = CNSudoDerivedTokenCache::CreateDerivedToken(
+        Backend,
+        UserModeType,
+        SessionId,
+        TokenHandle);
+    if (hr != S_OK || !Cacheable)
+    {
+        return hr;
+    }
+
+    HANDLE CachedToken = INVALID_HANDLE_VALUE;
+    if (S_OK != Backend->DuplicateHandle(*TokenHandle, &CachedToken))
+    {
+        return S_OK;
+    }
+
+    {
+        Mile::AutoSRWExclusiveLock Lock(this->m_Lock);
+
+        if (this->m_Backend != Backend ||
+            this->m_SessionId != SessionId ||
+            this->m_LogonTime != LogonTime.QuadPart)
+        {
+            if (this->m_Backend)
+            {
+                this->ReleaseEntries();
+            }
+
+            this->m_Backend = Backend;
+            this->m_SessionId = SessionId;
+            this->m_LogonTime = LogonTime.QuadPart;
+        }
+
+        auto Result = this->m_Entries.emplace(UserModeType, CachedToken);
+        if (Result.second)
+        {
+            CachedToken = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    if (CachedToken != INVALID_HANDLE_VALUE)
+    {
+        Backend->CloseHandle(CachedToken);
+    }
+
+    return S_OK;
+}
+
+void CNSudoDerivedTokenCache::Invalidate()
+{
+    Mile::AutoSRWExclusiveLock Lock(this->m_Lock);
+
+    if (this->m_Backend)
+    {
+        this->ReleaseEntries();
+    }
+
+    this->m_Backend = nullptr;
+    this->m_SessionId = static_cast<DWORD>(-1);
+    this->m_LogonTime = 0;
+}
+
+void CNSudoDerivedTokenCache::GetStatistics(
+    _Out_ PLONG Hits,
+    _Out_ PLONG Misses)
+{
+    *Hits = this->m_Hits;
+    *Misses = this->m_Misses;
+}
+
+CNSudoDerivedTokenCache& CNSudoDerivedTokenCache::GetInstance()
+{
+    static CNSudoDerivedTokenCache Instance;
+    return Instance;
+}
@@ -0,0 +1,126 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoDerivedTokenCache.h
+ * PURPOSE:   Definition for NSudo derived access token cache
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_DERIVED_TOKEN_CACHE
+#define NSUDO_DERIVED_TOKEN_CACHE
+
+#ifndef __cplusplus
+#error "[NSudoDerivedTokenCache] You should use a C++ compiler."
+#endif
+
+#include "NSudoAPI.h"
+#include "NSudoLaunchBackend.h"
+
+#include <Mile.Windows.h>
+
+#include <map>
+
+/**
+ * @brief Caches the primary access tokens derived for the
+ *        NSUDO_USER_MODE_TYPE::CURRENT_USER_ELEVATED and
+ *        NSUDO_USER_MODE_TYPE::CURRENT_PROCESS_DROP_RIGHT user modes. The
+ *        cached tokens belong to a session and its logon, they are released
+ *        when the active session changes or the user of the session logs off
+ *        and on again. Each launch gets a duplicated handle of the cached
+ *        token.
+*/
+class CNSudoDerivedTokenCache :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    Mile::SRWLock m_Lock;
+    INSudoLaunchBackend* m_Backend = nullptr;
+    DWORD m_SessionId = static_cast<DWORD>(-1);
+    LONGLONG m_LogonTime = 0;
+    std::map<NSUDO_USER_MODE_TYPE, HANDLE> m_Entries;
+
+    volatile LONG m_Hits = 0;
+    volatile LONG m_Misses = 0;
+
+    /**
+     * @brief Derives a new primary access token for the user mode. The
+     *        calling thread needs to impersonate the system context.
+     * @param Backend The launch backend.
+     * @param UserModeType The user mode.
+     * @param SessionId The active session ID.
+     * @param TokenHandle The derived primary access token.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    static HRESULT CreateDerivedToken(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_ NSUDO_USER_MODE_TYPE UserModeType,
+        _In_ DWORD SessionId,
+        _Out_ PHANDLE TokenHandle);
+
+    /**
+     * @brief Releases all cached tokens. The caller needs to hold the
+     *        exclusive lock.
+    */
+    void ReleaseEntries();
+
+public:
+
+    CNSudoDerivedTokenCache() = default;
+
+    ~CNSudoDerivedTokenCache();
+
+    /**
+     * @brief Checks whether the tokens of the user mode are cached.
+     * @param UserModeType The user mode.
+     * @return True if the tokens of the user mode are cached.
+    */
+    static bool IsCacheable(
+        _In_ NSUDO_USER_MODE_TYPE UserModeType);
+
+    /**
+     * @brief Gets the primary access token for the user mode. The cached
+     *        token is used if it belongs to the current logon of the session,
+     *        a new token will be derived and cached otherwise. The calling
+     *        thread needs to impersonate the system context.
+     * @param Backend The launch backend.
+     * @param UserModeType The user mode. It must be a cacheable user mode.
+     * @param SessionId The active session ID.
+     * @param TokenHandle The duplicated handle of the primary access token.
+     *                    The caller needs to close it.
+     * @param CacheHit Receives whether the cached token is used.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Acquire(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_ NSUDO_USER_MODE_TYPE UserModeType,
+        _In_ DWORD SessionId,
+        _Out_ PHANDLE TokenHandle,
+        _Out_ bool& CacheHit);
+
+    /**
+     * @brief Releases all cached tokens.
+    */
+    void Invalidate();
+
+    /**
+     * @brief Gets the hit and miss counters of the cache.
+     * @param Hits The number of launches which used a cached token.
+     * @param Misses The number of launches which derived a new token.
+    */
+    void GetStatistics(
+        _Out_ PLONG Hits,
+        _Out_ PLONG Misses);
+
+    /**
+     * @brief Gets the derived access token cache shared by the current
+     *        process.
+     * @return The derived access token cache shared by the current process.
+    */
+    static CNSudoDerivedTokenCache& GetInstance();
+};
+
+#endif // !NSUDO_DERIVED_TOKEN_CACHE
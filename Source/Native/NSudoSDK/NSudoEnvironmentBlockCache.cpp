@@ -0,0 +1,232 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoEnvironmentBlockCache.cpp
+ * PURPOSE:   Implementation for NSudo environment block cache
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoEnvironmentBlockCache.h"
+#include "NSudoEnvironmentBlockMerge.h"
+
+#include <sddl.h>
+
+#include <cwchar>
+#include <vector>
+
+HRESULT CNSudoEnvironmentBlockCache::GetCacheKey(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ HANDLE TokenHandle,
+    _In_ BOOL Inherit,
+    _Out_ CacheKey& Key)
+{
+    Key.UserSid.clear();
+    Key.SessionId = static_cast<DWORD>(-1);
+    Key.Inherit = Inherit ? TRUE : FALSE;
+
+    DWORD ReturnLength = 0;
+    HRESULT hr = Backend->GetTokenInformation(
+        TokenHandle,
+        TokenUser,
+        nullptr,
+        0,
+        &ReturnLength);
+    if (hr != Mile::HResult::FromWin32(ERROR_INSUFFICIENT_BUFFER))
+    {
+        return hr == S_OK ? E_UNEXPECTED : hr;
+    }
+
+    PTOKEN_USER UserInformation = reinterpret_cast<PTOKEN_USER>(
+        Mile::HeapMemory::Allocate(ReturnLength));
+    if (!UserInformation)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    hr = Backend->GetTokenInformation(
+        TokenHandle,
+        TokenUser,
+        UserInformation,
+        ReturnLength,
+        &ReturnLength);
+    if (hr == S_OK)
+    {
+        LPWSTR StringSid = nullptr;
+        hr = Mile::HResultFromLastError(::ConvertSidToStringSidW(
+            UserInformation->User.Sid,
+            &StringSid));
+        if (hr == S_OK)
+        {
+            Key.UserSid = StringSid;
+            ::LocalFree(StringSid);
+        }
+    }
+
+    Mile::HeapMemory::Free(UserInformation);
+
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    return Backend->GetTokenInformation(
+        TokenHandle,
+        TokenSessionId,
+        &Key.SessionId,
+        sizeof(DWORD),
+        &ReturnLength);
+}
+
+HRESULT CNSudoEnvironmentBlockCache::CreateBlock(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ HANDLE TokenHandle,
+    _In_ BOOL Inherit,
+    _Out_ std::wstring& Block)
+{
+    Block.clear();
+
+    LPVOID lpEnvironment = nullptr;
+
+    HRESULT hr = Backend->CreateEnvironmentBlock(
+        &lpEnvironment, TokenHandle, Inherit);
+    if (hr == S_OK)
+    {
+        const wchar_t* Start = reinterpret_cast<const wchar_t*>(
+            lpEnvironment);
+        const wchar_t* Current = Start;
+        while (*Current)
+        {
+            Current += std::wcslen(Current) + 1;
+        }
+
+        // Keep the terminating null character of the last variable, the
+        // second one is provided by std::wstring::c_str.
+        Block.assign(Start, Current - Start + 1);
+
+        Backend->DestroyEnvironmentBlock(lpEnvironment);
+    }
+
+    return hr;
+}
+
+HRESULT CNSudoEnvironmentBlockCache::Acquire(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ HANDLE TokenHandle,
+    _In_ BOOL Inherit,
+    _In_opt_ LPCWSTR Overrides,
+    _Out_ std::wstring& EnvironmentBlock)
+{
+    EnvironmentBlock.clear();
+
+    ULONGLONG TimeToLive = 0;
+    {
+        Mile::AutoSRWSharedLock Lock(this->m_Lock);
+        TimeToLive = this->m_TimeToLive;
+    }
+
+    HRESULT hr = S_OK;
+    std::wstring Block;
+
+    if (TimeToLive)
+    {
+        CacheKey Key;
+        hr = CNSudoEnvironmentBlockCache::GetCacheKey(
+            Backend,
+            TokenHandle,
+            Inherit,
+            Key);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+
+        bool CacheHit = false;
+        {
+            Mile::AutoSRWSharedLock Lock(this->m_Lock);
+
+            auto Iterator = this->m_Entries.find(Key);
+            if (Iterator != this->m_Entries.end() &&
+                Mile::GetTickCount() - Iterator->second.CreationTick
+                < TimeToLive)
+            {
+                Block = Iterator->second.Block;
+                CacheHit = true;
+            }
+        }
+
+        if (!CacheHit)
+        {
+            hr = CNSudoEnvironmentBlockCache::CreateBlock(
+                Backend,
+                TokenHandle,
+                Inherit,
+                Block);
+            if (hr != S_OK)
+            {
+                return hr;
+            }
+
+            Mile::AutoSRWExclusiveLock Lock(this->m_Lock);
+
+            CacheEntry& Entry = this->m_Entries[Key];
+            Entry.Block = Block;
+            Entry.CreationTick = Mile::GetTickCount();
+        }
+    }
+    else
+    {
+        hr = CNSudoEnvironmentBlockCache::CreateBlock(
+            Backend,
+            TokenHandle,
+            Inherit,
+            Block);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    std::vector<NSudoEnvironmentVariableView> SortedOverrides;
+    ::NSudoParseEnvironmentOverrides(Overrides, SortedOverrides);
+
+    if (SortedOverrides.empty())
+    {
+        EnvironmentBlock = std::move(Block);
+    }
+    else
+    {
+        EnvironmentBlock = ::NSudoMergeEnvironmentBlock(
+            Block.c_str(),
+            SortedOverrides);
+    }
+
+    return S_OK;
+}
+
+void CNSudoEnvironmentBlockCache::Invalidate()
+{
+    Mile::AutoSRWExclusiveLock Lock(this->m_Lock);
+
+    this->m_Entries.clear();
+}
+
+void CNSudoEnvironmentBlockCache::SetTimeToLive(
+    _In_ ULONGLONG TimeToLive)
+{
+    Mile::AutoSRWExclusiveLock Lock(this->m_Lock);
+
+    this->m_TimeToLive = TimeToLive;
+
+    if (!TimeToLive)
+    {
+        this->m_Entries.clear();
+    }
+}
+
+CNSudoEnvironmentBlockCache& CNSudoEnvironmentBlockCache::GetInstance()
+{
+    static CNSudoEnvironmentBlockCache Instance;
+    return Instance;
+}
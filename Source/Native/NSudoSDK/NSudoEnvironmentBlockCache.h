@@ -0,0 +1,163 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoEnvironmentBlockCache.h
+ * PURPOSE:   Definition for NSudo environment block cache
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_ENVIRONMENT_BLOCK_CACHE
+#define NSUDO_ENVIRONMENT_BLOCK_CACHE
+
+#ifndef __cplusplus
+#error "[NSudoEnvironmentBlockCache] You should use a C++ compiler."
+#endif
+
+#include <Mile.Windows.h>
+
+#include "NSudoLaunchBackend.h"
+
+#include <map>
+#include <string>
+
+/**
+ * @brief The default time-to-live of the cached environment blocks, in
+ *        milliseconds.
+*/
+#define NSUDO_ENVIRONMENT_BLOCK_CACHE_DEFAULT_TIME_TO_LIVE 30000
+
+/**
+ * @brief Caches the environment blocks created by CreateEnvironmentBlock, keyed
+ *        by the user SID, the session ID and the inherit flag of the request.
+*/
+class CNSudoEnvironmentBlockCache :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    /**
+     * @brief The identity of a cached environment block.
+    */
+    struct CacheKey
+    {
+        std::wstring UserSid;
+        DWORD SessionId;
+        BOOL Inherit;
+
+        bool operator<(
+            CacheKey const& Other) const
+        {
+            if (this->SessionId != Other.SessionId)
+            {
+                return this->SessionId < Other.SessionId;
+            }
+
+            if (this->Inherit != Other.Inherit)
+            {
+                return this->Inherit < Other.Inherit;
+            }
+
+            return this->UserSid < Other.UserSid;
+        }
+    };
+
+    /**
+     * @brief The content of a cached environment block.
+    */
+    struct CacheEntry
+    {
+        std::wstring Block;
+        ULONGLONG CreationTick;
+    };
+
+    Mile::SRWLock m_Lock;
+    std::map<CacheKey, CacheEntry> m_Entries;
+    ULONGLONG m_TimeToLive = NSUDO_ENVIRONMENT_BLOCK_CACHE_DEFAULT_TIME_TO_LIVE;
+
+    /**
+     * @brief Gets the cache key of the access token.
+     * @param Backend The launch backend.
+     * @param TokenHandle The access token.
+     * @param Inherit The inherit flag of the request.
+     * @param Key The cache key of the access token.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    static HRESULT GetCacheKey(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_ HANDLE TokenHandle,
+        _In_ BOOL Inherit,
+        _Out_ CacheKey& Key);
+
+    /**
+     * @brief Creates a new environment block and copies it to the heap
+     *        managed by the cache.
+     * @param Backend The launch backend.
+     * @param TokenHandle The access token.
+     * @param Inherit The inherit flag of the request.
+     * @param Block The copy of the environment block.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    static HRESULT CreateBlock(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_ HANDLE TokenHandle,
+        _In_ BOOL Inherit,
+        _Out_ std::wstring& Block);
+
+public:
+
+    CNSudoEnvironmentBlockCache() = default;
+
+    /**
+     * @brief Gets the environment block for the specified access token. The
+     *        cached block is used if it is not expired, a new block will be
+     *        created and cached otherwise.
+     * @param Backend The launch backend.
+     * @param TokenHandle The access token of the user for whom the environment
+     *                    block is created. The session ID of the access token
+     *                    must be set before calling this function.
+     * @param Inherit Specifies whether to inherit from the environment of the
+     *                current process.
+     * @param Overrides The per-launch overrides in "Name=Value" form,
+     *                  terminated by two null characters like an environment
+     *                  block. If the value is empty, the variable will be
+     *                  removed. The overrides are merged into a copy of the
+     *                  block and never written back to the cache. This
+     *                  parameter can be nullptr.
+     * @param EnvironmentBlock The UTF-16 environment block which is terminated
+     *                         by two null characters, suitable for passing to
+     *                         CreateProcessAsUserW with the
+     *                         CREATE_UNICODE_ENVIRONMENT flag.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Acquire(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_ HANDLE TokenHandle,
+        _In_ BOOL Inherit,
+        _In_opt_ LPCWSTR Overrides,
+        _Out_ std::wstring& EnvironmentBlock);
+
+    /**
+     * @brief Removes all cached environment blocks.
+    */
+    void Invalidate();
+
+    /**
+     * @brief Sets the time-to-live of the cached environment blocks.
+     * @param TimeToLive The time-to-live of the cached environment blocks, in
+     *                   milliseconds. If this parameter is 0, the environment
+     *                   blocks will not be cached.
+    */
+    void SetTimeToLive(
+        _In_ ULONGLONG TimeToLive);
+
+    /**
+     * @brief Gets the environment block cache shared by the current process.
+     * @return The environment block cache shared by the current process.
+    */
+    static CNSudoEnvironmentBlockCache& GetInstance();
+};
+
+#endif // !NSUDO_ENVIRONMENT_BLOCK_CACHE
@@ -0,0 +1,289 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoEnvironmentBlockMerge.h
+ * PURPOSE:   Definition for NSudo environment block merging
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_ENVIRONMENT_BLOCK_MERGE
+#define NSUDO_ENVIRONMENT_BLOCK_MERGE
+
+#include <algorithm>
+#include <cstddef>
+#include <cwctype>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A variable of an environment block, which points into the block.
+*/
+struct NSudoEnvironmentVariableView
+{
+    /**
+     * @brief The "Name=Value" string of the variable.
+    */
+    const wchar_t* Variable;
+
+    /**
+     * @brief The length of Variable, in characters.
+    */
+    std::size_t VariableLength;
+
+    /**
+     * @brief The length of the name part of Variable, in characters.
+    */
+    std::size_t NameLength;
+};
+
+/**
+ * @brief Gets the length of the name part of an environment variable. The
+ *        first character is skipped for the hidden variables like "=C:".
+ * @param Variable The "Name=Value" string of the variable.
+ * @param VariableLength The length of Variable, in characters.
+ * @return The length of the name part, in characters.
+*/
+inline std::size_t NSudoGetEnvironmentVariableNameLength(
+    const wchar_t* Variable,
+    std::size_t VariableLength)
+{
+    for (std::size_t i = 1; i < VariableLength; ++i)
+    {
+        if (Variable[i] == L'=')
+        {
+            return i;
+        }
+    }
+
+    return VariableLength;
+}
+
+/**
+ * @brief Compares the names of two environment variables in the order used
+ *        by the environment blocks, which is case-insensitive.
+ * @param Left The name of the first variable.
+ * @param LeftLength The length of Left, in characters.
+ * @param Right The name of the second variable.
+ * @param RightLength The length of Right, in characters.
+ * @return A negative value if Left is ordered before Right, zero if they are
+ *         the same variable, a positive value otherwise.
+*/
+inline int NSudoCompareEnvironmentVariableNames(
+    const wchar_t* Left,
+    std::size_t LeftLength,
+    const wchar_t* Right,
+    std::size_t RightLength)
+{
+    std::size_t Length = (std::min)(LeftLength, RightLength);
+    for (std::size_t i = 0; i < Length; ++i)
+    {
+        wchar_t LeftChar = Left[i];
+        wchar_t RightChar = Right[i];
+        if (LeftChar == RightChar)
+        {
+            continue;
+        }
+
+        LeftChar = (LeftChar >= L'a' && LeftChar <= L'z')
+            ? static_cast<wchar_t>(LeftChar - L'a' + L'A')
+            : (LeftChar < 0x80
+                ? LeftChar
+                : static_cast<wchar_t>(std::towupper(LeftChar)));
+        RightChar = (RightChar >= L'a' && RightChar <= L'z')
+            ? static_cast<wchar_t>(RightChar - L'a' + L'A')
+            : (RightChar < 0x80
+                ? RightChar
+                : static_cast<wchar_t>(std::towupper(RightChar)));
+        if (LeftChar != RightChar)
+        {
+            return LeftChar < RightChar ? -1 : 1;
+        }
+    }
+
+    if (LeftLength == RightLength)
+    {
+        return 0;
+    }
+
+    return LeftLength < RightLength ? -1 : 1;
+}
+
+/**
+ * @brief Parses the overrides and sorts them by name. If a variable is
+ *        overridden more than once, the last override is kept. The strings
+ *        without a name are ignored.
+ * @param Overrides The overrides in "Name=Value" form, terminated by two null
+ *                  characters like an environment block. If the value is
+ *                  empty, the variable will be removed. It can be nullptr.
+ * @param SortedOverrides Receives the sorted overrides, which point into
+ *                        Overrides.
+*/
+inline void NSudoParseEnvironmentOverrides(
+    const wchar_t* Overrides,
+    std::vector<NSudoEnvironmentVariableView>& SortedOverrides)
+{
+    SortedOverrides.clear();
+
+    if (!Overrides)
+    {
+        return;
+    }
+
+    for (const wchar_t* Current = Overrides; *Current;)
+    {
+        NSudoEnvironmentVariableView View;
+        View.Variable = Current;
+        View.VariableLength = std::char_traits<wchar_t>::length(Current);
+        View.NameLength = NSudoGetEnvironmentVariableNameLength(
+            View.Variable,
+            View.VariableLength);
+        Current += View.VariableLength + 1;
+
+        if (View.NameLength < View.VariableLength)
+        {
+            SortedOverrides.push_back(View);
+        }
+    }
+
+    auto Less = [](
+        NSudoEnvironmentVariableView const& Left,
+        NSudoEnvironmentVariableView const& Right)
+    {
+        return NSudoCompareEnvironmentVariableNames(
+            Left.Variable,
+            Left.NameLength,
+            Right.Variable,
+            Right.NameLength) < 0;
+    };
+
+    std::stable_sort(SortedOverrides.begin(), SortedOverrides.end(), Less);
+
+    // Keep the last one of the overrides with the same name.
+    std::size_t Count = 0;
+    for (std::size_t i = 0; i < SortedOverrides.size(); ++i)
+    {
+        if (i + 1 < SortedOverrides.size() &&
+            !Less(SortedOverrides[i], SortedOverrides[i + 1]))
+        {
+            continue;
+        }
+
+        SortedOverrides[Count++] = SortedOverrides[i];
+    }
+    SortedOverrides.resize(Count);
+}
+
+/**
+ * @brief Merges the sorted overrides into an environment block in a single
+ *        pass. The overrides are inserted at their sorted positions, the
+ *        variables with the same name are replaced or removed, and the result
+ *        is built in one allocation. The variables of the environment block
+ *        which are not in the sorted order are kept in place, and the
+ *        override still wins if its name has already been passed.
+ * @param Block The environment block, terminated by two null characters.
+ * @param SortedOverrides The overrides parsed by
+ *                        NSudoParseEnvironmentOverrides.
+ * @return The merged environment block. The last variable is followed by one
+ *         null character, the second one is provided by std::wstring::c_str.
+*/
+inline std::wstring NSudoMergeEnvironmentBlock(
+    const wchar_t* Block,
+    std::vector<NSudoEnvironmentVariableView> const& SortedOverrides)
+{
+    const wchar_t* BlockEnd = Block;
+    while (*BlockEnd)
+    {
+        BlockEnd += std::char_traits<wchar_t>::length(BlockEnd) + 1;
+    }
+
+    std::size_t ReservedSize = static_cast<std::size_t>(BlockEnd - Block) + 1;
+    for (NSudoEnvironmentVariableView const& Override : SortedOverrides)
+    {
+        ReservedSize += Override.VariableLength + 1;
+    }
+
+    std::wstring Result;
+    Result.reserve(ReservedSize);
+
+    auto AppendOverride = [&Result](
+        NSudoEnvironmentVariableView const& Override)
+    {
+        // An empty value removes the variable.
+        if (Override.NameLength + 1 < Override.VariableLength)
+        {
+            Result.append(Override.Variable, Override.VariableLength + 1);
+        }
+    };
+
+    std::size_t Next = 0;
+
+    for (const wchar_t* Current = Block; *Current;)
+    {
+        std::size_t VariableLength =
+            std::char_traits<wchar_t>::length(Current);
+        std::size_t NameLength = NSudoGetEnvironmentVariableNameLength(
+            Current,
+            VariableLength);
+
+        // Insert the overrides ordered before the current variable.
+        int Order = 1;
+        while (Next < SortedOverrides.size())
+        {
+            NSudoEnvironmentVariableView const& Override =
+                SortedOverrides[Next];
+            Order = NSudoCompareEnvironmentVariableNames(
+                Override.Variable,
+                Override.NameLength,
+                Current,
+                NameLength);
+            if (Order >= 0)
+            {
+                break;
+            }
+
+            AppendOverride(Override);
+            ++Next;
+        }
+
+        if (Next < SortedOverrides.size() && Order == 0)
+        {
+            AppendOverride(SortedOverrides[Next++]);
+        }
+        else if (!std::binary_search(
+            SortedOverrides.begin(),
+            SortedOverrides.begin() + Next,
+            NSudoEnvironmentVariableView{ Current, VariableLength, NameLength },
+            [](
+                NSudoEnvironmentVariableView const& Left,
+                NSudoEnvironmentVariableView const& Right)
+            {
+                return NSudoCompareEnvironmentVariableNames(
+                    Left.Variable,
+                    Left.NameLength,
+                    Right.Variable,
+                    Right.NameLength) < 0;
+            }))
+        {
+            Result.append(Current, VariableLength + 1);
+        }
+
+        Current += VariableLength + 1;
+    }
+
+    for (; Next < SortedOverrides.size(); ++Next)
+    {
+        AppendOverride(SortedOverrides[Next]);
+    }
+
+    // An empty environment block still needs two null characters.
+    if (Result.empty())
+    {
+        Result.push_back(L'\0');
+    }
+
+    return Result;
+}
+
+#endif // !NSUDO_ENVIRONMENT_BLOCK_MERGE
@@ -0,0 +1,196 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoJobObject.cpp
+ * PURPOSE:   Implementation for NSudo launched process tree job object
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoJobObject.h"
+
+#include <cstring>
+
+CNSudoJobObject::~CNSudoJobObject()
+{
+    if (this->m_JobHandle)
+    {
+        this->m_Backend->CloseHandle(this->m_JobHandle);
+    }
+}
+
+HRESULT CNSudoJobObject::Initialize(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options)
+{
+    if (!Backend)
+    {
+        return E_INVALIDARG;
+    }
+
+    this->m_Backend = Backend;
+
+    if (!Options)
+    {
+        return S_OK;
+    }
+
+    if (Options->JobCpuRate > 10000)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (!(Options->JobCpuRate ||
+        Options->JobWorkingSetLimit ||
+        Options->JobMemoryLimit ||
+        Options->JobKillOnClose))
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = Backend->CreateJobObject(&this->m_JobHandle);
+    if (hr != S_OK)
+    {
+        this->m_JobHandle = nullptr;
+        return hr;
+    }
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION LimitInformation = { 0 };
+
+    if (Options->JobWorkingSetLimit)
+    {
+        // The minimum working set size is required by the limit, use the
+        // system default unless it is larger than the maximum.
+        const SIZE_T DefaultMinimumWorkingSetSize = 200 * 4096;
+
+        LimitInformation.BasicLimitInformation.LimitFlags |=
+            JOB_OBJECT_LIMIT_WORKINGSET;
+        LimitInformation.BasicLimitInformation.MinimumWorkingSetSize =
+            Options->JobWorkingSetLimit < DefaultMinimumWorkingSetSize
+            ? Options->JobWorkingSetLimit
+            : DefaultMinimumWorkingSetSize;
+        LimitInformation.BasicLimitInformation.MaximumWorkingSetSize =
+            Options->JobWorkingSetLimit;
+    }
+
+    if (Options->JobMemoryLimit)
+    {
+        LimitInformation.BasicLimitInformation.LimitFlags |=
+            JOB_OBJECT_LIMIT_JOB_MEMORY;
+        LimitInformation.JobMemoryLimit = Options->JobMemoryLimit;
+    }
+
+    if (Options->JobKillOnClose)
+    {
+        LimitInformation.BasicLimitInformation.LimitFlags |=
+            JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    }
+
+    if (LimitInformation.BasicLimitInformation.LimitFlags)
+    {
+        hr = Backend->SetInformationJobObject(
+            this->m_JobHandle,
+            JobObjectExtendedLimitInformation,
+            &LimitInformation,
+            sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    if (Options->JobCpuRate)
+    {
+        JOBOBJECT_CPU_RATE_CONTROL_INFORMATION CpuRateInformation = { 0 };
+        CpuRateInformation.ControlFlags =
+            JOB_OBJECT_CPU_RATE_CONTROL_ENABLE |
+            JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+        CpuRateInformation.CpuRate = Options->JobCpuRate;
+
+        hr = Backend->SetInformationJobObject(
+            this->m_JobHandle,
+            JobObjectCpuRateControlInformation,
+            &CpuRateInformation,
+            sizeof(JOBOBJECT_CPU_RATE_CONTROL_INFORMATION));
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+bool CNSudoJobObject::IsEnabled() const
+{
+    return nullptr != this->m_JobHandle;
+}
+
+HRESULT CNSudoJobObject::Assign(
+    _In_ HANDLE ProcessHandle)
+{
+    if (!this->m_JobHandle)
+    {
+        return S_OK;
+    }
+
+    return this->m_Backend->AssignProcessToJobObject(
+        this->m_JobHandle,
+        ProcessHandle);
+}
+
+HRESULT CNSudoJobObject::QueryAccounting(
+    _Out_ PNSUDO_JOB_ACCOUNTING_INFORMATION Accounting)
+{
+    if (!Accounting)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::memset(Accounting, 0, sizeof(NSUDO_JOB_ACCOUNTING_INFORMATION));
+
+    if (!this->m_JobHandle)
+    {
+        return S_OK;
+    }
+
+    JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION AccountingInformation;
+    HRESULT hr = this->m_Backend->QueryInformationJobObject(
+        this->m_JobHandle,
+        JobObjectBasicAndIoAccountingInformation,
+        &AccountingInformation,
+        sizeof(JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION));
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION LimitInformation;
+    hr = this->m_Backend->QueryInformationJobObject(
+        this->m_JobHandle,
+        JobObjectExtendedLimitInformation,
+        &LimitInformation,
+        sizeof(JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    Accounting->TotalProcesses =
+        AccountingInformation.BasicInfo.TotalProcesses;
+    Accounting->TotalUserTime = static_cast<ULONGLONG>(
+        AccountingInformation.BasicInfo.TotalUserTime.QuadPart);
+    Accounting->TotalKernelTime = static_cast<ULONGLONG>(
+        AccountingInformation.BasicInfo.TotalKernelTime.QuadPart);
+    Accounting->PeakJobMemoryUsed = LimitInformation.PeakJobMemoryUsed;
+    Accounting->PeakProcessMemoryUsed = LimitInformation.PeakProcessMemoryUsed;
+    Accounting->ReadTransferCount =
+        AccountingInformation.IoInfo.ReadTransferCount;
+    Accounting->WriteTransferCount =
+        AccountingInformation.IoInfo.WriteTransferCount;
+    Accounting->OtherTransferCount =
+        AccountingInformation.IoInfo.OtherTransferCount;
+
+    return S_OK;
+}
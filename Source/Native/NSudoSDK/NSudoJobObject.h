@@ -0,0 +1,80 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoJobObject.h
+ * PURPOSE:   Definition for NSudo launched process tree job object
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_JOB_OBJECT
+#define NSUDO_JOB_OBJECT
+
+#ifndef __cplusplus
+#error "[NSudoJobObject] You should use a C++ compiler."
+#endif
+
+#include "NSudoAPI.h"
+#include "NSudoLaunchBackend.h"
+
+#include <Mile.Windows.h>
+
+/**
+ * @brief Places the launched process tree into a job with the limits
+ *        specified in the launch options, and queries the accounting
+ *        information of the job. All job object operations go through the
+ *        launch backend.
+*/
+class CNSudoJobObject :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    INSudoLaunchBackend* m_Backend = nullptr;
+    HANDLE m_JobHandle = nullptr;
+
+public:
+
+    CNSudoJobObject() = default;
+
+    ~CNSudoJobObject();
+
+    /**
+     * @brief Creates the job and sets its limits if any of the job options is
+     *        specified in the launch options.
+     * @param Backend The launch backend.
+     * @param Options The launch options.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Initialize(
+        _In_ INSudoLaunchBackend* Backend,
+        _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options);
+
+    /**
+     * @brief Checks whether the launched process tree is placed into a job.
+     * @return True if the launched process tree is placed into a job.
+    */
+    bool IsEnabled() const;
+
+    /**
+     * @brief Assigns the process to the job. It needs to be called while the
+     *        primary thread of the process is still suspended, so the child
+     *        processes are also placed into the job.
+     * @param ProcessHandle The handle of the process.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Assign(
+        _In_ HANDLE ProcessHandle);
+
+    /**
+     * @brief Queries the accounting information of the job.
+     * @param Accounting The accounting information of the job.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT QueryAccounting(
+        _Out_ PNSUDO_JOB_ACCOUNTING_INFORMATION Accounting);
+};
+
+#endif // !NSUDO_JOB_OBJECT
@@ -0,0 +1,412 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoLaunchBackend.cpp
+ * PURPOSE:   Implementation for NSudo launch backend
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoLaunchBackend.h"
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP | WINAPI_PARTITION_SYSTEM)
+#include <Userenv.h>
+#pragma comment(lib, "Userenv.lib")
+#endif
+
+#include <WtsApi32.h>
+#pragma comment(lib, "WtsApi32.lib")
+
+/**
+ * @brief The launch backend which forwards to the Win32 API.
+*/
+class CNSudoWin32LaunchBackend : public INSudoLaunchBackend
+{
+public:
+
+    virtual HRESULT STDMETHODCALLTYPE OpenProcessToken(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        return Mile::HResultFromLastError(::OpenProcessToken(
+            ProcessHandle,
+            DesiredAccess,
+            TokenHandle));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateTokenEx(
+        _In_ HANDLE ExistingTokenHandle,
+        _In_ DWORD DesiredAccess,
+        _In_ SECURITY_IMPERSONATION_LEVEL ImpersonationLevel,
+        _In_ TOKEN_TYPE TokenType,
+        _Out_ PHANDLE NewTokenHandle)
+    {
+        return Mile::HResultFromLastError(::DuplicateTokenEx(
+            ExistingTokenHandle,
+            DesiredAccess,
+            nullptr,
+            ImpersonationLevel,
+            TokenType,
+            NewTokenHandle));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE LookupPrivilegeValueW(
+        _In_ LPCWSTR Name,
+        _Out_ PLUID Luid)
+    {
+        return Mile::HResultFromLastError(::LookupPrivilegeValueW(
+            nullptr,
+            Name,
+            Luid));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ PLUID_AND_ATTRIBUTES Privileges,
+        _In_ DWORD PrivilegeCount)
+    {
+        return Mile::AdjustTokenPrivilegesSimple(
+            TokenHandle,
+            Privileges,
+            PrivilegeCount);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenAllPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD Attributes)
+    {
+        return Mile::AdjustTokenAllPrivileges(TokenHandle, Attributes);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetThreadToken(
+        _In_opt_ HANDLE TokenHandle)
+    {
+        return Mile::HResultFromLastError(::SetThreadToken(
+            nullptr,
+            TokenHandle));
+    }
+
+    virtual DWORD STDMETHODCALLTYPE GetActiveSessionID()
+    {
+        return Mile::GetActiveSessionID();
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetSessionLogonTime(
+        _In_ DWORD SessionId,
+        _Out_ PLARGE_INTEGER LogonTime)
+    {
+        LogonTime->QuadPart = 0;
+
+        PWTSINFOW SessionInformation = nullptr;
+        DWORD ReturnLength = 0;
+        HRESULT hr = Mile::HResultFromLastError(::WTSQuerySessionInformationW(
+            WTS_CURRENT_SERVER_HANDLE,
+            SessionId,
+            WTSSessionInfo,
+            reinterpret_cast<LPWSTR*>(&SessionInformation),
+            &ReturnLength));
+        if (hr == S_OK)
+        {
+            *LogonTime = SessionInformation->LogonTime;
+
+            ::WTSFreeMemory(SessionInformation);
+        }
+
+        return hr;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSystemToken(
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        return Mile::CreateSystemToken(DesiredAccess, TokenHandle);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE OpenServiceProcessToken(
+        _In_ LPCWSTR ServiceName,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle)
+    {
+        return Mile::OpenServiceProcessToken(
+            ServiceName,
+            DesiredAccess,
+            TokenHandle);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSessionToken(
+        _In_ DWORD SessionId,
+        _Out_ PHANDLE TokenHandle)
+    {
+        return Mile::CreateSessionToken(SessionId, TokenHandle);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateLUAToken(
+        _In_ HANDLE ExistingTokenHandle,
+        _Out_ PHANDLE TokenHandle)
+    {
+        return Mile::CreateLUAToken(ExistingTokenHandle, TokenHandle);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _Out_opt_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength,
+        _Out_ PDWORD ReturnLength)
+    {
+        return Mile::HResultFromLastError(::GetTokenInformation(
+            TokenHandle,
+            TokenInformationClass,
+            TokenInformation,
+            TokenInformationLength,
+            ReturnLength));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _In_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength)
+    {
+        return Mile::HResultFromLastError(::SetTokenInformation(
+            TokenHandle,
+            TokenInformationClass,
+            TokenInformation,
+            TokenInformationLength));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenMandatoryLabel(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD MandatoryLabelRid)
+    {
+        return Mile::SetTokenMandatoryLabel(TokenHandle, MandatoryLabelRid);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateEnvironmentBlock(
+        _Out_ LPVOID* Environment,
+        _In_opt_ HANDLE TokenHandle,
+        _In_ BOOL Inherit)
+    {
+        return Mile::HResultFromLastError(::CreateEnvironmentBlock(
+            Environment,
+            TokenHandle,
+            Inherit));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DestroyEnvironmentBlock(
+        _In_ LPVOID Environment)
+    {
+        return Mile::HResultFromLastError(::DestroyEnvironmentBlock(
+            Environment));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateProcessAsUserW(
+        _In_opt_ HANDLE TokenHandle,
+        _Inout_ LPWSTR CommandLine,
+        _In_ BOOL InheritHandles,
+        _In_ DWORD CreationFlags,
+        _In_opt_ LPVOID Environment,
+        _In_opt_ LPCWSTR CurrentDirectory,
+        _In_ LPSTARTUPINFOW StartupInfo,
+        _Out_ LPPROCESS_INFORMATION ProcessInformation)
+    {
+        return Mile::HResultFromLastError(::CreateProcessAsUserW(
+            TokenHandle,
+            nullptr,
+            CommandLine,
+            nullptr,
+            nullptr,
+            InheritHandles,
+            CreationFlags,
+            Environment,
+            CurrentDirectory,
+            StartupInfo,
+            ProcessInformation));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetPriorityClass(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD PriorityClass)
+    {
+        return Mile::HResultFromLastError(::SetPriorityClass(
+            ProcessHandle,
+            PriorityClass));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessAffinityMask(
+        _In_ HANDLE ProcessHandle,
+        _In_ KAFFINITY AffinityMask)
+    {
+        return Mile::HResultFromLastError(::SetProcessAffinityMask(
+            ProcessHandle,
+            AffinityMask));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessMemoryPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG MemoryPriority)
+    {
+        // SetProcessInformation is only available since Windows 8.
+        HMODULE ModuleHandle = ::GetModuleHandleW(L"kernel32.dll");
+        if (!ModuleHandle)
+        {
+            return Mile::HResultFromLastError(FALSE);
+        }
+
+        decltype(::SetProcessInformation)* Procedure =
+            reinterpret_cast<decltype(::SetProcessInformation)*>(
+                ::GetProcAddress(ModuleHandle, "SetProcessInformation"));
+        if (!Procedure)
+        {
+            return Mile::HResultFromLastError(FALSE);
+        }
+
+        MEMORY_PRIORITY_INFORMATION Information = { 0 };
+        Information.MemoryPriority = MemoryPriority;
+
+        return Mile::HResultFromLastError(Procedure(
+            ProcessHandle,
+            ProcessMemoryPriority,
+            &Information,
+            sizeof(MEMORY_PRIORITY_INFORMATION)));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessIoPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG IoPriority)
+    {
+        typedef LONG(NTAPI* PNtSetInformationProcess)(
+            _In_ HANDLE ProcessHandle,
+            _In_ ULONG ProcessInformationClass,
+            _In_ PVOID ProcessInformation,
+            _In_ ULONG ProcessInformationLength);
+
+        // The value of ProcessIoPriority in PROCESSINFOCLASS.
+        const ULONG ProcessIoPriorityClass = 33;
+
+        HMODULE ModuleHandle = ::GetModuleHandleW(L"ntdll.dll");
+        if (!ModuleHandle)
+        {
+            return Mile::HResultFromLastError(FALSE);
+        }
+
+        PNtSetInformationProcess Procedure =
+            reinterpret_cast<PNtSetInformationProcess>(
+                ::GetProcAddress(ModuleHandle, "NtSetInformationProcess"));
+        if (!Procedure)
+        {
+            return Mile::HResultFromLastError(FALSE);
+        }
+
+        LONG Status = Procedure(
+            ProcessHandle,
+            ProcessIoPriorityClass,
+            &IoPriority,
+            sizeof(ULONG));
+
+        return Status < 0 ? HRESULT_FROM_NT(Status) : S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CreateJobObject(
+        _Out_ PHANDLE JobHandle)
+    {
+        *JobHandle = ::CreateJobObjectW(nullptr, nullptr);
+        return Mile::HResultFromLastError(nullptr != *JobHandle);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE SetInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _In_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength)
+    {
+        return Mile::HResultFromLastError(::SetInformationJobObject(
+            JobHandle,
+            JobObjectInformationClass,
+            JobObjectInformation,
+            JobObjectInformationLength));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AssignProcessToJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ HANDLE ProcessHandle)
+    {
+        return Mile::HResultFromLastError(::AssignProcessToJobObject(
+            JobHandle,
+            ProcessHandle));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _Out_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength)
+    {
+        return Mile::HResultFromLastError(::QueryInformationJobObject(
+            JobHandle,
+            JobObjectInformationClass,
+            JobObjectInformation,
+            JobObjectInformationLength,
+            nullptr));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ResumeThread(
+        _In_ HANDLE ThreadHandle)
+    {
+        return Mile::HResultFromLastError(
+            static_cast<DWORD>(-1) != ::ResumeThread(ThreadHandle));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE TerminateProcess(
+        _In_ HANDLE ProcessHandle,
+        _In_ UINT ExitCode)
+    {
+        return Mile::HResultFromLastError(::TerminateProcess(
+            ProcessHandle,
+            ExitCode));
+    }
+
+    virtual DWORD STDMETHODCALLTYPE WaitForSingleObject(
+        _In_ HANDLE Handle,
+        _In_ DWORD Milliseconds)
+    {
+        return ::WaitForSingleObjectEx(Handle, Milliseconds, FALSE);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE GetExitCodeProcess(
+        _In_ HANDLE ProcessHandle,
+        _Out_ LPDWORD ExitCode)
+    {
+        return Mile::HResultFromLastError(::GetExitCodeProcess(
+            ProcessHandle,
+            ExitCode));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateHandle(
+        _In_ HANDLE SourceHandle,
+        _Out_ PHANDLE TargetHandle)
+    {
+        return Mile::HResultFromLastError(::DuplicateHandle(
+            ::GetCurrentProcess(),
+            SourceHandle,
+            ::GetCurrentProcess(),
+            TargetHandle,
+            0,
+            FALSE,
+            DUPLICATE_SAME_ACCESS));
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE CloseHandle(
+        _In_ HANDLE Handle)
+    {
+        return Mile::HResultFromLastError(::CloseHandle(Handle));
+    }
+};
+
+INSudoLaunchBackend* NSudoGetWin32LaunchBackend()
+{
+    static CNSudoWin32LaunchBackend Backend;
+    return &Backend;
+}
@@ -0,0 +1,203 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoLaunchBackend.h
+ * PURPOSE:   Definition for NSudo launch backend
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_LAUNCH_BACKEND
+#define NSUDO_LAUNCH_BACKEND
+
+#ifndef __cplusplus
+#error "[NSudoLaunchBackend] You should use a C++ compiler."
+#endif
+
+#include "NSudoAPI.h"
+
+#include <Mile.Windows.h>
+
+/**
+ * @brief The system calls used by the launch path of NSudoCreateProcess. The
+ *        launch path only reaches the system through this interface, so an
+ *        alternative implementation can drive the whole control flow without
+ *        touching the system, e.g. to measure the overhead of the launch
+ *        path itself.
+*/
+class INSudoLaunchBackend
+{
+public:
+
+    virtual HRESULT STDMETHODCALLTYPE OpenProcessToken(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateTokenEx(
+        _In_ HANDLE ExistingTokenHandle,
+        _In_ DWORD DesiredAccess,
+        _In_ SECURITY_IMPERSONATION_LEVEL ImpersonationLevel,
+        _In_ TOKEN_TYPE TokenType,
+        _Out_ PHANDLE NewTokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE LookupPrivilegeValueW(
+        _In_ LPCWSTR Name,
+        _Out_ PLUID Luid) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ PLUID_AND_ATTRIBUTES Privileges,
+        _In_ DWORD PrivilegeCount) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE AdjustTokenAllPrivileges(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD Attributes) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetThreadToken(
+        _In_opt_ HANDLE TokenHandle) = 0;
+
+    virtual DWORD STDMETHODCALLTYPE GetActiveSessionID() = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetSessionLogonTime(
+        _In_ DWORD SessionId,
+        _Out_ PLARGE_INTEGER LogonTime) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSystemToken(
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE OpenServiceProcessToken(
+        _In_ LPCWSTR ServiceName,
+        _In_ DWORD DesiredAccess,
+        _Out_ PHANDLE TokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateSessionToken(
+        _In_ DWORD SessionId,
+        _Out_ PHANDLE TokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateLUAToken(
+        _In_ HANDLE ExistingTokenHandle,
+        _Out_ PHANDLE TokenHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _Out_opt_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength,
+        _Out_ PDWORD ReturnLength) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenInformation(
+        _In_ HANDLE TokenHandle,
+        _In_ TOKEN_INFORMATION_CLASS TokenInformationClass,
+        _In_ LPVOID TokenInformation,
+        _In_ DWORD TokenInformationLength) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetTokenMandatoryLabel(
+        _In_ HANDLE TokenHandle,
+        _In_ DWORD MandatoryLabelRid) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateEnvironmentBlock(
+        _Out_ LPVOID* Environment,
+        _In_opt_ HANDLE TokenHandle,
+        _In_ BOOL Inherit) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE DestroyEnvironmentBlock(
+        _In_ LPVOID Environment) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateProcessAsUserW(
+        _In_opt_ HANDLE TokenHandle,
+        _Inout_ LPWSTR CommandLine,
+        _In_ BOOL InheritHandles,
+        _In_ DWORD CreationFlags,
+        _In_opt_ LPVOID Environment,
+        _In_opt_ LPCWSTR CurrentDirectory,
+        _In_ LPSTARTUPINFOW StartupInfo,
+        _Out_ LPPROCESS_INFORMATION ProcessInformation) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetPriorityClass(
+        _In_ HANDLE ProcessHandle,
+        _In_ DWORD PriorityClass) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessAffinityMask(
+        _In_ HANDLE ProcessHandle,
+        _In_ KAFFINITY AffinityMask) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessMemoryPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG MemoryPriority) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetProcessIoPriority(
+        _In_ HANDLE ProcessHandle,
+        _In_ ULONG IoPriority) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CreateJobObject(
+        _Out_ PHANDLE JobHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _In_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE AssignProcessToJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ HANDLE ProcessHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _Out_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE ResumeThread(
+        _In_ HANDLE ThreadHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE TerminateProcess(
+        _In_ HANDLE ProcessHandle,
+        _In_ UINT ExitCode) = 0;
+
+    virtual DWORD STDMETHODCALLTYPE WaitForSingleObject(
+        _In_ HANDLE Handle,
+        _In_ DWORD Milliseconds) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetExitCodeProcess(
+        _In_ HANDLE ProcessHandle,
+        _Out_ LPDWORD ExitCode) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE DuplicateHandle(
+        _In_ HANDLE SourceHandle,
+        _Out_ PHANDLE TargetHandle) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE CloseHandle(
+        _In_ HANDLE Handle) = 0;
+};
+
+/**
+ * @brief Gets the launch backend which forwards to the Win32 API.
+ * @return The launch backend which forwards to the Win32 API.
+*/
+INSudoLaunchBackend* NSudoGetWin32LaunchBackend();
+
+/**
+ * @brief Creates a new process and its primary thread through the specified
+ *        launch backend. The parameters and the behavior are the same as
+ *        NSudoCreateProcessEx.
+ * @param Backend The launch backend.
+ * @return HRESULT. If the function succeeds, the return value is S_OK.
+*/
+HRESULT NSudoCreateProcessWithBackend(
+    _In_ INSudoLaunchBackend* Backend,
+    _In_ NSUDO_USER_MODE_TYPE UserModeType,
+    _In_ NSUDO_PRIVILEGES_MODE_TYPE PrivilegesModeType,
+    _In_ NSUDO_MANDATORY_LABEL_TYPE MandatoryLabelType,
+    _In_ NSUDO_PROCESS_PRIORITY_CLASS_TYPE ProcessPriorityClassType,
+    _In_ NSUDO_SHOW_WINDOW_MODE_TYPE ShowWindowModeType,
+    _In_ DWORD WaitInterval,
+    _In_ BOOL CreateNewConsole,
+    _In_ LPCWSTR CommandLine,
+    _In_opt_ LPCWSTR CurrentDirectory,
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options);
+
+#endif // !NSUDO_LAUNCH_BACKEND
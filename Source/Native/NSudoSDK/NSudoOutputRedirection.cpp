@@ -0,0 +1,515 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoOutputRedirection.cpp
+ * PURPOSE:   Implementation for NSudo child process output redirection
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoOutputRedirection.h"
+
+#include <string>
+
+static volatile LONG g_NSudoOutputPipeSerialNumber = 0;
+
+CNSudoOutputRedirector::CNSudoOutputRedirector()
+{
+    this->m_Streams[0].StreamType = NSUDO_OUTPUT_STREAM_TYPE::STANDARD_OUTPUT;
+    this->m_Streams[1].StreamType = NSUDO_OUTPUT_STREAM_TYPE::STANDARD_ERROR;
+}
+
+CNSudoOutputRedirector::~CNSudoOutputRedirector()
+{
+    if (this->m_Streams[0].ThreadHandle || this->m_Streams[1].ThreadHandle)
+    {
+        this->Cancel();
+    }
+
+    for (StreamContext& Stream : this->m_Streams)
+    {
+        if (Stream.ThreadHandle)
+        {
+            ::WaitForSingleObjectEx(Stream.ThreadHandle, INFINITE, FALSE);
+            ::CloseHandle(Stream.ThreadHandle);
+        }
+
+        if (Stream.ReadHandle != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(Stream.ReadHandle);
+        }
+
+        if (Stream.WriteHandle != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(Stream.WriteHandle);
+        }
+    }
+
+    for (HANDLE StandardHandle : {
+        this->m_StandardInput,
+        this->m_StandardOutput,
+        this->m_StandardError })
+    {
+        if (StandardHandle != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(StandardHandle);
+        }
+    }
+
+    // Never leave the consumer of the ring waiting if the child process was
+    // not created.
+    if (this->m_SinkType == NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER)
+    {
+        this->m_Ring->Complete();
+    }
+}
+
+HRESULT CNSudoOutputRedirector::CreatePipe(
+    _Inout_ StreamContext& Stream)
+{
+    std::wstring PipeName = Mile::FormatUtf16String(
+        L"\\\\.\\pipe\\NSudo.Output.%08X.%08X",
+        ::GetCurrentProcessId(),
+        ::InterlockedIncrement(&g_NSudoOutputPipeSerialNumber));
+
+    Stream.ReadHandle = ::CreateNamedPipeW(
+        PipeName.c_str(),
+        PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1,
+        0,
+        this->m_BufferSize,
+        0,
+        nullptr);
+    if (Stream.ReadHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    SECURITY_ATTRIBUTES SecurityAttributes = { 0 };
+    SecurityAttributes.nLength = sizeof(SECURITY_ATTRIBUTES);
+    SecurityAttributes.bInheritHandle = TRUE;
+
+    Stream.WriteHandle = ::CreateFileW(
+        PipeName.c_str(),
+        GENERIC_WRITE,
+        0,
+        &SecurityAttributes,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (Stream.WriteHandle == INVALID_HANDLE_VALUE)
+    {
+        return Mile::HResult::FromWin32(::GetLastError());
+    }
+
+    return S_OK;
+}
+
+HRESULT CNSudoOutputRedirector::DuplicateStandardHandle(
+    _In_ DWORD StandardHandleType,
+    _Out_ PHANDLE DuplicatedHandle)
+{
+    *DuplicatedHandle = INVALID_HANDLE_VALUE;
+
+    HANDLE StandardHandle = ::GetStdHandle(StandardHandleType);
+    if (StandardHandle == INVALID_HANDLE_VALUE || !StandardHandle)
+    {
+        return S_OK;
+    }
+
+    return Mile::HResultFromLastError(::DuplicateHandle(
+        ::GetCurrentProcess(),
+        StandardHandle,
+        ::GetCurrentProcess(),
+        DuplicatedHandle,
+        0,
+        TRUE,
+        DUPLICATE_SAME_ACCESS));
+}
+
+void CNSudoOutputRedirector::RelayStream(
+    _In_ StreamContext& Stream)
+{
+    HANDLE EventHandle = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    LPVOID Buffer = Mile::HeapMemory::Allocate(this->m_BufferSize);
+
+    if (EventHandle && Buffer)
+    {
+        auto Reader = [&](void* Buffer, std::size_t Size) -> std::size_t
+        {
+            for (;;)
+            {
+                if (::InterlockedCompareExchange(&this->m_Canceled, 0, 0))
+                {
+                    return 0;
+                }
+
+                OVERLAPPED Overlapped = { 0 };
+                Overlapped.hEvent = EventHandle;
+
+                if (!::ReadFile(
+                    Stream.ReadHandle,
+                    Buffer,
+                    static_cast<DWORD>(Size),
+                    nullptr,
+                    &Overlapped))
+                {
+                    if (::GetLastError() != ERROR_IO_PENDING)
+                    {
+                        // ERROR_BROKEN_PIPE means the end of the stream.
+                        return 0;
+                    }
+                }
+
+                DWORD NumberOfBytesRead = 0;
+                if (!::GetOverlappedResult(
+                    Stream.ReadHandle,
+                    &Overlapped,
+                    &NumberOfBytesRead,
+                    TRUE))
+                {
+                    return 0;
+                }
+
+                // Skip the zero-byte writes from the child process.
+                if (NumberOfBytesRead)
+                {
+                    return NumberOfBytesRead;
+                }
+            }
+        };
+
+        auto Sink = [&](const void* Buffer, std::size_t Size) -> bool
+        {
+            return this->Deliver(
+                Stream.StreamType,
+                Buffer,
+                static_cast<DWORD>(Size));
+        };
+
+        ::NSudoRelayOutput(Reader, Sink, Buffer, this->m_BufferSize);
+    }
+
+    if (Buffer)
+    {
+        Mile::HeapMemory::Free(Buffer);
+    }
+
+    if (EventHandle)
+    {
+        ::CloseHandle(EventHandle);
+    }
+}
+
+void CNSudoOutputRedirector::Cancel()
+{
+    ::InterlockedExchange(&this->m_Canceled, TRUE);
+
+    // The relay thread blocked in CNSudoOutputRing::Write waits on a
+    // condition variable, which CancelIoEx cannot wake up.
+    if (this->m_SinkType == NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER)
+    {
+        this->m_Ring->Close();
+    }
+
+    for (StreamContext& Stream : this->m_Streams)
+    {
+        if (Stream.ThreadHandle)
+        {
+            ::CancelIoEx(Stream.ReadHandle, nullptr);
+
+            // Wakes up the relay thread blocked in writing the file sink.
+            ::CancelSynchronousIo(Stream.ThreadHandle);
+        }
+    }
+}
+
+bool CNSudoOutputRedirector::Deliver(
+    _In_ NSUDO_OUTPUT_STREAM_TYPE StreamType,
+    _In_ LPCVOID Buffer,
+    _In_ DWORD Size)
+{
+    Mile::AutoCriticalSectionLock Lock(this->m_SinkLock);
+
+    switch (this->m_SinkType)
+    {
+    case NSUDO_OUTPUT_SINK_TYPE::CALLBACK_FUNCTION:
+    {
+        this->m_Callback(this->m_CallbackContext, StreamType, Buffer, Size);
+        return true;
+    }
+    case NSUDO_OUTPUT_SINK_TYPE::FILE_HANDLE:
+    {
+        const BYTE* Current = reinterpret_cast<const BYTE*>(Buffer);
+        while (Size)
+        {
+            DWORD NumberOfBytesWritten = 0;
+            if (!::WriteFile(
+                this->m_FileHandle,
+                Current,
+                Size,
+                &NumberOfBytesWritten,
+                nullptr))
+            {
+                return false;
+            }
+
+            Current += NumberOfBytesWritten;
+            Size -= NumberOfBytesWritten;
+        }
+
+        return true;
+    }
+    case NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER:
+    {
+        return this->m_Ring->Write(Buffer, Size);
+    }
+    default:
+        return false;
+    }
+}
+
+HRESULT CNSudoOutputRedirector::Initialize(
+    _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options)
+{
+    if (!Options || Options->OutputSinkType == NSUDO_OUTPUT_SINK_TYPE::NONE)
+    {
+        return S_OK;
+    }
+
+    switch (Options->OutputSinkType)
+    {
+    case NSUDO_OUTPUT_SINK_TYPE::CALLBACK_FUNCTION:
+        if (!Options->OutputCallback)
+        {
+            return E_INVALIDARG;
+        }
+        break;
+    case NSUDO_OUTPUT_SINK_TYPE::FILE_HANDLE:
+        if (!Options->OutputFileHandle ||
+            Options->OutputFileHandle == INVALID_HANDLE_VALUE)
+        {
+            return E_INVALIDARG;
+        }
+        break;
+    case NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER:
+        if (!Options->OutputRingHandle)
+        {
+            return E_INVALIDARG;
+        }
+        break;
+    default:
+        return E_INVALIDARG;
+    }
+
+    if (!Options->RedirectStandardOutput && !Options->RedirectStandardError)
+    {
+        return S_OK;
+    }
+
+    this->m_SinkType = Options->OutputSinkType;
+    this->m_Callback = Options->OutputCallback;
+    this->m_CallbackContext = Options->OutputCallbackContext;
+    this->m_FileHandle = Options->OutputFileHandle;
+    if (Options->OutputRingHandle)
+    {
+        this->m_Ring = Options->OutputRingHandle->Ring;
+    }
+    if (Options->OutputPipeBufferSize)
+    {
+        this->m_BufferSize = Options->OutputPipeBufferSize;
+    }
+
+    HRESULT hr = S_OK;
+
+    if (Options->RedirectStandardOutput)
+    {
+        hr = this->CreatePipe(this->m_Streams[0]);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+        this->m_StandardOutput = this->m_Streams[0].WriteHandle;
+        this->m_Streams[0].WriteHandle = INVALID_HANDLE_VALUE;
+    }
+    else
+    {
+        hr = CNSudoOutputRedirector::DuplicateStandardHandle(
+            STD_OUTPUT_HANDLE,
+            &this->m_StandardOutput);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    if (Options->RedirectStandardError)
+    {
+        hr = this->CreatePipe(this->m_Streams[1]);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+        this->m_StandardError = this->m_Streams[1].WriteHandle;
+        this->m_Streams[1].WriteHandle = INVALID_HANDLE_VALUE;
+    }
+    else
+    {
+        hr = CNSudoOutputRedirector::DuplicateStandardHandle(
+            STD_ERROR_HANDLE,
+            &this->m_StandardError);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+    }
+
+    hr = CNSudoOutputRedirector::DuplicateStandardHandle(
+        STD_INPUT_HANDLE,
+        &this->m_StandardInput);
+    if (hr != S_OK)
+    {
+        return hr;
+    }
+
+    for (HANDLE StandardHandle : {
+        this->m_StandardInput,
+        this->m_StandardOutput,
+        this->m_StandardError })
+    {
+        if (StandardHandle != INVALID_HANDLE_VALUE)
+        {
+            this->m_InheritedHandles.push_back(StandardHandle);
+        }
+    }
+
+    return S_OK;
+}
+
+bool CNSudoOutputRedirector::IsEnabled() const
+{
+    return this->m_SinkType != NSUDO_OUTPUT_SINK_TYPE::NONE;
+}
+
+void CNSudoOutputRedirector::FillStartupInfo(
+    _Inout_ LPSTARTUPINFOW StartupInfo)
+{
+    if (!this->IsEnabled())
+    {
+        return;
+    }
+
+    StartupInfo->dwFlags |= STARTF_USESTDHANDLES;
+    StartupInfo->hStdInput = this->m_StandardInput;
+    StartupInfo->hStdOutput = this->m_StandardOutput;
+    StartupInfo->hStdError = this->m_StandardError;
+}
+
+std::vector<HANDLE>& CNSudoOutputRedirector::GetInheritedHandles()
+{
+    return this->m_InheritedHandles;
+}
+
+HRESULT CNSudoOutputRedirector::Start()
+{
+    if (!this->IsEnabled())
+    {
+        return S_OK;
+    }
+
+    // The child process owns the write ends now, the relay sees the end of
+    // the stream when the child process and its descendants close them.
+    PHANDLE StandardHandles[] =
+    {
+        &this->m_StandardInput,
+        &this->m_StandardOutput,
+        &this->m_StandardError
+    };
+    for (PHANDLE StandardHandle : StandardHandles)
+    {
+        if (*StandardHandle != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(*StandardHandle);
+            *StandardHandle = INVALID_HANDLE_VALUE;
+        }
+    }
+    this->m_InheritedHandles.clear();
+
+    for (StreamContext& Stream : this->m_Streams)
+    {
+        if (Stream.ReadHandle == INVALID_HANDLE_VALUE)
+        {
+            continue;
+        }
+
+        StreamContext* Current = &Stream;
+        Stream.ThreadHandle = Mile::CreateThread([this, Current]()
+        {
+            this->RelayStream(*Current);
+        });
+        if (!Stream.ThreadHandle)
+        {
+            return Mile::HResult::FromWin32(::GetLastError());
+        }
+    }
+
+    return S_OK;
+}
+
+void CNSudoOutputRedirector::Wait(
+    _In_ DWORD Timeout)
+{
+    HANDLE ThreadHandles[2];
+    DWORD ThreadCount = 0;
+
+    for (StreamContext& Stream : this->m_Streams)
+    {
+        if (Stream.ThreadHandle)
+        {
+            ThreadHandles[ThreadCount++] = Stream.ThreadHandle;
+        }
+    }
+
+    if (ThreadCount)
+    {
+        if (WAIT_TIMEOUT == ::WaitForMultipleObjectsEx(
+            ThreadCount, ThreadHandles, TRUE, Timeout, FALSE))
+        {
+            // Retry the cancellation in case a relay thread was delivering a
+            // chunk and started a new read after the previous cancellation.
+            // Only a callback sink which never returns can keep the relay
+            // thread running after that, and it is waited for without
+            // retrying.
+            const DWORD MaximumCancelAttempts = 10;
+            DWORD CancelAttempts = 0;
+            do
+            {
+                this->Cancel();
+            } while (++CancelAttempts < MaximumCancelAttempts &&
+                WAIT_TIMEOUT == ::WaitForMultipleObjectsEx(
+                    ThreadCount, ThreadHandles, TRUE, 100, FALSE));
+
+            if (CancelAttempts >= MaximumCancelAttempts)
+            {
+                ::WaitForMultipleObjectsEx(
+                    ThreadCount, ThreadHandles, TRUE, INFINITE, FALSE);
+            }
+        }
+
+        for (StreamContext& Stream : this->m_Streams)
+        {
+            if (Stream.ThreadHandle)
+            {
+                ::CloseHandle(Stream.ThreadHandle);
+                Stream.ThreadHandle = nullptr;
+            }
+        }
+    }
+
+    if (this->m_SinkType == NSUDO_OUTPUT_SINK_TYPE::RING_BUFFER)
+    {
+        this->m_Ring->Complete();
+    }
+}
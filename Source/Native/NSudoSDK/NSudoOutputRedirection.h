@@ -0,0 +1,176 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoOutputRedirection.h
+ * PURPOSE:   Definition for NSudo child process output redirection
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_OUTPUT_REDIRECTION
+#define NSUDO_OUTPUT_REDIRECTION
+
+#ifndef __cplusplus
+#error "[NSudoOutputRedirection] You should use a C++ compiler."
+#endif
+
+#include "NSudoAPI.h"
+
+#include <Mile.Windows.h>
+
+#include "NSudoOutputRelay.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The memory ring behind NSUDO_OUTPUT_RING_HANDLE. The ring is shared
+ *        with the redirectors which write to it, so it is kept alive until
+ *        their relay threads have exited even if the handle is closed first.
+*/
+struct _NSUDO_OUTPUT_RING
+{
+    std::shared_ptr<CNSudoOutputRing> Ring;
+};
+
+/**
+ * @brief Redirects the standard output and the standard error of the child
+ *        process to the sink specified in the launch options. Each redirected
+ *        stream has an overlapped named pipe with a large buffer and a relay
+ *        thread which forwards the chunks to the sink.
+*/
+class CNSudoOutputRedirector :
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    /**
+     * @brief The state of a redirected stream.
+    */
+    struct StreamContext
+    {
+        NSUDO_OUTPUT_STREAM_TYPE StreamType;
+        HANDLE ReadHandle = INVALID_HANDLE_VALUE;
+        HANDLE WriteHandle = INVALID_HANDLE_VALUE;
+        HANDLE ThreadHandle = nullptr;
+    };
+
+    NSUDO_OUTPUT_SINK_TYPE m_SinkType = NSUDO_OUTPUT_SINK_TYPE::NONE;
+    NSUDO_OUTPUT_CALLBACK_TYPE m_Callback = nullptr;
+    LPVOID m_CallbackContext = nullptr;
+    HANDLE m_FileHandle = INVALID_HANDLE_VALUE;
+    std::shared_ptr<CNSudoOutputRing> m_Ring;
+    DWORD m_BufferSize = NSUDO_DEFAULT_OUTPUT_PIPE_BUFFER_SIZE;
+
+    Mile::CriticalSection m_SinkLock;
+    volatile LONG m_Canceled = FALSE;
+
+    StreamContext m_Streams[2];
+    HANDLE m_StandardInput = INVALID_HANDLE_VALUE;
+    HANDLE m_StandardOutput = INVALID_HANDLE_VALUE;
+    HANDLE m_StandardError = INVALID_HANDLE_VALUE;
+    std::vector<HANDLE> m_InheritedHandles;
+
+    /**
+     * @brief Creates the overlapped named pipe for a redirected stream.
+     * @param Stream The redirected stream.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT CreatePipe(
+        _Inout_ StreamContext& Stream);
+
+    /**
+     * @brief Creates the inheritable duplicate of a standard handle of the
+     *        current process for the stream which is not redirected.
+     * @param StandardHandleType The standard handle type for GetStdHandle.
+     * @param DuplicatedHandle The inheritable duplicate of the standard
+     *                         handle, or INVALID_HANDLE_VALUE if the current
+     *                         process has no such handle.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    static HRESULT DuplicateStandardHandle(
+        _In_ DWORD StandardHandleType,
+        _Out_ PHANDLE DuplicatedHandle);
+
+    /**
+     * @brief Relays a redirected stream to the sink until the end of the
+     *        stream or the cancellation.
+     * @param Stream The redirected stream.
+    */
+    void RelayStream(
+        _In_ StreamContext& Stream);
+
+    /**
+     * @brief Stops the relay threads. The pending reads are canceled, and the
+     *        ring sink is closed, which wakes up the relay thread waiting for
+     *        the space of the ring.
+    */
+    void Cancel();
+
+    /**
+     * @brief Delivers a chunk to the sink. The deliveries are serialized.
+     * @param StreamType The stream which the chunk comes from.
+     * @param Buffer The chunk.
+     * @param Size The size of the chunk, in bytes.
+     * @return true if the relay should continue, false otherwise.
+    */
+    bool Deliver(
+        _In_ NSUDO_OUTPUT_STREAM_TYPE StreamType,
+        _In_ LPCVOID Buffer,
+        _In_ DWORD Size);
+
+public:
+
+    CNSudoOutputRedirector();
+
+    ~CNSudoOutputRedirector();
+
+    /**
+     * @brief Validates the launch options and creates the pipes for the
+     *        redirected streams.
+     * @param Options The launch options, can be nullptr.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Initialize(
+        _In_opt_ PNSUDO_CREATE_PROCESS_OPTIONS Options);
+
+    /**
+     * @brief Gets whether any stream is redirected.
+     * @return true if any stream is redirected, false otherwise.
+    */
+    bool IsEnabled() const;
+
+    /**
+     * @brief Fills the standard handles of the startup information.
+     * @param StartupInfo The startup information of the child process.
+    */
+    void FillStartupInfo(
+        _Inout_ LPSTARTUPINFOW StartupInfo);
+
+    /**
+     * @brief Gets the handles which should be inherited by the child process,
+     *        suitable for PROC_THREAD_ATTRIBUTE_HANDLE_LIST.
+     * @return The handles which should be inherited by the child process.
+    */
+    std::vector<HANDLE>& GetInheritedHandles();
+
+    /**
+     * @brief Closes the handles inherited by the child process and starts the
+     *        relay threads. It should be called after the child process is
+     *        created.
+     * @return HRESULT. If the function succeeds, the return value is S_OK.
+    */
+    HRESULT Start();
+
+    /**
+     * @brief Waits for the relay threads. If they do not finish in time, the
+     *        pending reads will be canceled.
+     * @param Timeout The time-out interval, in milliseconds.
+    */
+    void Wait(
+        _In_ DWORD Timeout);
+};
+
+#endif // !NSUDO_OUTPUT_REDIRECTION
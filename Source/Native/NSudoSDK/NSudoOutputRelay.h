@@ -0,0 +1,244 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoOutputRelay.h
+ * PURPOSE:   Definition for NSudo output relay core (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_OUTPUT_RELAY
+#define NSUDO_OUTPUT_RELAY
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L)
+#elif (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#else
+#error "[NSudoOutputRelay] You should use a C++ compiler with the C++14 standard."
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A bounded byte ring which is filled by the output relay and drained
+ *        by the consumer. The writer blocks when the ring is full, so the
+ *        child process is throttled instead of losing output.
+*/
+class CNSudoOutputRing
+{
+private:
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Readable;
+    std::condition_variable m_Writable;
+
+    std::vector<std::uint8_t> m_Buffer;
+    std::uint64_t m_ReadOffset = 0;
+    std::uint64_t m_WriteOffset = 0;
+    bool m_Completed = false;
+    bool m_Closed = false;
+
+public:
+
+    /**
+     * @brief Creates the ring.
+     * @param Capacity The capacity of the ring, in bytes.
+    */
+    explicit CNSudoOutputRing(
+        std::size_t Capacity) :
+        m_Buffer(Capacity ? Capacity : 1)
+    {
+    }
+
+    CNSudoOutputRing(const CNSudoOutputRing&) = delete;
+    CNSudoOutputRing& operator=(const CNSudoOutputRing&) = delete;
+
+    /**
+     * @brief Appends the data to the ring, waits until there is enough space
+     *        if the ring is full.
+     * @param Data The data to append.
+     * @param Size The size of the data, in bytes.
+     * @return true if all data is appended, false if the consumer closed the
+     *         ring.
+    */
+    bool Write(
+        const void* Data,
+        std::size_t Size)
+    {
+        const std::uint8_t* Current =
+            reinterpret_cast<const std::uint8_t*>(Data);
+        const std::size_t Capacity = this->m_Buffer.size();
+
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+
+        while (Size)
+        {
+            this->m_Writable.wait(Lock, [&]()
+            {
+                return this->m_Closed ||
+                    this->m_WriteOffset - this->m_ReadOffset < Capacity;
+            });
+            if (this->m_Closed)
+            {
+                return false;
+            }
+
+            std::size_t Available = static_cast<std::size_t>(
+                Capacity - (this->m_WriteOffset - this->m_ReadOffset));
+            std::size_t Position = static_cast<std::size_t>(
+                this->m_WriteOffset % Capacity);
+            std::size_t Contiguous = Capacity - Position;
+
+            std::size_t Length = Size < Available ? Size : Available;
+            if (Length > Contiguous)
+            {
+                Length = Contiguous;
+            }
+
+            std::memcpy(&this->m_Buffer[Position], Current, Length);
+
+            this->m_WriteOffset += Length;
+            Current += Length;
+            Size -= Length;
+
+            this->m_Readable.notify_all();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Reads the data from the ring.
+     * @param Data The buffer which receives the data.
+     * @param Size The size of the buffer, in bytes.
+     * @param Timeout The time-out interval for waiting the data.
+     * @param Completed Set to true if there is no data left and the writer
+     *                  has completed.
+     * @return The number of bytes read.
+    */
+    std::size_t Read(
+        void* Data,
+        std::size_t Size,
+        std::chrono::milliseconds Timeout,
+        bool& Completed)
+    {
+        std::uint8_t* Current = reinterpret_cast<std::uint8_t*>(Data);
+        const std::size_t Capacity = this->m_Buffer.size();
+
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+
+        this->m_Readable.wait_for(Lock, Timeout, [&]()
+        {
+            return this->m_Completed ||
+                this->m_WriteOffset != this->m_ReadOffset;
+        });
+
+        std::size_t Total = 0;
+
+        while (Size && this->m_WriteOffset != this->m_ReadOffset)
+        {
+            std::size_t Available = static_cast<std::size_t>(
+                this->m_WriteOffset - this->m_ReadOffset);
+            std::size_t Position = static_cast<std::size_t>(
+                this->m_ReadOffset % Capacity);
+            std::size_t Contiguous = Capacity - Position;
+
+            std::size_t Length = Size < Available ? Size : Available;
+            if (Length > Contiguous)
+            {
+                Length = Contiguous;
+            }
+
+            std::memcpy(Current, &this->m_Buffer[Position], Length);
+
+            this->m_ReadOffset += Length;
+            Current += Length;
+            Size -= Length;
+            Total += Length;
+        }
+
+        Completed =
+            this->m_Completed && this->m_WriteOffset == this->m_ReadOffset;
+
+        if (Total)
+        {
+            this->m_Writable.notify_all();
+        }
+
+        return Total;
+    }
+
+    /**
+     * @brief Marks that the writer will not append data anymore.
+    */
+    void Complete()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->m_Completed = true;
+        this->m_Readable.notify_all();
+    }
+
+    /**
+     * @brief Marks that the consumer will not read data anymore, and wakes
+     *        up the blocked writer.
+    */
+    void Close()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->m_Closed = true;
+        this->m_Writable.notify_all();
+    }
+};
+
+/**
+ * @brief Relays a stream to a sink chunk by chunk. The chunks are passed to
+ *        the sink in the buffer they were read into, and they are not split
+ *        by lines.
+ * @tparam ReaderType The reader type, the signature should be
+ *                    std::size_t(void* Buffer, std::size_t Size), which
+ *                    returns 0 at the end of the stream.
+ * @tparam SinkType The sink type, the signature should be
+ *                  bool(const void* Buffer, std::size_t Size), which returns
+ *                  false to stop the relay.
+ * @param Reader The reader.
+ * @param Sink The sink.
+ * @param Buffer The relay buffer.
+ * @param BufferSize The size of the relay buffer, in bytes.
+ * @return The number of bytes relayed.
+*/
+template<typename ReaderType, typename SinkType>
+std::uint64_t NSudoRelayOutput(
+    ReaderType&& Reader,
+    SinkType&& Sink,
+    void* Buffer,
+    std::size_t BufferSize)
+{
+    std::uint64_t Total = 0;
+
+    for (;;)
+    {
+        std::size_t Length = Reader(Buffer, BufferSize);
+        if (!Length)
+        {
+            break;
+        }
+
+        if (!Sink(static_cast<const void*>(Buffer), Length))
+        {
+            break;
+        }
+
+        Total += Length;
+    }
+
+    return Total;
+}
+
+#endif // !NSUDO_OUTPUT_RELAY
@@ -0,0 +1,309 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoServiceTokenPrewarmer.h
+ * PURPOSE:   Definition for NSudo service access token prewarmer
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_SERVICE_TOKEN_PREWARMER
+#define NSUDO_SERVICE_TOKEN_PREWARMER
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief The operations on a service which are needed by the service access
+ *        token prewarmer. The interface only depends on the C++ standard
+ *        library, so the prewarmer can be driven by a fake service.
+ * @tparam TokenType The type of the access token.
+*/
+template<typename TokenType>
+class INSudoServiceController
+{
+public:
+
+    virtual ~INSudoServiceController() = default;
+
+    /**
+     * @brief Starts the service if it is not running, waits for it to run and
+     *        opens the access token of the service process.
+     * @param Token Receives the access token of the service process.
+     * @return True if the access token is opened.
+    */
+    virtual bool StartAndOpenToken(
+        TokenType& Token) = 0;
+
+    /**
+     * @brief Waits for the service process which owns the access token to
+     *        stop.
+     * @param Timeout The time-out interval.
+     * @return True if the service process is stopped, false if the time-out
+     *         interval elapses or the wait is canceled.
+    */
+    virtual bool WaitForStop(
+        std::chrono::milliseconds Timeout) = 0;
+
+    /**
+     * @brief Wakes up the pending and the following WaitForStop calls, it is
+     *        called from another thread when the prewarmer is stopping.
+    */
+    virtual void CancelWait() = 0;
+
+    /**
+     * @brief Duplicates the access token for a launch.
+     * @param Token The access token.
+     * @param DuplicatedToken Receives the duplicated access token.
+     * @return True if the access token is duplicated.
+    */
+    virtual bool DuplicateToken(
+        TokenType const& Token,
+        TokenType& DuplicatedToken) = 0;
+
+    /**
+     * @brief Closes the access token.
+     * @param Token The access token.
+    */
+    virtual void CloseToken(
+        TokenType& Token) = 0;
+
+    /**
+     * @brief Called on the prewarm thread before the first operation and
+     *        after the last operation, e.g. for impersonating the context
+     *        which is needed by the operations.
+     * @param Entering True before the first operation, false after the last
+     *                 operation.
+    */
+    virtual void OnThreadContext(
+        bool Entering) = 0;
+};
+
+/**
+ * @brief The state of the service access token prewarmer.
+*/
+enum class NSUDO_SERVICE_TOKEN_PREWARM_STATE
+{
+    STOPPED,
+    STARTING,
+    READY,
+    RETRY_WAITING,
+};
+
+/**
+ * @brief Keeps a ready access token of a service. A background thread starts
+ *        the service and opens its access token, waits for the service to
+ *        stop and then opens the access token again. The launch path takes a
+ *        duplicate of the ready access token instead of starting the service
+ *        by itself.
+ * @tparam TokenType The type of the access token.
+*/
+template<typename TokenType>
+class CNSudoServiceTokenPrewarmer
+{
+private:
+
+    INSudoServiceController<TokenType>* m_Controller;
+    std::chrono::milliseconds m_PollInterval;
+    std::chrono::milliseconds m_RetryInterval;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_StateChanged;
+    NSUDO_SERVICE_TOKEN_PREWARM_STATE m_State =
+        NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED;
+    bool m_StopRequested = false;
+    bool m_HasToken = false;
+    TokenType m_Token = TokenType();
+    std::thread m_Thread;
+
+    void SetState(
+        NSUDO_SERVICE_TOKEN_PREWARM_STATE State)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            this->m_State = State;
+        }
+        this->m_StateChanged.notify_all();
+    }
+
+    bool IsStopRequested()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return this->m_StopRequested;
+    }
+
+    void ReleaseToken()
+    {
+        TokenType Token;
+        bool HasToken;
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            Token = this->m_Token;
+            HasToken = this->m_HasToken;
+            this->m_Token = TokenType();
+            this->m_HasToken = false;
+        }
+        if (HasToken)
+        {
+            this->m_Controller->CloseToken(Token);
+        }
+    }
+
+    void Run()
+    {
+        this->m_Controller->OnThreadContext(true);
+
+        while (!this->IsStopRequested())
+        {
+            this->SetState(NSUDO_SERVICE_TOKEN_PREWARM_STATE::STARTING);
+
+            TokenType Token = TokenType();
+            if (!this->m_Controller->StartAndOpenToken(Token))
+            {
+                std::unique_lock<std::mutex> Lock(this->m_Mutex);
+                this->m_State = NSUDO_SERVICE_TOKEN_PREWARM_STATE::RETRY_WAITING;
+                this->m_StateChanged.notify_all();
+                this->m_StateChanged.wait_for(
+                    Lock,
+                    this->m_RetryInterval,
+                    [this]() { return this->m_StopRequested; });
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> Lock(this->m_Mutex);
+                this->m_Token = Token;
+                this->m_HasToken = true;
+                this->m_State = NSUDO_SERVICE_TOKEN_PREWARM_STATE::READY;
+            }
+            this->m_StateChanged.notify_all();
+
+            while (!this->IsStopRequested())
+            {
+                if (this->m_Controller->WaitForStop(this->m_PollInterval))
+                {
+                    break;
+                }
+            }
+
+            this->ReleaseToken();
+        }
+
+        this->ReleaseToken();
+
+        this->m_Controller->OnThreadContext(false);
+
+        this->SetState(NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED);
+    }
+
+public:
+
+    /**
+     * @brief Initializes the prewarmer.
+     * @param Controller The service controller.
+     * @param PollInterval The interval for checking the stop request while
+     *                     waiting for the service to stop.
+     * @param RetryInterval The interval before retrying when the service
+     *                      fails to start.
+    */
+    CNSudoServiceTokenPrewarmer(
+        INSudoServiceController<TokenType>* Controller,
+        std::chrono::milliseconds PollInterval,
+        std::chrono::milliseconds RetryInterval) :
+        m_Controller(Controller),
+        m_PollInterval(PollInterval),
+        m_RetryInterval(RetryInterval)
+    {
+    }
+
+    CNSudoServiceTokenPrewarmer(
+        CNSudoServiceTokenPrewarmer const&) = delete;
+
+    CNSudoServiceTokenPrewarmer& operator=(
+        CNSudoServiceTokenPrewarmer const&) = delete;
+
+    ~CNSudoServiceTokenPrewarmer()
+    {
+        this->Stop();
+    }
+
+    /**
+     * @brief Starts the prewarm thread. It does nothing if the prewarm thread
+     *        is already started.
+    */
+    void Start()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        if (this->m_Thread.joinable())
+        {
+            return;
+        }
+
+        this->m_StopRequested = false;
+        this->m_State = NSUDO_SERVICE_TOKEN_PREWARM_STATE::STARTING;
+        this->m_Thread = std::thread([this]() { this->Run(); });
+    }
+
+    /**
+     * @brief Stops the prewarm thread and releases the ready access token.
+    */
+    void Stop()
+    {
+        std::thread Thread;
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            this->m_StopRequested = true;
+            Thread = std::move(this->m_Thread);
+        }
+        this->m_StateChanged.notify_all();
+        this->m_Controller->CancelWait();
+
+        if (Thread.joinable())
+        {
+            Thread.join();
+        }
+    }
+
+    /**
+     * @brief Gets the state of the prewarmer.
+     * @return The state of the prewarmer.
+    */
+    NSUDO_SERVICE_TOKEN_PREWARM_STATE GetState()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return this->m_State;
+    }
+
+    /**
+     * @brief Takes a duplicate of the ready access token. If the prewarm
+     *        thread is starting the service, it waits for the access token.
+     * @param Token Receives the duplicated access token.
+     * @param Timeout The maximum time for waiting the access token.
+     * @return True if the duplicated access token is taken, false if the
+     *         caller needs to open the access token by itself.
+    */
+    bool TryAcquire(
+        TokenType& Token,
+        std::chrono::milliseconds Timeout)
+    {
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+
+        this->m_StateChanged.wait_for(Lock, Timeout, [this]()
+        {
+            return this->m_State != NSUDO_SERVICE_TOKEN_PREWARM_STATE::STARTING;
+        });
+
+        if (this->m_State != NSUDO_SERVICE_TOKEN_PREWARM_STATE::READY ||
+            !this->m_HasToken)
+        {
+            return false;
+        }
+
+        return this->m_Controller->DuplicateToken(this->m_Token, Token);
+    }
+};
+
+#endif // !NSUDO_SERVICE_TOKEN_PREWARMER
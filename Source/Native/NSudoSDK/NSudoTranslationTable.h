@@ -0,0 +1,758 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoTranslationTable.h
+ * PURPOSE:   Definition for NSudo frozen translation table
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_TRANSLATION_TABLE
+#define NSUDO_TRANSLATION_TABLE
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The magic number of the compiled translation table, "NSTT".
+*/
+#define NSUDO_TRANSLATION_TABLE_MAGIC 0x5454534EU
+
+/**
+ * @brief The version of the compiled translation table layout.
+*/
+#define NSUDO_TRANSLATION_TABLE_VERSION 1U
+
+/**
+ * @brief The header of the compiled translation table. It is followed by the
+ *        entries sorted by the keys, the hash buckets, the value pool and the
+ *        key pool. The layout is only produced by
+ *        CNSudoTranslationTableBuilder, both at runtime and at build time
+ *        through NSudoTranslationCompiler.
+*/
+struct NSudoTranslationTableHeader
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+    std::uint32_t EntryCount;
+    std::uint32_t BucketCount;
+    std::uint32_t ValuePoolLength; // In UTF-16 code units.
+    std::uint32_t KeyPoolSize; // In bytes.
+};
+
+/**
+ * @brief An entry of the compiled translation table. The values are UTF-16
+ *        strings in the value pool, each followed by a null character. The
+ *        keys are UTF-8 strings in the key pool.
+*/
+struct NSudoTranslationTableEntry
+{
+    std::uint32_t Hash;
+    std::uint32_t KeyOffset;
+    std::uint32_t KeyLength;
+    std::uint32_t ValueOffset;
+    std::uint32_t ValueLength;
+};
+
+/**
+ * @brief Computes the hash of a key of the translation table, which is the
+ *        32-bit FNV-1a hash of the UTF-8 key.
+ * @param Key The UTF-8 key.
+ * @return The hash of the key.
+*/
+inline std::uint32_t NSudoHashTranslationKey(
+    std::string_view Key)
+{
+    std::uint32_t Hash = 2166136261U;
+    for (char const& Character : Key)
+    {
+        Hash ^= static_cast<std::uint8_t>(Character);
+        Hash *= 16777619U;
+    }
+    return Hash;
+}
+
+/**
+ * @brief Appends the UTF-8 string to the UTF-16 string. The invalid UTF-8
+ *        sequences are replaced with U+FFFD, the same as MultiByteToWideChar.
+ * @param Output The UTF-16 string.
+ * @param Input The UTF-8 string.
+*/
+inline void NSudoAppendUtf8AsUtf16(
+    std::u16string& Output,
+    std::string_view Input)
+{
+    std::size_t Index = 0;
+    while (Index < Input.size())
+    {
+        std::uint8_t Lead = static_cast<std::uint8_t>(Input[Index]);
+        if (Lead < 0x80)
+        {
+            Output.push_back(static_cast<char16_t>(Lead));
+            ++Index;
+            continue;
+        }
+
+        std::size_t Length = 0;
+        std::uint32_t CodePoint = 0;
+        std::uint32_t Minimum = 0;
+        if (Lead >= 0xC2 && Lead <= 0xDF)
+        {
+            Length = 2;
+            CodePoint = Lead & 0x1F;
+            Minimum = 0x80;
+        }
+        else if (Lead >= 0xE0 && Lead <= 0xEF)
+        {
+            Length = 3;
+            CodePoint = Lead & 0x0F;
+            Minimum = 0x800;
+        }
+        else if (Lead >= 0xF0 && Lead <= 0xF4)
+        {
+            Length = 4;
+            CodePoint = Lead & 0x07;
+            Minimum = 0x10000;
+        }
+
+        std::size_t Current = 1;
+        for (; Length && Current < Length; ++Current)
+        {
+            if (Index + Current >= Input.size())
+            {
+                break;
+            }
+            std::uint8_t Trail =
+                static_cast<std::uint8_t>(Input[Index + Current]);
+            if ((Trail & 0xC0) != 0x80)
+            {
+                break;
+            }
+            CodePoint = (CodePoint << 6) | (Trail & 0x3F);
+        }
+
+        if (!Length ||
+            Current != Length ||
+            CodePoint < Minimum ||
+            CodePoint > 0x10FFFF ||
+            (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+        {
+            // Skip the lead byte and the valid trail bytes of the invalid
+            // sequence.
+            Output.push_back(static_cast<char16_t>(0xFFFD));
+            Index += Current;
+            continue;
+        }
+
+        if (CodePoint >= 0x10000)
+        {
+            CodePoint -= 0x10000;
+            Output.push_back(
+                static_cast<char16_t>(0xD800 + (CodePoint >> 10)));
+            Output.push_back(
+                static_cast<char16_t>(0xDC00 + (CodePoint & 0x3FF)));
+        }
+        else
+        {
+            Output.push_back(static_cast<char16_t>(CodePoint));
+        }
+        Index += Length;
+    }
+}
+
+/**
+ * @brief The frozen translation table. It is backed by a compiled translation
+ *        table, which is either attached in place from a resource without
+ *        parsing, converting or copying, or serialized by
+ *        CNSudoTranslationTableBuilder. The UTF-8 values added by the builder
+ *        are converted to UTF-16 when they are looked up for the first time,
+ *        and the result is published to the entry atomically. The table is
+ *        not changed by the lookups otherwise, so it can be read from any
+ *        number of threads at the same time without locks. The values are
+ *        stored as char16_t, so the table is portable, and they are viewed
+ *        as wchar_t at the Windows boundary.
+*/
+class CNSudoTranslationTable
+{
+private:
+
+    friend class CNSudoTranslationTableBuilder;
+
+    std::vector<std::uint8_t> m_OwnedTable;
+    const std::uint8_t* m_Table = nullptr;
+
+    struct LazyValue
+    {
+        bool Utf8 = false;
+        std::atomic<std::u16string*> Value{ nullptr };
+
+        ~LazyValue()
+        {
+            delete this->Value.load(std::memory_order_relaxed);
+        }
+    };
+
+    // The UTF-8 values and their conversion slots, which are indexed by the
+    // entries. The slots are only allocated if the table has UTF-8 values.
+    std::string m_Utf8ValuePool;
+    std::unique_ptr<LazyValue[]> m_LazyValues;
+
+    const NSudoTranslationTableHeader* GetHeader() const
+    {
+        return reinterpret_cast<const NSudoTranslationTableHeader*>(
+            this->m_Table);
+    }
+
+    const NSudoTranslationTableEntry* GetEntries() const
+    {
+        return reinterpret_cast<const NSudoTranslationTableEntry*>(
+            this->m_Table + sizeof(NSudoTranslationTableHeader));
+    }
+
+    const std::uint32_t* GetBuckets() const
+    {
+        return reinterpret_cast<const std::uint32_t*>(
+            this->GetEntries() + this->GetHeader()->EntryCount);
+    }
+
+    const char16_t* GetValuePool() const
+    {
+        return reinterpret_cast<const char16_t*>(
+            this->GetBuckets() + this->GetHeader()->BucketCount);
+    }
+
+    const char* GetKeyPool() const
+    {
+        return reinterpret_cast<const char*>(
+            this->GetValuePool() + this->GetHeader()->ValuePoolLength);
+    }
+
+public:
+
+    /**
+     * @brief Checks the layout of a compiled translation table. The offsets
+     *        of the entries are checked when they are looked up.
+     * @param Table The compiled translation table.
+     * @param TableSize The size of the compiled translation table, in bytes.
+     * @return True if the layout is valid.
+    */
+    static bool CheckLayout(
+        const void* Table,
+        std::size_t TableSize)
+    {
+        if (!Table ||
+            TableSize < sizeof(NSudoTranslationTableHeader) ||
+            reinterpret_cast<std::uintptr_t>(Table) % sizeof(std::uint32_t))
+        {
+            return false;
+        }
+
+        const NSudoTranslationTableHeader* Header =
+            reinterpret_cast<const NSudoTranslationTableHeader*>(Table);
+        if (Header->Magic != NSUDO_TRANSLATION_TABLE_MAGIC ||
+            Header->Version != NSUDO_TRANSLATION_TABLE_VERSION)
+        {
+            return false;
+        }
+
+        // The bucket count is a power of two with at least one empty bucket,
+        // so the probing always stops.
+        if (!Header->BucketCount ||
+            (Header->BucketCount & (Header->BucketCount - 1)) ||
+            Header->BucketCount <= Header->EntryCount)
+        {
+            return false;
+        }
+
+        std::uint64_t ExpectedSize =
+            sizeof(NSudoTranslationTableHeader) +
+            static_cast<std::uint64_t>(Header->EntryCount) *
+            sizeof(NSudoTranslationTableEntry) +
+            static_cast<std::uint64_t>(Header->BucketCount) *
+            sizeof(std::uint32_t) +
+            static_cast<std::uint64_t>(Header->ValuePoolLength) *
+            sizeof(char16_t) +
+            Header->KeyPoolSize;
+
+        return ExpectedSize == TableSize;
+    }
+
+    /**
+     * @brief Attaches a compiled translation table in place. The previous
+     *        translated strings are released.
+     * @param Table The compiled translation table. It must stay valid until
+     *              the table is cleared, e.g. a resource of a loaded module.
+     *              If it is not aligned to 4 bytes, it is copied.
+     * @param TableSize The size of the compiled translation table, in bytes.
+     * @return True if the compiled translation table is attached.
+    */
+    bool Attach(
+        const void* Table,
+        std::size_t TableSize)
+    {
+        this->Clear();
+
+        if (Table &&
+            reinterpret_cast<std::uintptr_t>(Table) % sizeof(std::uint32_t))
+        {
+            const std::uint8_t* Source =
+                reinterpret_cast<const std::uint8_t*>(Table);
+            this->m_OwnedTable.assign(Source, Source + TableSize);
+            Table = this->m_OwnedTable.data();
+        }
+
+        if (!CNSudoTranslationTable::CheckLayout(Table, TableSize))
+        {
+            this->m_OwnedTable.clear();
+            return false;
+        }
+
+        this->m_Table = reinterpret_cast<const std::uint8_t*>(Table);
+        return true;
+    }
+
+    /**
+     * @brief Gets the translated string.
+     * @param Key The UTF-8 key of the translated string.
+     * @return The UTF-16 translated string, which is followed by a null
+     *         character. If the key is not found, the return value is a
+     *         static empty string.
+    */
+    std::u16string_view FindUtf16(
+        std::string_view Key) const
+    {
+        static const char16_t EmptyString[] = u"";
+
+        if (!this->m_Table)
+        {
+            return std::u16string_view(EmptyString, 0);
+        }
+
+        const NSudoTranslationTableHeader* Header = this->GetHeader();
+        const NSudoTranslationTableEntry* Entries = this->GetEntries();
+        const std::uint32_t* Buckets = this->GetBuckets();
+
+        std::uint32_t Hash = ::NSudoHashTranslationKey(Key);
+        std::uint32_t Mask = Header->BucketCount - 1;
+        for (std::uint32_t Bucket = Hash & Mask;
+            Buckets[Bucket];
+            Bucket = (Bucket + 1) & Mask)
+        {
+            // The buckets hold the index of the entry plus one.
+            std::uint32_t EntryIndex = Buckets[Bucket] - 1;
+            if (EntryIndex >= Header->EntryCount)
+            {
+                break;
+            }
+
+            NSudoTranslationTableEntry const& Entry = Entries[EntryIndex];
+            if (Entry.Hash != Hash ||
+                Entry.KeyLength != Key.size() ||
+                Entry.KeyOffset > Header->KeyPoolSize ||
+                Entry.KeyLength > Header->KeyPoolSize - Entry.KeyOffset ||
+                0 != std::memcmp(
+                    this->GetKeyPool() + Entry.KeyOffset,
+                    Key.data(),
+                    Key.size()))
+            {
+                continue;
+            }
+
+            if (this->m_LazyValues && this->m_LazyValues[EntryIndex].Utf8)
+            {
+                if (Entry.ValueOffset > this->m_Utf8ValuePool.size() ||
+                    Entry.ValueLength >
+                    this->m_Utf8ValuePool.size() - Entry.ValueOffset)
+                {
+                    break;
+                }
+
+                LazyValue& Slot = this->m_LazyValues[EntryIndex];
+                std::u16string* Value =
+                    Slot.Value.load(std::memory_order_acquire);
+                if (!Value)
+                {
+                    // The threads which look up the value at the same time
+                    // convert it on their own and the first one publishes
+                    // its result, so the lookups never wait for each other.
+                    std::unique_ptr<std::u16string> Converted(
+                        new std::u16string());
+                    ::NSudoAppendUtf8AsUtf16(
+                        *Converted,
+                        std::string_view(this->m_Utf8ValuePool).substr(
+                            Entry.ValueOffset,
+                            Entry.ValueLength));
+                    if (Slot.Value.compare_exchange_strong(
+                        Value,
+                        Converted.get(),
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire))
+                    {
+                        Value = Converted.release();
+                    }
+                }
+                return *Value;
+            }
+
+            const char16_t* ValuePool = this->GetValuePool();
+            if (Entry.ValueOffset >= Header->ValuePoolLength ||
+                Entry.ValueLength >=
+                Header->ValuePoolLength - Entry.ValueOffset ||
+                ValuePool[Entry.ValueOffset + Entry.ValueLength])
+            {
+                break;
+            }
+
+            return std::u16string_view(
+                ValuePool + Entry.ValueOffset,
+                Entry.ValueLength);
+        }
+
+        return std::u16string_view(EmptyString, 0);
+    }
+
+#ifdef _WIN32
+    /**
+     * @brief Gets the translated string.
+     * @param Key The UTF-8 key of the translated string.
+     * @return The translated string, which is followed by a null character.
+     *         If the key is not found, the return value is a static empty
+     *         string.
+    */
+    std::wstring_view Find(
+        std::string_view Key) const
+    {
+        static_assert(
+            sizeof(wchar_t) == sizeof(char16_t),
+            "The wide strings are in UTF-16 on Windows.");
+
+        std::u16string_view Value = this->FindUtf16(Key);
+        return std::wstring_view(
+            reinterpret_cast<const wchar_t*>(Value.data()),
+            Value.size());
+    }
+#endif
+
+    /**
+     * @brief Gets the number of the translated strings.
+     * @return The number of the translated strings.
+    */
+    std::size_t GetCount() const
+    {
+        return this->m_Table ? this->GetHeader()->EntryCount : 0;
+    }
+
+    /**
+     * @brief Removes all translated strings.
+    */
+    void Clear()
+    {
+        this->m_OwnedTable.clear();
+        this->m_Table = nullptr;
+        this->m_Utf8ValuePool.clear();
+        this->m_LazyValues.reset();
+    }
+};
+
+/**
+ * @brief Builds the frozen translation table from the translations which are
+ *        parsed at runtime, e.g. the plugins without compiled translations.
+*/
+class CNSudoTranslationTableBuilder
+{
+private:
+
+    struct PendingEntry
+    {
+        NSudoTranslationTableEntry Entry;
+        bool Utf8;
+    };
+
+    std::vector<PendingEntry> m_Entries;
+    std::string m_KeyPool;
+    std::u16string m_ValuePool;
+    std::string m_Utf8ValuePool;
+
+    void AddEntry(
+        std::string_view Key,
+        std::size_t ValueOffset,
+        std::size_t ValueLength,
+        bool Utf8)
+    {
+        PendingEntry Pending;
+        Pending.Entry.Hash = ::NSudoHashTranslationKey(Key);
+        Pending.Entry.KeyOffset =
+            static_cast<std::uint32_t>(this->m_KeyPool.size());
+        Pending.Entry.KeyLength = static_cast<std::uint32_t>(Key.size());
+        Pending.Entry.ValueOffset = static_cast<std::uint32_t>(ValueOffset);
+        Pending.Entry.ValueLength = static_cast<std::uint32_t>(ValueLength);
+        Pending.Utf8 = Utf8;
+        this->m_Entries.push_back(Pending);
+
+        this->m_KeyPool.append(Key);
+    }
+
+    /**
+     * @brief Sorts the entries by the keys, and keeps the first translated
+     *        string of each key, the same as std::map::emplace.
+    */
+    void SortEntries()
+    {
+        std::string_view KeyPool(this->m_KeyPool);
+        auto GetKey = [KeyPool](PendingEntry const& Pending)
+        {
+            return KeyPool.substr(
+                Pending.Entry.KeyOffset,
+                Pending.Entry.KeyLength);
+        };
+
+        std::stable_sort(
+            this->m_Entries.begin(),
+            this->m_Entries.end(),
+            [&GetKey](
+                PendingEntry const& Left,
+                PendingEntry const& Right)
+            {
+                return GetKey(Left) < GetKey(Right);
+            });
+        this->m_Entries.erase(
+            std::unique(
+                this->m_Entries.begin(),
+                this->m_Entries.end(),
+                [&GetKey](
+                    PendingEntry const& Left,
+                    PendingEntry const& Right)
+                {
+                    return GetKey(Left) == GetKey(Right);
+                }),
+            this->m_Entries.end());
+    }
+
+    /**
+     * @brief Writes the sorted entries, the hash buckets, the value pool and
+     *        the key pool in the compiled translation table layout.
+     * @param Output Receives the compiled translation table.
+    */
+    void Serialize(
+        std::vector<std::uint8_t>& Output) const
+    {
+        NSudoTranslationTableHeader Header;
+        Header.Magic = NSUDO_TRANSLATION_TABLE_MAGIC;
+        Header.Version = NSUDO_TRANSLATION_TABLE_VERSION;
+        Header.EntryCount = static_cast<std::uint32_t>(this->m_Entries.size());
+        Header.BucketCount = 1;
+        while (Header.BucketCount <= Header.EntryCount * 2)
+        {
+            Header.BucketCount <<= 1;
+        }
+        Header.ValuePoolLength =
+            static_cast<std::uint32_t>(this->m_ValuePool.size());
+        Header.KeyPoolSize = static_cast<std::uint32_t>(this->m_KeyPool.size());
+
+        std::vector<std::uint32_t> Buckets(Header.BucketCount);
+        std::uint32_t Mask = Header.BucketCount - 1;
+        for (std::uint32_t i = 0; i < Header.EntryCount; ++i)
+        {
+            std::uint32_t Bucket = this->m_Entries[i].Entry.Hash & Mask;
+            while (Buckets[Bucket])
+            {
+                Bucket = (Bucket + 1) & Mask;
+            }
+            Buckets[Bucket] = i + 1;
+        }
+
+        std::size_t EntriesSize =
+            this->m_Entries.size() * sizeof(NSudoTranslationTableEntry);
+        std::size_t BucketsSize = Buckets.size() * sizeof(std::uint32_t);
+        std::size_t ValuePoolSize =
+            this->m_ValuePool.size() * sizeof(char16_t);
+
+        Output.resize(
+            sizeof(NSudoTranslationTableHeader) +
+            EntriesSize +
+            BucketsSize +
+            ValuePoolSize +
+            this->m_KeyPool.size());
+
+        std::uint8_t* Current = Output.data();
+        std::memcpy(Current, &Header, sizeof(Header));
+        Current += sizeof(Header);
+        for (PendingEntry const& Pending : this->m_Entries)
+        {
+            std::memcpy(Current, &Pending.Entry, sizeof(Pending.Entry));
+            Current += sizeof(Pending.Entry);
+        }
+        std::memcpy(Current, Buckets.data(), BucketsSize);
+        Current += BucketsSize;
+        if (ValuePoolSize)
+        {
+            std::memcpy(Current, this->m_ValuePool.data(), ValuePoolSize);
+            Current += ValuePoolSize;
+        }
+        if (!this->m_KeyPool.empty())
+        {
+            std::memcpy(
+                Current,
+                this->m_KeyPool.data(),
+                this->m_KeyPool.size());
+        }
+    }
+
+    void Reset()
+    {
+        this->m_Entries.clear();
+        this->m_KeyPool.clear();
+        this->m_ValuePool.clear();
+        this->m_Utf8ValuePool.clear();
+    }
+
+public:
+
+    /**
+     * @brief Reserves the space for the translated strings.
+     * @param Count The number of the translated strings.
+    */
+    void Reserve(
+        std::size_t Count)
+    {
+        this->m_Entries.reserve(Count);
+    }
+
+    /**
+     * @brief Adds a translated string. If the key has been added, the first
+     *        translated string is kept.
+     * @param Key The UTF-8 key of the translated string.
+     * @param Value The translated string.
+    */
+    void Add(
+        std::string_view Key,
+        std::u16string_view Value)
+    {
+        this->AddEntry(Key, this->m_ValuePool.size(), Value.size(), false);
+
+        // The values are terminated, so they can be returned as C strings.
+        this->m_ValuePool.append(Value);
+        this->m_ValuePool.push_back(u'\0');
+    }
+
+#ifdef _WIN32
+    /**
+     * @brief Adds a translated string. If the key has been added, the first
+     *        translated string is kept.
+     * @param Key The UTF-8 key of the translated string.
+     * @param Value The translated string.
+    */
+    void Add(
+        std::string_view Key,
+        std::wstring_view Value)
+    {
+        static_assert(
+            sizeof(wchar_t) == sizeof(char16_t),
+            "The wide strings are in UTF-16 on Windows.");
+
+        this->Add(Key, std::u16string_view(
+            reinterpret_cast<const char16_t*>(Value.data()),
+            Value.size()));
+    }
+#endif
+
+    /**
+     * @brief Adds a translated string in UTF-8, which is converted to UTF-16
+     *        when it is looked up for the first time. If the key has been
+     *        added, the first translated string is kept.
+     * @param Key The UTF-8 key of the translated string.
+     * @param Value The UTF-8 translated string.
+    */
+    void AddUtf8(
+        std::string_view Key,
+        std::string_view Value)
+    {
+        this->AddEntry(Key, this->m_Utf8ValuePool.size(), Value.size(), true);
+
+        this->m_Utf8ValuePool.append(Value);
+    }
+
+    /**
+     * @brief Serializes the translated strings into the table. The builder is
+     *        emptied.
+     * @param Table The table which receives the translated strings. The
+     *              previous translated strings are released.
+    */
+    void Build(
+        CNSudoTranslationTable& Table)
+    {
+        this->SortEntries();
+
+        Table.Clear();
+        this->Serialize(Table.m_OwnedTable);
+        Table.m_Table = Table.m_OwnedTable.data();
+
+        if (std::any_of(
+            this->m_Entries.begin(),
+            this->m_Entries.end(),
+            [](PendingEntry const& Pending) { return Pending.Utf8; }))
+        {
+            std::size_t EntryCount = this->m_Entries.size();
+            Table.m_LazyValues.reset(
+                new CNSudoTranslationTable::LazyValue[EntryCount]);
+            for (std::size_t i = 0; i < EntryCount; ++i)
+            {
+                Table.m_LazyValues[i].Utf8 = this->m_Entries[i].Utf8;
+            }
+            Table.m_Utf8ValuePool.swap(this->m_Utf8ValuePool);
+        }
+
+        this->Reset();
+    }
+
+    /**
+     * @brief Serializes the translated strings into a compiled translation
+     *        table, e.g. the resources compiled by NSudoTranslationCompiler
+     *        at build time. The UTF-8 translated strings are converted to
+     *        UTF-16, so the compiled translation table can be attached by
+     *        CNSudoTranslationTable::Attach. The builder is emptied.
+     * @param Output Receives the compiled translation table.
+    */
+    void Compile(
+        std::vector<std::uint8_t>& Output)
+    {
+        this->SortEntries();
+
+        std::string_view Utf8ValuePool(this->m_Utf8ValuePool);
+        for (PendingEntry& Pending : this->m_Entries)
+        {
+            if (!Pending.Utf8)
+            {
+                continue;
+            }
+
+            std::size_t ValueOffset = this->m_ValuePool.size();
+            ::NSudoAppendUtf8AsUtf16(
+                this->m_ValuePool,
+                Utf8ValuePool.substr(
+                    Pending.Entry.ValueOffset,
+                    Pending.Entry.ValueLength));
+            Pending.Entry.ValueOffset =
+                static_cast<std::uint32_t>(ValueOffset);
+            Pending.Entry.ValueLength = static_cast<std::uint32_t>(
+                this->m_ValuePool.size() - ValueOffset);
+            Pending.Utf8 = false;
+
+            this->m_ValuePool.push_back(u'\0');
+        }
+
+        this->Serialize(Output);
+
+        this->Reset();
+    }
+};
+
+#endif // !NSUDO_TRANSLATION_TABLE
@@ -0,0 +1,494 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoTranslationToml.h
+ * PURPOSE:   Definition for NSudo flat translation TOML reader
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_TRANSLATION_TOML
+#define NSUDO_TRANSLATION_TOML
+
+#include "NSudoTranslationTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Reads the flat translation TOML files, e.g. Translations.toml of the
+ *        plugins, which only have the string keys and the string values. The
+ *        values without escape sequences are added to the builder directly
+ *        from the content, and the others are decoded in a reusable buffer,
+ *        so no document tree is built. Anything outside the subset makes the
+ *        reader fail instead of guessing, and the caller falls back to toml++.
+*/
+class CNSudoTranslationTomlReader
+{
+private:
+
+    std::string_view m_Content;
+    std::size_t m_Position = 0;
+    std::string m_KeyBuffer;
+    std::string m_ValueBuffer;
+
+    bool IsEnd() const
+    {
+        return this->m_Position >= this->m_Content.size();
+    }
+
+    char GetCurrent() const
+    {
+        return this->IsEnd() ? '\0' : this->m_Content[this->m_Position];
+    }
+
+    bool StartsWith(
+        std::string_view Value) const
+    {
+        return this->m_Content.substr(this->m_Position, Value.size()) == Value;
+    }
+
+    void SkipSpaces()
+    {
+        while (this->GetCurrent() == ' ' || this->GetCurrent() == '\t')
+        {
+            ++this->m_Position;
+        }
+    }
+
+    bool SkipNewLine()
+    {
+        if (this->StartsWith("\r\n"))
+        {
+            this->m_Position += 2;
+            return true;
+        }
+        else if (this->GetCurrent() == '\n')
+        {
+            ++this->m_Position;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool SkipComment()
+    {
+        if (this->GetCurrent() != '#')
+        {
+            return true;
+        }
+
+        while (!this->IsEnd() && this->GetCurrent() != '\n')
+        {
+            char Current = this->GetCurrent();
+            if (Current != '\t' && Current != '\r' &&
+                (static_cast<std::uint8_t>(Current) < 0x20 || Current == 0x7F))
+            {
+                return false;
+            }
+            ++this->m_Position;
+        }
+
+        return true;
+    }
+
+    static bool AppendUtf8(
+        std::string& Output,
+        std::uint32_t CodePoint)
+    {
+        if (CodePoint > 0x10FFFF ||
+            (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+        {
+            return false;
+        }
+
+        if (CodePoint < 0x80)
+        {
+            Output.push_back(static_cast<char>(CodePoint));
+        }
+        else if (CodePoint < 0x800)
+        {
+            Output.push_back(static_cast<char>(0xC0 | (CodePoint >> 6)));
+            Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+        }
+        else if (CodePoint < 0x10000)
+        {
+            Output.push_back(static_cast<char>(0xE0 | (CodePoint >> 12)));
+            Output.push_back(
+                static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+            Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+        }
+        else
+        {
+            Output.push_back(static_cast<char>(0xF0 | (CodePoint >> 18)));
+            Output.push_back(
+                static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F)));
+            Output.push_back(
+                static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+            Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+        }
+
+        return true;
+    }
+
+    bool ReadUnicodeEscape(
+        std::string& Output,
+        std::size_t Digits)
+    {
+        if (this->m_Content.size() - this->m_Position < Digits)
+        {
+            return false;
+        }
+
+        std::uint32_t CodePoint = 0;
+        for (std::size_t i = 0; i < Digits; ++i)
+        {
+            char Current = this->m_Content[this->m_Position++];
+            CodePoint <<= 4;
+            if (Current >= '0' && Current <= '9')
+            {
+                CodePoint |= Current - '0';
+            }
+            else if (Current >= 'A' && Current <= 'F')
+            {
+                CodePoint |= Current - 'A' + 10;
+            }
+            else if (Current >= 'a' && Current <= 'f')
+            {
+                CodePoint |= Current - 'a' + 10;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return CNSudoTranslationTomlReader::AppendUtf8(Output, CodePoint);
+    }
+
+    /**
+     * @brief Reads a basic string or a literal string, which can be
+     *        multi-line. The reader is at the opening delimiter.
+     * @param Buffer The buffer for the decoded string.
+     * @param Value Receives the string. It points into the content if the
+     *              string is not changed by decoding, or into the buffer.
+     * @param AllowMultiLine False for the keys.
+     * @return True if the string is in the supported subset.
+    */
+    bool ReadString(
+        std::string& Buffer,
+        std::string_view& Value,
+        bool AllowMultiLine)
+    {
+        char Quote = this->GetCurrent();
+        bool Literal = Quote == '\'';
+        bool MultiLine = AllowMultiLine && this->StartsWith(
+            Literal ? std::string_view("'''") : std::string_view("\"\"\""));
+
+        this->m_Position += MultiLine ? 3 : 1;
+
+        // A newline immediately following the opening delimiter is trimmed.
+        if (MultiLine)
+        {
+            this->SkipNewLine();
+        }
+
+        // The string is a view of the content until the first character
+        // which is changed by decoding.
+        std::size_t Start = this->m_Position;
+        bool Decoded = false;
+        Buffer.clear();
+
+        for (;;)
+        {
+            if (this->IsEnd())
+            {
+                return false;
+            }
+
+            char Current = this->GetCurrent();
+            if (Current == Quote)
+            {
+                if (!MultiLine)
+                {
+                    if (!Decoded)
+                    {
+                        Value = this->m_Content.substr(
+                            Start,
+                            this->m_Position - Start);
+                    }
+                    ++this->m_Position;
+                    break;
+                }
+
+                std::size_t Count = 0;
+                while (this->GetCurrent() == Quote)
+                {
+                    ++Count;
+                    ++this->m_Position;
+                }
+                if (Count < 3)
+                {
+                    if (Decoded)
+                    {
+                        Buffer.append(Count, Quote);
+                    }
+                    continue;
+                }
+                else if (Count > 5)
+                {
+                    return false;
+                }
+
+                // Up to two quotes are allowed before the closing delimiter.
+                if (Decoded)
+                {
+                    Buffer.append(Count - 3, Quote);
+                }
+                else
+                {
+                    Value = this->m_Content.substr(
+                        Start,
+                        this->m_Position - 3 - Start);
+                }
+                break;
+            }
+
+            if (!Decoded && ((!Literal && Current == '\\') ||
+                (MultiLine && this->StartsWith("\r\n"))))
+            {
+                Buffer.assign(
+                    this->m_Content.data() + Start,
+                    this->m_Position - Start);
+                Decoded = true;
+            }
+
+            if (Current == '\\' && !Literal)
+            {
+                ++this->m_Position;
+                char Escape = this->GetCurrent();
+                ++this->m_Position;
+                switch (Escape)
+                {
+                case 'b':
+                    Buffer.push_back('\b');
+                    break;
+                case 't':
+                    Buffer.push_back('\t');
+                    break;
+                case 'n':
+                    Buffer.push_back('\n');
+                    break;
+                case 'f':
+                    Buffer.push_back('\f');
+                    break;
+                case 'r':
+                    Buffer.push_back('\r');
+                    break;
+                case '"':
+                    Buffer.push_back('"');
+                    break;
+                case '\\':
+                    Buffer.push_back('\\');
+                    break;
+                case 'u':
+                    if (!this->ReadUnicodeEscape(Buffer, 4))
+                    {
+                        return false;
+                    }
+                    break;
+                case 'U':
+                    if (!this->ReadUnicodeEscape(Buffer, 8))
+                    {
+                        return false;
+                    }
+                    break;
+                case ' ':
+                case '\t':
+                case '\r':
+                case '\n':
+                {
+                    if (!MultiLine)
+                    {
+                        return false;
+                    }
+
+                    // The line ending backslash trims all whitespaces and
+                    // newlines up to the next non-whitespace character.
+                    --this->m_Position;
+                    this->SkipSpaces();
+                    if (!this->SkipNewLine())
+                    {
+                        return false;
+                    }
+                    for (;;)
+                    {
+                        this->SkipSpaces();
+                        if (!this->SkipNewLine())
+                        {
+                            break;
+                        }
+                    }
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            else if (MultiLine && this->StartsWith("\r\n"))
+            {
+                // Newlines are normalized to LF, the same as toml++.
+                Buffer.push_back('\n');
+                this->m_Position += 2;
+            }
+            else if (Current == '\n' && MultiLine)
+            {
+                if (Decoded)
+                {
+                    Buffer.push_back(Current);
+                }
+                ++this->m_Position;
+            }
+            else if (Current != '\t' &&
+                (static_cast<std::uint8_t>(Current) < 0x20 || Current == 0x7F))
+            {
+                return false;
+            }
+            else
+            {
+                if (Decoded)
+                {
+                    Buffer.push_back(Current);
+                }
+                ++this->m_Position;
+            }
+        }
+
+        if (Decoded)
+        {
+            Value = Buffer;
+        }
+
+        return true;
+    }
+
+    bool ReadKey(
+        std::string_view& Key)
+    {
+        char Current = this->GetCurrent();
+        if (Current == '"' || Current == '\'')
+        {
+            return this->ReadString(this->m_KeyBuffer, Key, false);
+        }
+
+        std::size_t Start = this->m_Position;
+        for (;;)
+        {
+            Current = this->GetCurrent();
+            if ((Current >= 'A' && Current <= 'Z') ||
+                (Current >= 'a' && Current <= 'z') ||
+                (Current >= '0' && Current <= '9') ||
+                Current == '_' ||
+                Current == '-')
+            {
+                ++this->m_Position;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        Key = this->m_Content.substr(Start, this->m_Position - Start);
+        return !Key.empty();
+    }
+
+public:
+
+    /**
+     * @brief Reads the translations from the flat translation TOML file. The
+     *        keys which are defined more than once keep the first value, while
+     *        toml++ rejects the file.
+     * @param Content The UTF-8 content of the TOML file. The BOM is skipped.
+     * @param Builder The builder which receives the translations as the
+     *                UTF-8 values. If the function fails, the builder has
+     *                partial translations and should be discarded.
+     * @return True if the file is in the supported subset and has been read.
+     *         False if it is outside the subset or invalid, which should be
+     *         read by toml++ instead.
+    */
+    bool Read(
+        std::string_view Content,
+        CNSudoTranslationTableBuilder& Builder)
+    {
+        this->m_Content = Content;
+        this->m_Position = 0;
+
+        if (this->StartsWith("\xEF\xBB\xBF"))
+        {
+            this->m_Position += 3;
+        }
+
+        for (;;)
+        {
+            this->SkipSpaces();
+            if (!this->SkipComment())
+            {
+                return false;
+            }
+            if (this->SkipNewLine())
+            {
+                continue;
+            }
+            if (this->IsEnd())
+            {
+                break;
+            }
+
+            // The tables, the dotted keys and the values which are not
+            // strings are outside the subset.
+            std::string_view Key;
+            if (!this->ReadKey(Key))
+            {
+                return false;
+            }
+            this->SkipSpaces();
+            if (this->GetCurrent() != '=')
+            {
+                return false;
+            }
+            ++this->m_Position;
+            this->SkipSpaces();
+            if (this->GetCurrent() != '"' && this->GetCurrent() != '\'')
+            {
+                return false;
+            }
+
+            std::string_view Value;
+            if (!this->ReadString(this->m_ValueBuffer, Value, true))
+            {
+                return false;
+            }
+
+            Builder.AddUtf8(Key, Value);
+
+            this->SkipSpaces();
+            if (!this->SkipComment())
+            {
+                return false;
+            }
+            if (!this->SkipNewLine() && !this->IsEnd())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif // !NSUDO_TRANSLATION_TOML
@@ -0,0 +1,319 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoTrustedInstallerPrewarm.cpp
+ * PURPOSE:   Implementation for NSudo TrustedInstaller access token prewarm
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include "NSudoTrustedInstallerPrewarm.h"
+
+#include <memory>
+
+CNSudoWin32ServiceController::CNSudoWin32ServiceController(
+    std::wstring const& ServiceName) :
+    m_ServiceName(ServiceName)
+{
+    this->m_CancelEvent = ::CreateEventExW(
+        nullptr,
+        nullptr,
+        CREATE_EVENT_MANUAL_RESET,
+        EVENT_ALL_ACCESS);
+}
+
+CNSudoWin32ServiceController::~CNSudoWin32ServiceController()
+{
+    if (this->m_ServiceProcessHandle)
+    {
+        ::CloseHandle(this->m_ServiceProcessHandle);
+    }
+
+    if (this->m_CancelEvent)
+    {
+        ::CloseHandle(this->m_CancelEvent);
+    }
+}
+
+bool CNSudoWin32ServiceController::StartAndOpenToken(
+    HANDLE& Token)
+{
+    Token = INVALID_HANDLE_VALUE;
+
+    if (this->m_ServiceProcessHandle)
+    {
+        ::CloseHandle(this->m_ServiceProcessHandle);
+        this->m_ServiceProcessHandle = nullptr;
+    }
+
+    SERVICE_STATUS_PROCESS ServiceStatus;
+    if (S_OK != Mile::StartServiceW(
+        this->m_ServiceName.c_str(),
+        &ServiceStatus))
+    {
+        return false;
+    }
+
+    this->m_ServiceProcessHandle = ::OpenProcess(
+        SYNCHRONIZE,
+        FALSE,
+        ServiceStatus.dwProcessId);
+    if (!this->m_ServiceProcessHandle)
+    {
+        return false;
+    }
+
+    if (S_OK != Mile::OpenProcessTokenByProcessId(
+        ServiceStatus.dwProcessId,
+        MAXIMUM_ALLOWED,
+        &Token))
+    {
+        Token = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    return true;
+}
+
+bool CNSudoWin32ServiceController::WaitForStop(
+    std::chrono::milliseconds Timeout)
+{
+    if (!this->m_ServiceProcessHandle)
+    {
+        return true;
+    }
+
+    if (!this->m_CancelEvent)
+    {
+        return WAIT_TIMEOUT != ::WaitForSingleObjectEx(
+            this->m_ServiceProcessHandle,
+            static_cast<DWORD>(Timeout.count()),
+            FALSE);
+    }
+
+    HANDLE Handles[] = { this->m_ServiceProcessHandle, this->m_CancelEvent };
+    return WAIT_OBJECT_0 == ::WaitForMultipleObjectsEx(
+        2,
+        Handles,
+        FALSE,
+        static_cast<DWORD>(Timeout.count()),
+        FALSE);
+}
+
+void CNSudoWin32ServiceController::CancelWait()
+{
+    if (this->m_CancelEvent)
+    {
+        ::SetEvent(this->m_CancelEvent);
+    }
+}
+
+bool CNSudoWin32ServiceController::DuplicateToken(
+    HANDLE const& Token,
+    HANDLE& DuplicatedToken)
+{
+    return FALSE != ::DuplicateHandle(
+        ::GetCurrentProcess(),
+        Token,
+        ::GetCurrentProcess(),
+        &DuplicatedToken,
+        0,
+        FALSE,
+        DUPLICATE_SAME_ACCESS);
+}
+
+void CNSudoWin32ServiceController::CloseToken(
+    HANDLE& Token)
+{
+    if (Token != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(Token);
+        Token = INVALID_HANDLE_VALUE;
+    }
+}
+
+void CNSudoWin32ServiceController::OnThreadContext(
+    bool Entering)
+{
+    if (!Entering)
+    {
+        ::SetThreadToken(nullptr, nullptr);
+        return;
+    }
+
+    // The same context as NSudoCreateProcess: the SeDebugPrivilege of the
+    // current process is needed for creating the system access token, and
+    // the system context with all privileges enabled is needed for starting
+    // the service and opening its access token.
+
+    HANDLE CurrentProcessToken = INVALID_HANDLE_VALUE;
+    HANDLE DuplicatedCurrentProcessToken = INVALID_HANDLE_VALUE;
+    HANDLE OriginalSystemToken = INVALID_HANDLE_VALUE;
+    HANDLE SystemToken = INVALID_HANDLE_VALUE;
+
+    auto Handler = Mile::ScopeExitTaskHandler([&]()
+    {
+        HANDLE Handles[] =
+        {
+            CurrentProcessToken,
+            DuplicatedCurrentProcessToken,
+            OriginalSystemToken,
+            SystemToken
+        };
+
+        for (HANDLE& Handle : Handles)
+        {
+            if (Handle != INVALID_HANDLE_VALUE)
+            {
+                ::CloseHandle(Handle);
+            }
+        }
+    });
+
+    if (!::OpenProcessToken(
+        ::GetCurrentProcess(),
+        MAXIMUM_ALLOWED,
+        &CurrentProcessToken))
+    {
+        CurrentProcessToken = INVALID_HANDLE_VALUE;
+        return;
+    }
+
+    if (!::DuplicateTokenEx(
+        CurrentProcessToken,
+        MAXIMUM_ALLOWED,
+        nullptr,
+        SecurityImpersonation,
+        TokenImpersonation,
+        &DuplicatedCurrentProcessToken))
+    {
+        DuplicatedCurrentProcessToken = INVALID_HANDLE_VALUE;
+        return;
+    }
+
+    LUID_AND_ATTRIBUTES RawPrivilege;
+    if (!::LookupPrivilegeValueW(nullptr, SE_DEBUG_NAME, &RawPrivilege.Luid))
+    {
+        return;
+    }
+    RawPrivilege.Attributes = SE_PRIVILEGE_ENABLED;
+
+    if (S_OK != Mile::AdjustTokenPrivilegesSimple(
+        DuplicatedCurrentProcessToken,
+        &RawPrivilege,
+        1))
+    {
+        return;
+    }
+
+    if (!::SetThreadToken(nullptr, DuplicatedCurrentProcessToken))
+    {
+        return;
+    }
+
+    if (S_OK != Mile::CreateSystemToken(MAXIMUM_ALLOWED, &OriginalSystemToken))
+    {
+        OriginalSystemToken = INVALID_HANDLE_VALUE;
+        return;
+    }
+
+    if (!::DuplicateTokenEx(
+        OriginalSystemToken,
+        MAXIMUM_ALLOWED,
+        nullptr,
+        SecurityImpersonation,
+        TokenImpersonation,
+        &SystemToken))
+    {
+        SystemToken = INVALID_HANDLE_VALUE;
+        return;
+    }
+
+    if (S_OK != Mile::AdjustTokenAllPrivileges(
+        SystemToken,
+        SE_PRIVILEGE_ENABLED))
+    {
+        return;
+    }
+
+    ::SetThreadToken(nullptr, SystemToken);
+}
+
+/**
+ * @brief The interval for checking the stop request while waiting for the
+ *        TrustedInstaller service to stop.
+*/
+static const std::chrono::milliseconds g_PrewarmPollInterval(1000);
+
+/**
+ * @brief The interval before retrying when the TrustedInstaller service fails
+ *        to start.
+*/
+static const std::chrono::milliseconds g_PrewarmRetryInterval(5000);
+
+// The prewarmer and its controller are shared with the threads acquiring the
+// token, which may wait for the prewarmer without holding the lock while it is
+// replaced by NSudoStartTrustedInstallerPrewarm.
+static Mile::CriticalSection g_PrewarmLock;
+static std::shared_ptr<CNSudoWin32ServiceController> g_PrewarmController;
+static std::shared_ptr<CNSudoServiceTokenPrewarmer<HANDLE>> g_Prewarmer;
+
+void NSudoStartTrustedInstallerPrewarm()
+{
+    Mile::AutoCriticalSectionLock Lock(g_PrewarmLock);
+
+    if (g_Prewarmer && g_Prewarmer->GetState()
+        != NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED)
+    {
+        return;
+    }
+
+    // The controller is recreated because the cancel event of the previous
+    // stop is still signaled.
+    g_Prewarmer.reset();
+    g_PrewarmController.reset(
+        new CNSudoWin32ServiceController(L"TrustedInstaller"));
+    g_Prewarmer.reset(new CNSudoServiceTokenPrewarmer<HANDLE>(
+        g_PrewarmController.get(),
+        g_PrewarmPollInterval,
+        g_PrewarmRetryInterval));
+
+    g_Prewarmer->Start();
+}
+
+void NSudoStopTrustedInstallerPrewarm()
+{
+    Mile::AutoCriticalSectionLock Lock(g_PrewarmLock);
+
+    if (g_Prewarmer)
+    {
+        g_Prewarmer->Stop();
+    }
+}
+
+bool NSudoAcquireTrustedInstallerPrewarmToken(
+    _Out_ PHANDLE TokenHandle)
+{
+    *TokenHandle = INVALID_HANDLE_VALUE;
+
+    // The controller is released after the prewarmer which refers to it.
+    std::shared_ptr<CNSudoWin32ServiceController> Controller;
+    std::shared_ptr<CNSudoServiceTokenPrewarmer<HANDLE>> Prewarmer;
+    {
+        Mile::AutoCriticalSectionLock Lock(g_PrewarmLock);
+        Controller = g_PrewarmController;
+        Prewarmer = g_Prewarmer;
+    }
+
+    if (!Prewarmer || Prewarmer->GetState()
+        == NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED)
+    {
+        return false;
+    }
+
+    return Prewarmer->TryAcquire(
+        *TokenHandle,
+        std::chrono::milliseconds(
+            NSUDO_TRUSTED_INSTALLER_PREWARM_ACQUIRE_TIMEOUT));
+}
@@ -0,0 +1,94 @@
+﻿/*
+ * PROJECT:   NSudo Shared Library
+ * FILE:      NSudoTrustedInstallerPrewarm.h
+ * PURPOSE:   Definition for NSudo TrustedInstaller access token prewarm
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_TRUSTED_INSTALLER_PREWARM
+#define NSUDO_TRUSTED_INSTALLER_PREWARM
+
+#ifndef __cplusplus
+#error "[NSudoTrustedInstallerPrewarm] You should use a C++ compiler."
+#endif
+
+#include <Mile.Windows.h>
+
+#include "NSudoServiceTokenPrewarmer.h"
+
+#include <string>
+
+/**
+ * @brief The maximum time for the launch path waiting the prewarm thread
+ *        which is starting the TrustedInstaller service, in milliseconds.
+*/
+#define NSUDO_TRUSTED_INSTALLER_PREWARM_ACQUIRE_TIMEOUT 30000
+
+/**
+ * @brief The service controller which starts the service through the Service
+ *        Control Manager. The operations run in the system context with all
+ *        privileges enabled.
+*/
+class CNSudoWin32ServiceController :
+    public INSudoServiceController<HANDLE>,
+    Mile::DisableCopyConstruction,
+    Mile::DisableMoveConstruction
+{
+private:
+
+    std::wstring m_ServiceName;
+    HANDLE m_ServiceProcessHandle = nullptr;
+    HANDLE m_CancelEvent = nullptr;
+
+public:
+
+    explicit CNSudoWin32ServiceController(
+        std::wstring const& ServiceName);
+
+    virtual ~CNSudoWin32ServiceController();
+
+    virtual bool StartAndOpenToken(
+        HANDLE& Token);
+
+    virtual bool WaitForStop(
+        std::chrono::milliseconds Timeout);
+
+    virtual void CancelWait();
+
+    virtual bool DuplicateToken(
+        HANDLE const& Token,
+        HANDLE& DuplicatedToken);
+
+    virtual void CloseToken(
+        HANDLE& Token);
+
+    virtual void OnThreadContext(
+        bool Entering);
+};
+
+/**
+ * @brief Starts prewarming the access token of the TrustedInstaller service.
+ *        It does nothing if the prewarm is already started.
+*/
+void NSudoStartTrustedInstallerPrewarm();
+
+/**
+ * @brief Stops prewarming the access token of the TrustedInstaller service.
+*/
+void NSudoStopTrustedInstallerPrewarm();
+
+/**
+ * @brief Takes a duplicate of the prewarmed access token of the
+ *        TrustedInstaller service.
+ * @param TokenHandle Receives the duplicated access token. The caller needs to
+ *                    close it.
+ * @return True if the prewarmed access token is taken, false if the prewarm is
+ *         not started or the access token is not available.
+*/
+bool NSudoAcquireTrustedInstallerPrewarmToken(
+    _Out_ PHANDLE TokenHandle);
+
+#endif // !NSUDO_TRUSTED_INSTALLER_PREWARM
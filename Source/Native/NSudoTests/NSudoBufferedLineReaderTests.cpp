@@ -0,0 +1,184 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoBufferedLineReaderTests.cpp
+ * PURPOSE:   Implementation for NSudo buffered line reader tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <NSudoBufferedLineReader.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief The source of the buffered line reader tests, which returns the
+ *        input in reads of a fixed maximum size, like a pipe which is
+ *        written in small pieces.
+*/
+template<typename CharType>
+class CNSudoTestLineSource
+{
+public:
+
+    std::basic_string<CharType> Input;
+    std::size_t Position = 0;
+    std::size_t MaxRead = 0;
+    std::size_t Calls = 0;
+
+    static std::size_t Read(
+        void* Context,
+        CharType* Buffer,
+        std::size_t Size)
+    {
+        CNSudoTestLineSource* Source =
+            reinterpret_cast<CNSudoTestLineSource*>(Context);
+        ++Source->Calls;
+
+        std::size_t Length = Source->Input.size() - Source->Position;
+        if (Length > Size)
+        {
+            Length = Size;
+        }
+        if (Source->MaxRead && Length > Source->MaxRead)
+        {
+            Length = Source->MaxRead;
+        }
+
+        std::copy(
+            Source->Input.begin() + Source->Position,
+            Source->Input.begin() + Source->Position + Length,
+            Buffer);
+        Source->Position += Length;
+        return Length;
+    }
+};
+
+/**
+ * @brief Reads all the lines of the input.
+ * @param Input The input.
+ * @param ChunkSize The chunk size of the reader.
+ * @param MaxRead The maximum number of characters returned by each read of
+ *                the source, or zero for no limit.
+ * @return The lines.
+*/
+template<typename CharType>
+static std::vector<std::basic_string<CharType>> NSudoTestReadLines(
+    std::basic_string<CharType> const& Input,
+    std::size_t ChunkSize,
+    std::size_t MaxRead)
+{
+    CNSudoTestLineSource<CharType> Source;
+    Source.Input = Input;
+    Source.MaxRead = MaxRead;
+
+    CNSudoBufferedLineReader<CharType> Reader(
+        &CNSudoTestLineSource<CharType>::Read,
+        &Source,
+        ChunkSize);
+
+    std::vector<std::basic_string<CharType>> Lines;
+    const CharType* Line = nullptr;
+    std::size_t Length = 0;
+    while (Reader.ReadLine(Line, Length))
+    {
+        Lines.emplace_back(Line, Length);
+    }
+
+    // The source is not read again after the end of the input.
+    std::size_t Calls = Source.Calls;
+    NSUDO_TEST_ASSERT(!Reader.ReadLine(Line, Length));
+    NSUDO_TEST_ASSERT(Source.Calls == Calls);
+
+    return Lines;
+}
+
+NSUDO_TEST(BufferedLineReaderSplitsAcrossChunks)
+{
+    // The CRLF and the lines cross every chunk boundary for some of the
+    // sizes, and the long line needs the buffer to grow.
+    std::string Input =
+        "Yes\r\n"
+        "\n"
+        "\r\n"
+        "No\n"
+        "A\rB\r\n";
+    Input.append(100, 'L');
+    Input.append("\r\nLast");
+
+    std::vector<std::string> Expected =
+    {
+        "Yes",
+        "",
+        "",
+        "No",
+        "A\rB",
+        std::string(100, 'L'),
+        "Last",
+    };
+
+    for (std::size_t ChunkSize = 1; ChunkSize <= 16; ++ChunkSize)
+    {
+        for (std::size_t MaxRead = 0; MaxRead <= 7; ++MaxRead)
+        {
+            NSUDO_TEST_ASSERT(Expected == ::NSudoTestReadLines(
+                Input,
+                ChunkSize,
+                MaxRead));
+        }
+    }
+
+    NSUDO_TEST_ASSERT(Expected == ::NSudoTestReadLines(Input, 4096, 0));
+}
+
+NSUDO_TEST(BufferedLineReaderHandlesTheEndOfInput)
+{
+    for (std::size_t MaxRead = 0; MaxRead <= 3; ++MaxRead)
+    {
+        // The empty input has no lines, and a terminated last line is not
+        // followed by an empty one.
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            std::string(),
+            2,
+            MaxRead).empty());
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            std::string("One\r\n"),
+            2,
+            MaxRead) == std::vector<std::string>({ "One" }));
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            std::string("\n"),
+            2,
+            MaxRead) == std::vector<std::string>({ "" }));
+
+        // The CR at the end of the last line without LF is removed, the same
+        // as the CR before LF.
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            std::string("One\nTwo\r"),
+            2,
+            MaxRead) == std::vector<std::string>({ "One", "Two" }));
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            std::string("\r"),
+            2,
+            MaxRead) == std::vector<std::string>({ "" }));
+    }
+}
+
+NSUDO_TEST(BufferedLineReaderReadsWideCharacters)
+{
+    std::wstring Input = L"\x4E2D\x6587\r\nSecond\nThird";
+
+    for (std::size_t ChunkSize = 1; ChunkSize <= 8; ++ChunkSize)
+    {
+        NSUDO_TEST_ASSERT(::NSudoTestReadLines(
+            Input,
+            ChunkSize,
+            1) == std::vector<std::wstring>(
+                { L"\x4E2D\x6587", L"Second", L"Third" }));
+    }
+}
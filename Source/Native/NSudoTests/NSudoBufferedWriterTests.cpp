@@ -0,0 +1,173 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoBufferedWriterTests.cpp
+ * PURPOSE:   Implementation for NSudo buffered writer tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <NSudoBufferedWriter.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief The sink of the buffered writer tests, which keeps the chunks.
+*/
+class CNSudoTestWriterSink
+{
+private:
+
+    std::mutex m_Mutex;
+    std::condition_variable m_ChunkReceived;
+    std::vector<std::string> m_Chunks;
+
+public:
+
+    static void Write(
+        void* Context,
+        const void* Data,
+        std::size_t Size)
+    {
+        CNSudoTestWriterSink* Sink =
+            reinterpret_cast<CNSudoTestWriterSink*>(Context);
+        {
+            std::lock_guard<std::mutex> Lock(Sink->m_Mutex);
+            Sink->m_Chunks.emplace_back(
+                reinterpret_cast<const char*>(Data),
+                Size);
+        }
+        Sink->m_ChunkReceived.notify_all();
+    }
+
+    /**
+     * @brief Waits for the chunks.
+     * @param Count The number of the chunks to wait for.
+     * @param Timeout The maximum time to wait.
+     * @return True if the chunks have been received.
+    */
+    bool WaitForChunks(
+        std::size_t Count,
+        std::chrono::milliseconds Timeout)
+    {
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+        return this->m_ChunkReceived.wait_for(Lock, Timeout, [&]()
+        {
+            return this->m_Chunks.size() >= Count;
+        });
+    }
+
+    std::vector<std::string> GetChunks()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return this->m_Chunks;
+    }
+};
+
+/**
+ * @brief Writes the string to the buffered writer.
+ * @param Writer The buffered writer.
+ * @param Value The string to write.
+*/
+static void NSudoTestWriteString(
+    CNSudoBufferedWriter& Writer,
+    std::string const& Value)
+{
+    Writer.Write([&](std::string& Buffer)
+    {
+        Buffer.append(Value);
+    });
+}
+
+NSUDO_TEST(BufferedWriterFlushesAfterTheInterval)
+{
+    CNSudoTestWriterSink Sink;
+    CNSudoBufferedWriter Writer(&CNSudoTestWriterSink::Write, &Sink);
+
+    // The writes within the interval are passed to the sink together, and
+    // not before the interval since the first of them has passed.
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+    ::NSudoTestWriteString(Writer, "Detected - A.\r\n");
+    ::NSudoTestWriteString(Writer, "Detected - B.\r\n");
+
+    NSUDO_TEST_ASSERT(Sink.WaitForChunks(1, std::chrono::seconds(10)));
+    NSUDO_TEST_ASSERT(
+        std::chrono::steady_clock::now() - Start >=
+        std::chrono::milliseconds(50));
+    NSUDO_TEST_ASSERT(Sink.GetChunks() == std::vector<std::string>(
+        { "Detected - A.\r\nDetected - B.\r\n" }));
+
+    // The interval starts again with the next write after the flush.
+    Start = std::chrono::steady_clock::now();
+    ::NSudoTestWriteString(Writer, "Removed - C.\r\n");
+    NSUDO_TEST_ASSERT(Sink.WaitForChunks(2, std::chrono::seconds(10)));
+    NSUDO_TEST_ASSERT(
+        std::chrono::steady_clock::now() - Start >=
+        std::chrono::milliseconds(50));
+    NSUDO_TEST_ASSERT(Sink.GetChunks().back() == "Removed - C.\r\n");
+}
+
+NSUDO_TEST(BufferedWriterFlushesAtTheCapacity)
+{
+    CNSudoTestWriterSink Sink;
+    CNSudoBufferedWriter Writer(
+        &CNSudoTestWriterSink::Write,
+        &Sink,
+        16,
+        std::chrono::hours(1));
+
+    // The sink is called by the write which fills the buffer.
+    ::NSudoTestWriteString(Writer, "0123456789");
+    NSUDO_TEST_ASSERT(Sink.GetChunks().empty());
+    ::NSudoTestWriteString(Writer, "ABCDEF");
+    NSUDO_TEST_ASSERT(Sink.GetChunks() == std::vector<std::string>(
+        { "0123456789ABCDEF" }));
+
+    ::NSudoTestWriteString(Writer, "Tail");
+    Writer.Flush();
+    NSUDO_TEST_ASSERT(Sink.GetChunks().size() == 2);
+    NSUDO_TEST_ASSERT(Sink.GetChunks().back() == "Tail");
+
+    // Flushing the empty buffer does not call the sink.
+    Writer.Flush();
+    NSUDO_TEST_ASSERT(Sink.GetChunks().size() == 2);
+}
+
+NSUDO_TEST(BufferedWriterFlushesWhenDestroyed)
+{
+    CNSudoTestWriterSink Sink;
+
+    // The destructor does not wait for the interval.
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+    {
+        CNSudoBufferedWriter Writer(
+            &CNSudoTestWriterSink::Write,
+            &Sink,
+            64 * 1024,
+            std::chrono::hours(1));
+        ::NSudoTestWriteString(Writer, "Pending");
+        ::NSudoTestWriteString(Writer, " output");
+        NSUDO_TEST_ASSERT(Sink.GetChunks().empty());
+    }
+    NSUDO_TEST_ASSERT(
+        std::chrono::steady_clock::now() - Start <
+        std::chrono::seconds(10));
+    NSUDO_TEST_ASSERT(Sink.GetChunks() == std::vector<std::string>(
+        { "Pending output" }));
+
+    // A writer which has never been written to does not call the sink.
+    {
+        CNSudoBufferedWriter Writer(&CNSudoTestWriterSink::Write, &Sink);
+    }
+    NSUDO_TEST_ASSERT(Sink.GetChunks().size() == 1);
+}
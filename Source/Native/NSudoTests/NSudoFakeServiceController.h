@@ -0,0 +1,223 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoFakeServiceController.h
+ * PURPOSE:   Definition for NSudo fake service controller (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_FAKE_SERVICE_CONTROLLER
+#define NSUDO_FAKE_SERVICE_CONTROLLER
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L)
+#elif (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#else
+#error "[NSudoFakeServiceController] You should use a C++ compiler with the C++14 standard."
+#endif
+
+#include <NSudoServiceTokenPrewarmer.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/**
+ * @brief The service controller which never touches the system. The access
+ *        tokens are positive integers, the service is running from a
+ *        successful start until it is stopped by the test, and each start
+ *        can be delayed or failed to drive the prewarmer through all its
+ *        states.
+*/
+class CNSudoFakeServiceController : public INSudoServiceController<int>
+{
+private:
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Changed;
+
+    std::chrono::milliseconds m_StartLatency = std::chrono::milliseconds(0);
+    int m_FailingStarts = 0;
+    bool m_Running = false;
+    bool m_Canceled = false;
+
+    int m_NextToken = 1;
+    std::set<int> m_OpenTokens;
+
+    int m_StartCount = 0;
+    int m_EnterCount = 0;
+    int m_LeaveCount = 0;
+
+public:
+
+    /**
+     * @brief Sets the time which each start takes.
+     * @param Latency The time which each start takes.
+    */
+    void SetStartLatency(
+        std::chrono::milliseconds Latency)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->m_StartLatency = Latency;
+    }
+
+    /**
+     * @brief Makes the following starts fail.
+     * @param Count The number of the following starts which fail.
+    */
+    void SetFailingStarts(
+        int Count)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->m_FailingStarts = Count;
+    }
+
+    /**
+     * @brief Stops the service as if it stopped by itself.
+    */
+    void StopService()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            this->m_Running = false;
+        }
+        this->m_Changed.notify_all();
+    }
+
+    /**
+     * @brief Waits for the number of the starts to reach the count.
+     * @param Count The number of the starts.
+     * @param Timeout The time-out interval.
+     * @return True if the number of the starts reaches the count.
+    */
+    bool WaitForStartCount(
+        int Count,
+        std::chrono::milliseconds Timeout)
+    {
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+        return this->m_Changed.wait_for(Lock, Timeout, [&]()
+        {
+            return this->m_StartCount >= Count;
+        });
+    }
+
+    /**
+     * @brief Gets the number of the starts, including the failed ones.
+     * @return The number of the starts.
+    */
+    int GetStartCount()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return this->m_StartCount;
+    }
+
+    /**
+     * @brief Gets the number of the access tokens which are not closed.
+     * @return The number of the access tokens which are not closed.
+    */
+    std::size_t GetOpenTokenCount()
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return this->m_OpenTokens.size();
+    }
+
+    /**
+     * @brief Gets the number of the OnThreadContext calls.
+     * @param Entering True for the entering calls, false for the leaving
+     *                 calls.
+     * @return The number of the OnThreadContext calls.
+    */
+    int GetThreadContextCount(
+        bool Entering)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        return Entering ? this->m_EnterCount : this->m_LeaveCount;
+    }
+
+    virtual bool StartAndOpenToken(
+        int& Token)
+    {
+        std::chrono::milliseconds Latency;
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            Latency = this->m_StartLatency;
+        }
+        std::this_thread::sleep_for(Latency);
+
+        bool Started = false;
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            ++this->m_StartCount;
+            if (this->m_FailingStarts)
+            {
+                --this->m_FailingStarts;
+                Token = 0;
+            }
+            else
+            {
+                this->m_Running = true;
+                Token = this->m_NextToken++;
+                this->m_OpenTokens.insert(Token);
+                Started = true;
+            }
+        }
+        this->m_Changed.notify_all();
+
+        return Started;
+    }
+
+    virtual bool WaitForStop(
+        std::chrono::milliseconds Timeout)
+    {
+        std::unique_lock<std::mutex> Lock(this->m_Mutex);
+        this->m_Changed.wait_for(Lock, Timeout, [this]()
+        {
+            return !this->m_Running || this->m_Canceled;
+        });
+        return !this->m_Running;
+    }
+
+    virtual void CancelWait()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(this->m_Mutex);
+            this->m_Canceled = true;
+        }
+        this->m_Changed.notify_all();
+    }
+
+    virtual bool DuplicateToken(
+        int const& Token,
+        int& DuplicatedToken)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        if (!this->m_OpenTokens.count(Token))
+        {
+            return false;
+        }
+        DuplicatedToken = this->m_NextToken++;
+        this->m_OpenTokens.insert(DuplicatedToken);
+        return true;
+    }
+
+    virtual void CloseToken(
+        int& Token)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        this->m_OpenTokens.erase(Token);
+        Token = 0;
+    }
+
+    virtual void OnThreadContext(
+        bool Entering)
+    {
+        std::lock_guard<std::mutex> Lock(this->m_Mutex);
+        ++(Entering ? this->m_EnterCount : this->m_LeaveCount);
+    }
+};
+
+#endif // !NSUDO_FAKE_SERVICE_CONTROLLER
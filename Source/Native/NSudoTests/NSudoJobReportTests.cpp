@@ -0,0 +1,189 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoJobReportTests.cpp
+ * PURPOSE:   Implementation for NSudo job accounting report tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <Mile.Windows.h>
+
+#include <cstring>
+#include <string>
+
+#include <NSudoFakeLaunchBackend.h>
+#include <NSudoJobObject.h>
+#include <NSudoLauncherJobReport.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief The fake launch backend which reports fixed accounting information
+ *        for every job, and optionally fails one class of the queries.
+*/
+class CNSudoTestJobAccountingBackend : public CNSudoFakeLaunchBackend
+{
+public:
+
+    JOBOBJECTINFOCLASS FailedClass = static_cast<JOBOBJECTINFOCLASS>(0);
+    HRESULT FailedResult = S_OK;
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInformationJobObject(
+        _In_ HANDLE JobHandle,
+        _In_ JOBOBJECTINFOCLASS JobObjectInformationClass,
+        _Out_ LPVOID JobObjectInformation,
+        _In_ DWORD JobObjectInformationLength)
+    {
+        HRESULT hr = CNSudoFakeLaunchBackend::QueryInformationJobObject(
+            JobHandle,
+            JobObjectInformationClass,
+            JobObjectInformation,
+            JobObjectInformationLength);
+        if (hr != S_OK)
+        {
+            return hr;
+        }
+
+        if (this->FailedResult != S_OK &&
+            this->FailedClass == JobObjectInformationClass)
+        {
+            return this->FailedResult;
+        }
+
+        if (JobObjectInformationClass ==
+            JobObjectBasicAndIoAccountingInformation)
+        {
+            NSUDO_TEST_ASSERT(JobObjectInformationLength == sizeof(
+                JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION));
+
+            JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION& Information =
+                *reinterpret_cast<
+                PJOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION>(
+                    JobObjectInformation);
+            Information.BasicInfo.TotalProcesses = 3;
+            Information.BasicInfo.TotalUserTime.QuadPart = 25000000;
+            Information.BasicInfo.TotalKernelTime.QuadPart = 5000000;
+            Information.IoInfo.ReadTransferCount = 1024;
+            Information.IoInfo.WriteTransferCount = 2048;
+            Information.IoInfo.OtherTransferCount = 64;
+        }
+        else if (JobObjectInformationClass ==
+            JobObjectExtendedLimitInformation)
+        {
+            NSUDO_TEST_ASSERT(JobObjectInformationLength == sizeof(
+                JOBOBJECT_EXTENDED_LIMIT_INFORMATION));
+
+            JOBOBJECT_EXTENDED_LIMIT_INFORMATION& Information =
+                *reinterpret_cast<PJOBOBJECT_EXTENDED_LIMIT_INFORMATION>(
+                    JobObjectInformation);
+            Information.PeakJobMemoryUsed = 8 * 1024 * 1024;
+            Information.PeakProcessMemoryUsed = 4 * 1024 * 1024;
+        }
+
+        return S_OK;
+    }
+};
+
+NSUDO_TEST(JobAccountingIsQueriedThroughBackend)
+{
+    CNSudoTestJobAccountingBackend Backend;
+
+    NSUDO_CREATE_PROCESS_OPTIONS Options = { 0 };
+    Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+    Options.JobKillOnClose = TRUE;
+
+    NSUDO_JOB_ACCOUNTING_INFORMATION Accounting;
+    {
+        CNSudoJobObject JobObject;
+        NSUDO_TEST_ASSERT(S_OK == JobObject.Initialize(&Backend, &Options));
+        NSUDO_TEST_ASSERT(JobObject.IsEnabled());
+        NSUDO_TEST_ASSERT(S_OK == JobObject.QueryAccounting(&Accounting));
+    }
+
+    NSUDO_TEST_ASSERT(2 == Backend.GetCallCount(
+        NSUDO_LAUNCH_BACKEND_CALL::QUERY_INFORMATION_JOB_OBJECT));
+    NSUDO_TEST_ASSERT(0 == Backend.GetOpenHandles());
+
+    NSUDO_TEST_ASSERT(Accounting.TotalProcesses == 3);
+    NSUDO_TEST_ASSERT(Accounting.TotalUserTime == 25000000);
+    NSUDO_TEST_ASSERT(Accounting.TotalKernelTime == 5000000);
+    NSUDO_TEST_ASSERT(Accounting.PeakJobMemoryUsed == 8 * 1024 * 1024);
+    NSUDO_TEST_ASSERT(Accounting.PeakProcessMemoryUsed == 4 * 1024 * 1024);
+    NSUDO_TEST_ASSERT(Accounting.ReadTransferCount == 1024);
+    NSUDO_TEST_ASSERT(Accounting.WriteTransferCount == 2048);
+    NSUDO_TEST_ASSERT(Accounting.OtherTransferCount == 64);
+
+    NSUDO_TEST_ASSERT(::NSudoFormatJobAccountingJson(Accounting) ==
+        L"{\"TotalProcesses\":3,"
+        L"\"UserTimeMilliseconds\":2500,"
+        L"\"KernelTimeMilliseconds\":500,"
+        L"\"PeakJobMemoryUsed\":8388608,"
+        L"\"PeakProcessMemoryUsed\":4194304,"
+        L"\"ReadTransferCount\":1024,"
+        L"\"WriteTransferCount\":2048,"
+        L"\"OtherTransferCount\":64}");
+
+    std::wstring Report = ::NSudoFormatJobAccountingReport(Accounting);
+    NSUDO_TEST_ASSERT(std::wstring::npos != Report.find(
+        L"    Processes: 3\r\n"));
+    NSUDO_TEST_ASSERT(std::wstring::npos != Report.find(
+        L"    User time: 2.500 s\r\n"));
+    NSUDO_TEST_ASSERT(std::wstring::npos != Report.find(
+        L"    Kernel time: 0.500 s\r\n"));
+}
+
+NSUDO_TEST(JobAccountingWithoutJobIsZero)
+{
+    CNSudoTestJobAccountingBackend Backend;
+
+    NSUDO_CREATE_PROCESS_OPTIONS Options = { 0 };
+    Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+
+    CNSudoJobObject JobObject;
+    NSUDO_TEST_ASSERT(S_OK == JobObject.Initialize(&Backend, &Options));
+    NSUDO_TEST_ASSERT(!JobObject.IsEnabled());
+
+    NSUDO_JOB_ACCOUNTING_INFORMATION Accounting;
+    std::memset(&Accounting, 0xFF, sizeof(Accounting));
+    NSUDO_TEST_ASSERT(S_OK == JobObject.QueryAccounting(&Accounting));
+
+    NSUDO_JOB_ACCOUNTING_INFORMATION Zero = { 0 };
+    NSUDO_TEST_ASSERT(0 == std::memcmp(&Accounting, &Zero, sizeof(Zero)));
+    NSUDO_TEST_ASSERT(0 == Backend.GetCallCount(
+        NSUDO_LAUNCH_BACKEND_CALL::QUERY_INFORMATION_JOB_OBJECT));
+}
+
+NSUDO_TEST(JobAccountingQueryFailureIsReported)
+{
+    const JOBOBJECTINFOCLASS Classes[] =
+    {
+        JobObjectBasicAndIoAccountingInformation,
+        JobObjectExtendedLimitInformation
+    };
+
+    for (JOBOBJECTINFOCLASS const& Class : Classes)
+    {
+        CNSudoTestJobAccountingBackend Backend;
+        Backend.FailedClass = Class;
+        Backend.FailedResult = E_ACCESSDENIED;
+
+        NSUDO_CREATE_PROCESS_OPTIONS Options = { 0 };
+        Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+        Options.JobKillOnClose = TRUE;
+
+        CNSudoJobObject JobObject;
+        NSUDO_TEST_ASSERT(S_OK == JobObject.Initialize(&Backend, &Options));
+
+        NSUDO_JOB_ACCOUNTING_INFORMATION Accounting;
+        std::memset(&Accounting, 0xFF, sizeof(Accounting));
+        NSUDO_TEST_ASSERT(
+            E_ACCESSDENIED == JobObject.QueryAccounting(&Accounting));
+
+        // A failed query never reports partial accounting information.
+        NSUDO_JOB_ACCOUNTING_INFORMATION Zero = { 0 };
+        NSUDO_TEST_ASSERT(
+            0 == std::memcmp(&Accounting, &Zero, sizeof(Zero)));
+    }
+}
@@ -0,0 +1,147 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoLauncherBatchTests.cpp
+ * PURPOSE:   Implementation for NSudo Launcher batch mode tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <Mile.Windows.h>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <NSudoFakeLaunchBackend.h>
+#include <NSudoLauncherBatch.h>
+#include <NSudoLauncherBatchScheduler.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief Runs a batch of fake commands and records the peak number of
+ *        commands running at the same time.
+ * @param ItemCount The number of commands in the batch.
+ * @param MaxParallel The maximum number of commands running at the same
+ *                    time.
+ * @param Peak Receives the peak number of commands running at the same time.
+ * @param Reported Receives the indexes in the reporting order.
+ * @param Results Receives the results of the commands.
+*/
+static void NSudoTestRunFakeBatch(
+    std::size_t ItemCount,
+    std::size_t MaxParallel,
+    std::size_t& Peak,
+    std::vector<std::size_t>& Reported,
+    std::vector<HRESULT>& Results)
+{
+    // The fake backend is used by the caches of the launch path, so it
+    // outlives all launches and the caches are invalidated after the batch.
+    static CNSudoFakeLaunchBackend Backend;
+
+    // Each command takes several milliseconds, so the commands of different
+    // workers overlap.
+    Backend.SetLatency(NSUDO_LAUNCH_BACKEND_CALL::CREATE_PROCESS_AS_USER, 500);
+    Backend.SetLatency(NSUDO_LAUNCH_BACKEND_CALL::WAIT_FOR_SINGLE_OBJECT, 2000);
+    Backend.ResetStatistics();
+
+    NSUDO_LAUNCHER_BATCH_SETTINGS Settings = { };
+    Settings.UserModeType = NSUDO_USER_MODE_TYPE::CURRENT_PROCESS;
+    Settings.PrivilegesModeType = NSUDO_PRIVILEGES_MODE_TYPE::DEFAULT;
+    Settings.MandatoryLabelType = NSUDO_MANDATORY_LABEL_TYPE::SYSTEM;
+    Settings.ProcessPriorityClassType =
+        NSUDO_PROCESS_PRIORITY_CLASS_TYPE::NORMAL;
+    Settings.ShowWindowModeType = NSUDO_SHOW_WINDOW_MODE_TYPE::DEFAULT;
+    Settings.CreateNewConsole = TRUE;
+    Settings.CurrentDirectory = nullptr;
+    Settings.Options.Size = sizeof(NSUDO_CREATE_PROCESS_OPTIONS);
+
+    std::atomic<std::size_t> InFlight(0);
+    std::atomic<std::size_t> PeakInFlight(0);
+
+    Peak = 0;
+    Reported.clear();
+    Results.clear();
+
+    ::NSudoRunBatch<NSUDO_LAUNCHER_BATCH_RESULT>(
+        ItemCount,
+        MaxParallel,
+        [&](std::size_t Index) -> NSUDO_LAUNCHER_BATCH_RESULT
+        {
+            UNREFERENCED_PARAMETER(Index);
+
+            std::size_t Current = ++InFlight;
+            std::size_t Previous = PeakInFlight.load();
+            while (Previous < Current &&
+                !PeakInFlight.compare_exchange_weak(Previous, Current))
+            {
+            }
+
+            NSUDO_LAUNCHER_BATCH_RESULT Result = ::NSudoLaunchBatchCommand(
+                &Backend,
+                Settings,
+                L"cmd.exe /c exit");
+
+            --InFlight;
+
+            return Result;
+        },
+        [&](std::size_t Index, NSUDO_LAUNCHER_BATCH_RESULT& Result)
+        {
+            Reported.push_back(Index);
+            Results.push_back(Result.Result);
+        });
+
+    Peak = PeakInFlight.load();
+
+    NSUDO_TEST_ASSERT(ItemCount == Backend.GetCallCount(
+        NSUDO_LAUNCH_BACKEND_CALL::CREATE_PROCESS_AS_USER));
+
+    ::NSudoInvalidateDerivedTokenCache();
+    ::NSudoInvalidateEnvironmentBlockCache();
+}
+
+NSUDO_TEST(BatchRespectsMaxParallel)
+{
+    std::size_t Peak = 0;
+    std::vector<std::size_t> Reported;
+    std::vector<HRESULT> Results;
+
+    ::NSudoTestRunFakeBatch(24, 4, Peak, Reported, Results);
+
+    NSUDO_TEST_ASSERT(Peak >= 1);
+    NSUDO_TEST_ASSERT(Peak <= 4);
+
+    NSUDO_TEST_ASSERT(Reported.size() == 24);
+    for (std::size_t i = 0; i < Reported.size(); ++i)
+    {
+        NSUDO_TEST_ASSERT(Reported[i] == i);
+        NSUDO_TEST_ASSERT(Results[i] == S_OK);
+    }
+}
+
+NSUDO_TEST(BatchRunsOneCommandWhenMaxParallelIsZero)
+{
+    std::size_t Peak = 0;
+    std::vector<std::size_t> Reported;
+    std::vector<HRESULT> Results;
+
+    ::NSudoTestRunFakeBatch(8, 0, Peak, Reported, Results);
+
+    NSUDO_TEST_ASSERT(Peak == 1);
+    NSUDO_TEST_ASSERT(Reported.size() == 8);
+}
+
+NSUDO_TEST(BatchClampsMaxParallelToItemCount)
+{
+    std::size_t Peak = 0;
+    std::vector<std::size_t> Reported;
+    std::vector<HRESULT> Results;
+
+    ::NSudoTestRunFakeBatch(3, 64, Peak, Reported, Results);
+
+    NSUDO_TEST_ASSERT(Peak <= 3);
+    NSUDO_TEST_ASSERT(Reported.size() == 3);
+}
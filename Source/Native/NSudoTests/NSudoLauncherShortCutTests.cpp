@@ -0,0 +1,383 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoLauncherShortCutTests.cpp
+ * PURPOSE:   Implementation for NSudo Launcher shortcut list tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <Mile.Windows.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <NSudoLauncherShortCuts.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief The content of NSudo.json used by the shortcut tests. The second
+ *        "cmd" only differs in the case, so it is dropped.
+*/
+static const char g_TestShortCutList[] =
+    "\xEF\xBB\xBF"
+    "{\n"
+    "  \"ShortCutList_V2\": {\n"
+    "    \"cmd\": \"cmd.exe\",\n"
+    "    \"Regedit\": \"regedit.exe\",\n"
+    "    \"CMD\": \"powershell.exe\",\n"
+    "    \"Taskmgr\": \"taskmgr.exe\"\n"
+    "  }\n"
+    "}\n";
+
+/**
+ * @brief Checks the shortcuts built from g_TestShortCutList.
+ * @param ShortCutList The shortcut list.
+*/
+static void NSudoTestCheckShortCutList(
+    CNSudoShortCutList const& ShortCutList)
+{
+    NSUDO_TEST_ASSERT(ShortCutList.GetCount() == 3);
+
+    // The shortcuts are sorted by the case-folded names.
+    NSUDO_TEST_ASSERT(ShortCutList.GetName(0) == "cmd");
+    NSUDO_TEST_ASSERT(ShortCutList.GetName(1) == "Regedit");
+    NSUDO_TEST_ASSERT(ShortCutList.GetName(2) == "Taskmgr");
+    NSUDO_TEST_ASSERT(ShortCutList.GetName(3).empty());
+
+    std::string_view Target;
+    NSUDO_TEST_ASSERT(ShortCutList.Find("CMD", Target));
+    NSUDO_TEST_ASSERT(Target == "cmd.exe");
+    NSUDO_TEST_ASSERT(ShortCutList.Find("regedit", Target));
+    NSUDO_TEST_ASSERT(Target == "regedit.exe");
+    NSUDO_TEST_ASSERT(ShortCutList.Find("TASKMGR", Target));
+    NSUDO_TEST_ASSERT(Target == "taskmgr.exe");
+    NSUDO_TEST_ASSERT(!ShortCutList.Find("notepad", Target));
+    NSUDO_TEST_ASSERT(Target.empty());
+}
+
+NSUDO_TEST(ShortCutIndexBuildsFromContent)
+{
+    CNSudoShortCutList ShortCutList;
+
+    bool CachedIndexReused = true;
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        g_TestShortCutList,
+        1,
+        nullptr,
+        0,
+        &CachedIndexReused));
+    NSUDO_TEST_ASSERT(!CachedIndexReused);
+
+    ::NSudoTestCheckShortCutList(ShortCutList);
+
+    NSUDO_TEST_ASSERT(CNSudoShortCutList::IsIndexCurrent(
+        ShortCutList.GetIndex(),
+        ShortCutList.GetIndexSize(),
+        sizeof(g_TestShortCutList) - 1,
+        1));
+}
+
+NSUDO_TEST(ShortCutIndexBuildsFromEmptyContent)
+{
+    CNSudoShortCutList ShortCutList;
+
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        std::string_view(),
+        1,
+        nullptr,
+        0,
+        nullptr));
+    NSUDO_TEST_ASSERT(ShortCutList.GetIndex());
+    NSUDO_TEST_ASSERT(ShortCutList.GetCount() == 0);
+
+    std::string_view Target;
+    NSUDO_TEST_ASSERT(!ShortCutList.Find("cmd", Target));
+}
+
+NSUDO_TEST(ShortCutIndexRejectsInvalidContent)
+{
+    CNSudoShortCutList ShortCutList;
+
+    NSUDO_TEST_ASSERT(E_INVALIDARG == ShortCutList.Build(
+        "{ \"ShortCutList_V2\": { \"cmd\": ",
+        1,
+        nullptr,
+        0,
+        nullptr));
+    NSUDO_TEST_ASSERT(!ShortCutList.GetIndex());
+    NSUDO_TEST_ASSERT(ShortCutList.GetCount() == 0);
+}
+
+NSUDO_TEST(ShortCutIndexLoadsFromIndex)
+{
+    CNSudoShortCutList Source;
+    NSUDO_TEST_ASSERT(S_OK == Source.Build(
+        g_TestShortCutList,
+        1,
+        nullptr,
+        0,
+        nullptr));
+
+    std::vector<BYTE> Index(
+        Source.GetIndex(),
+        Source.GetIndex() + Source.GetIndexSize());
+    Source.Close();
+    NSUDO_TEST_ASSERT(!Source.GetIndex());
+
+    CNSudoShortCutList ShortCutList;
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.LoadIndex(
+        Index.data(),
+        Index.size()));
+
+    ::NSudoTestCheckShortCutList(ShortCutList);
+
+    // The truncated or damaged indexes are rejected.
+    NSUDO_TEST_ASSERT(E_INVALIDARG == ShortCutList.LoadIndex(
+        Index.data(),
+        Index.size() - 1));
+    NSUDO_TEST_ASSERT(ShortCutList.GetCount() == 0);
+
+    std::vector<BYTE> DamagedIndex = Index;
+    DamagedIndex[0] ^= 0xFF;
+    NSUDO_TEST_ASSERT(E_INVALIDARG == ShortCutList.LoadIndex(
+        DamagedIndex.data(),
+        DamagedIndex.size()));
+    NSUDO_TEST_ASSERT(!CNSudoShortCutList::IsIndexCurrent(
+        DamagedIndex.data(),
+        DamagedIndex.size(),
+        sizeof(g_TestShortCutList) - 1,
+        1));
+}
+
+NSUDO_TEST(ShortCutIndexRevalidatesStaleLastWriteTime)
+{
+    std::string_view Content = g_TestShortCutList;
+
+    CNSudoShortCutList Cached;
+    NSUDO_TEST_ASSERT(S_OK == Cached.Build(Content, 1, nullptr, 0, nullptr));
+
+    // Only the last write time is changed, e.g. NSudo.json is copied.
+    NSUDO_TEST_ASSERT(!CNSudoShortCutList::IsIndexCurrent(
+        Cached.GetIndex(),
+        Cached.GetIndexSize(),
+        Content.size(),
+        2));
+
+    CNSudoShortCutList ShortCutList;
+    bool CachedIndexReused = false;
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        Content,
+        2,
+        Cached.GetIndex(),
+        Cached.GetIndexSize(),
+        &CachedIndexReused));
+    NSUDO_TEST_ASSERT(CachedIndexReused);
+    NSUDO_TEST_ASSERT(CNSudoShortCutList::IsIndexCurrent(
+        ShortCutList.GetIndex(),
+        ShortCutList.GetIndexSize(),
+        Content.size(),
+        2));
+    ::NSudoTestCheckShortCutList(ShortCutList);
+
+    // The content with the same size but different bytes is rebuilt.
+    std::string ChangedContent(Content);
+    ChangedContent.replace(ChangedContent.find("cmd.exe"), 7, "cmd.com");
+    NSUDO_TEST_ASSERT(ChangedContent.size() == Content.size());
+
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        ChangedContent,
+        2,
+        Cached.GetIndex(),
+        Cached.GetIndexSize(),
+        &CachedIndexReused));
+    NSUDO_TEST_ASSERT(!CachedIndexReused);
+
+    std::string_view Target;
+    NSUDO_TEST_ASSERT(ShortCutList.Find("cmd", Target));
+    NSUDO_TEST_ASSERT(Target == "cmd.com");
+
+    // The damaged cached index is ignored.
+    std::vector<BYTE> DamagedIndex(
+        Cached.GetIndex(),
+        Cached.GetIndex() + Cached.GetIndexSize() - 1);
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        Content,
+        2,
+        DamagedIndex.data(),
+        DamagedIndex.size(),
+        &CachedIndexReused));
+    NSUDO_TEST_ASSERT(!CachedIndexReused);
+    ::NSudoTestCheckShortCutList(ShortCutList);
+}
+
+/**
+ * @brief Builds the shortcut list used by the prefix and the expansion tests.
+ * @param ShortCutList The shortcut list.
+*/
+static void NSudoTestBuildArgumentShortCutList(
+    CNSudoShortCutList& ShortCutList)
+{
+    NSUDO_TEST_ASSERT(S_OK == ShortCutList.Build(
+        "{\n"
+        "  \"ShortCutList_V2\": {\n"
+        "    \"PowerShell\": \"powershell.exe\",\n"
+        "    \"PowerShell ISE\": \"powershell_ise.exe\",\n"
+        "    \"Copy\": \"cmd /c copy {0} {1}\",\n"
+        "    \"Swap\": \"cmd /c copy {1} {0}\",\n"
+        "    \"Run\": \"cmd /c {*} & pause\",\n"
+        "    \"Notepad\": \"notepad.exe\",\n"
+        "    \"Braces\": \"echo {} {x}\",\n"
+        "    \"Host Files\": \"notepad.exe {0}\"\n"
+        "  }\n"
+        "}\n",
+        1,
+        nullptr,
+        0,
+        nullptr));
+}
+
+NSUDO_TEST(ShortCutFindPrefixMatchesLongestName)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    std::string_view Target;
+    std::size_t NameLength = 0;
+
+    NSUDO_TEST_ASSERT(ShortCutList.FindPrefix(
+        "powershell ise -File a.ps1",
+        Target,
+        NameLength));
+    NSUDO_TEST_ASSERT(Target == "powershell_ise.exe");
+    NSUDO_TEST_ASSERT(NameLength == 14);
+
+    // The longer name is not followed by an argument boundary.
+    NSUDO_TEST_ASSERT(ShortCutList.FindPrefix(
+        "PowerShell\tISEx",
+        Target,
+        NameLength));
+    NSUDO_TEST_ASSERT(Target == "powershell.exe");
+    NSUDO_TEST_ASSERT(NameLength == 10);
+
+    NSUDO_TEST_ASSERT(ShortCutList.FindPrefix(
+        "POWERSHELL",
+        Target,
+        NameLength));
+    NSUDO_TEST_ASSERT(Target == "powershell.exe");
+    NSUDO_TEST_ASSERT(NameLength == 10);
+
+    NSUDO_TEST_ASSERT(!ShortCutList.FindPrefix(
+        "PowerShellX",
+        Target,
+        NameLength));
+    NSUDO_TEST_ASSERT(Target.empty());
+    NSUDO_TEST_ASSERT(NameLength == 0);
+
+    NSUDO_TEST_ASSERT(!ShortCutList.FindPrefix("Power", Target, NameLength));
+    NSUDO_TEST_ASSERT(!ShortCutList.FindPrefix("", Target, NameLength));
+
+    CNSudoShortCutList EmptyList;
+    NSUDO_TEST_ASSERT(!EmptyList.FindPrefix("cmd", Target, NameLength));
+}
+
+NSUDO_TEST(ShortCutTranslateReplacesNumberedPlaceholders)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    // The quoted arguments keep their quotes.
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"copy a.txt \"b c.txt\"") == L"cmd /c copy a.txt \"b c.txt\"");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Swap  a.txt\tb.txt  ") == L"cmd /c copy b.txt a.txt");
+
+    // The missing arguments are replaced with nothing and the extra
+    // arguments are dropped.
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Copy a.txt") == L"cmd /c copy a.txt ");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Copy a b c") == L"cmd /c copy a b");
+}
+
+NSUDO_TEST(ShortCutTranslateReplacesAllArgumentsPlaceholder)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Run  dir \"C:\\Program Files\" /s ") ==
+        L"cmd /c dir \"C:\\Program Files\" /s & pause");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Run") == L"cmd /c  & pause");
+}
+
+NSUDO_TEST(ShortCutTranslateAppendsArgumentsWithoutPlaceholders)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"notepad  C:\\a.txt ") == L"notepad.exe C:\\a.txt");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Notepad") == L"notepad.exe");
+
+    // The braces which are not placeholders are kept.
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"Braces a") == L"echo {} {x} a");
+}
+
+NSUDO_TEST(ShortCutTranslateMatchesQuotedNames)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"\"Host Files\" C:\\hosts") == L"notepad.exe C:\\hosts");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"\"PowerShell ISE\"") == L"powershell_ise.exe");
+
+    // The quoted name must be the whole name and be followed by an argument
+    // boundary.
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"\"Host\" Files") == L"\"Host\" Files");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"\"Notepad\"x") == L"\"Notepad\"x");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"\"Notepad") == L"\"Notepad");
+}
+
+NSUDO_TEST(ShortCutTranslateKeepsUnknownCommandLines)
+{
+    CNSudoShortCutList ShortCutList;
+    ::NSudoTestBuildArgumentShortCutList(ShortCutList);
+
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"regedit.exe /s a.reg") == L"regedit.exe /s a.reg");
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        ShortCutList,
+        L"") == L"");
+
+    CNSudoShortCutList EmptyList;
+    NSUDO_TEST_ASSERT(CNSudoShortCutAdapter::Translate(
+        EmptyList,
+        L"Notepad") == L"Notepad");
+}
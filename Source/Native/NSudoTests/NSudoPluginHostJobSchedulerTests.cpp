@@ -0,0 +1,367 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoPluginHostJobSchedulerTests.cpp
+ * PURPOSE:   Implementation for NSudo Plugin Host job scheduler tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <NSudoPluginHostJobScheduler.h>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief Creates a task of the job.
+ * @param After The indexes of the tasks which the task depends on.
+ * @param Resources The indexes of the resource classes used by the task.
+ * @return The task.
+*/
+static NSUDO_JOB_TASK NSudoTestCreateJobTask(
+    std::vector<std::size_t> After,
+    std::vector<std::size_t> Resources = std::vector<std::size_t>())
+{
+    NSUDO_JOB_TASK Task;
+    Task.After = std::move(After);
+    Task.Resources = std::move(Resources);
+    return Task;
+}
+
+/**
+ * @brief A finished task, as reported by the scheduler.
+*/
+typedef struct _NSUDO_TEST_JOB_REPORT
+{
+    std::size_t Index;
+    int Result;
+    NSUDO_JOB_TASK_STATUS Status;
+} NSUDO_TEST_JOB_REPORT;
+
+/**
+ * @brief Runs the job with stub tasks, which return their index plus one as
+ *        the result.
+ * @param Tasks The tasks of the job.
+ * @param ResourceCapacities The capacities of the resource classes.
+ * @param MaxParallel The maximum number of tasks running at the same time.
+ * @param FailedTasks The tasks which fail.
+ * @param Started Receives the tasks in the starting order.
+ * @param Reports Receives the reports in the reporting order.
+*/
+static void NSudoTestRunJob(
+    std::vector<NSUDO_JOB_TASK> const& Tasks,
+    std::vector<std::size_t> const& ResourceCapacities,
+    std::size_t MaxParallel,
+    std::vector<bool> const& FailedTasks,
+    std::vector<std::size_t>& Started,
+    std::vector<NSUDO_TEST_JOB_REPORT>& Reports)
+{
+    std::mutex StartedLock;
+    std::thread::id CallingThread = std::this_thread::get_id();
+    bool ReportedFromWorker = false;
+
+    Started.clear();
+    Reports.clear();
+
+    ::NSudoRunJob<int>(
+        Tasks,
+        ResourceCapacities,
+        MaxParallel,
+        [&](std::size_t Index, int& Result) -> bool
+        {
+            {
+                std::lock_guard<std::mutex> Lock(StartedLock);
+                Started.push_back(Index);
+            }
+
+            Result = static_cast<int>(Index) + 1;
+            return !FailedTasks[Index];
+        },
+        [&](std::size_t Index, int& Result, NSUDO_JOB_TASK_STATUS Status)
+        {
+            if (std::this_thread::get_id() != CallingThread)
+            {
+                ReportedFromWorker = true;
+            }
+            Reports.push_back({ Index, Result, Status });
+        });
+
+    NSUDO_TEST_ASSERT(!ReportedFromWorker);
+
+    // Every task is reported once. A task which has run is reported after
+    // all the tasks it depends on, and a skipped task is reported as soon as
+    // one of them has failed or has been skipped, while the others may still
+    // be running.
+    NSUDO_TEST_ASSERT(Reports.size() == Tasks.size());
+    std::vector<bool> Reported(Tasks.size(), false);
+    std::vector<NSUDO_JOB_TASK_STATUS> Statuses(Tasks.size());
+    for (NSUDO_TEST_JOB_REPORT const& Report : Reports)
+    {
+        NSUDO_TEST_ASSERT(!Reported[Report.Index]);
+
+        bool Unsucceeded = false;
+        for (std::size_t const& Dependency : Tasks[Report.Index].After)
+        {
+            if (Report.Status != NSUDO_JOB_TASK_STATUS::Skipped)
+            {
+                NSUDO_TEST_ASSERT(Reported[Dependency]);
+                NSUDO_TEST_ASSERT(
+                    Statuses[Dependency] == NSUDO_JOB_TASK_STATUS::Succeeded);
+            }
+            else if (Reported[Dependency] &&
+                Statuses[Dependency] != NSUDO_JOB_TASK_STATUS::Succeeded)
+            {
+                Unsucceeded = true;
+            }
+        }
+        NSUDO_TEST_ASSERT(
+            Unsucceeded ==
+            (Report.Status == NSUDO_JOB_TASK_STATUS::Skipped));
+
+        Reported[Report.Index] = true;
+        Statuses[Report.Index] = Report.Status;
+    }
+}
+
+NSUDO_TEST(JobCheckAcceptsAcyclicTasks)
+{
+    // A diamond and an independent task.
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    Tasks.push_back(::NSudoTestCreateJobTask({ 1, 2 }, { 0 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 3 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 3 }, { 1 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({}, { 0, 1 }));
+
+    std::size_t InvalidTask = static_cast<std::size_t>(-1);
+    NSUDO_TEST_ASSERT(::NSudoCheckJobTasks(Tasks, { 1, 2 }, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == static_cast<std::size_t>(-1));
+
+    NSUDO_TEST_ASSERT(::NSudoCheckJobTasks(
+        std::vector<NSUDO_JOB_TASK>(),
+        std::vector<std::size_t>(),
+        InvalidTask));
+}
+
+NSUDO_TEST(JobCheckRejectsUnknownReferences)
+{
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 0, 2 }));
+
+    std::size_t InvalidTask = 0;
+    NSUDO_TEST_ASSERT(!::NSudoCheckJobTasks(Tasks, {}, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == 1);
+
+    // The unknown resource classes and the ones without capacity.
+    Tasks[1] = ::NSudoTestCreateJobTask({ 0 }, { 1 });
+    InvalidTask = 0;
+    NSUDO_TEST_ASSERT(!::NSudoCheckJobTasks(Tasks, { 1 }, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == 1);
+
+    InvalidTask = 0;
+    NSUDO_TEST_ASSERT(!::NSudoCheckJobTasks(Tasks, { 1, 0 }, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == 1);
+
+    NSUDO_TEST_ASSERT(::NSudoCheckJobTasks(Tasks, { 1, 1 }, InvalidTask));
+}
+
+NSUDO_TEST(JobCheckRejectsCycles)
+{
+    // Task 1 and task 2 depend on each other, and task 3 depends on them.
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 0, 2 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 1 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 2 }));
+
+    std::size_t InvalidTask = 0;
+    NSUDO_TEST_ASSERT(!::NSudoCheckJobTasks(Tasks, {}, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == 1);
+
+    // A task which depends on itself.
+    Tasks.clear();
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 1 }));
+    InvalidTask = 0;
+    NSUDO_TEST_ASSERT(!::NSudoCheckJobTasks(Tasks, {}, InvalidTask));
+    NSUDO_TEST_ASSERT(InvalidTask == 1);
+}
+
+NSUDO_TEST(JobRunsReadyTasksInInputOrder)
+{
+    // Task 1 waits for task 3, so it starts after the other ready tasks.
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 3 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+
+    std::vector<std::size_t> Started;
+    std::vector<NSUDO_TEST_JOB_REPORT> Reports;
+    ::NSudoTestRunJob(
+        Tasks,
+        {},
+        0,
+        std::vector<bool>(Tasks.size(), false),
+        Started,
+        Reports);
+
+    NSUDO_TEST_ASSERT(Started == std::vector<std::size_t>({ 0, 2, 3, 4, 1 }));
+
+    // One task runs at a time, so the tasks are reported as they start.
+    for (std::size_t i = 0; i < Reports.size(); ++i)
+    {
+        NSUDO_TEST_ASSERT(Reports[i].Index == Started[i]);
+        NSUDO_TEST_ASSERT(
+            Reports[i].Result == static_cast<int>(Reports[i].Index) + 1);
+        NSUDO_TEST_ASSERT(
+            Reports[i].Status == NSUDO_JOB_TASK_STATUS::Succeeded);
+    }
+}
+
+NSUDO_TEST(JobSkipsTheDependentsOfFailedTasks)
+{
+    // Task 0 fails. Task 1 and task 2 are skipped through it, and task 4 is
+    // skipped although its other dependency succeeds.
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 0 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 1 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({}));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 3, 0 }));
+    Tasks.push_back(::NSudoTestCreateJobTask({ 3 }));
+
+    std::vector<bool> FailedTasks(Tasks.size(), false);
+    FailedTasks[0] = true;
+
+    for (std::size_t MaxParallel = 1; MaxParallel <= 4; ++MaxParallel)
+    {
+        std::vector<std::size_t> Started;
+        std::vector<NSUDO_TEST_JOB_REPORT> Reports;
+        ::NSudoTestRunJob(
+            Tasks,
+            {},
+            MaxParallel,
+            FailedTasks,
+            Started,
+            Reports);
+
+        NSUDO_TEST_ASSERT(Started.size() == 3);
+
+        for (NSUDO_TEST_JOB_REPORT const& Report : Reports)
+        {
+            switch (Report.Index)
+            {
+            case 0:
+                NSUDO_TEST_ASSERT(
+                    Report.Status == NSUDO_JOB_TASK_STATUS::Failed);
+                NSUDO_TEST_ASSERT(Report.Result == 1);
+                break;
+            case 1:
+            case 2:
+            case 4:
+                // The skipped tasks are not run and have no result.
+                NSUDO_TEST_ASSERT(
+                    Report.Status == NSUDO_JOB_TASK_STATUS::Skipped);
+                NSUDO_TEST_ASSERT(Report.Result == 0);
+                break;
+            default:
+                NSUDO_TEST_ASSERT(
+                    Report.Status == NSUDO_JOB_TASK_STATUS::Succeeded);
+                break;
+            }
+        }
+    }
+}
+
+NSUDO_TEST(JobRespectsResourceCapacities)
+{
+    // Resource class 0 allows two tasks at a time and class 1 allows one.
+    const std::vector<std::size_t> ResourceCapacities = { 2, 1 };
+    const std::size_t MaxParallel = 6;
+
+    std::vector<NSUDO_JOB_TASK> Tasks;
+    for (std::size_t i = 0; i < 24; ++i)
+    {
+        switch (i % 4)
+        {
+        case 0:
+            Tasks.push_back(::NSudoTestCreateJobTask({}, { 0 }));
+            break;
+        case 1:
+            Tasks.push_back(::NSudoTestCreateJobTask({}, { 1 }));
+            break;
+        case 2:
+            Tasks.push_back(::NSudoTestCreateJobTask({}, { 0, 1 }));
+            break;
+        default:
+            Tasks.push_back(::NSudoTestCreateJobTask({ i - 1 }));
+            break;
+        }
+    }
+
+    std::size_t InvalidTask = 0;
+    NSUDO_TEST_ASSERT(::NSudoCheckJobTasks(
+        Tasks,
+        ResourceCapacities,
+        InvalidTask));
+
+    std::atomic<std::size_t> InFlight(0);
+    std::atomic<std::size_t> ResourceInFlight[2] = { { 0 }, { 0 } };
+    std::atomic<bool> Exceeded(false);
+    std::size_t Succeeded = 0;
+
+    ::NSudoRunJob<int>(
+        Tasks,
+        ResourceCapacities,
+        MaxParallel,
+        [&](std::size_t Index, int& Result) -> bool
+        {
+            if (++InFlight > MaxParallel)
+            {
+                Exceeded = true;
+            }
+            for (std::size_t const& Resource : Tasks[Index].Resources)
+            {
+                if (++ResourceInFlight[Resource] >
+                    ResourceCapacities[Resource])
+                {
+                    Exceeded = true;
+                }
+            }
+
+            // The tasks overlap, so the limits are actually tested.
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+            for (std::size_t const& Resource : Tasks[Index].Resources)
+            {
+                --ResourceInFlight[Resource];
+            }
+            --InFlight;
+
+            Result = static_cast<int>(Index);
+            return true;
+        },
+        [&](std::size_t Index, int& Result, NSUDO_JOB_TASK_STATUS Status)
+        {
+            // The assertions are checked after the workers are joined.
+            if (Result == static_cast<int>(Index) &&
+                Status == NSUDO_JOB_TASK_STATUS::Succeeded)
+            {
+                ++Succeeded;
+            }
+        });
+
+    NSUDO_TEST_ASSERT(!Exceeded);
+    NSUDO_TEST_ASSERT(Succeeded == Tasks.size());
+}
@@ -0,0 +1,206 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoServiceTokenPrewarmerTests.cpp
+ * PURPOSE:   Implementation for NSudo service token prewarmer tests
+ *            (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <chrono>
+
+#include "NSudoFakeServiceController.h"
+#include "NSudoTest.h"
+
+/**
+ * @brief The time-out interval of the waits which are expected to succeed.
+*/
+static const std::chrono::milliseconds g_PrewarmTestTimeout(10000);
+
+NSUDO_TEST(PrewarmerHandsOutDuplicatesOfReadyToken)
+{
+    CNSudoFakeServiceController Controller;
+    {
+        CNSudoServiceTokenPrewarmer<int> Prewarmer(
+            &Controller,
+            std::chrono::milliseconds(10),
+            std::chrono::milliseconds(10));
+
+        NSUDO_TEST_ASSERT(Prewarmer.GetState() ==
+            NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED);
+
+        Prewarmer.Start();
+
+        int First = 0;
+        int Second = 0;
+        NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(First, g_PrewarmTestTimeout));
+        NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(Second, g_PrewarmTestTimeout));
+        NSUDO_TEST_ASSERT(Prewarmer.GetState() ==
+            NSUDO_SERVICE_TOKEN_PREWARM_STATE::READY);
+
+        // Each launch gets its own duplicate, the ready token is kept.
+        NSUDO_TEST_ASSERT(First != Second);
+        NSUDO_TEST_ASSERT(Controller.GetStartCount() == 1);
+        NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 3);
+
+        Controller.CloseToken(First);
+        Controller.CloseToken(Second);
+    }
+
+    // The destructor stops the thread and closes the ready token.
+    NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 0);
+    NSUDO_TEST_ASSERT(Controller.GetThreadContextCount(true) == 1);
+    NSUDO_TEST_ASSERT(Controller.GetThreadContextCount(false) == 1);
+}
+
+NSUDO_TEST(PrewarmerReopensTokenAfterServiceStops)
+{
+    CNSudoFakeServiceController Controller;
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(10));
+
+    Prewarmer.Start();
+
+    int First = 0;
+    NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(First, g_PrewarmTestTimeout));
+    Controller.CloseToken(First);
+
+    Controller.StopService();
+    NSUDO_TEST_ASSERT(Controller.WaitForStartCount(2, g_PrewarmTestTimeout));
+
+    int Second = 0;
+    NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(Second, g_PrewarmTestTimeout));
+    Controller.CloseToken(Second);
+
+    Prewarmer.Stop();
+
+    // The token of the stopped service is closed before it is reopened.
+    NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 0);
+    NSUDO_TEST_ASSERT(Prewarmer.GetState() ==
+        NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED);
+}
+
+NSUDO_TEST(PrewarmerRetriesFailedStarts)
+{
+    CNSudoFakeServiceController Controller;
+    Controller.SetFailingStarts(2);
+
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(10));
+
+    Prewarmer.Start();
+
+    NSUDO_TEST_ASSERT(Controller.WaitForStartCount(3, g_PrewarmTestTimeout));
+
+    int Token = 0;
+    NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(Token, g_PrewarmTestTimeout));
+    Controller.CloseToken(Token);
+
+    Prewarmer.Stop();
+
+    NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 0);
+}
+
+NSUDO_TEST(PrewarmerFallsBackWhileRetryWaiting)
+{
+    CNSudoFakeServiceController Controller;
+    Controller.SetFailingStarts(1);
+
+    // The retry interval is longer than the test, so the prewarmer stays in
+    // the retry waiting state after the failed start.
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::milliseconds(10),
+        std::chrono::hours(1));
+
+    Prewarmer.Start();
+
+    NSUDO_TEST_ASSERT(Controller.WaitForStartCount(1, g_PrewarmTestTimeout));
+
+    int Token = 0;
+    NSUDO_TEST_ASSERT(!Prewarmer.TryAcquire(Token, g_PrewarmTestTimeout));
+    NSUDO_TEST_ASSERT(Prewarmer.GetState() ==
+        NSUDO_SERVICE_TOKEN_PREWARM_STATE::RETRY_WAITING);
+
+    // Stopping wakes up the retry wait instead of waiting for an hour.
+    Prewarmer.Stop();
+
+    NSUDO_TEST_ASSERT(Controller.GetStartCount() == 1);
+    NSUDO_TEST_ASSERT(Prewarmer.GetState() ==
+        NSUDO_SERVICE_TOKEN_PREWARM_STATE::STOPPED);
+}
+
+NSUDO_TEST(PrewarmerAcquireWaitsForStartingService)
+{
+    CNSudoFakeServiceController Controller;
+    Controller.SetStartLatency(std::chrono::milliseconds(100));
+
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(10));
+
+    Prewarmer.Start();
+
+    // The launch path waits for the service which is being started instead
+    // of starting it by itself.
+    int Token = 0;
+    NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(Token, g_PrewarmTestTimeout));
+    NSUDO_TEST_ASSERT(Controller.GetStartCount() == 1);
+    Controller.CloseToken(Token);
+
+    Prewarmer.Stop();
+}
+
+NSUDO_TEST(PrewarmerAcquireTimesOutWhileStarting)
+{
+    CNSudoFakeServiceController Controller;
+    Controller.SetStartLatency(std::chrono::milliseconds(500));
+
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::milliseconds(10),
+        std::chrono::milliseconds(10));
+
+    Prewarmer.Start();
+
+    int Token = 0;
+    NSUDO_TEST_ASSERT(
+        !Prewarmer.TryAcquire(Token, std::chrono::milliseconds(1)));
+
+    Prewarmer.Stop();
+
+    NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 0);
+}
+
+NSUDO_TEST(PrewarmerStopWakesUpServiceWait)
+{
+    CNSudoFakeServiceController Controller;
+
+    // The poll interval is longer than the test, so only CancelWait can end
+    // the wait for the service to stop.
+    CNSudoServiceTokenPrewarmer<int> Prewarmer(
+        &Controller,
+        std::chrono::hours(1),
+        std::chrono::milliseconds(10));
+
+    Prewarmer.Start();
+
+    int Token = 0;
+    NSUDO_TEST_ASSERT(Prewarmer.TryAcquire(Token, g_PrewarmTestTimeout));
+    Controller.CloseToken(Token);
+
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+    Prewarmer.Stop();
+    NSUDO_TEST_ASSERT(
+        std::chrono::steady_clock::now() - Start < g_PrewarmTestTimeout);
+
+    NSUDO_TEST_ASSERT(Controller.GetOpenTokenCount() == 0);
+}
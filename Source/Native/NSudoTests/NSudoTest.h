@@ -0,0 +1,98 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoTest.h
+ * PURPOSE:   Definition for NSudo test harness (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#ifndef NSUDO_TEST_HARNESS
+#define NSUDO_TEST_HARNESS
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L)
+#elif (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#else
+#error "[NSudoTest] You should use a C++ compiler with the C++14 standard."
+#endif
+
+#include <vector>
+
+/**
+ * @brief A registered test case.
+*/
+typedef struct _NSUDO_TEST_CASE
+{
+    const char* Name;
+    void (*Function)();
+} NSUDO_TEST_CASE, *PNSUDO_TEST_CASE;
+
+/**
+ * @brief The exception which is thrown by a failed assertion to stop the
+ *        current test case. The failure is already reported when it is
+ *        thrown.
+*/
+class CNSudoTestFailure
+{
+};
+
+/**
+ * @brief Gets the registered test cases.
+ * @return The registered test cases, in the registration order.
+*/
+inline std::vector<NSUDO_TEST_CASE>& NSudoGetTestCases()
+{
+    static std::vector<NSUDO_TEST_CASE> TestCases;
+    return TestCases;
+}
+
+/**
+ * @brief Registers a test case from the constructor of a static object.
+*/
+class CNSudoTestRegistration
+{
+public:
+
+    CNSudoTestRegistration(
+        const char* Name,
+        void (*Function)())
+    {
+        ::NSudoGetTestCases().push_back({ Name, Function });
+    }
+};
+
+/**
+ * @brief Reports a failed assertion and stops the current test case.
+ * @param Expression The text of the failed expression.
+ * @param File The source file of the assertion.
+ * @param Line The source line of the assertion.
+*/
+[[noreturn]] void NSudoTestFail(
+    const char* Expression,
+    const char* File,
+    int Line);
+
+/**
+ * @brief Defines and registers a test case.
+ * @param Name The name of the test case, which is also the function name.
+*/
+#define NSUDO_TEST(Name) \
+    static void Name(); \
+    static CNSudoTestRegistration Name##Registration(#Name, Name); \
+    static void Name()
+
+/**
+ * @brief Stops the current test case if the expression is false.
+ * @param Expression The expression.
+*/
+#define NSUDO_TEST_ASSERT(Expression) \
+    do \
+    { \
+        if (!(Expression)) \
+        { \
+            ::NSudoTestFail(#Expression, __FILE__, __LINE__); \
+        } \
+    } while (false)
+
+#endif // !NSUDO_TEST_HARNESS
@@ -0,0 +1,91 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoTests.cpp
+ * PURPOSE:   Implementation for NSudo test runner (Portable)
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+// The test cases of the portable components only depend on the C++
+// standard library, so they also build on Linux with the runner, e.g.
+// g++ -std=c++14 -pthread -I../NSudoSDK -I../NSudoLauncher NSudoTests.cpp
+// followed by the portable test sources.
+
+#include "NSudoTest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+[[noreturn]] void NSudoTestFail(
+    const char* Expression,
+    const char* File,
+    int Line)
+{
+    std::printf("    %s(%d): NSUDO_TEST_ASSERT(%s)\n", File, Line, Expression);
+    throw CNSudoTestFailure();
+}
+
+/**
+ * @brief Runs the registered test cases. Each argument is a filter, a test
+ *        case is run if its name contains any of the filters, and all test
+ *        cases are run if there is no filter.
+ * @return The number of the failed test cases.
+*/
+int main(int argc, char* argv[])
+{
+    int Passed = 0;
+    int Failed = 0;
+
+    for (NSUDO_TEST_CASE const& TestCase : ::NSudoGetTestCases())
+    {
+        bool Selected = (argc < 2);
+        for (int i = 1; i < argc && !Selected; ++i)
+        {
+            Selected = (nullptr != std::strstr(TestCase.Name, argv[i]));
+        }
+        if (!Selected)
+        {
+            continue;
+        }
+
+        std::printf("[ RUN  ] %s\n", TestCase.Name);
+        std::fflush(stdout);
+
+        bool Succeeded = false;
+        try
+        {
+            TestCase.Function();
+            Succeeded = true;
+        }
+        catch (CNSudoTestFailure const&)
+        {
+        }
+        catch (std::exception const& Exception)
+        {
+            std::printf("    Unexpected exception: %s\n", Exception.what());
+        }
+        catch (...)
+        {
+            std::printf("    Unexpected exception.\n");
+        }
+
+        if (Succeeded)
+        {
+            ++Passed;
+            std::printf("[  OK  ] %s\n", TestCase.Name);
+        }
+        else
+        {
+            ++Failed;
+            std::printf("[ FAIL ] %s\n", TestCase.Name);
+        }
+        std::fflush(stdout);
+    }
+
+    std::printf("%d passed, %d failed.\n", Passed, Failed);
+
+    return Failed;
+}
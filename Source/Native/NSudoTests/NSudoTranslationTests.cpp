@@ -0,0 +1,234 @@
+﻿/*
+ * PROJECT:   NSudo Tests
+ * FILE:      NSudoTranslationTests.cpp
+ * PURPOSE:   Implementation for NSudo translation table tests
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <NSudoTranslationTable.h>
+#include <NSudoTranslationToml.h>
+#include <toml.hpp>
+
+#include "NSudoTest.h"
+
+/**
+ * @brief Reads the TOML content with the flat translation reader.
+ * @param Content The TOML content.
+ * @param Table Receives the translations.
+ * @return True if the content is in the supported subset.
+*/
+static bool NSudoTestReadTranslationToml(
+    std::string_view Content,
+    CNSudoTranslationTable& Table)
+{
+    CNSudoTranslationTableBuilder Builder;
+    CNSudoTranslationTomlReader Reader;
+    if (!Reader.Read(Content, Builder))
+    {
+        return false;
+    }
+
+    Builder.Build(Table);
+    return true;
+}
+
+NSUDO_TEST(TranslationTomlMatchesTomlPlusPlus)
+{
+    // The same strings as the bundled files: the escapes, the multi-line
+    // strings with the trimmed first newline, the literal strings, the
+    // quoted keys and the comments.
+    std::string_view Content =
+        "\xEF\xBB\xBF"
+        "## The header\n"
+        "\n"
+        "Plain = \"Detected - %s.\" # The comment\n"
+        "Escaped = \"Tab\\t\\\"Quote\\\" \\u00E9\\U0001F600\"\n"
+        "MultiLine = \"\"\"\r\n"
+        "First\r\n"
+        "Second \\\n"
+        "    Third\"\"\"\n"
+        "Literal = 'C:\\Windows\\System32'\n"
+        "\"Quoted Key\" = '''\n"
+        "Two quotes '' inside'''\n"
+        "Unicode = \"\xE5\x91\xBD\xE4\xBB\xA4\"\n";
+
+    CNSudoTranslationTable Table;
+    NSUDO_TEST_ASSERT(::NSudoTestReadTranslationToml(Content, Table));
+
+    toml::table Reference = toml::parse(Content);
+    NSUDO_TEST_ASSERT(Table.GetCount() == Reference.size());
+
+    for (auto const& Translation : Reference)
+    {
+        std::u16string Expected;
+        ::NSudoAppendUtf8AsUtf16(
+            Expected,
+            Translation.second.value_or(std::string_view()));
+        NSUDO_TEST_ASSERT(Table.FindUtf16(Translation.first) == Expected);
+    }
+
+    NSUDO_TEST_ASSERT(
+        Table.FindUtf16("MultiLine") == u"First\nSecond Third");
+    NSUDO_TEST_ASSERT(
+        Table.FindUtf16("Quoted Key") == u"Two quotes '' inside");
+}
+
+NSUDO_TEST(TranslationTomlKeepsTheFirstDuplicateKey)
+{
+    std::string_view Content =
+        "Duplicated = \"First\"\n"
+        "Other = \"Other\"\n"
+        "Duplicated = \"Second\"\n"
+        "\"Duplicated\" = 'Third'\n";
+
+    // The translations are looked up by the first definition, the same as
+    // the builder does for the other sources.
+    CNSudoTranslationTable Table;
+    NSUDO_TEST_ASSERT(::NSudoTestReadTranslationToml(Content, Table));
+    NSUDO_TEST_ASSERT(Table.GetCount() == 2);
+    NSUDO_TEST_ASSERT(Table.FindUtf16("Duplicated") == u"First");
+    NSUDO_TEST_ASSERT(Table.FindUtf16("Other") == u"Other");
+
+    // toml++ rejects the same file, so the reader is more permissive here
+    // than the fallback.
+    bool Rejected = false;
+    try
+    {
+        toml::table Reference = toml::parse(Content);
+        NSUDO_TEST_ASSERT(Reference.empty());
+    }
+    catch (toml::parse_error const&)
+    {
+        Rejected = true;
+    }
+    NSUDO_TEST_ASSERT(Rejected);
+}
+
+NSUDO_TEST(TranslationTomlRejectsOutsideTheSubset)
+{
+    static const char* const Contents[] =
+    {
+        "[Table]\nKey = \"Value\"\n",
+        "Dotted.Key = \"Value\"\n",
+        "Number = 1\n",
+        "Unterminated = \"Value\n",
+        "Invalid = \"\\q\"\n",
+        "Surrogate = \"\\uD800\"\n",
+        "Trailing = \"Value\" Garbage\n",
+    };
+
+    for (const char* Content : Contents)
+    {
+        CNSudoTranslationTable Table;
+        NSUDO_TEST_ASSERT(!::NSudoTestReadTranslationToml(Content, Table));
+    }
+}
+
+NSUDO_TEST(TranslationTableConcurrentLookups)
+{
+    const std::size_t KeyCount = 256;
+    const std::size_t ThreadCount = 16;
+    const std::size_t RoundCount = 20;
+    const std::size_t LookupCount = 20;
+
+    std::vector<std::string> Keys;
+    std::vector<std::u16string> Values;
+    for (std::size_t i = 0; i < KeyCount; ++i)
+    {
+        char Key[32];
+        std::snprintf(Key, sizeof(Key), "Key.%zu", i);
+        Keys.emplace_back(Key);
+
+        std::string Value = "\xE5\x91\xBD\xE4\xBB\xA4 ";
+        Value.append(Key);
+        Values.emplace_back();
+        ::NSudoAppendUtf8AsUtf16(Values.back(), Value);
+    }
+
+    // Every round publishes a new table like the plugin host does, so the
+    // threads race on the first conversion of every UTF-8 value.
+    for (std::size_t Round = 0; Round < RoundCount; ++Round)
+    {
+        std::unique_ptr<CNSudoTranslationTable> Table(
+            new CNSudoTranslationTable());
+        {
+            CNSudoTranslationTableBuilder Builder;
+            for (std::size_t i = 0; i < KeyCount; ++i)
+            {
+                std::string Value = "\xE5\x91\xBD\xE4\xBB\xA4 ";
+                Value.append(Keys[i]);
+                Builder.AddUtf8(Keys[i], Value);
+            }
+            Builder.Build(*Table);
+        }
+
+        std::atomic<const CNSudoTranslationTable*> Published(nullptr);
+        std::atomic<std::size_t> Ready(0);
+        std::atomic<std::size_t> Mismatches(0);
+        std::vector<std::vector<const char16_t*>> Pointers(ThreadCount);
+
+        std::vector<std::thread> Threads;
+        for (std::size_t Index = 0; Index < ThreadCount; ++Index)
+        {
+            Threads.emplace_back([&, Index]()
+            {
+                std::vector<const char16_t*>& Seen = Pointers[Index];
+                Seen.resize(KeyCount);
+
+                ++Ready;
+                const CNSudoTranslationTable* Current = nullptr;
+                while (!(Current = Published.load(std::memory_order_acquire)))
+                {
+                    std::this_thread::yield();
+                }
+
+                // The threads start at different keys, so some of them
+                // convert the values while the others read them.
+                for (std::size_t i = 0; i < LookupCount * KeyCount; ++i)
+                {
+                    std::size_t Key = (i + Index * 17) % KeyCount;
+                    std::u16string_view Value = Current->FindUtf16(Keys[Key]);
+                    if (Value != Values[Key] ||
+                        Value.data()[Value.size()] != u'\0' ||
+                        (Seen[Key] && Seen[Key] != Value.data()) ||
+                        !Current->FindUtf16("Missing").empty())
+                    {
+                        ++Mismatches;
+                    }
+                    Seen[Key] = Value.data();
+                }
+            });
+        }
+
+        while (Ready != ThreadCount)
+        {
+            std::this_thread::yield();
+        }
+        Published.store(Table.get(), std::memory_order_release);
+
+        for (std::thread& Thread : Threads)
+        {
+            Thread.join();
+        }
+
+        // The first published conversion is the only one every thread sees.
+        NSUDO_TEST_ASSERT(Mismatches == 0);
+        for (std::size_t Index = 1; Index < ThreadCount; ++Index)
+        {
+            NSUDO_TEST_ASSERT(Pointers[Index] == Pointers[0]);
+        }
+
+        Published.store(nullptr, std::memory_order_release);
+    }
+}
@@ -0,0 +1,283 @@
+﻿/*
+ * PROJECT:   NSudo Translation Benchmark
+ * FILE:      NSudoTranslationBenchmark.cpp
+ * PURPOSE:   Implementation for NSudo Translation Benchmark
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <NSudoTranslationTable.h>
+#include <NSudoTranslationToml.h>
+#include <toml.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Scales a flat translation TOML file up by repeating its lines. The
+ *        keys of each copy get the number of the copy as the suffix, so toml++
+ *        accepts the result. The lines in the multi-line strings are copied
+ *        as they are.
+ * @param Content The content of the TOML file without the BOM.
+ * @param Scale The number of the copies.
+ * @return The scaled content.
+*/
+static std::string NSudoTranslationBenchmarkScale(
+    std::string_view Content,
+    std::size_t Scale)
+{
+    std::string Result;
+    Result.reserve(Content.size() * Scale + Scale * 64);
+
+    for (std::size_t i = 0; i < Scale; ++i)
+    {
+        char Suffix[32];
+        std::snprintf(Suffix, sizeof(Suffix), "_%06zu", i);
+
+        std::string_view Remaining = Content;
+        std::string_view MultiLineQuote;
+        while (!Remaining.empty())
+        {
+            std::size_t End = Remaining.find('\n');
+            End = (End == std::string_view::npos) ? Remaining.size() : End + 1;
+            std::string_view Line = Remaining.substr(0, End);
+            Remaining.remove_prefix(End);
+
+            std::size_t KeyEnd = 0;
+            if (MultiLineQuote.empty())
+            {
+                while (KeyEnd < Line.size() &&
+                    ((Line[KeyEnd] >= 'A' && Line[KeyEnd] <= 'Z') ||
+                    (Line[KeyEnd] >= 'a' && Line[KeyEnd] <= 'z') ||
+                    (Line[KeyEnd] >= '0' && Line[KeyEnd] <= '9') ||
+                    Line[KeyEnd] == '_' ||
+                    Line[KeyEnd] == '-'))
+                {
+                    ++KeyEnd;
+                }
+            }
+
+            Result.append(Line.substr(0, KeyEnd));
+            if (KeyEnd)
+            {
+                Result.append(Suffix);
+            }
+            Result.append(Line.substr(KeyEnd));
+
+            // The multi-line strings are tracked by their delimiters, which
+            // are enough for the bundled files.
+            for (std::string_view Quote : { "\"\"\"", "'''" })
+            {
+                std::size_t Position = Line.find(Quote, KeyEnd);
+                while (Position != std::string_view::npos)
+                {
+                    if (MultiLineQuote.empty())
+                    {
+                        MultiLineQuote = Quote;
+                    }
+                    else if (MultiLineQuote == Quote)
+                    {
+                        MultiLineQuote = std::string_view();
+                    }
+                    Position = Line.find(Quote, Position + Quote.size());
+                }
+            }
+        }
+
+        if (!Result.empty() && Result.back() != '\n')
+        {
+            Result.push_back('\n');
+        }
+    }
+
+    return Result;
+}
+
+/**
+ * @brief Measures a reader.
+ * @param Iterations The number of the iterations.
+ * @param Read The reader, which returns the number of the translations or -1
+ *             if the content is not parsed.
+ * @param Count Receives the number of the translations.
+ * @return The average time of each iteration, in milliseconds.
+*/
+template<typename ReadType>
+static double NSudoTranslationBenchmarkMeasure(
+    std::uint64_t Iterations,
+    ReadType&& Read,
+    std::ptrdiff_t& Count)
+{
+    std::chrono::steady_clock::time_point Start =
+        std::chrono::steady_clock::now();
+
+    for (std::uint64_t i = 0; i < Iterations; ++i)
+    {
+        Count = Read();
+    }
+
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - Start).count()
+        / static_cast<double>(Iterations);
+}
+
+int main(int argc, char* argv[])
+{
+    std::uint64_t Iterations = 10;
+    std::size_t Scale = 1000;
+    int FirstFile = argc;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char* End = nullptr;
+        unsigned long long Value = 0;
+
+        if (0 == std::strncmp(argv[i], "-Iterations:", 12))
+        {
+            Value = std::strtoull(argv[i] + 12, &End, 10);
+            Iterations = Value;
+        }
+        else if (0 == std::strncmp(argv[i], "-Scale:", 7))
+        {
+            Value = std::strtoull(argv[i] + 7, &End, 10);
+            Scale = static_cast<std::size_t>(Value);
+        }
+        else
+        {
+            FirstFile = i;
+            break;
+        }
+
+        if (!Value || !End || *End)
+        {
+            FirstFile = argc;
+            break;
+        }
+    }
+
+    if (FirstFile == argc)
+    {
+        std::printf(
+            "Usage: NSudoTranslationBenchmark [-Iterations:Count] "
+            "[-Scale:Count] Files...\n"
+            "\n"
+            "Scales up the flat translation TOML files, e.g. the bundled "
+            "Translations.toml\n"
+            "files, and reports the time of the flat reader and of "
+            "toml::parse.\n");
+        return EXIT_FAILURE;
+    }
+
+    std::printf(
+        "%-48s %8s %10s %12s %12s %8s\n",
+        "File",
+        "Keys",
+        "KiB",
+        "Reader (ms)",
+        "toml++ (ms)",
+        "Speedup");
+
+    int Result = EXIT_SUCCESS;
+
+    for (int i = FirstFile; i < argc; ++i)
+    {
+        std::ifstream File(argv[i], std::ios::binary);
+        std::string Source(
+            (std::istreambuf_iterator<char>(File)),
+            std::istreambuf_iterator<char>());
+        if (!File.good() && !File.eof())
+        {
+            std::printf("%-48s cannot be read.\n", argv[i]);
+            Result = EXIT_FAILURE;
+            continue;
+        }
+
+        std::string_view SourceView = Source;
+        if (SourceView.substr(0, 3) == "\xEF\xBB\xBF")
+        {
+            SourceView.remove_prefix(3);
+        }
+
+        std::string Content = ::NSudoTranslationBenchmarkScale(
+            SourceView,
+            Scale);
+
+        // The readers fill a builder, which is what the plugin host does
+        // with the result of both of them.
+        std::ptrdiff_t ReaderCount = 0;
+        double ReaderTime = ::NSudoTranslationBenchmarkMeasure(
+            Iterations,
+            [&]() -> std::ptrdiff_t
+            {
+                CNSudoTranslationTableBuilder Builder;
+                CNSudoTranslationTomlReader Reader;
+                if (!Reader.Read(Content, Builder))
+                {
+                    return -1;
+                }
+                CNSudoTranslationTable Table;
+                Builder.Build(Table);
+                return static_cast<std::ptrdiff_t>(Table.GetCount());
+            },
+            ReaderCount);
+
+        std::ptrdiff_t TomlCount = 0;
+        double TomlTime = ::NSudoTranslationBenchmarkMeasure(
+            Iterations,
+            [&]() -> std::ptrdiff_t
+            {
+                try
+                {
+                    toml::table TranslationsTable = toml::parse(Content);
+
+                    CNSudoTranslationTableBuilder Builder;
+                    Builder.Reserve(TranslationsTable.size());
+                    for (auto const& Translation : TranslationsTable)
+                    {
+                        Builder.AddUtf8(
+                            Translation.first,
+                            Translation.second.value_or(std::string_view()));
+                    }
+                    CNSudoTranslationTable Table;
+                    Builder.Build(Table);
+                    return static_cast<std::ptrdiff_t>(Table.GetCount());
+                }
+                catch (...)
+                {
+                    return -1;
+                }
+            },
+            TomlCount);
+
+        if (ReaderCount <= 0 || ReaderCount != TomlCount)
+        {
+            std::printf(
+                "%-48s is read as %td keys by the reader and as %td keys by "
+                "toml++.\n",
+                argv[i],
+                ReaderCount,
+                TomlCount);
+            Result = EXIT_FAILURE;
+            continue;
+        }
+
+        std::printf(
+            "%-48s %8td %10.1f %12.2f %12.2f %7.1fx\n",
+            argv[i],
+            ReaderCount,
+            Content.size() / 1024.0,
+            ReaderTime,
+            TomlTime,
+            TomlTime / ReaderTime);
+    }
+
+    return Result;
+}
@@ -0,0 +1,542 @@
+﻿/*
+ * PROJECT:   NSudo Translation Compiler
+ * FILE:      NSudoTranslationCompiler.cpp
+ * PURPOSE:   Implementation for NSudo Translation Compiler
+ *
+ * LICENSE:   The MIT License
+ *
+ * DEVELOPER: Mouri_Naruto (Mouri_Naruto AT Outlook.com)
+ */
+
+#include <NSudoLauncherJson.h>
+#include <NSudoTranslationTable.h>
+#include <NSudoTranslationToml.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Reports an error in the canonical format, so MSBuild shows it in the
+ *        error list with the file.
+ * @param Path The file which has the error.
+ * @param Code The error code.
+ * @param Message The error message.
+*/
+static void NSudoTranslationCompilerError(
+    std::string const& Path,
+    const char* Code,
+    const char* Message)
+{
+    std::fprintf(
+        stderr,
+        "%s : error %s: %s\n",
+        Path.c_str(),
+        Code,
+        Message);
+}
+
+/**
+ * @brief Checks whether the string is valid UTF-8, which excludes the
+ *        overlong sequences and the surrogates.
+ * @param Value The string.
+ * @return True if the string is valid UTF-8.
+*/
+static bool NSudoIsValidUtf8(
+    std::string_view Value)
+{
+    std::size_t Index = 0;
+    while (Index < Value.size())
+    {
+        std::uint8_t Lead = static_cast<std::uint8_t>(Value[Index]);
+
+        std::size_t Length = 1;
+        std::uint32_t CodePoint = Lead;
+        std::uint32_t Minimum = 0;
+        if (Lead >= 0xC2 && Lead <= 0xDF)
+        {
+            Length = 2;
+            CodePoint = Lead & 0x1F;
+            Minimum = 0x80;
+        }
+        else if (Lead >= 0xE0 && Lead <= 0xEF)
+        {
+            Length = 3;
+            CodePoint = Lead & 0x0F;
+            Minimum = 0x800;
+        }
+        else if (Lead >= 0xF0 && Lead <= 0xF4)
+        {
+            Length = 4;
+            CodePoint = Lead & 0x07;
+            Minimum = 0x10000;
+        }
+        else if (Lead >= 0x80)
+        {
+            return false;
+        }
+
+        if (Length > Value.size() - Index)
+        {
+            return false;
+        }
+
+        for (std::size_t i = 1; i < Length; ++i)
+        {
+            std::uint8_t Trail = static_cast<std::uint8_t>(Value[Index + i]);
+            if ((Trail & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            CodePoint = (CodePoint << 6) | (Trail & 0x3F);
+        }
+
+        if (CodePoint < Minimum ||
+            CodePoint > 0x10FFFF ||
+            (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+        {
+            return false;
+        }
+
+        Index += Length;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the UTF-8 file. The BOM is removed.
+ * @param Path The path of the file.
+ * @param Content Receives the content of the file.
+ * @return True if the file is read and is valid UTF-8. The error is reported.
+*/
+static bool NSudoReadUtf8File(
+    std::string const& Path,
+    std::string& Content)
+{
+    std::ifstream File(Path, std::ios::in | std::ios::binary);
+    if (!File)
+    {
+        ::NSudoTranslationCompilerError(
+            Path,
+            "NSTR0002",
+            "The file cannot be opened.");
+        return false;
+    }
+
+    Content.assign(
+        std::istreambuf_iterator<char>(File),
+        std::istreambuf_iterator<char>());
+    if (File.bad())
+    {
+        ::NSudoTranslationCompilerError(
+            Path,
+            "NSTR0002",
+            "The file cannot be read.");
+        return false;
+    }
+
+    if (0 == Content.compare(0, 3, "\xEF\xBB\xBF"))
+    {
+        Content.erase(0, 3);
+    }
+
+    if (!::NSudoIsValidUtf8(Content))
+    {
+        ::NSudoTranslationCompilerError(
+            Path,
+            "NSTR0001",
+            "The file is not valid UTF-8.");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends the code point to the UTF-8 string.
+ * @param Output The UTF-8 string.
+ * @param CodePoint The code point, which is not a surrogate.
+*/
+static void NSudoAppendCodePointAsUtf8(
+    std::string& Output,
+    std::uint32_t CodePoint)
+{
+    if (CodePoint < 0x80)
+    {
+        Output.push_back(static_cast<char>(CodePoint));
+    }
+    else if (CodePoint < 0x800)
+    {
+        Output.push_back(static_cast<char>(0xC0 | (CodePoint >> 6)));
+        Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+    }
+    else if (CodePoint < 0x10000)
+    {
+        Output.push_back(static_cast<char>(0xE0 | (CodePoint >> 12)));
+        Output.push_back(static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+        Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+    }
+    else
+    {
+        Output.push_back(static_cast<char>(0xF0 | (CodePoint >> 18)));
+        Output.push_back(
+            static_cast<char>(0x80 | ((CodePoint >> 12) & 0x3F)));
+        Output.push_back(static_cast<char>(0x80 | ((CodePoint >> 6) & 0x3F)));
+        Output.push_back(static_cast<char>(0x80 | (CodePoint & 0x3F)));
+    }
+}
+
+/**
+ * @brief Reads the 4 hexadecimal digits of a "\u" escape sequence.
+ * @param Value The JSON string.
+ * @param Position The position of the digits, which is moved after them.
+ * @param CodeUnit Receives the UTF-16 code unit.
+ * @return True if the digits are valid.
+*/
+static bool NSudoReadJsonCodeUnit(
+    std::string_view Value,
+    std::size_t& Position,
+    std::uint32_t& CodeUnit)
+{
+    if (Value.size() - Position < 4)
+    {
+        return false;
+    }
+
+    CodeUnit = 0;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        char Current = Value[Position++];
+        CodeUnit <<= 4;
+        if (Current >= '0' && Current <= '9')
+        {
+            CodeUnit |= Current - '0';
+        }
+        else if (Current >= 'A' && Current <= 'F')
+        {
+            CodeUnit |= Current - 'A' + 10;
+        }
+        else if (Current >= 'a' && Current <= 'f')
+        {
+            CodeUnit |= Current - 'a' + 10;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Unescapes the JSON string. The surrogate pairs are combined.
+ * @param Value The JSON string without the quotes.
+ * @param Output Receives the UTF-8 string.
+ * @return True if the escape sequences are valid.
+*/
+static bool NSudoUnescapeJsonString(
+    std::string_view Value,
+    std::string& Output)
+{
+    Output.clear();
+
+    std::size_t Position = 0;
+    while (Position < Value.size())
+    {
+        char Current = Value[Position++];
+        if (Current != '\\')
+        {
+            Output.push_back(Current);
+            continue;
+        }
+
+        if (Position == Value.size())
+        {
+            return false;
+        }
+
+        char Escape = Value[Position++];
+        switch (Escape)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            Output.push_back(Escape);
+            break;
+        case 'b':
+            Output.push_back('\b');
+            break;
+        case 'f':
+            Output.push_back('\f');
+            break;
+        case 'n':
+            Output.push_back('\n');
+            break;
+        case 'r':
+            Output.push_back('\r');
+            break;
+        case 't':
+            Output.push_back('\t');
+            break;
+        case 'u':
+        {
+            std::uint32_t CodePoint = 0;
+            if (!::NSudoReadJsonCodeUnit(Value, Position, CodePoint))
+            {
+                return false;
+            }
+
+            if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF)
+            {
+                std::uint32_t Low = 0;
+                if (Value.substr(Position, 2) != "\\u")
+                {
+                    return false;
+                }
+                Position += 2;
+                if (!::NSudoReadJsonCodeUnit(Value, Position, Low) ||
+                    Low < 0xDC00 || Low > 0xDFFF)
+                {
+                    return false;
+                }
+                CodePoint =
+                    0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+            }
+            else if (CodePoint >= 0xDC00 && CodePoint <= 0xDFFF)
+            {
+                return false;
+            }
+
+            ::NSudoAppendCodePointAsUtf8(Output, CodePoint);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the string members of the "Translations" object of the JSON
+ *        file. The members whose values are not strings are skipped, the
+ *        same as the launchers did at runtime.
+ * @param Content The UTF-8 content of the JSON file without the BOM.
+ * @param Builder The builder which receives the translations.
+ * @return True if the JSON file is read.
+*/
+static bool NSudoReadJsonTranslations(
+    std::string_view Content,
+    CNSudoTranslationTableBuilder& Builder)
+{
+    std::vector<NSUDO_LAUNCHER_JSON_STRING_MEMBER> Members;
+    if (!::NSudoReadJsonStringMembers(Content, "Translations", Members))
+    {
+        return false;
+    }
+
+    Builder.Reserve(Members.size());
+
+    std::string Key;
+    std::string Value;
+    for (NSUDO_LAUNCHER_JSON_STRING_MEMBER const& Member : Members)
+    {
+        if (!::NSudoUnescapeJsonString(Member.first, Key) ||
+            !::NSudoUnescapeJsonString(Member.second, Value))
+        {
+            return false;
+        }
+
+        Builder.AddUtf8(Key, Value);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Adds the files listed in the strings argument as the UTF-8 text of
+ *        the keys.
+ * @param Strings The "Key=Path;..." list. The paths are relative to the
+ *                current directory.
+ * @param Builder The builder which receives the translations.
+ * @return True if all files are added. The error is reported.
+*/
+static bool NSudoAddStringFiles(
+    std::string_view Strings,
+    CNSudoTranslationTableBuilder& Builder)
+{
+    auto Trim = [](std::string_view Value)
+    {
+        while (!Value.empty() &&
+            (Value.front() == ' ' || Value.front() == '\t'))
+        {
+            Value.remove_prefix(1);
+        }
+        while (!Value.empty() &&
+            (Value.back() == ' ' || Value.back() == '\t'))
+        {
+            Value.remove_suffix(1);
+        }
+        return Value;
+    };
+
+    while (!Strings.empty())
+    {
+        std::size_t End = Strings.find(';');
+        std::string_view Item = Strings.substr(0, End);
+        Strings.remove_prefix(
+            End == std::string_view::npos ? Strings.size() : End + 1);
+
+        Item = Trim(Item);
+        if (Item.empty())
+        {
+            continue;
+        }
+
+        std::size_t Separator = Item.find('=');
+        if (Separator == std::string_view::npos || !Separator)
+        {
+            ::NSudoTranslationCompilerError(
+                std::string(Item),
+                "NSTR0001",
+                "Invalid string, Key=Path is expected.");
+            return false;
+        }
+
+        std::string Path(Trim(Item.substr(Separator + 1)));
+        std::string Content;
+        if (!::NSudoReadUtf8File(Path, Content))
+        {
+            return false;
+        }
+
+        Builder.AddUtf8(Trim(Item.substr(0, Separator)), Content);
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string SourcePath;
+    std::string OutputPath;
+    std::string_view Strings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == std::strncmp(argv[i], "-Strings:", 9))
+        {
+            Strings = argv[i] + 9;
+        }
+        else if (SourcePath.empty())
+        {
+            SourcePath = argv[i];
+        }
+        else if (OutputPath.empty())
+        {
+            OutputPath = argv[i];
+        }
+        else
+        {
+            OutputPath.clear();
+            break;
+        }
+    }
+
+    if (SourcePath.empty() || OutputPath.empty())
+    {
+        std::printf(
+            "Usage: NSudoTranslationCompiler Source Output "
+            "[-Strings:Key=Path;...]\n"
+            "\n"
+            "Compiles a flat translation TOML file or the \"Translations\" "
+            "object of a JSON\n"
+            "file into the frozen translation table layout, which is "
+            "attached in place\n"
+            "from the resources at runtime. The files in the strings list "
+            "are added as the\n"
+            "UTF-8 text of the keys.\n");
+        return EXIT_FAILURE;
+    }
+
+    std::string Content;
+    if (!::NSudoReadUtf8File(SourcePath, Content))
+    {
+        return EXIT_FAILURE;
+    }
+
+    CNSudoTranslationTableBuilder Builder;
+
+    // The JSON files are recognized by the extension, the same as the other
+    // files are read as TOML.
+    std::string Extension = SourcePath.substr(
+        SourcePath.size() - std::min<std::size_t>(SourcePath.size(), 5));
+    for (char& Character : Extension)
+    {
+        if (Character >= 'A' && Character <= 'Z')
+        {
+            Character = static_cast<char>(Character - 'A' + 'a');
+        }
+    }
+
+    if (Extension == ".json")
+    {
+        if (!::NSudoReadJsonTranslations(Content, Builder))
+        {
+            ::NSudoTranslationCompilerError(
+                SourcePath,
+                "NSTR0001",
+                "The JSON file or its escape sequences are invalid.");
+            return EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        CNSudoTranslationTomlReader Reader;
+        if (!Reader.Read(Content, Builder))
+        {
+            ::NSudoTranslationCompilerError(
+                SourcePath,
+                "NSTR0001",
+                "Only the flat translation tables with the string keys and "
+                "the string values are supported.");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!::NSudoAddStringFiles(Strings, Builder))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint8_t> Table;
+    Builder.Compile(Table);
+
+    std::ofstream Output(
+        OutputPath,
+        std::ios::out | std::ios::binary | std::ios::trunc);
+    Output.write(
+        reinterpret_cast<const char*>(Table.data()),
+        static_cast<std::streamsize>(Table.size()));
+    Output.close();
+    if (!Output)
+    {
+        ::NSudoTranslationCompilerError(
+            OutputPath,
+            "NSTR0002",
+            "The file cannot be written.");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}